@@ -0,0 +1,201 @@
+// ArtMapBenchmark.cpp : easy::art_map against easy::map<std::string, int> and easy::string_map
+//
+// Standalone, builds on Linux with just a compiler:
+//
+//     g++ -O2 -std=c++11 -I../TestCpp.Shared ArtMapBenchmark.cpp -o ArtMapBenchmark
+//
+// Usage:
+//     ArtMapBenchmark [--sizes 100000,1000000,...]
+//
+// Every case builds a map of the given number of keys shaped like URL paths,
+// "/api/v2/tenant0042/orders/0001234567", which share long prefixes, and reports
+// per key the time to insert them in random order, to find every key, to
+// lower_bound a key which is not in the map, and to iterate. The last column
+// is the time per element to enumerate the keys under one tenant with
+// prefix_range, or with lower_bound and a compare of each key for the maps.
+//
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "ArtMap.h"
+#include "Map.h"
+#include "StringMap.h"
+
+
+typedef easy::map<std::string, int> tree_map;
+typedef easy::string_map<int>       string_map;
+typedef easy::art_map<int>          art_map;
+
+// Keeps the optimizer from dropping the lookups.
+static volatile size_t gSink = 0;
+
+static const size_t kTenants = 256;
+
+template <typename Function>
+static double TimeNs(Function f)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    f();
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::string MakeKey(size_t nTenant, const char* pKind, uint64_t nId)
+{
+    char key[64];
+    snprintf(key, sizeof(key), "/api/v2/tenant%04u/%s/%010llu", (unsigned)nTenant, pKind, (unsigned long long)nId);
+    return key;
+}
+
+static std::string TenantPrefix(size_t nTenant)
+{
+    char prefix[32];
+    snprintf(prefix, sizeof(prefix), "/api/v2/tenant%04u/", (unsigned)nTenant);
+    return prefix;
+}
+
+static void Report(const char* pImpl, size_t nKeys, double insertNs, double findNs, double missNs, double iterateNs, double prefixNs, size_t nPrefixed)
+{
+    const double n = (double)nKeys;
+    printf("%-7s %10u %9.2f %9.2f %9.2f %9.2f %9.2f\n", pImpl, (unsigned)nKeys,
+        insertNs / n, findNs / n, missNs / n, iterateNs / n, prefixNs / (double)nPrefixed);
+}
+
+
+// The keys under a prefix: the maps seek to it and compare each key.
+template <typename Map>
+static size_t PrefixCount(const Map& map, const std::string& prefix)
+{
+    size_t nCount = 0;
+    for (typename Map::const_iterator it = map.lower_bound(prefix); (it != map.end()) && (it->first.compare(0, prefix.size(), prefix) == 0); ++it)
+        nCount += (it->second >= 0);
+    return nCount;
+}
+
+static size_t PrefixCount(const art_map& map, const std::string& prefix)
+{
+    size_t nCount = 0;
+    const easy::pair<art_map::const_iterator, art_map::const_iterator> range = map.prefix_range(prefix);
+    for (art_map::const_iterator it = range.first; it != range.second; ++it)
+        nCount += (it->second >= 0);
+    return nCount;
+}
+
+
+// Runs one implementation; Map is any of the three, which share this API.
+template <typename Map>
+static void RunMap(const char* pImpl, const std::vector<std::string>& keys, const std::vector<std::string>& misses)
+{
+    Map map;
+
+    const double insertNs = TimeNs([&]()
+    {
+        for (size_t i = 0; i < keys.size(); ++i)
+            map.insert(easy::make_pair(keys[i], (int)i));
+    });
+
+    const double findNs = TimeNs([&]()
+    {
+        size_t nFound = 0;
+        for (size_t i = 0; i < keys.size(); ++i)
+            nFound += (map.find(keys[i]) != map.end());
+        gSink = gSink + nFound;
+    });
+
+    const double missNs = TimeNs([&]()
+    {
+        size_t nSum = 0;
+        for (size_t i = 0; i < misses.size(); ++i)
+        {
+            typename Map::const_iterator it = map.lower_bound(misses[i]);
+            nSum += (it != map.end()) ? (size_t)it->second : 0;
+        }
+        gSink = gSink + nSum;
+    });
+
+    const double iterateNs = TimeNs([&]()
+    {
+        size_t nSum = 0;
+        for (typename Map::const_iterator it = map.begin(); it != map.end(); ++it)
+            nSum += (size_t)it->second;
+        gSink = gSink + nSum;
+    });
+
+    size_t nPrefixed = 0;
+    const double prefixNs = TimeNs([&]()
+    {
+        for (size_t t = 0; t < kTenants; ++t)
+            nPrefixed += PrefixCount(map, TenantPrefix(t));
+    });
+
+    Report(pImpl, map.size(), insertNs, findNs, missNs, iterateNs, prefixNs, nPrefixed);
+}
+
+
+static void RunCase(size_t n)
+{
+    static const char* const kinds[] = { "orders", "users", "invoices", "sessions" };
+
+    std::mt19937_64          random(n);
+    std::vector<std::string> keys, misses;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        const size_t   nTenant = (size_t)(random() % kTenants);
+        const char*    pKind = kinds[random() % 4];
+        const uint64_t nId = random() % 10000000000ULL;
+        keys.push_back(MakeKey(nTenant, pKind, nId));
+        misses.push_back(MakeKey(nTenant, pKind, nId) + "-");
+    }
+    std::shuffle(misses.begin(), misses.end(), random);
+
+    RunMap<tree_map>("map", keys, misses);
+    RunMap<string_map>("string", keys, misses);
+    RunMap<art_map>("art", keys, misses);
+}
+
+
+static std::vector<size_t> SplitSizes(const char* p)
+{
+    std::vector<size_t> sizes;
+
+    while (*p)
+    {
+        char* pEnd;
+        sizes.push_back((size_t)strtoull(p, &pEnd, 10));
+        p = (*pEnd == ',') ? (pEnd + 1) : pEnd;
+    }
+
+    return sizes;
+}
+
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> sizes = SplitSizes("100000,1000000");
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if ((strcmp(argv[i], "--sizes") == 0) && ((i + 1) < argc))
+            sizes = SplitSizes(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [--sizes 100000,...]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("%-7s %10s %9s %9s %9s %9s %9s\n", "impl", "keys", "ns/insert", "ns/find", "ns/seek", "ns/iter", "ns/prefix");
+
+    for (size_t s = 0; s < sizes.size(); ++s)
+        RunCase(sizes[s]);
+
+    return 0;
+}
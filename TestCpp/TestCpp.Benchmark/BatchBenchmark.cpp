@@ -0,0 +1,150 @@
+// BatchBenchmark.cpp : easy::map apply_batch against one insert or erase at a time
+//
+// Standalone, builds on Linux with just a compiler:
+//
+//     g++ -O2 -std=c++11 -I../TestCpp.Shared BatchBenchmark.cpp -o BatchBenchmark
+//
+// Usage:
+//     BatchBenchmark [--sizes 100000,1000000,...] [--batches 1,16,250,1000,2000]
+//
+// Every case builds a map of the given size by inserting random keys and churns
+// it once over, by erasing a random element and inserting a new key, so that the
+// nodes are spread across the heap as in a long-lived map. It copies the map, and
+// applies the same batch of random upserts and erases, half of each, to the two
+// copies. --batches gives the batch sizes in thousandths of the map's size. The
+// rows are:
+//
+//     loop      insert, or assign on a duplicate key, and erase, one per operation
+//     batch     apply_batch, which searches from the previous key's position for
+//               batches up to the map's size, and rebuilds the tree for larger ones
+//
+// Each map first gets a batch of the same size whose operations do nothing. After
+// the churn, glibc's malloc otherwise spends milliseconds sorting its free lists
+// on the first allocation of each new size, which the vectors in apply_batch hit.
+//
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "Map.h"
+
+
+typedef easy::map<uint64_t, uint64_t> map_type;
+typedef map_type::batch_op_type       batch_op;
+
+template <typename Function>
+static double TimeNs(Function f)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    f();
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void Churn(map_type& m, std::mt19937_64& random, uint64_t nKeyRange)
+{
+    for (size_t i = 0, n = m.size(); i < n; ++i)
+    {
+        const map_type::iterator itBound = m.lower_bound(random() % nKeyRange);
+        m.erase((itBound != m.end()) ? itBound : m.begin());
+        m.insert(map_type::value_type(random() % nKeyRange, i));
+    }
+}
+
+static void ApplyOneByOne(map_type& m, const std::vector<batch_op>& ops)
+{
+    for (size_t i = 0; i < ops.size(); ++i)
+    {
+        if (ops[i].mbErase)
+            m.erase(ops[i].mValue.first);
+        else
+        {
+            const easy::pair<map_type::iterator, bool> result = m.insert(ops[i].mValue);
+            if (!result.second)
+                result.first->second = ops[i].mValue.second;
+        }
+    }
+}
+
+
+static void RunCase(size_t n, size_t nPerMille)
+{
+    const uint64_t  nKeyRange = 4 * (uint64_t)n;
+    const size_t    nBatch = ((n * nPerMille) / 1000) ? ((n * nPerMille) / 1000) : 1;
+    std::mt19937_64 random(n);
+    map_type        loop;
+
+    while (loop.size() < n)
+        loop.insert(map_type::value_type(random() % nKeyRange, loop.size()));
+    Churn(loop, random, nKeyRange);
+
+    map_type batch(loop);
+    Churn(batch, random, nKeyRange);
+
+    std::vector<batch_op> ops(nBatch, batch_op::erase(map_type::value_type(nKeyRange, 0))); // Keys past the range, out of order.
+    for (size_t i = 0; i < nBatch; i += 2)
+        ops[i].mValue.first = nKeyRange + 1;
+    batch.apply_batch(ops.begin(), ops.end());
+    ApplyOneByOne(loop, ops);
+
+    for (size_t i = 0; i < nBatch; ++i)
+    {
+        const map_type::value_type value(random() % nKeyRange, i);
+        ops[i] = (random() & 1) ? batch_op::erase(value) : batch_op::upsert(value);
+    }
+
+    const double loopNs = TimeNs([&]() { ApplyOneByOne(loop, ops); });
+    const double batchNs = TimeNs([&]() { batch.apply_batch(ops.begin(), ops.end()); });
+
+    printf("%-10s %10u %10u %12.2f\n", "loop", (unsigned)n, (unsigned)nBatch, loopNs / nBatch);
+    printf("%-10s %10u %10u %12.2f\n", "batch", (unsigned)n, (unsigned)nBatch, batchNs / nBatch);
+}
+
+
+static std::vector<size_t> SplitSizes(const char* p)
+{
+    std::vector<size_t> sizes;
+
+    while (*p)
+    {
+        char* pEnd;
+        sizes.push_back((size_t)strtoull(p, &pEnd, 10));
+        p = (*pEnd == ',') ? (pEnd + 1) : pEnd;
+    }
+
+    return sizes;
+}
+
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> sizes = SplitSizes("100000,1000000");
+    std::vector<size_t> batches = SplitSizes("1,16,250,1000,2000");
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if ((strcmp(argv[i], "--sizes") == 0) && ((i + 1) < argc))
+            sizes = SplitSizes(argv[++i]);
+        else if ((strcmp(argv[i], "--batches") == 0) && ((i + 1) < argc))
+            batches = SplitSizes(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [--sizes 100000,...] [--batches 1,...]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("%-10s %10s %10s %12s\n", "impl", "size", "batch", "ns/op");
+
+    for (size_t s = 0; s < sizes.size(); ++s)
+    {
+        for (size_t b = 0; b < batches.size(); ++b)
+            RunCase(sizes[s], batches[b]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,235 @@
+// BitmapSetBenchmark.cpp : easy::bitmap_set against easy::set<uint32_t>
+//
+// Standalone, builds on Linux with just a compiler:
+//
+//     g++ -O2 -std=c++11 -I../TestCpp.Shared BitmapSetBenchmark.cpp -o BitmapSetBenchmark
+//
+// Usage:
+//     BitmapSetBenchmark [--sizes 100000,1000000,...]
+//
+// Every case builds two sets of the given size, as document id sets would be,
+// with the ids spread in one of these ways:
+//
+//     sparse    random over all 32-bit values, so chunks hold a few ids each
+//     medium    random over 16 times the size: arrays of a few thousand ids
+//     dense     random over twice the size: half full bitsets
+//     runs      ranges of 1000 consecutive ids at random places in 64 times the size
+//
+// and reports, per id, the bytes the set takes and the time to build it from an
+// unsorted vector, to find every id, to iterate, and to intersect the two sets
+// and count the intersection. The bytes of easy::set are its nodes rounded up to
+// glibc's 16-byte chunks with their 8-byte header; the bitmap is optimize()d
+// after it is built. easy::set intersects with a merge of the two iterations.
+//
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "BitmapSet.h"
+#include "Set.h"
+
+
+typedef easy::set<uint32_t>        tree_set;
+typedef easy::bitmap_set<uint32_t> bitmap_set;
+
+// Keeps the optimizer from dropping the lookups.
+static volatile size_t gSink = 0;
+
+template <typename Function>
+static double TimeNs(Function f)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    f();
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::vector<uint32_t> MakeIds(size_t n, const char* pShape, std::mt19937_64& random)
+{
+    std::vector<uint32_t> ids;
+    ids.reserve(n);
+
+    if (strcmp(pShape, "runs") == 0)
+    {
+        const uint64_t nRange = 64 * (uint64_t)n;
+        while (ids.size() < n)
+        {
+            const uint32_t nFirst = (uint32_t)(random() % nRange);
+            for (uint32_t i = 0; (i < 1000) && (ids.size() < n); ++i)
+                ids.push_back(nFirst + i);
+        }
+    }
+    else
+    {
+        const uint64_t nRange = (strcmp(pShape, "sparse") == 0) ? 0x100000000ULL : (((strcmp(pShape, "medium") == 0) ? 16 : 2) * (uint64_t)n);
+        while (ids.size() < n)
+            ids.push_back((uint32_t)(random() % nRange));
+    }
+
+    std::shuffle(ids.begin(), ids.end(), random);
+    return ids;
+}
+
+static size_t TreeIntersectionSize(const tree_set& a, const tree_set& b)
+{
+    size_t nCount = 0;
+    tree_set::const_iterator itA = a.begin(), itB = b.begin();
+
+    while ((itA != a.end()) && (itB != b.end()))
+    {
+        if (*itA < *itB)
+            ++itA;
+        else if (*itB < *itA)
+            ++itB;
+        else
+        {
+            ++nCount;
+            ++itA;
+            ++itB;
+        }
+    }
+
+    return nCount;
+}
+
+static tree_set TreeIntersection(const tree_set& a, const tree_set& b)
+{
+    tree_set result;
+    tree_set::const_iterator itA = a.begin(), itB = b.begin();
+
+    while ((itA != a.end()) && (itB != b.end()))
+    {
+        if (*itA < *itB)
+            ++itA;
+        else if (*itB < *itA)
+            ++itB;
+        else
+        {
+            result.insert(result.end(), *itA);
+            ++itA;
+            ++itB;
+        }
+    }
+
+    return result;
+}
+
+
+static void Report(const char* pImpl, const char* pShape, size_t nIds, double bytes, double buildNs, double findNs, double iterateNs, double andNs, double countNs)
+{
+    const double n = (double)nIds;
+    printf("%-7s %-7s %10u %8.2f %9.2f %9.2f %9.2f %9.2f %9.2f\n", pImpl, pShape, (unsigned)nIds,
+        bytes / n, buildNs / n, findNs / n, iterateNs / n, andNs / n, countNs / n);
+}
+
+
+static void RunCase(size_t n, const char* pShape)
+{
+    std::mt19937_64             random(n);
+    const std::vector<uint32_t> idsA(MakeIds(n, pShape, random));
+    const std::vector<uint32_t> idsB(MakeIds(n, pShape, random));
+
+    {
+        tree_set a, b;
+        const double buildNs = TimeNs([&]() { a.insert(idsA.begin(), idsA.end()); });
+        b.insert(idsB.begin(), idsB.end());
+
+        const double findNs = TimeNs([&]()
+        {
+            size_t nFound = 0;
+            for (size_t i = 0; i < idsA.size(); ++i)
+                nFound += (a.find(idsA[i]) != a.end());
+            gSink = gSink + nFound;
+        });
+
+        const double iterateNs = TimeNs([&]()
+        {
+            size_t nSum = 0;
+            for (tree_set::const_iterator it = a.begin(); it != a.end(); ++it)
+                nSum += *it;
+            gSink = gSink + nSum;
+        });
+
+        const double andNs = TimeNs([&]() { gSink = gSink + TreeIntersection(a, b).size(); });
+        const double countNs = TimeNs([&]() { gSink = gSink + TreeIntersectionSize(a, b); });
+
+        const size_t nNodeBytes = (sizeof(tree_set::node_type) + 8 + 15) & ~(size_t)15;
+        Report("set", pShape, a.size(), (double)(sizeof(a) + a.size() * nNodeBytes), buildNs, findNs, iterateNs, andNs, countNs);
+    }
+
+    {
+        bitmap_set a, b;
+        const double buildNs = TimeNs([&]() { a.insert(idsA.begin(), idsA.end()); a.optimize(); });
+        b.insert(idsB.begin(), idsB.end());
+        b.optimize();
+
+        const double findNs = TimeNs([&]()
+        {
+            size_t nFound = 0;
+            for (size_t i = 0; i < idsA.size(); ++i)
+                nFound += (a.find(idsA[i]) != a.end());
+            gSink = gSink + nFound;
+        });
+
+        const double iterateNs = TimeNs([&]()
+        {
+            size_t nSum = 0;
+            for (bitmap_set::const_iterator it = a.begin(); it != a.end(); ++it)
+                nSum += *it;
+            gSink = gSink + nSum;
+        });
+
+        const double andNs = TimeNs([&]() { gSink = gSink + (a & b).size(); });
+        const double countNs = TimeNs([&]() { gSink = gSink + a.intersection_size(b); });
+
+        Report("bitmap", pShape, a.size(), (double)a.memory_usage(), buildNs, findNs, iterateNs, andNs, countNs);
+    }
+}
+
+
+static std::vector<size_t> SplitSizes(const char* p)
+{
+    std::vector<size_t> sizes;
+
+    while (*p)
+    {
+        char* pEnd;
+        sizes.push_back((size_t)strtoull(p, &pEnd, 10));
+        p = (*pEnd == ',') ? (pEnd + 1) : pEnd;
+    }
+
+    return sizes;
+}
+
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> sizes = SplitSizes("100000,1000000");
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if ((strcmp(argv[i], "--sizes") == 0) && ((i + 1) < argc))
+            sizes = SplitSizes(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [--sizes 100000,...]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("%-7s %-7s %10s %8s %9s %9s %9s %9s %9s\n", "impl", "ids", "size", "B/id", "ns/build", "ns/find", "ns/iter", "ns/and", "ns/count");
+
+    const char* const shapes[] = { "sparse", "medium", "dense", "runs" };
+    for (size_t s = 0; s < sizes.size(); ++s)
+    {
+        for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); ++i)
+            RunCase(sizes[s], shapes[i]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,181 @@
+// CompactBenchmark.cpp : in-order scan of easy::map before and after compact()
+//
+// Standalone, builds on Linux with just a compiler:
+//
+//     g++ -O2 -std=c++11 -I../TestCpp.Shared CompactBenchmark.cpp -o CompactBenchmark
+//
+// Usage:
+//     CompactBenchmark [--sizes 100000,1000000,...] [--churn 4]
+//
+// Every case builds a map of the given size by inserting random keys, then churns
+// it, --churn times its size, by erasing a random element and inserting a new key,
+// which leaves the nodes spread across the heap in no particular order. It then
+// times an iterator loop and for_each over the map, compacts it, and times them
+// again. The rows are:
+//
+//     fresh      a map of the same keys inserted in order into a new heap region,
+//                the layout compact aims for
+//     churned    the churned map
+//     compacted  the churned map after compact()
+//     stepped    the churned map after compact_step() in steps of 256
+//
+// compact and compact_step also report their own time per element. With glibc's
+// malloc, each step of compact_step reuses the blocks freed by the step before it,
+// so only compact restores the fresh layout.
+//
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "Map.h"
+
+
+typedef easy::map<uint64_t, uint64_t> map_type;
+
+// Keeps the optimizer from dropping the scans.
+static volatile uint64_t gSink = 0;
+
+template <typename Function>
+static double TimeNs(Function f)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    f();
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Runs f three times and returns the fastest, in ns.
+template <typename Function>
+static double BestNs(Function f)
+{
+    double best = TimeNs(f);
+    for (int i = 0; i < 2; ++i)
+        best = std::min(best, TimeNs(f));
+    return best;
+}
+
+static void ReportScan(const char* pLayout, map_type& m)
+{
+    const double iterateNs = BestNs([&]()
+    {
+        uint64_t nSum = 0;
+        for (map_type::iterator it = m.begin(); it != m.end(); ++it)
+            nSum += it->second;
+        gSink = gSink + nSum;
+    });
+
+    const double forEachNs = BestNs([&]()
+    {
+        uint64_t nSum = 0;
+        m.for_each([&](const easy::pair<uint64_t, uint64_t>& x) { nSum += x.second; });
+        gSink = gSink + nSum;
+    });
+
+    printf("%-10s %10u %12.2f %12.2f\n", pLayout, (unsigned)m.size(), iterateNs / m.size(), forEachNs / m.size());
+}
+
+
+static void RunCase(size_t n, size_t nChurn)
+{
+    std::mt19937_64 random(n);
+    map_type        m;
+
+    while (m.size() < n)
+        m.insert(map_type::value_type(random(), m.size()));
+
+    // Each round erases a random element, found by a random key's lower bound.
+    for (size_t i = 0; i < (nChurn * n); ++i)
+    {
+        map_type::iterator it = m.lower_bound(random());
+        if (it == m.end())
+            it = m.begin();
+        m.erase(it);
+        m.insert(map_type::value_type(random(), i));
+    }
+
+    {
+        std::vector<uint64_t> keys;
+        keys.reserve(n);
+        for (map_type::iterator it = m.begin(); it != m.end(); ++it)
+            keys.push_back(it->first);
+
+        map_type fresh;
+        for (size_t i = 0; i < keys.size(); ++i)
+            fresh.insert(map_type::value_type(keys[i], i));
+        ReportScan("fresh", fresh);
+    }
+
+    ReportScan("churned", m);
+
+    map_type stepped(m); // Copied in key order, then churned again below to match m.
+
+    const double compactNs = TimeNs([&]() { m.compact(); });
+    ReportScan("compacted", m);
+
+    for (size_t i = 0; i < (nChurn * n); ++i)
+    {
+        map_type::iterator it = stepped.lower_bound(random());
+        if (it == stepped.end())
+            it = stepped.begin();
+        stepped.erase(it);
+        stepped.insert(map_type::value_type(random(), i));
+    }
+
+    const double stepNs = TimeNs([&]()
+    {
+        map_type::iterator it = stepped.begin();
+        do
+            it = stepped.compact_step(it, 256);
+        while (it != stepped.end());
+    });
+    ReportScan("stepped", stepped);
+
+    printf("%-10s %10u %12.2f ns/element for compact, %.2f for compact_step\n", "", (unsigned)n, compactNs / n, stepNs / n);
+}
+
+
+static std::vector<size_t> SplitSizes(const char* p)
+{
+    std::vector<size_t> sizes;
+
+    while (*p)
+    {
+        char* pEnd;
+        sizes.push_back((size_t)strtoull(p, &pEnd, 10));
+        p = (*pEnd == ',') ? (pEnd + 1) : pEnd;
+    }
+
+    return sizes;
+}
+
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> sizes = SplitSizes("100000,1000000");
+    size_t              nChurn = 4;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if ((strcmp(argv[i], "--sizes") == 0) && ((i + 1) < argc))
+            sizes = SplitSizes(argv[++i]);
+        else if ((strcmp(argv[i], "--churn") == 0) && ((i + 1) < argc))
+            nChurn = (size_t)atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [--sizes 100000,...] [--churn 4]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("%-10s %10s %12s %12s\n", "layout", "size", "ns/iterate", "ns/for_each");
+
+    for (size_t s = 0; s < sizes.size(); ++s)
+        RunCase(sizes[s], nChurn);
+
+    return 0;
+}
@@ -0,0 +1,148 @@
+// DiffBenchmark.cpp : easy::diff and easy::parallel_diff against a find per element
+//
+// Standalone, builds on Linux with just a compiler:
+//
+//     g++ -O2 -std=c++11 -pthread -I../TestCpp.Shared DiffBenchmark.cpp -o DiffBenchmark
+//
+// Usage:
+//     DiffBenchmark [--sizes 100000,1000000,...] [--threads 0]
+//
+// Every case builds a map of the given size with random 64-bit keys and a copy
+// in which 1% of the keys were removed, 1% added and 1% changed, and reports
+// per element of the two maps the time to compute the difference by calling
+// find on the other map for each element of both, with diff, and with
+// parallel_diff on --threads threads (0 means one per hardware thread).
+//
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "Map.h"
+#include "MapDiff.h"
+
+
+typedef easy::map<uint64_t, uint64_t> tree_map;
+
+// Keeps the optimizer from dropping the work.
+static volatile size_t gSink = 0;
+
+template <typename Function>
+static double TimeNs(Function f)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    f();
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static size_t FindDiff(const tree_map& a, const tree_map& b)
+{
+    size_t nChanges = 0;
+
+    for (tree_map::const_iterator it = a.begin(); it != a.end(); ++it)
+    {
+        const tree_map::const_iterator itB = b.find(it->first);
+        nChanges += (itB == b.end()) || (itB->second != it->second);
+    }
+
+    for (tree_map::const_iterator it = b.begin(); it != b.end(); ++it)
+        nChanges += (a.find(it->first) == a.end());
+
+    return nChanges;
+}
+
+
+static void RunCase(size_t n, size_t nThreads)
+{
+    std::mt19937_64 random(n);
+    tree_map        a;
+
+    while (a.size() < n)
+        a.insert(easy::make_pair((uint64_t)random(), (uint64_t)a.size()));
+
+    tree_map b(a);
+    for (size_t i = 0; i < n / 100; ++i)
+    {
+        b.erase(b.lower_bound(random()));
+        b.insert(easy::make_pair((uint64_t)random(), (uint64_t)i));
+        tree_map::iterator it = b.lower_bound(random());
+        if (it != b.end())
+            it->second += 1;
+    }
+
+    size_t nFind = 0, nDiff = 0;
+    std::atomic<size_t> nParallel(0);
+
+    const double findNs = TimeNs([&]() { nFind = FindDiff(a, b); });
+
+    const double diffNs = TimeNs([&]()
+    {
+        easy::diff(a, b,
+            [&nDiff](const tree_map::value_type&) { ++nDiff; },
+            [&nDiff](const tree_map::value_type&) { ++nDiff; },
+            [&nDiff](const tree_map::value_type&, const tree_map::value_type&) { ++nDiff; });
+    });
+
+    const double parallelNs = TimeNs([&]()
+    {
+        easy::parallel_diff(a, b,
+            [&nParallel](const tree_map::value_type&) { nParallel.fetch_add(1, std::memory_order_relaxed); },
+            [&nParallel](const tree_map::value_type&) { nParallel.fetch_add(1, std::memory_order_relaxed); },
+            [&nParallel](const tree_map::value_type&, const tree_map::value_type&) { nParallel.fetch_add(1, std::memory_order_relaxed); },
+            nThreads);
+    });
+
+    if ((nFind != nDiff) || (nDiff != nParallel.load()))
+        fprintf(stderr, "mismatch: find %u diff %u parallel %u\n", (unsigned)nFind, (unsigned)nDiff, (unsigned)nParallel.load());
+    gSink = gSink + nDiff;
+
+    const double nElements = (double)(a.size() + b.size());
+    printf("%10u %8u %10.2f %10.2f %10.2f\n", (unsigned)n, (unsigned)nDiff, findNs / nElements, diffNs / nElements, parallelNs / nElements);
+}
+
+
+static std::vector<size_t> SplitSizes(const char* p)
+{
+    std::vector<size_t> sizes;
+
+    while (*p)
+    {
+        char* pEnd;
+        sizes.push_back((size_t)strtoull(p, &pEnd, 10));
+        p = (*pEnd == ',') ? (pEnd + 1) : pEnd;
+    }
+
+    return sizes;
+}
+
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> sizes = SplitSizes("100000,1000000");
+    size_t              nThreads = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if ((strcmp(argv[i], "--sizes") == 0) && ((i + 1) < argc))
+            sizes = SplitSizes(argv[++i]);
+        else if ((strcmp(argv[i], "--threads") == 0) && ((i + 1) < argc))
+            nThreads = (size_t)atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [--sizes 100000,...] [--threads 0]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("%10s %8s %10s %10s %10s\n", "size", "changes", "ns/find", "ns/diff", "ns/par");
+
+    for (size_t s = 0; s < sizes.size(); ++s)
+        RunCase(sizes[s], nThreads);
+
+    return 0;
+}
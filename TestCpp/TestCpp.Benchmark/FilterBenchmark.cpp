@@ -0,0 +1,136 @@
+// FilterBenchmark.cpp : easy::map with and without a filtered_compare, on lookups that mostly miss
+//
+// Standalone, builds on Linux with just a compiler:
+//
+//     g++ -O2 -std=c++11 -I../TestCpp.Shared FilterBenchmark.cpp -o FilterBenchmark
+//
+// Usage:
+//     FilterBenchmark [--sizes 100000,1000000,...] [--hits 20]
+//
+// Every case fills a map with the given number of random 64-bit keys and then
+// finds as many keys in random order, of which --hits percent are in the map.
+// It reports per key the time to insert, to find, and to erase every key again,
+// the filter's bytes per key, and the fraction of the absent keys that passed
+// the filter.
+//
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "Map.h"
+#include "RbTreeFilter.h"
+
+
+typedef easy::map<uint64_t, uint64_t>                                        plain_map;
+typedef easy::map<uint64_t, uint64_t, easy::filtered_compare<uint64_t> >     filtered_map;
+
+// Keeps the optimizer from dropping the lookups.
+static volatile size_t gSink = 0;
+
+template <typename Function>
+static double TimeNs(Function f)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    f();
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+template <typename Map>
+static void RunMap(const char* pImpl, const std::vector<uint64_t>& keys, const std::vector<uint64_t>& probes)
+{
+    Map map;
+
+    const double insertNs = TimeNs([&]()
+    {
+        for (size_t i = 0; i < keys.size(); ++i)
+            map.insert(easy::make_pair(keys[i], (uint64_t)i));
+    });
+
+    map.reset_counters();
+
+    const double findNs = TimeNs([&]()
+    {
+        size_t nFound = 0;
+        for (size_t i = 0; i < probes.size(); ++i)
+            nFound += (map.find(probes[i]) != map.end());
+        gSink = gSink + nFound;
+    });
+
+    const easy::rbtree_stats s = map.stats();
+    const size_t             nAbsent = s.filter_negatives + s.filter_false_positives;
+
+    const double eraseNs = TimeNs([&]()
+    {
+        for (size_t i = 0; i < keys.size(); ++i)
+            map.erase(keys[i]);
+    });
+
+    const double n = (double)keys.size();
+    printf("%-9s %10u %9.2f %9.2f %9.2f %8.2f %8.4f\n", pImpl, (unsigned)keys.size(), insertNs / n, findNs / (double)probes.size(),
+        eraseNs / n, (double)s.filter_bytes / n, nAbsent ? ((double)s.filter_false_positives / nAbsent) : 0.0);
+}
+
+
+static void RunCase(size_t n, unsigned nHitPercent)
+{
+    std::mt19937_64       random(n);
+    std::vector<uint64_t> keys, probes;
+
+    for (size_t i = 0; i < n; ++i)
+        keys.push_back(random());
+
+    for (size_t i = 0; i < n; ++i)
+        probes.push_back(((random() % 100) < nHitPercent) ? keys[random() % n] : random());
+
+    RunMap<plain_map>("map", keys, probes);
+    RunMap<filtered_map>("filtered", keys, probes);
+}
+
+
+static std::vector<size_t> SplitSizes(const char* p)
+{
+    std::vector<size_t> sizes;
+
+    while (*p)
+    {
+        char* pEnd;
+        sizes.push_back((size_t)strtoull(p, &pEnd, 10));
+        p = (*pEnd == ',') ? (pEnd + 1) : pEnd;
+    }
+
+    return sizes;
+}
+
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> sizes = SplitSizes("100000,1000000");
+    unsigned            nHitPercent = 20;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if ((strcmp(argv[i], "--sizes") == 0) && ((i + 1) < argc))
+            sizes = SplitSizes(argv[++i]);
+        else if ((strcmp(argv[i], "--hits") == 0) && ((i + 1) < argc))
+            nHitPercent = (unsigned)atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [--sizes 100000,...] [--hits 20]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("%-9s %10s %9s %9s %9s %8s %8s\n", "impl", "keys", "ns/insert", "ns/find", "ns/erase", "B/key", "fp rate");
+
+    for (size_t s = 0; s < sizes.size(); ++s)
+        RunCase(sizes[s], nHitPercent);
+
+    return 0;
+}
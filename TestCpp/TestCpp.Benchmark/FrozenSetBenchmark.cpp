@@ -0,0 +1,187 @@
+// FrozenSetBenchmark.cpp : easy::frozen_set against easy::set<uint64_t> and a sorted vector
+//
+// Standalone, builds on Linux with just a compiler:
+//
+//     g++ -O2 -std=c++11 -I../TestCpp.Shared FrozenSetBenchmark.cpp -o FrozenSetBenchmark
+//
+// Usage:
+//     FrozenSetBenchmark [--sizes 100000,1000000,...]
+//
+// Every case draws the given number of random ids, spread in one of two ways:
+//
+//     dense     over 4 times the number of ids, like a posting list of a common term
+//     sparse    over 2^40, like random 64-bit ids with their high bits in common
+//
+// and reports, per id, the bytes each representation takes and the time to
+// lower_bound every id in random order, to iterate with iterators, and, for
+// frozen_set, to decode with for_each. The bytes of easy::set are its nodes
+// rounded up to glibc's 16-byte chunks with their 8-byte header; frozen_set's
+// are its whole image, which is also the size of the file it writes.
+//
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "FrozenSet.h"
+#include "Set.h"
+
+
+typedef easy::set<uint64_t>        tree_set;
+typedef easy::frozen_set<uint64_t> frozen_set;
+
+// Keeps the optimizer from dropping the lookups.
+static volatile uint64_t gSink = 0;
+
+template <typename Function>
+static double TimeNs(Function f)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    f();
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void Report(const char* pImpl, const char* pShape, size_t nIds, double bytes, double seekNs, double iterateNs, double decodeNs)
+{
+    const double n = (double)nIds;
+    printf("%-7s %-7s %10u %8.2f %10.2f %10.2f", pImpl, pShape, (unsigned)nIds, bytes / n, seekNs / n, iterateNs / n);
+    if (decodeNs >= 0)
+        printf(" %10.2f", decodeNs / n);
+    printf("\n");
+}
+
+
+static void RunCase(size_t n, const char* pShape)
+{
+    std::mt19937_64       random(n);
+    const uint64_t        nRange = (strcmp(pShape, "dense") == 0) ? (4 * (uint64_t)n) : (1ULL << 40);
+    std::vector<uint64_t> ids;
+
+    for (size_t i = 0; i < n; ++i)
+        ids.push_back(random() % nRange);
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    std::vector<uint64_t> probes(ids);
+    std::shuffle(probes.begin(), probes.end(), random);
+
+    tree_set tree;
+    for (size_t i = 0; i < ids.size(); ++i)
+        tree.insert(tree.end(), ids[i]);
+    const frozen_set frozen(tree.begin(), tree.end());
+
+    {
+        const double seekNs = TimeNs([&]()
+        {
+            uint64_t nSum = 0;
+            for (size_t i = 0; i < probes.size(); ++i)
+                nSum += *tree.lower_bound(probes[i]);
+            gSink = gSink + nSum;
+        });
+
+        const double iterateNs = TimeNs([&]()
+        {
+            uint64_t nSum = 0;
+            for (tree_set::const_iterator it = tree.begin(); it != tree.end(); ++it)
+                nSum += *it;
+            gSink = gSink + nSum;
+        });
+
+        const size_t nNodeBytes = (sizeof(tree_set::node_type) + 8 + 15) & ~(size_t)15;
+        Report("set", pShape, ids.size(), (double)(ids.size() * nNodeBytes), seekNs, iterateNs, -1);
+    }
+
+    {
+        const double seekNs = TimeNs([&]()
+        {
+            uint64_t nSum = 0;
+            for (size_t i = 0; i < probes.size(); ++i)
+                nSum += *std::lower_bound(ids.begin(), ids.end(), probes[i]);
+            gSink = gSink + nSum;
+        });
+
+        const double iterateNs = TimeNs([&]()
+        {
+            uint64_t nSum = 0;
+            for (size_t i = 0; i < ids.size(); ++i)
+                nSum += ids[i];
+            gSink = gSink + nSum;
+        });
+
+        Report("vector", pShape, ids.size(), (double)(ids.size() * sizeof(uint64_t)), seekNs, iterateNs, -1);
+    }
+
+    {
+        const double seekNs = TimeNs([&]()
+        {
+            uint64_t nSum = 0;
+            for (size_t i = 0; i < probes.size(); ++i)
+                nSum += *frozen.lower_bound(probes[i]);
+            gSink = gSink + nSum;
+        });
+
+        const double iterateNs = TimeNs([&]()
+        {
+            uint64_t nSum = 0;
+            for (frozen_set::const_iterator it = frozen.begin(); it != frozen.end(); ++it)
+                nSum += *it;
+            gSink = gSink + nSum;
+        });
+
+        const double decodeNs = TimeNs([&]()
+        {
+            uint64_t nSum = 0;
+            frozen.for_each([&nSum](uint64_t id) { nSum += id; });
+            gSink = gSink + nSum;
+        });
+
+        Report("frozen", pShape, ids.size(), (double)frozen.data_size(), seekNs, iterateNs, decodeNs);
+    }
+}
+
+
+static std::vector<size_t> SplitSizes(const char* p)
+{
+    std::vector<size_t> sizes;
+
+    while (*p)
+    {
+        char* pEnd;
+        sizes.push_back((size_t)strtoull(p, &pEnd, 10));
+        p = (*pEnd == ',') ? (pEnd + 1) : pEnd;
+    }
+
+    return sizes;
+}
+
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> sizes = SplitSizes("100000,1000000");
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if ((strcmp(argv[i], "--sizes") == 0) && ((i + 1) < argc))
+            sizes = SplitSizes(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [--sizes 100000,...]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("%-7s %-7s %10s %8s %10s %10s %10s\n", "impl", "ids", "size", "B/id", "ns/seek", "ns/iter", "ns/decode");
+
+    for (size_t s = 0; s < sizes.size(); ++s)
+    {
+        RunCase(sizes[s], "dense");
+        RunCase(sizes[s], "sparse");
+    }
+
+    return 0;
+}
@@ -0,0 +1,241 @@
+// LruCacheBenchmark.cpp : easy::lru_cache hit path benchmark
+//
+// Standalone, builds on Linux with just a compiler:
+//
+//     g++ -O2 -std=c++11 -pthread -I../TestCpp.Shared LruCacheBenchmark.cpp -o LruCacheBenchmark
+//
+// Usage:
+//     LruCacheBenchmark [--sizes 1000,100000,...] [--threads 4]
+//
+// Every case fills a cache of the given capacity and then times lookups of keys
+// which are all cached, in random order, so that every lookup is a hit which moves
+// the entry to the front. Each case runs twice and reports the second run, so that
+// all implementations use heap memory which the process has touched before; the
+// first run of the first case is otherwise much slower. The implementations are:
+//
+//     lru       easy::lru_cache, whose recency list runs through the map nodes
+//     maplist   easy::map of value + std::list iterator, and a std::list of keys,
+//               the cache this replaces
+//     sharded   easy::sharded_lru_cache from one thread
+//     sharded*N easy::sharded_lru_cache from --threads threads at once; the time
+//               is per lookup of one thread
+//
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <list>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "LruCache.h"
+#include "Map.h"
+
+
+///////////////////////////////////////////////////////////////////////
+// Implementations
+///////////////////////////////////////////////////////////////////////
+
+// The hand rolled cache: two allocations per entry, and a hit goes from the map
+// node to the list node.
+class MapListCache
+{
+public:
+    explicit MapListCache(size_t nCapacity) : mnCapacity(nCapacity) {}
+
+    uint64_t* get(uint64_t key)
+    {
+        map_type::iterator it = mMap.find(key);
+        if (it == mMap.end())
+            return NULL;
+
+        mRecent.splice(mRecent.begin(), mRecent, it->second.second);
+        return &it->second.first;
+    }
+
+    void put(uint64_t key, uint64_t value)
+    {
+        if (uint64_t* p = get(key))
+        {
+            *p = value;
+            return;
+        }
+
+        if (mMap.size() >= mnCapacity)
+        {
+            mMap.erase(mRecent.back());
+            mRecent.pop_back();
+        }
+
+        mRecent.push_front(key);
+        mMap.insert(easy::make_pair(key, easy::make_pair(value, mRecent.begin())));
+    }
+
+private:
+    typedef easy::map<uint64_t, easy::pair<uint64_t, std::list<uint64_t>::iterator> > map_type;
+
+    map_type            mMap;
+    std::list<uint64_t> mRecent;
+    size_t              mnCapacity;
+};
+
+
+///////////////////////////////////////////////////////////////////////
+// Benchmark
+///////////////////////////////////////////////////////////////////////
+
+// Keeps the optimizer from dropping the lookups.
+static volatile uint64_t gSink = 0;
+
+static const size_t kLookupCount = 4000000;
+
+static uint64_t MakeKey(size_t i)
+{
+    return (uint64_t)i * 0x9E3779B97F4A7C15ull;
+}
+
+static std::vector<uint64_t> MakeLookups(size_t nCapacity, unsigned nSeed)
+{
+    std::vector<uint64_t> lookups(kLookupCount);
+    std::mt19937_64       random(nSeed);
+
+    for (size_t i = 0; i < kLookupCount; ++i)
+        lookups[i] = MakeKey((size_t)(random() % nCapacity));
+
+    return lookups;
+}
+
+template <typename Function>
+static double TimeNs(Function f)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    f();
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void Report(const char* pImpl, size_t nCapacity, double ns)
+{
+    printf("%-10s %10llu %12.2f\n", pImpl, (unsigned long long)nCapacity, ns / kLookupCount);
+}
+
+
+template <typename Cache>
+static double RunSingleOnce(size_t nCapacity)
+{
+    Cache cache(nCapacity);
+    for (size_t i = 0; i < nCapacity; ++i)
+        cache.put(MakeKey(i), i);
+
+    const std::vector<uint64_t> lookups(MakeLookups(nCapacity, 1));
+
+    return TimeNs([&]()
+    {
+        uint64_t nSum = 0;
+        for (size_t i = 0; i < kLookupCount; ++i)
+            nSum += *cache.get(lookups[i]);
+        gSink = gSink + nSum;
+    });
+}
+
+template <typename Cache>
+static void RunSingle(const char* pImpl, size_t nCapacity)
+{
+    RunSingleOnce<Cache>(nCapacity);
+    Report(pImpl, nCapacity, RunSingleOnce<Cache>(nCapacity));
+}
+
+
+static double RunShardedOnce(size_t nCapacity, size_t nThreads)
+{
+    easy::sharded_lru_cache<uint64_t, uint64_t> cache(nCapacity + (nCapacity / 2)); // Room for the unevenly filled shards.
+    for (size_t i = 0; i < nCapacity; ++i)
+        cache.put(MakeKey(i), i);
+
+    std::vector<std::vector<uint64_t> > lookups;
+    for (size_t t = 0; t < nThreads; ++t)
+        lookups.push_back(MakeLookups(nCapacity, (unsigned)(t + 1)));
+
+    return TimeNs([&]()
+    {
+        std::vector<std::thread> threads;
+
+        for (size_t t = 0; t < nThreads; ++t)
+        {
+            const std::vector<uint64_t>* const pLookups = &lookups[t];
+
+            threads.push_back(std::thread([&cache, pLookups]()
+            {
+                uint64_t nSum = 0, nValue = 0;
+                for (size_t i = 0; i < kLookupCount; ++i)
+                    nSum += cache.get((*pLookups)[i], nValue) ? nValue : 0;
+                gSink = gSink + nSum;
+            }));
+        }
+
+        for (size_t t = 0; t < threads.size(); ++t)
+            threads[t].join();
+    });
+}
+
+static void RunSharded(size_t nCapacity, size_t nThreads)
+{
+    RunShardedOnce(nCapacity, nThreads);
+    const double ns = RunShardedOnce(nCapacity, nThreads);
+
+    char name[32];
+    snprintf(name, sizeof(name), (nThreads == 1) ? "sharded" : "sharded*%u", (unsigned)nThreads);
+    Report(name, nCapacity, ns);
+}
+
+
+static std::vector<size_t> SplitSizes(const char* p)
+{
+    std::vector<size_t> sizes;
+
+    while (*p)
+    {
+        char* pEnd;
+        sizes.push_back((size_t)strtoull(p, &pEnd, 10));
+        p = (*pEnd == ',') ? (pEnd + 1) : pEnd;
+    }
+
+    return sizes;
+}
+
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> sizes = SplitSizes("1000,100000,1000000");
+    size_t              nThreads = 4;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if ((strcmp(argv[i], "--sizes") == 0) && ((i + 1) < argc))
+            sizes = SplitSizes(argv[++i]);
+        else if ((strcmp(argv[i], "--threads") == 0) && ((i + 1) < argc))
+            nThreads = (size_t)atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [--sizes 1000,...] [--threads 4]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("%-10s %10s %12s\n", "impl", "capacity", "ns/get");
+
+    for (size_t s = 0; s < sizes.size(); ++s)
+    {
+        RunSingle<easy::lru_cache<uint64_t, uint64_t> >("lru", sizes[s]);
+        RunSingle<MapListCache>("maplist", sizes[s]);
+        RunSharded(sizes[s], 1);
+        if (nThreads > 1)
+            RunSharded(sizes[s], nThreads);
+    }
+
+    return 0;
+}
@@ -0,0 +1,552 @@
+// MapBenchmark.cpp : easy::map / std::map / eastl::map / hash map benchmark
+//
+// Standalone, builds on Linux with just a compiler:
+//
+//     g++ -O2 -std=c++11 -I../TestCpp.Shared MapBenchmark.cpp -o MapBenchmark
+//
+// To add eastl::map, build with the EASTL headers and library:
+//
+//     g++ -O2 -std=c++11 -DEASY_BENCH_EASTL -I../TestCpp.Shared -I<eastl>/include MapBenchmark.cpp -L<eastl> -lEASTL -o MapBenchmark
+//
+// Usage:
+//     MapBenchmark [--sizes 1000,10000,...] [--keys int,int64,string,hex,url] [--impls easy,std,prefix,hash,unordered,eastl] [--out file.json]
+//
+// The default sizes go from 1K to 1M; pass e.g. --sizes 100000000 for the large runs.
+// The hex keys differ within their first 8 bytes, and the string and url keys only
+// after that. The prefix implementation (easy::string_map) only runs for these three.
+// hash (easy::hash_map) and unordered (std::unordered_map) run for every key type.
+// Every (implementation, key type, size) case runs the operations below in order on
+// one container, and reports for each the time per element, the number of heap
+// allocations, and the peak RSS of the case. The JSON goes to stdout (or --out) and
+// a readable table goes to stderr.
+//
+//     insert_random, insert_sorted, insert_reverse, find_hit, find_miss,
+//     erase_insert, iterate, copy, erase, clear
+//
+// erase_insert replaces the elements one at a time, erasing a present key and
+// inserting an absent one, on a copy of the container.
+//
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <new>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "HashMap.h"
+#include "Map.h"
+#include "StringMap.h"
+
+#ifdef EASY_BENCH_EASTL
+#include <EASTL/map.h>
+#endif
+
+
+///////////////////////////////////////////////////////////////////////
+// Allocation counting
+///////////////////////////////////////////////////////////////////////
+
+static size_t gAllocations = 0;
+
+void* operator new(size_t n)
+{
+    ++gAllocations;
+    if (void* p = malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t n)
+{
+    ++gAllocations;
+    if (void* p = malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+#ifdef EASY_BENCH_EASTL
+// EASTL's default allocator calls these, and leaves them to the application.
+void* operator new[](size_t n, const char*, int, unsigned, const char*, int)
+{
+    return operator new[](n);
+}
+
+void* operator new[](size_t n, size_t alignment, size_t, const char*, int, unsigned, const char*, int)
+{
+    ++gAllocations;
+    void* p = NULL;
+    if (posix_memalign(&p, (alignment < sizeof(void*)) ? sizeof(void*) : alignment, n ? n : 1) != 0)
+        throw std::bad_alloc();
+    return p;
+}
+#endif
+
+
+///////////////////////////////////////////////////////////////////////
+// Peak RSS
+///////////////////////////////////////////////////////////////////////
+
+// Resets the peak RSS (VmHWM) of the process to its current RSS. Linux 4.0 and later.
+static void ResetPeakRss()
+{
+    if (FILE* f = fopen("/proc/self/clear_refs", "w"))
+    {
+        fputs("5", f);
+        fclose(f);
+    }
+}
+
+static long ReadPeakRssKb()
+{
+    long nKb = -1;
+
+    if (FILE* f = fopen("/proc/self/status", "r"))
+    {
+        char line[256];
+        while (fgets(line, sizeof(line), f))
+        {
+            if (strncmp(line, "VmHWM:", 6) == 0)
+            {
+                nKb = atol(line + 6);
+                break;
+            }
+        }
+        fclose(f);
+    }
+
+    return nKb;
+}
+
+
+///////////////////////////////////////////////////////////////////////
+// Keys
+///////////////////////////////////////////////////////////////////////
+
+// Key i of a case is MakeKey(2 * i), so MakeKey(2 * i + 1) is a guaranteed miss,
+// and the key order is the order of i for every key type.
+template <typename Key>
+struct KeyMaker;
+
+template <>
+struct KeyMaker<int>
+{
+    static const char* Name() { return "int"; }
+    static int MakeKey(size_t n) { return (int)n; }
+};
+
+template <>
+struct KeyMaker<uint64_t>
+{
+    static const char* Name() { return "int64"; }
+    static uint64_t MakeKey(size_t n) { return (uint64_t)n * 0x100000001ull; }
+};
+
+template <>
+struct KeyMaker<std::string>
+{
+    static const char* Name() { return "string"; }
+    static std::string MakeKey(size_t n)
+    {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "key%016llu", (unsigned long long)n);
+        return std::string(buffer);
+    }
+};
+
+// Strings which differ within their first 8 bytes, for up to 8M keys.
+struct HexKeyMaker
+{
+    static const char* Name() { return "hex"; }
+    static std::string MakeKey(size_t n)
+    {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%016llx", (unsigned long long)n << 40);
+        return std::string(buffer);
+    }
+};
+
+// Strings which only differ after a long common prefix.
+struct UrlKeyMaker
+{
+    static const char* Name() { return "url"; }
+    static std::string MakeKey(size_t n)
+    {
+        char buffer[96];
+        snprintf(buffer, sizeof(buffer), "https://www.example.com/api/v2/users/%016llx/profile", (unsigned long long)n);
+        return std::string(buffer);
+    }
+};
+
+
+///////////////////////////////////////////////////////////////////////
+// Implementations
+///////////////////////////////////////////////////////////////////////
+
+template <typename Key>
+struct EasyImpl
+{
+    typedef easy::map<Key, uint64_t> map_type;
+    static const char* Name() { return "easy"; }
+};
+
+template <typename Key>
+struct StdImpl
+{
+    typedef std::map<Key, uint64_t> map_type;
+    static const char* Name() { return "std"; }
+};
+
+struct PrefixImpl
+{
+    typedef easy::string_map<uint64_t> map_type;
+    static const char* Name() { return "prefix"; }
+};
+
+template <typename Key>
+struct HashImpl
+{
+    typedef easy::hash_map<Key, uint64_t> map_type;
+    static const char* Name() { return "hash"; }
+};
+
+template <typename Key>
+struct UnorderedImpl
+{
+    typedef std::unordered_map<Key, uint64_t> map_type;
+    static const char* Name() { return "unordered"; }
+};
+
+#ifdef EASY_BENCH_EASTL
+template <typename Key>
+struct EastlImpl
+{
+    typedef eastl::map<Key, uint64_t> map_type;
+    static const char* Name() { return "eastl"; }
+};
+#endif
+
+
+///////////////////////////////////////////////////////////////////////
+// Benchmark
+///////////////////////////////////////////////////////////////////////
+
+struct Result
+{
+    std::string mImpl;
+    std::string mKey;
+    std::string mOp;
+    size_t      mnSize;
+    double      mNsPerElement;
+    size_t      mnAllocations;
+    long        mnPeakRssKb;
+};
+
+static std::vector<Result> gResults;
+
+// Keeps the optimizer from dropping the work whose result is otherwise unused.
+static volatile uint64_t gSink = 0;
+
+class Timer
+{
+public:
+    Timer() : mnAllocations(gAllocations), mStart(std::chrono::steady_clock::now()) {}
+
+    void Report(const char* pImpl, const char* pKey, const char* pOp, size_t n)
+    {
+        const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        const double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - mStart).count();
+
+        Result r;
+        r.mImpl = pImpl;
+        r.mKey = pKey;
+        r.mOp = pOp;
+        r.mnSize = n;
+        r.mNsPerElement = n ? (ns / n) : 0.0;
+        r.mnAllocations = gAllocations - mnAllocations;
+        r.mnPeakRssKb = -1; // Filled in at the end of the case.
+        gResults.push_back(r);
+    }
+
+private:
+    size_t                                mnAllocations;
+    std::chrono::steady_clock::time_point mStart;
+};
+
+
+template <typename Impl, typename Key, typename KeyMakerType>
+void RunCase(size_t n)
+{
+    typedef typename Impl::map_type  map_type;
+    typedef typename map_type::value_type value_type;
+    typedef KeyMakerType             key_maker;
+
+    const char* const pImpl = Impl::Name();
+    const char* const pKey = key_maker::Name();
+    const size_t      nFirstResult = gResults.size();
+
+    std::vector<Key> sortedKeys;
+    std::vector<Key> missKeys;
+    sortedKeys.reserve(n);
+    missKeys.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        sortedKeys.push_back(key_maker::MakeKey(2 * i));
+        missKeys.push_back(key_maker::MakeKey(2 * i + 1));
+    }
+
+    std::vector<Key> randomKeys(sortedKeys);
+    std::shuffle(randomKeys.begin(), randomKeys.end(), std::mt19937_64(n));
+    std::shuffle(missKeys.begin(), missKeys.end(), std::mt19937_64(n + 1));
+
+    ResetPeakRss();
+
+    {
+        map_type m;
+        Timer    t;
+        for (size_t i = 0; i < n; ++i)
+            m.insert(value_type(randomKeys[i], i));
+        t.Report(pImpl, pKey, "insert_random", n);
+    }
+
+    {
+        map_type m;
+        Timer    t;
+        for (size_t i = 0; i < n; ++i)
+            m.insert(value_type(sortedKeys[i], i));
+        t.Report(pImpl, pKey, "insert_sorted", n);
+    }
+
+    map_type m;
+    {
+        Timer t;
+        for (size_t i = n; i-- > 0; )
+            m.insert(value_type(sortedKeys[i], i));
+        t.Report(pImpl, pKey, "insert_reverse", n);
+    }
+
+    {
+        uint64_t nFound = 0;
+        Timer    t;
+        for (size_t i = 0; i < n; ++i)
+            nFound += (m.find(randomKeys[i]) != m.end()) ? 1 : 0;
+        t.Report(pImpl, pKey, "find_hit", n);
+        gSink = gSink + nFound;
+    }
+
+    {
+        uint64_t nFound = 0;
+        Timer    t;
+        for (size_t i = 0; i < n; ++i)
+            nFound += (m.find(missKeys[i]) != m.end()) ? 1 : 0;
+        t.Report(pImpl, pKey, "find_miss", n);
+        gSink = gSink + nFound;
+    }
+
+    {
+        map_type copy(m);
+        Timer    t;
+        for (size_t i = 0; i < n; ++i)
+        {
+            copy.erase(randomKeys[i]);
+            copy.insert(value_type(missKeys[i], i));
+        }
+        t.Report(pImpl, pKey, "erase_insert", n);
+        gSink = gSink + copy.size();
+    }
+
+    {
+        uint64_t nSum = 0;
+        Timer    t;
+        for (typename map_type::iterator it = m.begin(); it != m.end(); ++it)
+            nSum += it->second;
+        t.Report(pImpl, pKey, "iterate", n);
+        gSink = gSink + nSum;
+    }
+
+    {
+        Timer    t;
+        map_type copy(m);
+        t.Report(pImpl, pKey, "copy", n);
+        gSink = gSink + copy.size();
+    }
+
+    {
+        map_type copy(m);
+        Timer    t;
+        for (size_t i = 0; i < n; ++i)
+            copy.erase(randomKeys[i]);
+        t.Report(pImpl, pKey, "erase", n);
+        gSink = gSink + copy.size();
+    }
+
+    {
+        Timer t;
+        m.clear();
+        t.Report(pImpl, pKey, "clear", n);
+    }
+
+    const long nPeakRssKb = ReadPeakRssKb();
+    for (size_t i = nFirstResult; i < gResults.size(); ++i)
+        gResults[i].mnPeakRssKb = nPeakRssKb;
+}
+
+
+// easy::string_map only takes string keys; the other key types skip it.
+template <typename KeyMakerType>
+void RunPrefixCase(size_t n, std::string*)
+{
+    RunCase<PrefixImpl, std::string, KeyMakerType>(n);
+}
+
+template <typename KeyMakerType, typename Key>
+void RunPrefixCase(size_t, Key*)
+{
+}
+
+
+template <typename Key, typename KeyMakerType>
+void RunKey(const std::vector<std::string>& impls, size_t n)
+{
+    for (size_t i = 0; i < impls.size(); ++i)
+    {
+        if (impls[i] == "easy")
+            RunCase<EasyImpl<Key>, Key, KeyMakerType>(n);
+        else if (impls[i] == "std")
+            RunCase<StdImpl<Key>, Key, KeyMakerType>(n);
+        else if (impls[i] == "prefix")
+            RunPrefixCase<KeyMakerType>(n, (Key*)NULL);
+        else if (impls[i] == "hash")
+            RunCase<HashImpl<Key>, Key, KeyMakerType>(n);
+        else if (impls[i] == "unordered")
+            RunCase<UnorderedImpl<Key>, Key, KeyMakerType>(n);
+#ifdef EASY_BENCH_EASTL
+        else if (impls[i] == "eastl")
+            RunCase<EastlImpl<Key>, Key, KeyMakerType>(n);
+#endif
+        else
+            fprintf(stderr, "skipping unknown or disabled implementation '%s'\n", impls[i].c_str());
+    }
+}
+
+
+static std::vector<std::string> SplitList(const char* p)
+{
+    std::vector<std::string> items;
+    std::string              item;
+
+    for (; *p; ++p)
+    {
+        if (*p == ',')
+        {
+            items.push_back(item);
+            item.clear();
+        } else
+            item += *p;
+    }
+
+    if (!item.empty())
+        items.push_back(item);
+    return items;
+}
+
+
+static void WriteJson(FILE* f)
+{
+    fprintf(f, "{\n  \"benchmark\": \"map\",\n  \"results\": [\n");
+
+    for (size_t i = 0; i < gResults.size(); ++i)
+    {
+        const Result& r = gResults[i];
+        fprintf(f, "    {\"impl\": \"%s\", \"key\": \"%s\", \"op\": \"%s\", \"n\": %llu, "
+                   "\"ns_per_element\": %.3f, \"allocations\": %llu, \"peak_rss_kb\": %ld}%s\n",
+                r.mImpl.c_str(), r.mKey.c_str(), r.mOp.c_str(), (unsigned long long)r.mnSize,
+                r.mNsPerElement, (unsigned long long)r.mnAllocations, r.mnPeakRssKb,
+                ((i + 1) < gResults.size()) ? "," : "");
+    }
+
+    fprintf(f, "  ]\n}\n");
+}
+
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> sizes = SplitList("1000,10000,100000,1000000");
+    std::vector<std::string> keys = SplitList("int,int64,string,hex,url");
+    std::vector<std::string> impls = SplitList("easy,std,prefix,hash,unordered");
+    const char*              pOut = NULL;
+
+#ifdef EASY_BENCH_EASTL
+    impls.push_back("eastl");
+#endif
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if ((strcmp(argv[i], "--sizes") == 0) && ((i + 1) < argc))
+            sizes = SplitList(argv[++i]);
+        else if ((strcmp(argv[i], "--keys") == 0) && ((i + 1) < argc))
+            keys = SplitList(argv[++i]);
+        else if ((strcmp(argv[i], "--impls") == 0) && ((i + 1) < argc))
+            impls = SplitList(argv[++i]);
+        else if ((strcmp(argv[i], "--out") == 0) && ((i + 1) < argc))
+            pOut = argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: %s [--sizes 1000,...] [--keys int,int64,string,hex,url] [--impls easy,std,prefix,hash,unordered,eastl] [--out file.json]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    for (size_t s = 0; s < sizes.size(); ++s)
+    {
+        const size_t n = (size_t)strtoull(sizes[s].c_str(), NULL, 10);
+
+        for (size_t k = 0; k < keys.size(); ++k)
+        {
+            if (keys[k] == "int")
+                RunKey<int, KeyMaker<int> >(impls, n);
+            else if (keys[k] == "int64")
+                RunKey<uint64_t, KeyMaker<uint64_t> >(impls, n);
+            else if (keys[k] == "string")
+                RunKey<std::string, KeyMaker<std::string> >(impls, n);
+            else if (keys[k] == "hex")
+                RunKey<std::string, HexKeyMaker>(impls, n);
+            else if (keys[k] == "url")
+                RunKey<std::string, UrlKeyMaker>(impls, n);
+            else
+                fprintf(stderr, "skipping unknown key type '%s'\n", keys[k].c_str());
+        }
+    }
+
+    fprintf(stderr, "%-9s %-7s %-15s %10s %14s %12s %12s\n", "impl", "key", "op", "n", "ns/element", "allocations", "peak rss kb");
+    for (size_t i = 0; i < gResults.size(); ++i)
+    {
+        const Result& r = gResults[i];
+        fprintf(stderr, "%-9s %-7s %-15s %10llu %14.2f %12llu %12ld\n", r.mImpl.c_str(), r.mKey.c_str(), r.mOp.c_str(),
+                (unsigned long long)r.mnSize, r.mNsPerElement, (unsigned long long)r.mnAllocations, r.mnPeakRssKb);
+    }
+
+    FILE* f = pOut ? fopen(pOut, "w") : stdout;
+    if (!f)
+    {
+        fprintf(stderr, "can't open %s\n", pOut);
+        return 1;
+    }
+
+    WriteJson(f);
+
+    if (pOut)
+        fclose(f);
+    return 0;
+}
@@ -0,0 +1,176 @@
+// MergeBenchmark.cpp : easy::merge_view iteration over several maps
+//
+// Standalone, builds on Linux with just a compiler:
+//
+//     g++ -O2 -std=c++11 -I../TestCpp.Shared MergeBenchmark.cpp -o MergeBenchmark
+//
+// Usage:
+//     MergeBenchmark [--sizes 100000,1000000,...] [--sources 8]
+//
+// Every case spreads the given number of keys over --sources maps, with every
+// tenth key in two of them, and walks a merged_view over all of them with each
+// of the three MergeDuplicates modes. It reports the time per visited element
+// and the heap allocations made while stepping, which should be zero: the view
+// allocates its cursors when the iterator is created and never again. Keys are
+// std::string, 24 characters long so that they don't fit in the small string
+// buffer and any copy of one allocates, and uint64_t.
+//
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include "Map.h"
+#include "MergedView.h"
+
+
+// Counts every allocation the process makes.
+static size_t gnAllocations = 0;
+
+void* operator new(size_t n)
+{
+    ++gnAllocations;
+    if (void* p = malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+
+// Keeps the optimizer from dropping the iteration.
+static volatile size_t gSink = 0;
+
+template <typename Function>
+static double TimeNs(Function f)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    f();
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static uint64_t MakeKey(uint64_t n, uint64_t*)
+{
+    return n;
+}
+
+static std::string MakeKey(uint64_t n, std::string*)
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "key/%020llu", (unsigned long long)n);
+    return std::string(buffer);
+}
+
+static size_t KeySize(uint64_t)             { return 0; }
+static size_t KeySize(const std::string& s) { return s.size(); }
+
+
+template <typename Key>
+static void RunCase(const char* pKeys, size_t n, size_t nSources)
+{
+    typedef easy::map<Key, uint64_t> map_type;
+
+    std::mt19937_64       random(n);
+    std::vector<map_type> sources(nSources);
+
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        const size_t nSource = (size_t)(random() % nSources);
+        sources[nSource].insert(easy::make_pair(MakeKey(i, (Key*)NULL), i));
+        if ((i % 10) == 0)
+            sources[(nSource + 1) % nSources].insert(easy::make_pair(MakeKey(i, (Key*)NULL), i));
+    }
+
+    easy::merge_view<map_type> view;
+    for (size_t s = 0; s < nSources; ++s)
+        view.add(sources[s]);
+
+    static const char* const kModes[] = { "all", "first", "last" };
+    static const easy::MergeDuplicates kDuplicates[] = { easy::kMergeKeepAll, easy::kMergeFirstWins, easy::kMergeLastWins };
+
+    for (size_t m = 0; m < 3; ++m)
+    {
+        view.set_duplicates(kDuplicates[m]);
+
+        size_t nVisited = 0, nAllocations = 0;
+
+        const double ns = TimeNs([&]()
+        {
+            size_t nSum = 0;
+            typename easy::merge_view<map_type>::const_iterator it = view.begin();
+            const typename easy::merge_view<map_type>::const_iterator itEnd = view.end();
+            const size_t nBefore = gnAllocations;
+
+            for (; it != itEnd; ++it, ++nVisited)
+                nSum += (size_t)it->second + KeySize(it->first);
+
+            nAllocations = gnAllocations - nBefore;
+            gSink = gSink + nSum;
+        });
+
+        printf("%-7s %-6s %10u %8u %10.2f %8u\n", pKeys, kModes[m], (unsigned)n, (unsigned)nSources,
+            ns / (double)nVisited, (unsigned)nAllocations);
+    }
+}
+
+
+static std::vector<size_t> SplitSizes(const char* p)
+{
+    std::vector<size_t> sizes;
+
+    while (*p)
+    {
+        char* pEnd;
+        sizes.push_back((size_t)strtoull(p, &pEnd, 10));
+        p = (*pEnd == ',') ? (pEnd + 1) : pEnd;
+    }
+
+    return sizes;
+}
+
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> sizes = SplitSizes("100000,1000000");
+    size_t              nSources = 8;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if ((strcmp(argv[i], "--sizes") == 0) && ((i + 1) < argc))
+            sizes = SplitSizes(argv[++i]);
+        else if ((strcmp(argv[i], "--sources") == 0) && ((i + 1) < argc))
+            nSources = (size_t)atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [--sizes 100000,...] [--sources 8]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (nSources < 1)
+        nSources = 1;
+
+    printf("%-7s %-6s %10s %8s %10s %8s\n", "keys", "dups", "size", "sources", "ns/elem", "allocs");
+
+    for (size_t s = 0; s < sizes.size(); ++s)
+    {
+        RunCase<uint64_t>("uint64", sizes[s], nSources);
+        RunCase<std::string>("string", sizes[s], nSources);
+    }
+
+    return 0;
+}
@@ -0,0 +1,189 @@
+// ThreeWayBenchmark.cpp : easy::map with string keys, less against three_way_less
+//
+// Standalone, builds on Linux with just a compiler:
+//
+//     g++ -O2 -std=c++11 -I../TestCpp.Shared ThreeWayBenchmark.cpp -o ThreeWayBenchmark
+//
+// Usage:
+//     ThreeWayBenchmark [--sizes 1000,100000,...]
+//
+// Every case inserts the given number of distinct random keys into an empty map,
+// then times find of each of them (hits), find of as many keys which are not in
+// the map (misses), and equal_range of the hits. Keys come in two shapes:
+//
+//     short     16 random letters, which mostly differ in the first few
+//     url       "https://example.com/static/assets/" and 16 random letters, so
+//               every comparison reads 35 equal bytes before the ones that differ
+//
+// The rows are easy::map<std::string, int> with each Compare:
+//
+//     less      easy::less<std::string>, one operator< per level, and one more
+//               against the node the descent ends at
+//     three     easy::three_way_less<std::string>, one std::string::compare per
+//               level, stopping at an equal key
+//
+// The two maps are built side by side, since the heap layout of the nodes and of
+// the strings matters more than the comparisons once the map is bigger than the
+// cache. Each time is the best of three runs, per operation in ns, and "cmp" is the
+// comparator calls per find hit, counted by instrumented_compare, whose counting
+// costs about as much as incrementing an integer.
+//
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "Map.h"
+#include "RbTreeStats.h"
+#include "ThreeWayCompare.h"
+
+
+// Keeps the optimizer from dropping the lookups.
+static volatile size_t gSink = 0;
+
+template <typename Function>
+static double TimeNs(Function f)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    f();
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::vector<std::string> MakeKeys(size_t n, const char* pPrefix, std::mt19937_64& random)
+{
+    std::vector<std::string> keys;
+    keys.reserve(n);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        std::string key(pPrefix);
+        for (int c = 0; c < 16; ++c)
+            key += (char)('a' + (random() % 26));
+        keys.push_back(key);
+    }
+
+    return keys;
+}
+
+
+// Runs f three times and returns the fastest, in ns.
+template <typename Function>
+static double BestNs(Function f)
+{
+    double best = TimeNs(f);
+    for (int i = 0; i < 2; ++i)
+        best = std::min(best, TimeNs(f));
+    return best;
+}
+
+template <typename Map>
+static void Report(const char* pImpl, const char* pShape, Map& m, const std::vector<std::string>& keys, const std::vector<std::string>& misses)
+{
+    const double hitNs = BestNs([&]()
+    {
+        size_t nFound = 0;
+        for (size_t i = 0; i < keys.size(); ++i)
+            nFound += (m.find(keys[i]) != m.end());
+        gSink = gSink + nFound;
+    });
+
+    const double missNs = BestNs([&]()
+    {
+        size_t nFound = 0;
+        for (size_t i = 0; i < misses.size(); ++i)
+            nFound += (m.find(misses[i]) != m.end());
+        gSink = gSink + nFound;
+    });
+
+    const double rangeNs = BestNs([&]()
+    {
+        size_t nFound = 0;
+        for (size_t i = 0; i < keys.size(); ++i)
+            nFound += (m.equal_range(keys[i]).first != m.end());
+        gSink = gSink + nFound;
+    });
+
+    m.reset_counters();
+    for (size_t i = 0; i < keys.size(); ++i)
+        m.find(keys[i]);
+
+    const double n = (double)keys.size();
+    printf("%-6s %-6s %10u %10.2f %10.2f %10.2f %8.2f\n", pImpl, pShape, (unsigned)keys.size(),
+        hitNs / n, missNs / n, rangeNs / n, m.stats().compares / n);
+}
+
+
+static void RunCase(size_t n, const char* pShape, const char* pPrefix)
+{
+    typedef easy::map<std::string, int, easy::instrumented_compare<easy::less<std::string> > >            less_map;
+    typedef easy::map<std::string, int, easy::instrumented_compare<easy::three_way_less<std::string> > >  three_map;
+
+    std::mt19937_64          random(n);
+    std::vector<std::string> keys(MakeKeys(n, pPrefix, random));
+    std::vector<std::string> misses(MakeKeys(n, pPrefix, random)); // 16 random letters collide with nothing.
+
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    std::shuffle(keys.begin(), keys.end(), random);
+
+    // Inserting into both maps in turn gives them the same kind of heap layout.
+    less_map  lessMap;
+    three_map threeMap;
+
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        lessMap.insert(easy::make_pair(keys[i], (int)i));
+        threeMap.insert(easy::make_pair(keys[i], (int)i));
+    }
+
+    Report("less", pShape, lessMap, keys, misses);
+    Report("three", pShape, threeMap, keys, misses);
+}
+
+
+static std::vector<size_t> SplitSizes(const char* p)
+{
+    std::vector<size_t> sizes;
+
+    while (*p)
+    {
+        char* pEnd;
+        sizes.push_back((size_t)strtoull(p, &pEnd, 10));
+        p = (*pEnd == ',') ? (pEnd + 1) : pEnd;
+    }
+
+    return sizes;
+}
+
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> sizes = SplitSizes("1000,100000,1000000");
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if ((strcmp(argv[i], "--sizes") == 0) && ((i + 1) < argc))
+            sizes = SplitSizes(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [--sizes 1000,...]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("%-6s %-6s %10s %10s %10s %10s %8s\n", "impl", "keys", "size", "ns/hit", "ns/miss", "ns/range", "cmp/hit");
+
+    for (size_t s = 0; s < sizes.size(); ++s)
+    {
+        RunCase(sizes[s], "short", "");
+        RunCase(sizes[s], "url", "https://example.com/static/assets/");
+    }
+
+    return 0;
+}
@@ -0,0 +1,1283 @@
+#ifndef __EASY_ART_MAP_H__
+#define __EASY_ART_MAP_H__
+
+/**
+ * 以字符串为键的自适应基数树(ART)有序map: 四种大小的内部节点, 路径压缩, 支持按前缀枚举
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <new>
+#include <string>
+#include "RbTree.h"
+
+namespace easy
+{
+    /// art_node_type
+    ///
+    /// Inner nodes come in four sizes, which a node moves between as its number of
+    /// children crosses their capacity:
+    ///     kArtNode4, kArtNode16   up to 4 or 16 sorted key bytes and as many children
+    ///     kArtNode48              a 256 entry index from key byte to one of 48 children
+    ///     kArtNode256             a child for every key byte
+    ///
+    enum art_node_type
+    {
+        kArtLeaf,
+        kArtNode4,
+        kArtNode16,
+        kArtNode48,
+        kArtNode256
+    };
+
+
+    struct art_node_base
+    {
+        uint8_t mType;  // art_node_type
+
+        explicit art_node_base(uint8_t nType) : mType(nType) {}
+    };
+
+
+    /// art_list_node
+    ///
+    /// The leaves are also a doubly linked list in key order, through which the
+    /// iterators move. The map's anchor is the list's end.
+    ///
+    struct art_list_node
+    {
+        art_list_node* mpNext;
+        art_list_node* mpPrev;
+    };
+
+
+    template <typename Value>
+    struct art_leaf : public art_node_base, public art_list_node
+    {
+        Value mValue;
+
+        explicit art_leaf(const Value& value) : art_node_base(kArtLeaf), art_list_node(), mValue(value) {}
+    };
+
+
+    /// art_inner
+    ///
+    /// The part all inner nodes share. mPrefix holds the key bytes between the
+    /// parent's key byte and this node's own, which every key below the node has in
+    /// common (path compression). The key which ends at this node, if any, is the
+    /// leaf mpLeaf rather than a child, as it has no next byte.
+    ///
+    struct art_inner : public art_node_base
+    {
+        uint16_t       mnCount;  // Children, not counting mpLeaf.
+        std::string    mPrefix;
+        art_node_base* mpLeaf;
+
+        explicit art_inner(uint8_t nType) : art_node_base(nType), mnCount(0), mPrefix(), mpLeaf(NULL) {}
+    };
+
+    struct art_node4 : public art_inner
+    {
+        static const uint32_t kCapacity = 4;
+
+        uint8_t        mKeys[kCapacity];      // Sorted.
+        art_node_base* mChildren[kCapacity];
+
+        art_node4() : art_inner(kArtNode4) {}
+    };
+
+    struct art_node16 : public art_inner
+    {
+        static const uint32_t kCapacity = 16;
+
+        uint8_t        mKeys[kCapacity];      // Sorted.
+        art_node_base* mChildren[kCapacity];
+
+        art_node16() : art_inner(kArtNode16) {}
+    };
+
+    struct art_node48 : public art_inner
+    {
+        static const uint32_t kCapacity = 48;
+
+        uint8_t        mIndex[256];           // 0 if there is no child for the byte, otherwise its slot + 1.
+        art_node_base* mChildren[kCapacity];  // NULL in free slots.
+
+        art_node48() : art_inner(kArtNode48) { memset(mIndex, 0, sizeof(mIndex)); memset(mChildren, 0, sizeof(mChildren)); }
+    };
+
+    struct art_node256 : public art_inner
+    {
+        static const uint32_t kCapacity = 256;
+
+        art_node_base* mChildren[kCapacity];
+
+        art_node256() : art_inner(kArtNode256) { memset(mChildren, 0, sizeof(mChildren)); }
+    };
+
+
+    namespace Internal
+    {
+        // Returns the slot of the child for byte c, or NULL.
+        inline art_node_base** ArtFindChild(art_inner* pNode, uint8_t c)
+        {
+            switch (pNode->mType)
+            {
+                case kArtNode4:
+                case kArtNode16:
+                {
+                    // Node4 and Node16 have the same layout up to their capacity.
+                    uint8_t* const        pKeys = (pNode->mType == kArtNode4) ? static_cast<art_node4*>(pNode)->mKeys : static_cast<art_node16*>(pNode)->mKeys;
+                    art_node_base** const pChildren = (pNode->mType == kArtNode4) ? static_cast<art_node4*>(pNode)->mChildren : static_cast<art_node16*>(pNode)->mChildren;
+
+                    for (uint32_t i = 0; (i < pNode->mnCount) && (pKeys[i] <= c); ++i)
+                    {
+                        if (pKeys[i] == c)
+                            return &pChildren[i];
+                    }
+                    return NULL;
+                }
+
+                case kArtNode48:
+                {
+                    art_node48* const pNode48 = static_cast<art_node48*>(pNode);
+                    return pNode48->mIndex[c] ? &pNode48->mChildren[pNode48->mIndex[c] - 1] : NULL;
+                }
+
+                default:
+                {
+                    art_node256* const pNode256 = static_cast<art_node256*>(pNode);
+                    return pNode256->mChildren[c] ? &pNode256->mChildren[c] : NULL;
+                }
+            }
+        }
+
+        // Calls f(byte, child) for each child in order of byte.
+        template <typename Function>
+        void ArtForEachChild(const art_inner* pNode, Function f)
+        {
+            switch (pNode->mType)
+            {
+                case kArtNode4:
+                    for (uint32_t i = 0; i < pNode->mnCount; ++i)
+                        f(static_cast<const art_node4*>(pNode)->mKeys[i], static_cast<const art_node4*>(pNode)->mChildren[i]);
+                    break;
+
+                case kArtNode16:
+                    for (uint32_t i = 0; i < pNode->mnCount; ++i)
+                        f(static_cast<const art_node16*>(pNode)->mKeys[i], static_cast<const art_node16*>(pNode)->mChildren[i]);
+                    break;
+
+                case kArtNode48:
+                {
+                    const art_node48* const pNode48 = static_cast<const art_node48*>(pNode);
+                    for (uint32_t c = 0; c < 256; ++c)
+                    {
+                        if (pNode48->mIndex[c])
+                            f((uint8_t)c, pNode48->mChildren[pNode48->mIndex[c] - 1]);
+                    }
+                    break;
+                }
+
+                default:
+                {
+                    const art_node256* const pNode256 = static_cast<const art_node256*>(pNode);
+                    for (uint32_t c = 0; c < 256; ++c)
+                    {
+                        if (pNode256->mChildren[c])
+                            f((uint8_t)c, pNode256->mChildren[c]);
+                    }
+                    break;
+                }
+            }
+        }
+
+        // Returns the child with the smallest byte greater than c, or NULL. c of
+        // -1 returns the first child.
+        inline art_node_base* ArtNextChild(const art_inner* pNode, int c)
+        {
+            switch (pNode->mType)
+            {
+                case kArtNode4:
+                case kArtNode16:
+                {
+                    const uint8_t* const        pKeys = (pNode->mType == kArtNode4) ? static_cast<const art_node4*>(pNode)->mKeys : static_cast<const art_node16*>(pNode)->mKeys;
+                    art_node_base* const* const pChildren = (pNode->mType == kArtNode4) ? static_cast<const art_node4*>(pNode)->mChildren : static_cast<const art_node16*>(pNode)->mChildren;
+
+                    for (uint32_t i = 0; i < pNode->mnCount; ++i)
+                    {
+                        if ((int)pKeys[i] > c)
+                            return pChildren[i];
+                    }
+                    return NULL;
+                }
+
+                case kArtNode48:
+                {
+                    const art_node48* const pNode48 = static_cast<const art_node48*>(pNode);
+                    for (int i = c + 1; i < 256; ++i)
+                    {
+                        if (pNode48->mIndex[i])
+                            return pNode48->mChildren[pNode48->mIndex[i] - 1];
+                    }
+                    return NULL;
+                }
+
+                default:
+                {
+                    const art_node256* const pNode256 = static_cast<const art_node256*>(pNode);
+                    for (int i = c + 1; i < 256; ++i)
+                    {
+                        if (pNode256->mChildren[i])
+                            return pNode256->mChildren[i];
+                    }
+                    return NULL;
+                }
+            }
+        }
+
+        inline art_node_base* ArtLastChild(const art_inner* pNode)
+        {
+            switch (pNode->mType)
+            {
+                case kArtNode4:
+                    return pNode->mnCount ? static_cast<const art_node4*>(pNode)->mChildren[pNode->mnCount - 1] : NULL;
+
+                case kArtNode16:
+                    return pNode->mnCount ? static_cast<const art_node16*>(pNode)->mChildren[pNode->mnCount - 1] : NULL;
+
+                case kArtNode48:
+                {
+                    const art_node48* const pNode48 = static_cast<const art_node48*>(pNode);
+                    for (int i = 255; i >= 0; --i)
+                    {
+                        if (pNode48->mIndex[i])
+                            return pNode48->mChildren[pNode48->mIndex[i] - 1];
+                    }
+                    return NULL;
+                }
+
+                default:
+                {
+                    const art_node256* const pNode256 = static_cast<const art_node256*>(pNode);
+                    for (int i = 255; i >= 0; --i)
+                    {
+                        if (pNode256->mChildren[i])
+                            return pNode256->mChildren[i];
+                    }
+                    return NULL;
+                }
+            }
+        }
+
+        inline bool ArtIsFull(const art_inner* pNode)
+        {
+            switch (pNode->mType)
+            {
+                case kArtNode4:  return pNode->mnCount == art_node4::kCapacity;
+                case kArtNode16: return pNode->mnCount == art_node16::kCapacity;
+                case kArtNode48: return pNode->mnCount == art_node48::kCapacity;
+                default:         return false;
+            }
+        }
+
+        // Inserts byte c and its child into the sorted arrays of a Node4 or Node16 holding nCount.
+        inline void ArtAddSortedChild(uint8_t* pKeys, art_node_base** pChildren, uint32_t nCount, uint8_t c, art_node_base* pChild)
+        {
+            uint32_t i = nCount;
+            for (; (i > 0) && (pKeys[i - 1] > c); --i)
+            {
+                pKeys[i] = pKeys[i - 1];
+                pChildren[i] = pChildren[i - 1];
+            }
+            pKeys[i] = c;
+            pChildren[i] = pChild;
+        }
+
+        // Adds a child to a node which is new, so a Node4 with room for two.
+        inline void ArtAddChild(art_node4* pNode, uint8_t c, art_node_base* pChild)
+        {
+            ArtAddSortedChild(pNode->mKeys, pNode->mChildren, pNode->mnCount++, c, pChild);
+        }
+
+        // Adds child for byte c to a node which has room for it and no child for c.
+        inline void ArtAddChild(art_inner* pNode, uint8_t c, art_node_base* pChild)
+        {
+            switch (pNode->mType)
+            {
+                case kArtNode4:
+                case kArtNode16:
+                {
+                    uint8_t* const        pKeys = (pNode->mType == kArtNode4) ? static_cast<art_node4*>(pNode)->mKeys : static_cast<art_node16*>(pNode)->mKeys;
+                    art_node_base** const pChildren = (pNode->mType == kArtNode4) ? static_cast<art_node4*>(pNode)->mChildren : static_cast<art_node16*>(pNode)->mChildren;
+
+                    ArtAddSortedChild(pKeys, pChildren, pNode->mnCount, c, pChild);
+                    break;
+                }
+
+                case kArtNode48:
+                {
+                    art_node48* const pNode48 = static_cast<art_node48*>(pNode);
+                    uint32_t i = 0;
+                    while (pNode48->mChildren[i])
+                        ++i;
+                    pNode48->mChildren[i] = pChild;
+                    pNode48->mIndex[c] = (uint8_t)(i + 1);
+                    break;
+                }
+
+                default:
+                    static_cast<art_node256*>(pNode)->mChildren[c] = pChild;
+                    break;
+            }
+
+            ++pNode->mnCount;
+        }
+
+        inline void ArtRemoveChild(art_inner* pNode, uint8_t c)
+        {
+            switch (pNode->mType)
+            {
+                case kArtNode4:
+                case kArtNode16:
+                {
+                    uint8_t* const        pKeys = (pNode->mType == kArtNode4) ? static_cast<art_node4*>(pNode)->mKeys : static_cast<art_node16*>(pNode)->mKeys;
+                    art_node_base** const pChildren = (pNode->mType == kArtNode4) ? static_cast<art_node4*>(pNode)->mChildren : static_cast<art_node16*>(pNode)->mChildren;
+
+                    uint32_t i = 0;
+                    while (pKeys[i] != c)
+                        ++i;
+                    for (; (i + 1) < pNode->mnCount; ++i)
+                    {
+                        pKeys[i] = pKeys[i + 1];
+                        pChildren[i] = pChildren[i + 1];
+                    }
+                    break;
+                }
+
+                case kArtNode48:
+                {
+                    art_node48* const pNode48 = static_cast<art_node48*>(pNode);
+                    pNode48->mChildren[pNode48->mIndex[c] - 1] = NULL;
+                    pNode48->mIndex[c] = 0;
+                    break;
+                }
+
+                default:
+                    static_cast<art_node256*>(pNode)->mChildren[c] = NULL;
+                    break;
+            }
+
+            --pNode->mnCount;
+        }
+
+        inline art_node_base* ArtMinLeaf(const art_node_base* pNode)
+        {
+            while (pNode->mType != kArtLeaf)
+            {
+                const art_inner* const pInner = static_cast<const art_inner*>(pNode);
+                pNode = pInner->mpLeaf ? pInner->mpLeaf : ArtNextChild(pInner, -1);
+            }
+            return const_cast<art_node_base*>(pNode);
+        }
+
+        inline art_node_base* ArtMaxLeaf(const art_node_base* pNode)
+        {
+            while (pNode->mType != kArtLeaf)
+            {
+                const art_inner* const pInner = static_cast<const art_inner*>(pNode);
+                pNode = pInner->mnCount ? ArtLastChild(pInner) : pInner->mpLeaf;
+            }
+            return const_cast<art_node_base*>(pNode);
+        }
+
+        // Compares two byte strings as unsigned chars, the order of std::string::compare.
+        inline int ArtCompare(const char* pA, size_t nA, const char* pB, size_t nB)
+        {
+            const int result = memcmp(pA, pB, (nA < nB) ? nA : nB);
+            if (result != 0)
+                return result;
+            return (nA < nB) ? -1 : ((nA > nB) ? 1 : 0);
+        }
+    }
+
+
+    /// art_map_iterator
+    ///
+    /// Moves along the list of leaves, so it is a pointer like rbtree_iterator,
+    /// and stays valid until its element is erased.
+    ///
+    template <typename T, typename Pointer, typename Reference>
+    struct art_map_iterator
+    {
+        typedef art_map_iterator<T, Pointer, Reference>     this_type;
+        typedef art_map_iterator<T, T*, T&>                 iterator;
+        typedef art_map_iterator<T, const T*, const T&>     const_iterator;
+        typedef ptrdiff_t                                   difference_type;
+        typedef T                                           value_type;
+        typedef art_leaf<T>                                 leaf_type;
+        typedef Pointer                                     pointer;
+        typedef Reference                                   reference;
+
+    public:
+        art_list_node* mpNode;
+
+    public:
+        art_map_iterator() : mpNode(NULL) {}
+        explicit art_map_iterator(const art_list_node* pNode) : mpNode(const_cast<art_list_node*>(pNode)) {}
+        art_map_iterator(const iterator& x) : mpNode(x.mpNode) {}
+
+        reference operator*() const { return static_cast<leaf_type*>(mpNode)->mValue; }
+        pointer   operator->() const { return &static_cast<leaf_type*>(mpNode)->mValue; }
+
+        this_type& operator++() { mpNode = mpNode->mpNext; return *this; }
+        this_type  operator++(int) { this_type temp(*this); mpNode = mpNode->mpNext; return temp; }
+
+        this_type& operator--() { mpNode = mpNode->mpPrev; return *this; }
+        this_type  operator--(int) { this_type temp(*this); mpNode = mpNode->mpPrev; return temp; }
+    };
+
+    template <typename T, typename PointerA, typename ReferenceA, typename PointerB, typename ReferenceB>
+    inline bool operator==(const art_map_iterator<T, PointerA, ReferenceA>& a, const art_map_iterator<T, PointerB, ReferenceB>& b)
+    {
+        return a.mpNode == b.mpNode;
+    }
+
+    template <typename T, typename PointerA, typename ReferenceA, typename PointerB, typename ReferenceB>
+    inline bool operator!=(const art_map_iterator<T, PointerA, ReferenceA>& a, const art_map_iterator<T, PointerB, ReferenceB>& b)
+    {
+        return a.mpNode != b.mpNode;
+    }
+
+
+
+    /// art_map
+    ///
+    /// A map from std::string to T, ordered like easy::map<std::string, T>, stored
+    /// as an adaptive radix tree. A lookup reads each byte of the key once, at one
+    /// node per byte that isn't shared by all the keys below a node, instead of
+    /// comparing whole keys at each level of a tree. That suits long keys with long
+    /// common prefixes, such as paths and URLs. Inner nodes hold 4, 16, 48 or 256
+    /// children and grow and shrink between those sizes, and a chain of nodes with
+    /// a single child is collapsed into a prefix stored in the node below it.
+    ///
+    /// The API is that of easy::map, plus prefix_range, which returns the elements
+    /// whose keys start with a prefix: the search is O(prefix length), and the
+    /// elements are then iterated at O(1) each, along the list of leaves.
+    ///
+    /// Iterators and references stay valid until their element is erased.
+    ///
+    /// Example usage:
+    ///     easy::art_map<int> routes;
+    ///     routes.insert(easy::make_pair(std::string("/api/users"), 1));
+    ///     easy::pair<easy::art_map<int>::iterator, easy::art_map<int>::iterator> range = routes.prefix_range("/api/");
+    ///
+    template <typename T, typename Allocator = easy::allocator>
+    class art_map
+    {
+    public:
+        typedef art_map<T, Allocator>                                                       this_type;
+        typedef std::string                                                                 key_type;
+        typedef T                                                                           mapped_type;
+        typedef easy::pair<std::string, T>                                                  value_type;
+        typedef size_t                                                                      size_type;
+        typedef art_leaf<value_type>                                                        leaf_type;
+        typedef Allocator                                                                   allocator_type;
+        typedef art_map_iterator<value_type, value_type*, value_type&>                      iterator;
+        typedef art_map_iterator<value_type, const value_type*, const value_type&>          const_iterator;
+        typedef easy::pair<iterator, bool>                                                  insert_return_type;
+
+    public:
+        art_map();
+        art_map(const this_type& x);
+
+        template <typename InputIterator>
+        art_map(InputIterator first, InputIterator last);
+
+        ~art_map();
+
+        this_type& operator=(const this_type& x);
+        void swap(this_type& x);
+
+    public:
+        iterator       begin() { return iterator(mAnchor.mpNext); }
+        const_iterator begin() const { return const_iterator(mAnchor.mpNext); }
+        const_iterator cbegin() const { return const_iterator(mAnchor.mpNext); }
+
+        iterator       end() { return iterator(&mAnchor); }
+        const_iterator end() const { return const_iterator(&mAnchor); }
+        const_iterator cend() const { return const_iterator(&mAnchor); }
+
+        bool      empty() const { return mnSize == 0; }
+        size_type size() const { return mnSize; }
+
+        insert_return_type insert(const value_type& value);
+
+        template <typename InputIterator>
+        void insert(InputIterator first, InputIterator last);
+
+        iterator  erase(const_iterator position);
+        iterator  erase(const_iterator first, const_iterator last);
+        size_type erase(const key_type& key);
+
+        void clear();
+
+        iterator       find(const key_type& key);
+        const_iterator find(const key_type& key) const;
+
+        size_type count(const key_type& key) const { return (find(key) != end()) ? 1 : 0; }
+
+        iterator       lower_bound(const key_type& key);
+        const_iterator lower_bound(const key_type& key) const;
+
+        iterator       upper_bound(const key_type& key);
+        const_iterator upper_bound(const key_type& key) const;
+
+        easy::pair<iterator, iterator>             equal_range(const key_type& key);
+        easy::pair<const_iterator, const_iterator> equal_range(const key_type& key) const;
+
+        /// Returns the elements whose keys start with prefix, in order. An empty
+        /// prefix returns every element.
+        easy::pair<iterator, iterator>             prefix_range(const key_type& prefix);
+        easy::pair<const_iterator, const_iterator> prefix_range(const key_type& prefix) const;
+
+    protected:
+        leaf_type*       DoFindLeaf(const char* pKey, size_t nKey) const;
+        art_list_node*   DoLowerBound(const char* pKey, size_t nKey) const;
+        easy::pair<art_list_node*, art_list_node*> DoPrefixRange(const char* pPrefix, size_t nPrefix) const;
+
+        leaf_type*       DoCreateLeaf(const value_type& value);
+        void             DoFreeLeaf(leaf_type* pLeaf);
+        art_inner*       DoCreateInner(uint8_t nType);
+        void             DoFreeInner(art_inner* pNode);
+        void             DoFreeSubtree(art_node_base* pNode);
+
+        void             DoAddChild(art_node_base** ppNode, uint8_t c, art_node_base* pChild);
+        void             DoResize(art_node_base** ppNode, uint8_t nType);
+        void             DoShrink(art_node_base** ppNode);
+        void             DoLinkBefore(art_list_node* pPosition, art_list_node* pNode);
+        void             DoUnlink(art_list_node* pNode);
+
+    protected:
+        art_node_base* mpRoot;
+        art_list_node  mAnchor;     // The list's end: mpNext is the first leaf and mpPrev the last.
+        size_type      mnSize;
+        Allocator      mAllocator;
+    }; // art_map
+
+
+
+    ///////////////////////////////////////////////////////////////////////
+    // art_map
+    ///////////////////////////////////////////////////////////////////////
+
+    template <typename T, typename Allocator>
+    inline art_map<T, Allocator>::art_map()
+        : mpRoot(NULL),
+        mAnchor(),
+        mnSize(0),
+        mAllocator()
+    {
+        mAnchor.mpNext = mAnchor.mpPrev = &mAnchor;
+    }
+
+
+    template <typename T, typename Allocator>
+    inline art_map<T, Allocator>::art_map(const this_type& x)
+        : mpRoot(NULL),
+        mAnchor(),
+        mnSize(0),
+        mAllocator(x.mAllocator)
+    {
+        mAnchor.mpNext = mAnchor.mpPrev = &mAnchor;
+        insert(x.begin(), x.end());
+    }
+
+
+    template <typename T, typename Allocator>
+    template <typename InputIterator>
+    inline art_map<T, Allocator>::art_map(InputIterator first, InputIterator last)
+        : mpRoot(NULL),
+        mAnchor(),
+        mnSize(0),
+        mAllocator()
+    {
+        mAnchor.mpNext = mAnchor.mpPrev = &mAnchor;
+        insert(first, last);
+    }
+
+
+    template <typename T, typename Allocator>
+    inline art_map<T, Allocator>::~art_map()
+    {
+        clear();
+    }
+
+
+    template <typename T, typename Allocator>
+    inline typename art_map<T, Allocator>::this_type& art_map<T, Allocator>::operator=(const this_type& x)
+    {
+        if (this != &x)
+        {
+            this_type temp(x);
+            swap(temp);
+        }
+        return *this;
+    }
+
+
+    template <typename T, typename Allocator>
+    inline void art_map<T, Allocator>::swap(this_type& x)
+    {
+        // The first and last leaves point back to the anchor, which stays in its object.
+        art_list_node* const pFirst = mAnchor.mpNext;
+        art_list_node* const pLast = mAnchor.mpPrev;
+        art_list_node* const pFirstX = x.mAnchor.mpNext;
+        art_list_node* const pLastX = x.mAnchor.mpPrev;
+
+        mAnchor.mpNext = (pFirstX == &x.mAnchor) ? &mAnchor : pFirstX;
+        mAnchor.mpPrev = (pLastX == &x.mAnchor) ? &mAnchor : pLastX;
+        mAnchor.mpNext->mpPrev = &mAnchor;
+        mAnchor.mpPrev->mpNext = &mAnchor;
+
+        x.mAnchor.mpNext = (pFirst == &mAnchor) ? &x.mAnchor : pFirst;
+        x.mAnchor.mpPrev = (pLast == &mAnchor) ? &x.mAnchor : pLast;
+        x.mAnchor.mpNext->mpPrev = &x.mAnchor;
+        x.mAnchor.mpPrev->mpNext = &x.mAnchor;
+
+        easy::swap(mpRoot, x.mpRoot);
+        easy::swap(mnSize, x.mnSize);
+        easy::swap(mAllocator, x.mAllocator);
+    }
+
+
+    template <typename T, typename Allocator>
+    typename art_map<T, Allocator>::insert_return_type
+        art_map<T, Allocator>::insert(const value_type& value)
+    {
+        const char* const pKey = value.first.data();
+        const size_t      nKey = value.first.size();
+        art_node_base**   ppNode = &mpRoot;
+        size_t            nDepth = 0;
+
+        for (;;)
+        {
+            art_node_base* const pNode = *ppNode;
+
+            if (pNode == NULL) // Only for the root of an empty map.
+            {
+                leaf_type* const pLeaf = DoCreateLeaf(value);
+                DoLinkBefore(&mAnchor, pLeaf);
+                *ppNode = pLeaf;
+                return insert_return_type(iterator(pLeaf), true);
+            }
+
+            if (pNode->mType == kArtLeaf)
+            {
+                // Replace the leaf with a node which holds it and the new leaf, with
+                // the bytes the two keys share after nDepth as its prefix.
+                leaf_type* const   pOld = static_cast<leaf_type*>(pNode);
+                const std::string& oldKey = pOld->mValue.first;
+
+                if ((oldKey.size() == nKey) && (memcmp(oldKey.data(), pKey, nKey) == 0))
+                    return insert_return_type(iterator(pOld), false);
+
+                size_t i = nDepth;
+                while ((i < oldKey.size()) && (i < nKey) && (oldKey[i] == pKey[i]))
+                    ++i;
+
+                leaf_type* const pLeaf = DoCreateLeaf(value);
+                art_node4* const pInner = static_cast<art_node4*>(DoCreateInner(kArtNode4));
+                pInner->mPrefix.assign(pKey + nDepth, i - nDepth);
+
+                if (i == oldKey.size())
+                    pInner->mpLeaf = pOld;
+                else
+                    Internal::ArtAddChild(pInner, (uint8_t)oldKey[i], pOld);
+
+                if (i == nKey)
+                    pInner->mpLeaf = pLeaf;
+                else
+                    Internal::ArtAddChild(pInner, (uint8_t)pKey[i], pLeaf);
+
+                if (Internal::ArtCompare(pKey, nKey, oldKey.data(), oldKey.size()) < 0)
+                    DoLinkBefore(pOld, pLeaf);
+                else
+                    DoLinkBefore(pOld->mpNext, pLeaf);
+
+                *ppNode = pInner;
+                return insert_return_type(iterator(pLeaf), true);
+            }
+
+            art_inner* const   pInner = static_cast<art_inner*>(pNode);
+            const std::string& prefix = pInner->mPrefix;
+
+            size_t j = 0;
+            while ((j < prefix.size()) && ((nDepth + j) < nKey) && (prefix[j] == pKey[nDepth + j]))
+                ++j;
+
+            if (j < prefix.size())
+            {
+                // The key leaves the prefix at j: put a node above this one, which
+                // holds the shared part of the prefix, this node under the byte at
+                // j, and the new leaf.
+                leaf_type* const pLeaf = DoCreateLeaf(value);
+                art_node4* const pSplit = static_cast<art_node4*>(DoCreateInner(kArtNode4));
+                const uint8_t    c = (uint8_t)prefix[j];
+
+                pSplit->mPrefix.assign(prefix, 0, j);
+                pInner->mPrefix.erase(0, j + 1);
+                Internal::ArtAddChild(pSplit, c, pInner);
+
+                if ((nDepth + j) == nKey)
+                {
+                    pSplit->mpLeaf = pLeaf;
+                    DoLinkBefore(static_cast<leaf_type*>(Internal::ArtMinLeaf(pInner)), pLeaf);
+                }
+                else
+                {
+                    Internal::ArtAddChild(pSplit, (uint8_t)pKey[nDepth + j], pLeaf);
+                    if ((uint8_t)pKey[nDepth + j] < c)
+                        DoLinkBefore(static_cast<leaf_type*>(Internal::ArtMinLeaf(pInner)), pLeaf);
+                    else
+                        DoLinkBefore(static_cast<leaf_type*>(Internal::ArtMaxLeaf(pInner))->mpNext, pLeaf);
+                }
+
+                *ppNode = pSplit;
+                return insert_return_type(iterator(pLeaf), true);
+            }
+
+            nDepth += prefix.size();
+
+            if (nDepth == nKey)
+            {
+                if (pInner->mpLeaf)
+                    return insert_return_type(iterator(static_cast<leaf_type*>(pInner->mpLeaf)), false);
+
+                // The key is shorter than every key below the node.
+                leaf_type* const pLeaf = DoCreateLeaf(value);
+                DoLinkBefore(static_cast<leaf_type*>(Internal::ArtMinLeaf(pInner)), pLeaf);
+                pInner->mpLeaf = pLeaf;
+                return insert_return_type(iterator(pLeaf), true);
+            }
+
+            const uint8_t c = (uint8_t)pKey[nDepth];
+
+            if (art_node_base** const ppChild = Internal::ArtFindChild(pInner, c))
+            {
+                ppNode = ppChild;
+                ++nDepth;
+                continue;
+            }
+
+            // A new child. Its neighbours in key order are the smallest leaf of the
+            // next child, or else the largest leaf of the node.
+            leaf_type* const pLeaf = DoCreateLeaf(value);
+
+            if (art_node_base* const pNext = Internal::ArtNextChild(pInner, c))
+                DoLinkBefore(static_cast<leaf_type*>(Internal::ArtMinLeaf(pNext)), pLeaf);
+            else
+                DoLinkBefore(static_cast<leaf_type*>(Internal::ArtMaxLeaf(pInner))->mpNext, pLeaf);
+
+            DoAddChild(ppNode, c, pLeaf);
+            return insert_return_type(iterator(pLeaf), true);
+        }
+    }
+
+
+    template <typename T, typename Allocator>
+    template <typename InputIterator>
+    inline void art_map<T, Allocator>::insert(InputIterator first, InputIterator last)
+    {
+        for (; first != last; ++first)
+            insert(*first);
+    }
+
+
+    template <typename T, typename Allocator>
+    inline typename art_map<T, Allocator>::iterator art_map<T, Allocator>::erase(const_iterator position)
+    {
+        const iterator itNext(position.mpNode->mpNext);
+        erase(position->first);
+        return itNext;
+    }
+
+
+    template <typename T, typename Allocator>
+    inline typename art_map<T, Allocator>::iterator art_map<T, Allocator>::erase(const_iterator first, const_iterator last)
+    {
+        while (first != last)
+            first = erase(first);
+        return iterator(last.mpNode);
+    }
+
+
+    template <typename T, typename Allocator>
+    typename art_map<T, Allocator>::size_type art_map<T, Allocator>::erase(const key_type& key)
+    {
+        const char* const pKey = key.data();
+        const size_t      nKey = key.size();
+        art_node_base**   ppNode = &mpRoot;
+        size_t            nDepth = 0;
+
+        if (mpRoot == NULL)
+            return 0;
+
+        if (mpRoot->mType == kArtLeaf)
+        {
+            leaf_type* const pLeaf = static_cast<leaf_type*>(mpRoot);
+            if ((pLeaf->mValue.first.size() != nKey) || (memcmp(pLeaf->mValue.first.data(), pKey, nKey) != 0))
+                return 0;
+
+            mpRoot = NULL;
+            DoUnlink(pLeaf);
+            DoFreeLeaf(pLeaf);
+            return 1;
+        }
+
+        for (;;)
+        {
+            art_inner* const   pInner = static_cast<art_inner*>(*ppNode);
+            const std::string& prefix = pInner->mPrefix;
+
+            if (((nKey - nDepth) < prefix.size()) || (memcmp(prefix.data(), pKey + nDepth, prefix.size()) != 0))
+                return 0;
+            nDepth += prefix.size();
+
+            leaf_type* pLeaf;
+
+            if (nDepth == nKey)
+            {
+                if ((pLeaf = static_cast<leaf_type*>(pInner->mpLeaf)) == NULL)
+                    return 0;
+                pInner->mpLeaf = NULL;
+            }
+            else
+            {
+                const uint8_t         c = (uint8_t)pKey[nDepth];
+                art_node_base** const ppChild = Internal::ArtFindChild(pInner, c);
+
+                if (ppChild == NULL)
+                    return 0;
+
+                if ((*ppChild)->mType != kArtLeaf)
+                {
+                    ppNode = ppChild;
+                    ++nDepth;
+                    continue;
+                }
+
+                pLeaf = static_cast<leaf_type*>(*ppChild);
+                if ((pLeaf->mValue.first.size() != nKey) || (memcmp(pLeaf->mValue.first.data(), pKey, nKey) != 0))
+                    return 0;
+                Internal::ArtRemoveChild(pInner, c);
+            }
+
+            DoShrink(ppNode);
+            DoUnlink(pLeaf);
+            DoFreeLeaf(pLeaf);
+            return 1;
+        }
+    }
+
+
+    template <typename T, typename Allocator>
+    inline void art_map<T, Allocator>::clear()
+    {
+        if (mpRoot)
+            DoFreeSubtree(mpRoot);
+
+        mpRoot = NULL;
+        mAnchor.mpNext = mAnchor.mpPrev = &mAnchor;
+        mnSize = 0;
+    }
+
+
+    template <typename T, typename Allocator>
+    inline typename art_map<T, Allocator>::iterator art_map<T, Allocator>::find(const key_type& key)
+    {
+        leaf_type* const pLeaf = DoFindLeaf(key.data(), key.size());
+        return pLeaf ? iterator(pLeaf) : end();
+    }
+
+
+    template <typename T, typename Allocator>
+    inline typename art_map<T, Allocator>::const_iterator art_map<T, Allocator>::find(const key_type& key) const
+    {
+        leaf_type* const pLeaf = DoFindLeaf(key.data(), key.size());
+        return pLeaf ? const_iterator(pLeaf) : end();
+    }
+
+
+    template <typename T, typename Allocator>
+    inline typename art_map<T, Allocator>::iterator art_map<T, Allocator>::lower_bound(const key_type& key)
+    {
+        return iterator(DoLowerBound(key.data(), key.size()));
+    }
+
+
+    template <typename T, typename Allocator>
+    inline typename art_map<T, Allocator>::const_iterator art_map<T, Allocator>::lower_bound(const key_type& key) const
+    {
+        return const_iterator(DoLowerBound(key.data(), key.size()));
+    }
+
+
+    template <typename T, typename Allocator>
+    inline typename art_map<T, Allocator>::iterator art_map<T, Allocator>::upper_bound(const key_type& key)
+    {
+        iterator it(DoLowerBound(key.data(), key.size()));
+        if ((it != end()) && (it->first == key))
+            ++it;
+        return it;
+    }
+
+
+    template <typename T, typename Allocator>
+    inline typename art_map<T, Allocator>::const_iterator art_map<T, Allocator>::upper_bound(const key_type& key) const
+    {
+        const_iterator it(DoLowerBound(key.data(), key.size()));
+        if ((it != end()) && (it->first == key))
+            ++it;
+        return it;
+    }
+
+
+    template <typename T, typename Allocator>
+    inline easy::pair<typename art_map<T, Allocator>::iterator, typename art_map<T, Allocator>::iterator>
+        art_map<T, Allocator>::equal_range(const key_type& key)
+    {
+        const iterator it(lower_bound(key));
+        if ((it != end()) && (it->first == key))
+            return easy::pair<iterator, iterator>(it, ++iterator(it));
+        return easy::pair<iterator, iterator>(it, it);
+    }
+
+
+    template <typename T, typename Allocator>
+    inline easy::pair<typename art_map<T, Allocator>::const_iterator, typename art_map<T, Allocator>::const_iterator>
+        art_map<T, Allocator>::equal_range(const key_type& key) const
+    {
+        const const_iterator it(lower_bound(key));
+        if ((it != end()) && (it->first == key))
+            return easy::pair<const_iterator, const_iterator>(it, ++const_iterator(it));
+        return easy::pair<const_iterator, const_iterator>(it, it);
+    }
+
+
+    template <typename T, typename Allocator>
+    inline easy::pair<typename art_map<T, Allocator>::iterator, typename art_map<T, Allocator>::iterator>
+        art_map<T, Allocator>::prefix_range(const key_type& prefix)
+    {
+        const easy::pair<art_list_node*, art_list_node*> range = DoPrefixRange(prefix.data(), prefix.size());
+        return easy::pair<iterator, iterator>(iterator(range.first), iterator(range.second));
+    }
+
+
+    template <typename T, typename Allocator>
+    inline easy::pair<typename art_map<T, Allocator>::const_iterator, typename art_map<T, Allocator>::const_iterator>
+        art_map<T, Allocator>::prefix_range(const key_type& prefix) const
+    {
+        const easy::pair<art_list_node*, art_list_node*> range = DoPrefixRange(prefix.data(), prefix.size());
+        return easy::pair<const_iterator, const_iterator>(const_iterator(range.first), const_iterator(range.second));
+    }
+
+
+    template <typename T, typename Allocator>
+    typename art_map<T, Allocator>::leaf_type*
+        art_map<T, Allocator>::DoFindLeaf(const char* pKey, size_t nKey) const
+    {
+        const art_node_base* pNode = mpRoot;
+        size_t               nDepth = 0;
+
+        while (pNode)
+        {
+            if (pNode->mType == kArtLeaf)
+            {
+                leaf_type* const pLeaf = static_cast<leaf_type*>(const_cast<art_node_base*>(pNode));
+                const bool       bEqual = (pLeaf->mValue.first.size() == nKey) && (memcmp(pLeaf->mValue.first.data(), pKey, nKey) == 0);
+                return bEqual ? pLeaf : NULL;
+            }
+
+            art_inner* const   pInner = static_cast<art_inner*>(const_cast<art_node_base*>(pNode));
+            const std::string& prefix = pInner->mPrefix;
+
+            if (((nKey - nDepth) < prefix.size()) || (memcmp(prefix.data(), pKey + nDepth, prefix.size()) != 0))
+                return NULL;
+            nDepth += prefix.size();
+
+            if (nDepth == nKey)
+                return static_cast<leaf_type*>(pInner->mpLeaf);
+
+            art_node_base** const ppChild = Internal::ArtFindChild(pInner, (uint8_t)pKey[nDepth++]);
+            pNode = ppChild ? *ppChild : NULL;
+        }
+
+        return NULL;
+    }
+
+
+    // Returns the first leaf whose key is not less than the key, or the anchor.
+    template <typename T, typename Allocator>
+    art_list_node* art_map<T, Allocator>::DoLowerBound(const char* pKey, size_t nKey) const
+    {
+        const art_node_base* pNode = mpRoot;
+        size_t               nDepth = 0;
+
+        if (pNode == NULL)
+            return const_cast<art_list_node*>(&mAnchor);
+
+        for (;;)
+        {
+            if (pNode->mType == kArtLeaf)
+            {
+                leaf_type* const pLeaf = static_cast<leaf_type*>(const_cast<art_node_base*>(pNode));
+                const int        result = Internal::ArtCompare(pLeaf->mValue.first.data(), pLeaf->mValue.first.size(), pKey, nKey);
+                return (result >= 0) ? pLeaf : pLeaf->mpNext;
+            }
+
+            const art_inner* const pInner = static_cast<const art_inner*>(pNode);
+            const std::string&     prefix = pInner->mPrefix;
+
+            // Every key below the node is greater if the key is shorter than the
+            // prefix or smaller at the first byte that differs, and smaller if it
+            // is greater at that byte.
+            for (size_t j = 0; j < prefix.size(); ++j)
+            {
+                if ((nDepth + j) == nKey)
+                    return static_cast<leaf_type*>(Internal::ArtMinLeaf(pInner));
+                if (prefix[j] != pKey[nDepth + j])
+                {
+                    if ((uint8_t)pKey[nDepth + j] < (uint8_t)prefix[j])
+                        return static_cast<leaf_type*>(Internal::ArtMinLeaf(pInner));
+                    return static_cast<leaf_type*>(Internal::ArtMaxLeaf(pInner))->mpNext;
+                }
+            }
+            nDepth += prefix.size();
+
+            if (nDepth == nKey)
+                return static_cast<leaf_type*>(Internal::ArtMinLeaf(pInner));
+
+            const uint8_t         c = (uint8_t)pKey[nDepth];
+            art_node_base** const ppChild = Internal::ArtFindChild(const_cast<art_inner*>(pInner), c);
+
+            if (ppChild)
+            {
+                pNode = *ppChild;
+                ++nDepth;
+                continue;
+            }
+
+            if (const art_node_base* const pNext = Internal::ArtNextChild(pInner, c))
+                return static_cast<leaf_type*>(Internal::ArtMinLeaf(pNext));
+            return static_cast<leaf_type*>(Internal::ArtMaxLeaf(pInner))->mpNext;
+        }
+    }
+
+
+    // Finds the node under which all the keys with the prefix are, and returns the
+    // smallest of its leaves and the leaf after its largest.
+    template <typename T, typename Allocator>
+    easy::pair<art_list_node*, art_list_node*> art_map<T, Allocator>::DoPrefixRange(const char* pPrefix, size_t nPrefix) const
+    {
+        const art_node_base* pNode = mpRoot;
+        size_t               nDepth = 0;
+
+        while (pNode)
+        {
+            if (pNode->mType == kArtLeaf)
+            {
+                leaf_type* const pLeaf = static_cast<leaf_type*>(const_cast<art_node_base*>(pNode));
+                if ((pLeaf->mValue.first.size() >= nPrefix) && (memcmp(pLeaf->mValue.first.data(), pPrefix, nPrefix) == 0))
+                    return easy::pair<art_list_node*, art_list_node*>(pLeaf, pLeaf->mpNext);
+                break;
+            }
+
+            const art_inner* const pInner = static_cast<const art_inner*>(pNode);
+            const std::string&     prefix = pInner->mPrefix;
+            const size_t           nCompare = ((nPrefix - nDepth) < prefix.size()) ? (nPrefix - nDepth) : prefix.size();
+
+            if (memcmp(prefix.data(), pPrefix + nDepth, nCompare) != 0)
+                break;
+
+            if ((nDepth + prefix.size()) >= nPrefix)
+            {
+                return easy::pair<art_list_node*, art_list_node*>(static_cast<leaf_type*>(Internal::ArtMinLeaf(pInner)),
+                    static_cast<leaf_type*>(Internal::ArtMaxLeaf(pInner))->mpNext);
+            }
+            nDepth += prefix.size();
+
+            art_node_base** const ppChild = Internal::ArtFindChild(const_cast<art_inner*>(pInner), (uint8_t)pPrefix[nDepth++]);
+            pNode = ppChild ? *ppChild : NULL;
+        }
+
+        // No key has the prefix; return the empty range where they would be.
+        art_list_node* const pPosition = DoLowerBound(pPrefix, nPrefix);
+        return easy::pair<art_list_node*, art_list_node*>(pPosition, pPosition);
+    }
+
+
+    template <typename T, typename Allocator>
+    inline typename art_map<T, Allocator>::leaf_type* art_map<T, Allocator>::DoCreateLeaf(const value_type& value)
+    {
+        void* const pMemory = mAllocator.allocate(sizeof(leaf_type));
+        ++mnSize;
+        return ::new(pMemory) leaf_type(value);
+    }
+
+
+    template <typename T, typename Allocator>
+    inline void art_map<T, Allocator>::DoFreeLeaf(leaf_type* pLeaf)
+    {
+        pLeaf->~leaf_type();
+        mAllocator.deallocate(pLeaf, sizeof(leaf_type));
+        --mnSize;
+    }
+
+
+    template <typename T, typename Allocator>
+    inline art_inner* art_map<T, Allocator>::DoCreateInner(uint8_t nType)
+    {
+        switch (nType)
+        {
+            case kArtNode4:  return ::new(mAllocator.allocate(sizeof(art_node4))) art_node4();
+            case kArtNode16: return ::new(mAllocator.allocate(sizeof(art_node16))) art_node16();
+            case kArtNode48: return ::new(mAllocator.allocate(sizeof(art_node48))) art_node48();
+            default:         return ::new(mAllocator.allocate(sizeof(art_node256))) art_node256();
+        }
+    }
+
+
+    template <typename T, typename Allocator>
+    inline void art_map<T, Allocator>::DoFreeInner(art_inner* pNode)
+    {
+        switch (pNode->mType)
+        {
+            case kArtNode4:
+                static_cast<art_node4*>(pNode)->~art_node4();
+                mAllocator.deallocate(pNode, sizeof(art_node4));
+                break;
+
+            case kArtNode16:
+                static_cast<art_node16*>(pNode)->~art_node16();
+                mAllocator.deallocate(pNode, sizeof(art_node16));
+                break;
+
+            case kArtNode48:
+                static_cast<art_node48*>(pNode)->~art_node48();
+                mAllocator.deallocate(pNode, sizeof(art_node48));
+                break;
+
+            default:
+                static_cast<art_node256*>(pNode)->~art_node256();
+                mAllocator.deallocate(pNode, sizeof(art_node256));
+                break;
+        }
+    }
+
+
+    template <typename T, typename Allocator>
+    void art_map<T, Allocator>::DoFreeSubtree(art_node_base* pNode)
+    {
+        if (pNode->mType == kArtLeaf)
+        {
+            DoFreeLeaf(static_cast<leaf_type*>(pNode));
+            return;
+        }
+
+        art_inner* const pInner = static_cast<art_inner*>(pNode);
+        if (pInner->mpLeaf)
+            DoFreeLeaf(static_cast<leaf_type*>(pInner->mpLeaf));
+        Internal::ArtForEachChild(pInner, [this](uint8_t, art_node_base* pChild) { DoFreeSubtree(pChild); });
+        DoFreeInner(pInner);
+    }
+
+
+    // Adds a child to the node at *ppNode, moving the node to the next size up first if it is full.
+    template <typename T, typename Allocator>
+    inline void art_map<T, Allocator>::DoAddChild(art_node_base** ppNode, uint8_t c, art_node_base* pChild)
+    {
+        if (Internal::ArtIsFull(static_cast<art_inner*>(*ppNode)))
+            DoResize(ppNode, (uint8_t)((*ppNode)->mType + 1));
+
+        Internal::ArtAddChild(static_cast<art_inner*>(*ppNode), c, pChild);
+    }
+
+
+    // Replaces the node at *ppNode with one of type nType with the same contents.
+    template <typename T, typename Allocator>
+    void art_map<T, Allocator>::DoResize(art_node_base** ppNode, uint8_t nType)
+    {
+        art_inner* const pOld = static_cast<art_inner*>(*ppNode);
+        art_inner* const pNew = DoCreateInner(nType);
+
+        pNew->mPrefix.swap(pOld->mPrefix);
+        pNew->mpLeaf = pOld->mpLeaf;
+        Internal::ArtForEachChild(pOld, [pNew](uint8_t c, art_node_base* pChild) { Internal::ArtAddChild(pNew, c, pChild); });
+
+        *ppNode = pNew;
+        DoFreeInner(pOld);
+    }
+
+
+    // After a leaf was taken out of the node at *ppNode: replaces a node left with
+    // only its own leaf by that leaf, merges a node left with a single child into
+    // the child, and moves a node which is mostly empty to the next size down.
+    template <typename T, typename Allocator>
+    void art_map<T, Allocator>::DoShrink(art_node_base** ppNode)
+    {
+        art_inner* const pInner = static_cast<art_inner*>(*ppNode);
+
+        if (pInner->mnCount == 0)
+        {
+            *ppNode = pInner->mpLeaf;
+            DoFreeInner(pInner);
+        }
+        else if ((pInner->mnCount == 1) && (pInner->mpLeaf == NULL))
+        {
+            art_node_base* const pChild = Internal::ArtNextChild(pInner, -1);
+
+            if (pChild->mType != kArtLeaf)
+            {
+                uint8_t c = 0;
+                Internal::ArtForEachChild(pInner, [&c](uint8_t cChild, art_node_base*) { c = cChild; });
+
+                art_inner* const pChildInner = static_cast<art_inner*>(pChild);
+                pInner->mPrefix += (char)c;
+                pInner->mPrefix += pChildInner->mPrefix;
+                pChildInner->mPrefix.swap(pInner->mPrefix);
+            }
+
+            *ppNode = pChild;
+            DoFreeInner(pInner);
+        }
+        else if ((pInner->mType == kArtNode16) && (pInner->mnCount <= 3))
+            DoResize(ppNode, kArtNode4);
+        else if ((pInner->mType == kArtNode48) && (pInner->mnCount <= 12))
+            DoResize(ppNode, kArtNode16);
+        else if ((pInner->mType == kArtNode256) && (pInner->mnCount <= 40))
+            DoResize(ppNode, kArtNode48);
+    }
+
+
+    template <typename T, typename Allocator>
+    inline void art_map<T, Allocator>::DoLinkBefore(art_list_node* pPosition, art_list_node* pNode)
+    {
+        pNode->mpNext = pPosition;
+        pNode->mpPrev = pPosition->mpPrev;
+        pPosition->mpPrev->mpNext = pNode;
+        pPosition->mpPrev = pNode;
+    }
+
+
+    template <typename T, typename Allocator>
+    inline void art_map<T, Allocator>::DoUnlink(art_list_node* pNode)
+    {
+        pNode->mpPrev->mpNext = pNode->mpNext;
+        pNode->mpNext->mpPrev = pNode->mpPrev;
+    }
+
+} // namespace easy
+
+#endif // __EASY_ART_MAP_H__
@@ -0,0 +1,1359 @@
+#ifndef __EASY_BITMAP_SET_H__
+#define __EASY_BITMAP_SET_H__
+
+/**
+ * 压缩位图的整数集合(Roaring): 按高16位分块, 每块按密度存为有序数组, 位图或区间, 支持有序查询和按块的并, 交, 计数
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+#include "RbTree.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace easy
+{
+    namespace Internal
+    {
+        // Returns the number of set bits. The bitset loops below count a word at a
+        // time, which compilers turn into vector code where the target has it.
+        inline unsigned BitmapCountBits(uint64_t n)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            return (unsigned)__builtin_popcountll(n);
+#else
+            n = n - ((n >> 1) & 0x5555555555555555ULL);
+            n = (n & 0x3333333333333333ULL) + ((n >> 2) & 0x3333333333333333ULL);
+            n = (n + (n >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+            return (unsigned)((n * 0x0101010101010101ULL) >> 56);
+#endif
+        }
+
+        // Returns the index of the lowest set bit of a non-zero word. The halves are
+        // scanned separately, as 32-bit targets have no 64-bit bit scan.
+        inline unsigned BitmapLowestBit(uint64_t n)
+        {
+            const uint32_t nLow = (uint32_t)n;
+            const uint32_t nScan = nLow ? nLow : (uint32_t)(n >> 32);
+            const unsigned nOffset = nLow ? 0 : 32;
+#if defined(_MSC_VER)
+            unsigned long nIndex;
+            _BitScanForward(&nIndex, nScan);
+            return nOffset + (unsigned)nIndex;
+#elif defined(__GNUC__) || defined(__clang__)
+            return nOffset + (unsigned)__builtin_ctz(nScan);
+#else
+            unsigned nIndex = 0;
+            for (uint32_t x = nScan; !(x & 1); x >>= 1)
+                ++nIndex;
+            return nOffset + nIndex;
+#endif
+        }
+
+        // Returns the index of the highest set bit of a non-zero word.
+        inline unsigned BitmapHighestBit(uint64_t n)
+        {
+            const uint32_t nHigh = (uint32_t)(n >> 32);
+            const uint32_t nScan = nHigh ? nHigh : (uint32_t)n;
+            const unsigned nOffset = nHigh ? 32 : 0;
+#if defined(_MSC_VER)
+            unsigned long nIndex;
+            _BitScanReverse(&nIndex, nScan);
+            return nOffset + (unsigned)nIndex;
+#elif defined(__GNUC__) || defined(__clang__)
+            return nOffset + 31 - (unsigned)__builtin_clz(nScan);
+#else
+            unsigned nIndex = 31;
+            for (uint32_t x = nScan; !(x & 0x80000000u); x <<= 1)
+                --nIndex;
+            return nOffset + nIndex;
+#endif
+        }
+
+
+        enum bitmap_container_type
+        {
+            kBitmapArray,   // The values in order, 2 bytes each.
+            kBitmapBitset,  // One bit per possible value, 8KB.
+            kBitmapRun      // The first and last value of each run of consecutive values, 4 bytes per run.
+        };
+
+        static const uint32_t kBitmapWordCount = 1024;  // Words of a bitset: 65536 bits.
+        static const uint32_t kBitmapArrayMax = 4096;   // More values take more space as an array than as a bitset.
+
+
+        // The values of a bitmap_set which share their high 16 bits, stored as
+        // whichever of the container types takes the least space.
+        struct bitmap_container
+        {
+            std::vector<uint16_t> mValues;  // Array: the values. Run: first and last of each run.
+            std::vector<uint64_t> mWords;   // Bitset: kBitmapWordCount words.
+            uint32_t              mnSize;   // 1 to 65536, but 0 while a value is being inserted or erased.
+            uint16_t              mnKey;    // The high 16 bits.
+            uint8_t               mType;    // bitmap_container_type
+
+            explicit bitmap_container(uint16_t nKey = 0)
+                : mValues(), mWords(), mnSize(0), mnKey(nKey), mType(kBitmapArray) {}
+
+            uint32_t RunCount() const { return (uint32_t)(mValues.size() / 2); }
+            uint32_t RunFirst(uint32_t i) const { return mValues[2 * i]; }
+            uint32_t RunLast(uint32_t i) const { return mValues[2 * i + 1]; }
+        };
+
+
+        // Returns the number of runs which start at or before nLow.
+        inline uint32_t BitmapRunUpperBound(const bitmap_container& c, uint32_t nLow)
+        {
+            uint32_t nBegin = 0, nEnd = c.RunCount();
+
+            while (nBegin < nEnd)
+            {
+                const uint32_t nMid = (nBegin + nEnd) / 2;
+                if (c.RunFirst(nMid) <= nLow)
+                    nBegin = nMid + 1;
+                else
+                    nEnd = nMid;
+            }
+
+            return nBegin;
+        }
+
+        // Sets the bits nFirst to nLast, inclusive.
+        inline void BitmapSetRange(uint64_t* pWords, uint32_t nFirst, uint32_t nLast)
+        {
+            const uint32_t nFirstWord = nFirst >> 6, nLastWord = nLast >> 6;
+            const uint64_t nFirstMask = ~0ULL << (nFirst & 63);
+            const uint64_t nLastMask = ~0ULL >> (63 - (nLast & 63));
+
+            if (nFirstWord == nLastWord)
+                pWords[nFirstWord] |= (nFirstMask & nLastMask);
+            else
+            {
+                pWords[nFirstWord] |= nFirstMask;
+                for (uint32_t i = nFirstWord + 1; i < nLastWord; ++i)
+                    pWords[i] = ~0ULL;
+                pWords[nLastWord] |= nLastMask;
+            }
+        }
+
+        // Counts the set bits among nFirst to nLast, inclusive.
+        inline uint32_t BitmapCountRange(const uint64_t* pWords, uint32_t nFirst, uint32_t nLast)
+        {
+            const uint32_t nFirstWord = nFirst >> 6, nLastWord = nLast >> 6;
+            const uint64_t nFirstMask = ~0ULL << (nFirst & 63);
+            const uint64_t nLastMask = ~0ULL >> (63 - (nLast & 63));
+
+            if (nFirstWord == nLastWord)
+                return BitmapCountBits(pWords[nFirstWord] & nFirstMask & nLastMask);
+
+            uint32_t nCount = BitmapCountBits(pWords[nFirstWord] & nFirstMask) + BitmapCountBits(pWords[nLastWord] & nLastMask);
+            for (uint32_t i = nFirstWord + 1; i < nLastWord; ++i)
+                nCount += BitmapCountBits(pWords[i]);
+            return nCount;
+        }
+
+        // Finds the lowest set bit at or after nFrom.
+        inline bool BitmapNextBit(const uint64_t* pWords, uint32_t nFrom, uint32_t& nValue)
+        {
+            uint32_t nWord = nFrom >> 6;
+            uint64_t n = pWords[nWord] & (~0ULL << (nFrom & 63));
+
+            for (;;)
+            {
+                if (n)
+                {
+                    nValue = (nWord << 6) + BitmapLowestBit(n);
+                    return true;
+                }
+                if (++nWord == kBitmapWordCount)
+                    return false;
+                n = pWords[nWord];
+            }
+        }
+
+        // Finds the highest set bit at or before nFrom.
+        inline bool BitmapPrevBit(const uint64_t* pWords, uint32_t nFrom, uint32_t& nValue)
+        {
+            uint32_t nWord = nFrom >> 6;
+            uint64_t n = pWords[nWord] & (~0ULL >> (63 - (nFrom & 63)));
+
+            for (;;)
+            {
+                if (n)
+                {
+                    nValue = (nWord << 6) + BitmapHighestBit(n);
+                    return true;
+                }
+                if (nWord-- == 0)
+                    return false;
+                n = pWords[nWord];
+            }
+        }
+
+        inline bool BitmapContains(const bitmap_container& c, uint32_t nLow)
+        {
+            switch (c.mType)
+            {
+                case kBitmapArray:
+                    return std::binary_search(c.mValues.begin(), c.mValues.end(), (uint16_t)nLow);
+
+                case kBitmapBitset:
+                    return ((c.mWords[nLow >> 6] >> (nLow & 63)) & 1) != 0;
+
+                default:
+                {
+                    const uint32_t i = BitmapRunUpperBound(c, nLow);
+                    return i && (nLow <= c.RunLast(i - 1));
+                }
+            }
+        }
+
+        // Writes the container as kBitmapWordCount words.
+        inline void BitmapToWords(const bitmap_container& c, uint64_t* pWords)
+        {
+            if (c.mType == kBitmapBitset)
+            {
+                memcpy(pWords, &c.mWords[0], kBitmapWordCount * sizeof(uint64_t));
+                return;
+            }
+
+            memset(pWords, 0, kBitmapWordCount * sizeof(uint64_t));
+
+            if (c.mType == kBitmapArray)
+            {
+                for (size_t i = 0; i < c.mValues.size(); ++i)
+                    pWords[c.mValues[i] >> 6] |= (1ULL << (c.mValues[i] & 63));
+            }
+            else
+            {
+                for (uint32_t i = 0; i < c.RunCount(); ++i)
+                    BitmapSetRange(pWords, c.RunFirst(i), c.RunLast(i));
+            }
+        }
+
+        inline void BitmapToBitset(bitmap_container& c)
+        {
+            if (c.mType != kBitmapBitset)
+            {
+                std::vector<uint64_t> words(kBitmapWordCount);
+                BitmapToWords(c, &words[0]);
+                c.mWords.swap(words);
+                std::vector<uint16_t>().swap(c.mValues);
+                c.mType = kBitmapBitset;
+            }
+        }
+
+        inline void BitmapToArray(bitmap_container& c)
+        {
+            if (c.mType == kBitmapArray)
+                return;
+
+            std::vector<uint16_t> values;
+            values.reserve(c.mnSize);
+
+            if (c.mType == kBitmapBitset)
+            {
+                for (uint32_t i = 0; i < kBitmapWordCount; ++i)
+                {
+                    for (uint64_t n = c.mWords[i]; n; n &= (n - 1))
+                        values.push_back((uint16_t)((i << 6) + BitmapLowestBit(n)));
+                }
+            }
+            else
+            {
+                for (uint32_t i = 0; i < c.RunCount(); ++i)
+                {
+                    for (uint32_t nValue = c.RunFirst(i); nValue <= c.RunLast(i); ++nValue)
+                        values.push_back((uint16_t)nValue);
+                }
+            }
+
+            c.mValues.swap(values);
+            std::vector<uint64_t>().swap(c.mWords);
+            c.mType = kBitmapArray;
+        }
+
+        // Moves the container to the type which takes the least space for its size,
+        // except that runs are only started by BitmapOptimize.
+        inline void BitmapFitType(bitmap_container& c)
+        {
+            switch (c.mType)
+            {
+                case kBitmapArray:
+                    if (c.mnSize > kBitmapArrayMax)
+                        BitmapToBitset(c);
+                    break;
+
+                case kBitmapBitset:
+                    if (c.mnSize <= kBitmapArrayMax)
+                        BitmapToArray(c);
+                    break;
+
+                default:
+                    if ((c.RunCount() * 2) > std::min(c.mnSize, kBitmapArrayMax))
+                    {
+                        if (c.mnSize <= kBitmapArrayMax)
+                            BitmapToArray(c);
+                        else
+                            BitmapToBitset(c);
+                    }
+                    break;
+            }
+        }
+
+        // Returns false if nLow is already in the container.
+        inline bool BitmapInsert(bitmap_container& c, uint32_t nLow)
+        {
+            if (c.mType == kBitmapArray)
+            {
+                std::vector<uint16_t>::iterator it = std::lower_bound(c.mValues.begin(), c.mValues.end(), (uint16_t)nLow);
+                if ((it != c.mValues.end()) && (*it == nLow))
+                    return false;
+                c.mValues.insert(it, (uint16_t)nLow);
+            }
+            else if (c.mType == kBitmapBitset)
+            {
+                uint64_t& nWord = c.mWords[nLow >> 6];
+                const uint64_t nBit = 1ULL << (nLow & 63);
+                if (nWord & nBit)
+                    return false;
+                nWord |= nBit;
+            }
+            else
+            {
+                const uint32_t i = BitmapRunUpperBound(c, nLow);
+                if (i && (nLow <= c.RunLast(i - 1)))
+                    return false;
+
+                const bool bJoinPrev = i && ((c.RunLast(i - 1) + 1) == nLow);
+                const bool bJoinNext = (i < c.RunCount()) && (c.RunFirst(i) == (nLow + 1));
+
+                if (bJoinPrev && bJoinNext)
+                {
+                    c.mValues[2 * i - 1] = c.mValues[2 * i + 1];
+                    c.mValues.erase(c.mValues.begin() + 2 * i, c.mValues.begin() + 2 * i + 2);
+                }
+                else if (bJoinPrev)
+                    c.mValues[2 * i - 1] = (uint16_t)nLow;
+                else if (bJoinNext)
+                    c.mValues[2 * i] = (uint16_t)nLow;
+                else
+                    c.mValues.insert(c.mValues.begin() + 2 * i, 2, (uint16_t)nLow);
+            }
+
+            ++c.mnSize;
+            BitmapFitType(c);
+            return true;
+        }
+
+        // Returns false if nLow isn't in the container. The caller drops the
+        // container when it becomes empty.
+        inline bool BitmapErase(bitmap_container& c, uint32_t nLow)
+        {
+            if (c.mType == kBitmapArray)
+            {
+                std::vector<uint16_t>::iterator it = std::lower_bound(c.mValues.begin(), c.mValues.end(), (uint16_t)nLow);
+                if ((it == c.mValues.end()) || (*it != nLow))
+                    return false;
+                c.mValues.erase(it);
+            }
+            else if (c.mType == kBitmapBitset)
+            {
+                uint64_t& nWord = c.mWords[nLow >> 6];
+                const uint64_t nBit = 1ULL << (nLow & 63);
+                if (!(nWord & nBit))
+                    return false;
+                nWord &= ~nBit;
+            }
+            else
+            {
+                const uint32_t i = BitmapRunUpperBound(c, nLow);
+                if (!i || (nLow > c.RunLast(i - 1)))
+                    return false;
+
+                const uint32_t r = i - 1, nFirst = c.RunFirst(r), nLast = c.RunLast(r);
+
+                if (nFirst == nLast)
+                    c.mValues.erase(c.mValues.begin() + 2 * r, c.mValues.begin() + 2 * r + 2);
+                else if (nLow == nFirst)
+                    c.mValues[2 * r] = (uint16_t)(nLow + 1);
+                else if (nLow == nLast)
+                    c.mValues[2 * r + 1] = (uint16_t)(nLow - 1);
+                else
+                {
+                    const uint16_t split[2] = { (uint16_t)(nLow + 1), (uint16_t)nLast };
+                    c.mValues[2 * r + 1] = (uint16_t)(nLow - 1);
+                    c.mValues.insert(c.mValues.begin() + 2 * r + 2, split, split + 2);
+                }
+            }
+
+            if (--c.mnSize)
+                BitmapFitType(c);
+            return true;
+        }
+
+        // The cursor functions find a value in the container. nPos is the index of
+        // the value in an array, of its run in a run container, and unused in a bitset.
+
+        // Finds the lowest value at or after nLow.
+        inline bool BitmapSeek(const bitmap_container& c, uint32_t nLow, uint32_t& nValue, uint32_t& nPos)
+        {
+            if (c.mType == kBitmapArray)
+            {
+                std::vector<uint16_t>::const_iterator it = std::lower_bound(c.mValues.begin(), c.mValues.end(), (uint16_t)nLow);
+                if (it == c.mValues.end())
+                    return false;
+                nPos = (uint32_t)(it - c.mValues.begin());
+                nValue = *it;
+                return true;
+            }
+
+            if (c.mType == kBitmapBitset)
+                return BitmapNextBit(&c.mWords[0], nLow, nValue);
+
+            const uint32_t i = BitmapRunUpperBound(c, nLow);
+            if (i && (nLow <= c.RunLast(i - 1)))
+            {
+                nPos = i - 1;
+                nValue = nLow;
+                return true;
+            }
+            if (i < c.RunCount())
+            {
+                nPos = i;
+                nValue = c.RunFirst(i);
+                return true;
+            }
+            return false;
+        }
+
+        // Finds the highest value at or before nLow.
+        inline bool BitmapSeekBack(const bitmap_container& c, uint32_t nLow, uint32_t& nValue, uint32_t& nPos)
+        {
+            if (c.mType == kBitmapArray)
+            {
+                std::vector<uint16_t>::const_iterator it = std::upper_bound(c.mValues.begin(), c.mValues.end(), (uint16_t)nLow);
+                if (it == c.mValues.begin())
+                    return false;
+                nPos = (uint32_t)(--it - c.mValues.begin());
+                nValue = *it;
+                return true;
+            }
+
+            if (c.mType == kBitmapBitset)
+                return BitmapPrevBit(&c.mWords[0], nLow, nValue);
+
+            const uint32_t i = BitmapRunUpperBound(c, nLow);
+            if (!i)
+                return false;
+            nPos = i - 1;
+            nValue = std::min(nLow, c.RunLast(i - 1));
+            return true;
+        }
+
+        // Moves from nValue to the next value.
+        inline bool BitmapNext(const bitmap_container& c, uint32_t& nValue, uint32_t& nPos)
+        {
+            if (c.mType == kBitmapArray)
+            {
+                if ((nPos + 1) >= c.mValues.size())
+                    return false;
+                nValue = c.mValues[++nPos];
+                return true;
+            }
+
+            if (c.mType == kBitmapBitset)
+                return (nValue < 0xFFFF) && BitmapNextBit(&c.mWords[0], nValue + 1, nValue);
+
+            if (nValue < c.RunLast(nPos))
+            {
+                ++nValue;
+                return true;
+            }
+            if ((nPos + 1) < c.RunCount())
+            {
+                nValue = c.RunFirst(++nPos);
+                return true;
+            }
+            return false;
+        }
+
+        // Moves from nValue to the previous value.
+        inline bool BitmapPrev(const bitmap_container& c, uint32_t& nValue, uint32_t& nPos)
+        {
+            if (c.mType == kBitmapArray)
+            {
+                if (nPos == 0)
+                    return false;
+                nValue = c.mValues[--nPos];
+                return true;
+            }
+
+            if (c.mType == kBitmapBitset)
+                return (nValue > 0) && BitmapPrevBit(&c.mWords[0], nValue - 1, nValue);
+
+            if (nValue > c.RunFirst(nPos))
+            {
+                --nValue;
+                return true;
+            }
+            if (nPos > 0)
+            {
+                nValue = c.RunLast(--nPos);
+                return true;
+            }
+            return false;
+        }
+
+        // Merges two sequences of runs, in which runs which overlap or touch join.
+        inline void BitmapUnionRuns(bitmap_container& a, const bitmap_container& b)
+        {
+            std::vector<uint16_t> runs;
+            runs.reserve(a.mValues.size() + b.mValues.size());
+
+            uint32_t i = 0, j = 0, nSize = 0;
+            while ((i < a.RunCount()) || (j < b.RunCount()))
+            {
+                const bool bFromA = (j == b.RunCount()) || ((i < a.RunCount()) && (a.RunFirst(i) <= b.RunFirst(j)));
+                const uint32_t nFirst = bFromA ? a.RunFirst(i) : b.RunFirst(j);
+                const uint32_t nLast = bFromA ? a.RunLast(i++) : b.RunLast(j++);
+
+                if (!runs.empty() && (nFirst <= ((uint32_t)runs.back() + 1)))
+                {
+                    if (nLast > runs.back())
+                    {
+                        nSize += nLast - runs.back();
+                        runs.back() = (uint16_t)nLast;
+                    }
+                }
+                else
+                {
+                    runs.push_back((uint16_t)nFirst);
+                    runs.push_back((uint16_t)nLast);
+                    nSize += nLast - nFirst + 1;
+                }
+            }
+
+            a.mValues.swap(runs);
+            a.mnSize = nSize;
+        }
+
+        // Adds the values of b to a.
+        inline void BitmapUnion(bitmap_container& a, const bitmap_container& b)
+        {
+            if ((a.mType == kBitmapArray) && (b.mType == kBitmapArray) && ((a.mnSize + b.mnSize) <= kBitmapArrayMax))
+            {
+                std::vector<uint16_t> values(a.mnSize + b.mnSize);
+                values.erase(std::set_union(a.mValues.begin(), a.mValues.end(), b.mValues.begin(), b.mValues.end(), values.begin()), values.end());
+                a.mValues.swap(values);
+                a.mnSize = (uint32_t)a.mValues.size();
+                return;
+            }
+
+            if ((a.mType == kBitmapRun) && (b.mType == kBitmapRun))
+            {
+                BitmapUnionRuns(a, b);
+                BitmapFitType(a);
+                return;
+            }
+
+            BitmapToBitset(a);
+            uint64_t* const pWords = &a.mWords[0];
+            uint32_t nSize = 0;
+
+            if (b.mType == kBitmapBitset)
+            {
+                const uint64_t* const pOther = &b.mWords[0];
+                for (uint32_t i = 0; i < kBitmapWordCount; ++i)
+                {
+                    pWords[i] |= pOther[i];
+                    nSize += BitmapCountBits(pWords[i]);
+                }
+            }
+            else
+            {
+                if (b.mType == kBitmapArray)
+                {
+                    for (size_t i = 0; i < b.mValues.size(); ++i)
+                        pWords[b.mValues[i] >> 6] |= (1ULL << (b.mValues[i] & 63));
+                }
+                else
+                {
+                    for (uint32_t i = 0; i < b.RunCount(); ++i)
+                        BitmapSetRange(pWords, b.RunFirst(i), b.RunLast(i));
+                }
+                for (uint32_t i = 0; i < kBitmapWordCount; ++i)
+                    nSize += BitmapCountBits(pWords[i]);
+            }
+
+            a.mnSize = nSize;
+            BitmapFitType(a);
+        }
+
+        // Keeps the values of a which are also in b. a may become empty.
+        inline void BitmapIntersect(bitmap_container& a, const bitmap_container& b)
+        {
+            if (a.mType == kBitmapArray)
+            {
+                size_t nOut = 0;
+
+                if (b.mType == kBitmapArray)
+                {
+                    for (size_t i = 0, j = 0; (i < a.mValues.size()) && (j < b.mValues.size()); )
+                    {
+                        if (a.mValues[i] < b.mValues[j])
+                            ++i;
+                        else if (b.mValues[j] < a.mValues[i])
+                            ++j;
+                        else
+                        {
+                            a.mValues[nOut++] = a.mValues[i++];
+                            ++j;
+                        }
+                    }
+                }
+                else
+                {
+                    for (size_t i = 0; i < a.mValues.size(); ++i)
+                    {
+                        if (BitmapContains(b, a.mValues[i]))
+                            a.mValues[nOut++] = a.mValues[i];
+                    }
+                }
+
+                a.mValues.resize(nOut);
+                a.mnSize = (uint32_t)nOut;
+                return;
+            }
+
+            if (b.mType == kBitmapArray)
+            {
+                std::vector<uint16_t> values;
+                values.reserve(b.mValues.size());
+                for (size_t i = 0; i < b.mValues.size(); ++i)
+                {
+                    if (BitmapContains(a, b.mValues[i]))
+                        values.push_back(b.mValues[i]);
+                }
+
+                a.mValues.swap(values);
+                std::vector<uint64_t>().swap(a.mWords);
+                a.mType = kBitmapArray;
+                a.mnSize = (uint32_t)a.mValues.size();
+                return;
+            }
+
+            if ((a.mType == kBitmapRun) && (b.mType == kBitmapRun))
+            {
+                std::vector<uint16_t> runs;
+                uint32_t nSize = 0;
+
+                for (uint32_t i = 0, j = 0; (i < a.RunCount()) && (j < b.RunCount()); )
+                {
+                    const uint32_t nFirst = std::max(a.RunFirst(i), b.RunFirst(j));
+                    const uint32_t nLast = std::min(a.RunLast(i), b.RunLast(j));
+                    if (nFirst <= nLast)
+                    {
+                        runs.push_back((uint16_t)nFirst);
+                        runs.push_back((uint16_t)nLast);
+                        nSize += nLast - nFirst + 1;
+                    }
+                    if (a.RunLast(i) < b.RunLast(j))
+                        ++i;
+                    else
+                        ++j;
+                }
+
+                a.mValues.swap(runs);
+                a.mnSize = nSize;
+                if (nSize)
+                    BitmapFitType(a);
+                return;
+            }
+
+            // Both are bitsets or runs, and at least one is a bitset.
+            std::vector<uint64_t> mask;
+            const uint64_t* pOther = b.mType == kBitmapBitset ? &b.mWords[0] : NULL;
+            if (!pOther)
+            {
+                mask.resize(kBitmapWordCount);
+                BitmapToWords(b, &mask[0]);
+                pOther = &mask[0];
+            }
+
+            BitmapToBitset(a);
+            uint64_t* const pWords = &a.mWords[0];
+            uint32_t nSize = 0;
+            for (uint32_t i = 0; i < kBitmapWordCount; ++i)
+            {
+                pWords[i] &= pOther[i];
+                nSize += BitmapCountBits(pWords[i]);
+            }
+
+            a.mnSize = nSize;
+            if (nSize)
+                BitmapFitType(a);
+        }
+
+        // Returns how many values a and b have in common, without building them.
+        inline uint32_t BitmapIntersectionSize(const bitmap_container& a, const bitmap_container& b)
+        {
+            if ((a.mType == kBitmapArray) && (b.mType == kBitmapArray))
+            {
+                uint32_t nCount = 0;
+                for (size_t i = 0, j = 0; (i < a.mValues.size()) && (j < b.mValues.size()); )
+                {
+                    if (a.mValues[i] < b.mValues[j])
+                        ++i;
+                    else if (b.mValues[j] < a.mValues[i])
+                        ++j;
+                    else
+                    {
+                        ++nCount;
+                        ++i;
+                        ++j;
+                    }
+                }
+                return nCount;
+            }
+
+            if ((a.mType == kBitmapArray) || (b.mType == kBitmapArray))
+            {
+                const bitmap_container& array = (a.mType == kBitmapArray) ? a : b;
+                const bitmap_container& other = (a.mType == kBitmapArray) ? b : a;
+
+                uint32_t nCount = 0;
+                for (size_t i = 0; i < array.mValues.size(); ++i)
+                    nCount += BitmapContains(other, array.mValues[i]);
+                return nCount;
+            }
+
+            if ((a.mType == kBitmapBitset) && (b.mType == kBitmapBitset))
+            {
+                const uint64_t* const pA = &a.mWords[0];
+                const uint64_t* const pB = &b.mWords[0];
+                uint32_t nCount = 0;
+                for (uint32_t i = 0; i < kBitmapWordCount; ++i)
+                    nCount += BitmapCountBits(pA[i] & pB[i]);
+                return nCount;
+            }
+
+            if ((a.mType == kBitmapRun) && (b.mType == kBitmapRun))
+            {
+                uint32_t nCount = 0;
+                for (uint32_t i = 0, j = 0; (i < a.RunCount()) && (j < b.RunCount()); )
+                {
+                    const uint32_t nFirst = std::max(a.RunFirst(i), b.RunFirst(j));
+                    const uint32_t nLast = std::min(a.RunLast(i), b.RunLast(j));
+                    if (nFirst <= nLast)
+                        nCount += nLast - nFirst + 1;
+                    if (a.RunLast(i) < b.RunLast(j))
+                        ++i;
+                    else
+                        ++j;
+                }
+                return nCount;
+            }
+
+            // A run container and a bitset.
+            const bitmap_container& runs = (a.mType == kBitmapRun) ? a : b;
+            const uint64_t* const pWords = (a.mType == kBitmapRun) ? &b.mWords[0] : &a.mWords[0];
+
+            uint32_t nCount = 0;
+            for (uint32_t i = 0; i < runs.RunCount(); ++i)
+                nCount += BitmapCountRange(pWords, runs.RunFirst(i), runs.RunLast(i));
+            return nCount;
+        }
+
+        // Stores the container as runs if that takes less space than it does now.
+        inline void BitmapOptimize(bitmap_container& c)
+        {
+            if (c.mType == kBitmapRun)
+                return;
+
+            uint32_t nRunCount = 0;
+
+            if (c.mType == kBitmapArray)
+            {
+                for (size_t i = 0; i < c.mValues.size(); ++i)
+                    nRunCount += (i == 0) || (c.mValues[i] != (c.mValues[i - 1] + 1));
+            }
+            else
+            {
+                // A run starts at every set bit whose lower neighbour is clear.
+                uint64_t nCarry = 0;
+                for (uint32_t i = 0; i < kBitmapWordCount; ++i)
+                {
+                    const uint64_t n = c.mWords[i];
+                    nRunCount += BitmapCountBits(n & ~((n << 1) | nCarry));
+                    nCarry = n >> 63;
+                }
+            }
+
+            if ((nRunCount * 2) >= std::min(c.mnSize, kBitmapArrayMax))
+                return;
+
+            std::vector<uint16_t> runs;
+            runs.reserve(nRunCount * 2);
+
+            uint32_t nValue, nPos = 0;
+            bool bMore = BitmapSeek(c, 0, nValue, nPos);
+            while (bMore)
+            {
+                const uint32_t nFirst = nValue;
+                uint32_t nLast = nValue;
+                while ((bMore = BitmapNext(c, nValue, nPos)) && (nValue == (nLast + 1)))
+                    nLast = nValue;
+                runs.push_back((uint16_t)nFirst);
+                runs.push_back((uint16_t)nLast);
+            }
+
+            c.mValues.swap(runs);
+            std::vector<uint64_t>().swap(c.mWords);
+            c.mType = kBitmapRun;
+        }
+
+        inline size_t BitmapMemoryUsage(const bitmap_container& c)
+        {
+            return (c.mValues.capacity() * sizeof(uint16_t)) + (c.mWords.capacity() * sizeof(uint64_t));
+        }
+    }
+
+
+    /// bitmap_set_iterator
+    ///
+    /// The iterator of bitmap_set. The values aren't stored as such, so operator*
+    /// returns the value rather than a reference to it. Inserting into or erasing
+    /// from the set invalidates all iterators.
+    ///
+    template <typename T>
+    struct bitmap_set_iterator
+    {
+        typedef bitmap_set_iterator<T>              this_type;
+        typedef Internal::bitmap_container          container_type;
+        typedef std::bidirectional_iterator_tag     iterator_category;
+        typedef T                                   value_type;
+        typedef ptrdiff_t                           difference_type;
+        typedef const T*                            pointer;
+        typedef T                                   reference;
+
+    public:
+        const std::vector<container_type>* mpChunks;
+        size_t                             mnChunk;  // The end iterator has the chunk count.
+        uint32_t                           mnLow;    // The low 16 bits of the value.
+        uint32_t                           mnPos;    // See BitmapSeek.
+
+    public:
+        bitmap_set_iterator()
+            : mpChunks(NULL), mnChunk(0), mnLow(0), mnPos(0) {}
+
+        bitmap_set_iterator(const std::vector<container_type>* pChunks, size_t nChunk, uint32_t nLow, uint32_t nPos)
+            : mpChunks(pChunks), mnChunk(nChunk), mnLow(nLow), mnPos(nPos) {}
+
+        reference operator*() const
+        {
+            return (T)(((uint32_t)(*mpChunks)[mnChunk].mnKey << 16) | mnLow);
+        }
+
+        this_type& operator++();
+        this_type  operator++(int);
+
+        this_type& operator--();
+        this_type  operator--(int);
+
+        bool operator==(const this_type& x) const { return (mnChunk == x.mnChunk) && (mnLow == x.mnLow); }
+        bool operator!=(const this_type& x) const { return !(*this == x); }
+    };
+
+
+
+    /// bitmap_set
+    ///
+    /// A set of unsigned integers of up to 32 bits, stored as a compressed bitmap
+    /// (the Roaring layout). The values are split into chunks of 65536 by their high
+    /// 16 bits, and each chunk stores its low 16 bits as whichever takes the least
+    /// space: a sorted array of up to 4096 values, a bitset of 8KB, or, after
+    /// optimize, the first and last value of each run of consecutive values. A dense
+    /// set of document ids then takes about a bit per possible id, and a sparse one
+    /// about 2 bytes per id, against the 40 or so bytes of a node of easy::set<uint32_t>.
+    ///
+    /// The query API is that of easy::set: find, count, lower_bound, upper_bound and
+    /// ordered iteration. Iterators are constant and are invalidated by any change.
+    ///
+    /// Union and intersection work a chunk at a time; two bitsets are combined with
+    /// word-wide AND or OR and counted with popcount in one loop, which compilers
+    /// vectorize where the target has vector instructions. intersection_size counts
+    /// the common values without building the intersection.
+    ///
+    /// Example usage:
+    ///     easy::bitmap_set<uint32_t> a, b;
+    ///     ... // Insert document ids.
+    ///     size_t nBoth = a.intersection_size(b);
+    ///     a &= b;
+    ///
+    template <typename T = uint32_t>
+    class bitmap_set
+    {
+        static_assert(std::is_integral<T>::value && std::is_unsigned<T>::value && (sizeof(T) <= 4),
+                      "bitmap_set holds unsigned integers of up to 32 bits");
+
+    public:
+        typedef bitmap_set<T>                   this_type;
+        typedef T                               key_type;
+        typedef T                               value_type;
+        typedef size_t                          size_type;
+        typedef bitmap_set_iterator<T>          iterator;
+        typedef bitmap_set_iterator<T>          const_iterator;
+        typedef Internal::bitmap_container      container_type;
+
+    public:
+        bitmap_set();
+
+        template <typename InputIterator>
+        bitmap_set(InputIterator first, InputIterator last);
+
+    public:
+        iterator begin() const;
+        iterator end() const;
+
+        bool      empty() const { return mnSize == 0; }
+        size_type size() const { return mnSize; }
+
+        easy::pair<iterator, bool> insert(T value);
+
+        /// Sorts the values before inserting them, so that each chunk is found once
+        /// and new chunks are appended rather than inserted into the chunk list.
+        /// Building a sparse set this way is much faster than one value at a time.
+        template <typename InputIterator>
+        void insert(InputIterator first, InputIterator last);
+
+        size_type erase(T value);
+
+        /// Returns the iterator to the value after position.
+        iterator  erase(const_iterator position);
+
+        void clear();
+        void swap(this_type& x);
+
+        iterator  find(T value) const;
+        size_type count(T value) const { return contains(value) ? 1 : 0; }
+        bool      contains(T value) const;
+        iterator  lower_bound(T value) const;
+        iterator  upper_bound(T value) const;
+
+        /// Adds the values of x.
+        this_type& operator|=(const this_type& x);
+
+        /// Keeps the values which are also in x.
+        this_type& operator&=(const this_type& x);
+
+        /// Returns the size of the intersection with x, without building it.
+        size_type intersection_size(const this_type& x) const;
+
+        /// Stores every chunk with long runs of consecutive values as runs, where
+        /// that takes less space. Worth calling once a set is built; inserts and
+        /// erases keep runs as long as they stay smaller, but never start them.
+        void optimize();
+
+        /// Returns the bytes the set takes, including the object itself.
+        size_t memory_usage() const;
+
+    protected:
+        size_t   DoFindChunk(uint32_t nKey) const;
+        iterator DoSeek(size_t nChunk, uint32_t nLow) const;
+        iterator DoLowerBound(uint32_t nValue) const;
+        bool     DoInsert(uint32_t nValue, size_t& nChunk);
+
+    protected:
+        std::vector<container_type> mChunks;  // In order of key.
+        size_type                   mnSize;
+    };
+
+
+    template <typename T>
+    inline bitmap_set<T> operator|(const bitmap_set<T>& a, const bitmap_set<T>& b)
+    {
+        bitmap_set<T> result(a);
+        result |= b;
+        return result;
+    }
+
+    template <typename T>
+    inline bitmap_set<T> operator&(const bitmap_set<T>& a, const bitmap_set<T>& b)
+    {
+        bitmap_set<T> result(a);
+        result &= b;
+        return result;
+    }
+
+
+
+    ///////////////////////////////////////////////////////////////////////
+    // bitmap_set_iterator
+    ///////////////////////////////////////////////////////////////////////
+
+    template <typename T>
+    inline typename bitmap_set_iterator<T>::this_type& bitmap_set_iterator<T>::operator++()
+    {
+        if (!Internal::BitmapNext((*mpChunks)[mnChunk], mnLow, mnPos))
+        {
+            mnLow = mnPos = 0;
+            if (++mnChunk < mpChunks->size())
+                Internal::BitmapSeek((*mpChunks)[mnChunk], 0, mnLow, mnPos);
+        }
+        return *this;
+    }
+
+
+    template <typename T>
+    inline typename bitmap_set_iterator<T>::this_type bitmap_set_iterator<T>::operator++(int)
+    {
+        this_type temp(*this);
+        ++*this;
+        return temp;
+    }
+
+
+    template <typename T>
+    inline typename bitmap_set_iterator<T>::this_type& bitmap_set_iterator<T>::operator--()
+    {
+        if ((mnChunk == mpChunks->size()) || !Internal::BitmapPrev((*mpChunks)[mnChunk], mnLow, mnPos))
+            Internal::BitmapSeekBack((*mpChunks)[--mnChunk], 0xFFFF, mnLow, mnPos);
+        return *this;
+    }
+
+
+    template <typename T>
+    inline typename bitmap_set_iterator<T>::this_type bitmap_set_iterator<T>::operator--(int)
+    {
+        this_type temp(*this);
+        --*this;
+        return temp;
+    }
+
+
+
+    ///////////////////////////////////////////////////////////////////////
+    // bitmap_set
+    ///////////////////////////////////////////////////////////////////////
+
+    template <typename T>
+    inline bitmap_set<T>::bitmap_set()
+        : mChunks(),
+        mnSize(0)
+    {
+    }
+
+
+    template <typename T>
+    template <typename InputIterator>
+    inline bitmap_set<T>::bitmap_set(InputIterator first, InputIterator last)
+        : mChunks(),
+        mnSize(0)
+    {
+        insert(first, last);
+    }
+
+
+    template <typename T>
+    inline typename bitmap_set<T>::iterator bitmap_set<T>::begin() const
+    {
+        return DoSeek(0, 0);
+    }
+
+
+    template <typename T>
+    inline typename bitmap_set<T>::iterator bitmap_set<T>::end() const
+    {
+        return iterator(&mChunks, mChunks.size(), 0, 0);
+    }
+
+
+    template <typename T>
+    inline easy::pair<typename bitmap_set<T>::iterator, bool> bitmap_set<T>::insert(T value)
+    {
+        size_t nChunk = mChunks.size();
+        const bool bInserted = DoInsert((uint32_t)value, nChunk);
+
+        uint32_t nLow, nPos = 0;
+        Internal::BitmapSeek(mChunks[nChunk], (uint32_t)value & 0xFFFF, nLow, nPos);
+        return easy::pair<iterator, bool>(iterator(&mChunks, nChunk, nLow, nPos), bInserted);
+    }
+
+
+    template <typename T>
+    template <typename InputIterator>
+    inline void bitmap_set<T>::insert(InputIterator first, InputIterator last)
+    {
+        std::vector<uint32_t> values;
+        for (; first != last; ++first)
+            values.push_back((uint32_t)*first);
+        std::sort(values.begin(), values.end());
+
+        size_t nChunk = mChunks.size(); // Kept from one value to the next, which skips the search while the high bits stay the same.
+
+        for (size_t i = 0; i < values.size(); ++i)
+            DoInsert(values[i], nChunk);
+    }
+
+
+    template <typename T>
+    inline typename bitmap_set<T>::size_type bitmap_set<T>::erase(T value)
+    {
+        const size_t nChunk = DoFindChunk((uint32_t)value >> 16);
+
+        if ((nChunk == mChunks.size()) || (mChunks[nChunk].mnKey != ((uint32_t)value >> 16)) ||
+            !Internal::BitmapErase(mChunks[nChunk], (uint32_t)value & 0xFFFF))
+            return 0;
+
+        if (mChunks[nChunk].mnSize == 0)
+            mChunks.erase(mChunks.begin() + nChunk);
+        --mnSize;
+        return 1;
+    }
+
+
+    template <typename T>
+    inline typename bitmap_set<T>::iterator bitmap_set<T>::erase(const_iterator position)
+    {
+        const T value = *position;
+        erase(value);
+        return DoLowerBound((uint32_t)value);
+    }
+
+
+    template <typename T>
+    inline void bitmap_set<T>::clear()
+    {
+        mChunks.clear();
+        mnSize = 0;
+    }
+
+
+    template <typename T>
+    inline void bitmap_set<T>::swap(this_type& x)
+    {
+        mChunks.swap(x.mChunks);
+        std::swap(mnSize, x.mnSize);
+    }
+
+
+    template <typename T>
+    inline typename bitmap_set<T>::iterator bitmap_set<T>::find(T value) const
+    {
+        const uint32_t nKey = (uint32_t)value >> 16, nLow = (uint32_t)value & 0xFFFF;
+        const size_t   nChunk = DoFindChunk(nKey);
+
+        uint32_t nFound, nPos = 0;
+        if ((nChunk < mChunks.size()) && (mChunks[nChunk].mnKey == nKey) &&
+            Internal::BitmapSeek(mChunks[nChunk], nLow, nFound, nPos) && (nFound == nLow))
+            return iterator(&mChunks, nChunk, nFound, nPos);
+
+        return end();
+    }
+
+
+    template <typename T>
+    inline bool bitmap_set<T>::contains(T value) const
+    {
+        const uint32_t nKey = (uint32_t)value >> 16;
+        const size_t   nChunk = DoFindChunk(nKey);
+
+        return (nChunk < mChunks.size()) && (mChunks[nChunk].mnKey == nKey) &&
+               Internal::BitmapContains(mChunks[nChunk], (uint32_t)value & 0xFFFF);
+    }
+
+
+    template <typename T>
+    inline typename bitmap_set<T>::iterator bitmap_set<T>::lower_bound(T value) const
+    {
+        return DoLowerBound((uint32_t)value);
+    }
+
+
+    template <typename T>
+    inline typename bitmap_set<T>::iterator bitmap_set<T>::upper_bound(T value) const
+    {
+        return ((uint32_t)value == 0xFFFFFFFFu) ? end() : DoLowerBound((uint32_t)value + 1);
+    }
+
+
+    template <typename T>
+    inline typename bitmap_set<T>::this_type& bitmap_set<T>::operator|=(const this_type& x)
+    {
+        if (this == &x)
+            return *this;
+
+        std::vector<container_type> chunks;
+        chunks.reserve(mChunks.size() + x.mChunks.size());
+        mnSize = 0;
+
+        for (size_t i = 0, j = 0; (i < mChunks.size()) || (j < x.mChunks.size()); )
+        {
+            if ((j == x.mChunks.size()) || ((i < mChunks.size()) && (mChunks[i].mnKey < x.mChunks[j].mnKey)))
+                chunks.push_back(std::move(mChunks[i++]));
+            else if ((i == mChunks.size()) || (x.mChunks[j].mnKey < mChunks[i].mnKey))
+                chunks.push_back(x.mChunks[j++]);
+            else
+            {
+                chunks.push_back(std::move(mChunks[i++]));
+                Internal::BitmapUnion(chunks.back(), x.mChunks[j++]);
+            }
+            mnSize += chunks.back().mnSize;
+        }
+
+        mChunks.swap(chunks);
+        return *this;
+    }
+
+
+    template <typename T>
+    inline typename bitmap_set<T>::this_type& bitmap_set<T>::operator&=(const this_type& x)
+    {
+        if (this == &x)
+            return *this;
+
+        size_t nOut = 0;
+        mnSize = 0;
+
+        for (size_t i = 0, j = 0; (i < mChunks.size()) && (j < x.mChunks.size()); )
+        {
+            if (mChunks[i].mnKey < x.mChunks[j].mnKey)
+                ++i;
+            else if (x.mChunks[j].mnKey < mChunks[i].mnKey)
+                ++j;
+            else
+            {
+                Internal::BitmapIntersect(mChunks[i], x.mChunks[j++]);
+                if (mChunks[i].mnSize)
+                {
+                    mnSize += mChunks[i].mnSize;
+                    if (nOut != i)
+                        mChunks[nOut] = std::move(mChunks[i]);
+                    ++nOut;
+                }
+                ++i;
+            }
+        }
+
+        mChunks.erase(mChunks.begin() + nOut, mChunks.end());
+        return *this;
+    }
+
+
+    template <typename T>
+    inline typename bitmap_set<T>::size_type bitmap_set<T>::intersection_size(const this_type& x) const
+    {
+        size_type nCount = 0;
+
+        for (size_t i = 0, j = 0; (i < mChunks.size()) && (j < x.mChunks.size()); )
+        {
+            if (mChunks[i].mnKey < x.mChunks[j].mnKey)
+                ++i;
+            else if (x.mChunks[j].mnKey < mChunks[i].mnKey)
+                ++j;
+            else
+                nCount += Internal::BitmapIntersectionSize(mChunks[i++], x.mChunks[j++]);
+        }
+
+        return nCount;
+    }
+
+
+    template <typename T>
+    inline void bitmap_set<T>::optimize()
+    {
+        for (size_t i = 0; i < mChunks.size(); ++i)
+            Internal::BitmapOptimize(mChunks[i]);
+    }
+
+
+    template <typename T>
+    inline size_t bitmap_set<T>::memory_usage() const
+    {
+        size_t nBytes = sizeof(*this) + (mChunks.capacity() * sizeof(container_type));
+
+        for (size_t i = 0; i < mChunks.size(); ++i)
+            nBytes += Internal::BitmapMemoryUsage(mChunks[i]);
+
+        return nBytes;
+    }
+
+
+    // Returns the index of the first chunk whose key isn't less than nKey.
+    template <typename T>
+    inline size_t bitmap_set<T>::DoFindChunk(uint32_t nKey) const
+    {
+        size_t nBegin = 0, nEnd = mChunks.size();
+
+        while (nBegin < nEnd)
+        {
+            const size_t nMid = (nBegin + nEnd) / 2;
+            if (mChunks[nMid].mnKey < nKey)
+                nBegin = nMid + 1;
+            else
+                nEnd = nMid;
+        }
+
+        return nBegin;
+    }
+
+
+    // Returns the first value at or after nLow in chunk nChunk, or in the chunks after it.
+    template <typename T>
+    inline typename bitmap_set<T>::iterator bitmap_set<T>::DoSeek(size_t nChunk, uint32_t nLow) const
+    {
+        for (; nChunk < mChunks.size(); ++nChunk, nLow = 0)
+        {
+            uint32_t nFound, nPos = 0;
+            if (Internal::BitmapSeek(mChunks[nChunk], nLow, nFound, nPos))
+                return iterator(&mChunks, nChunk, nFound, nPos);
+        }
+
+        return end();
+    }
+
+
+    template <typename T>
+    inline typename bitmap_set<T>::iterator bitmap_set<T>::DoLowerBound(uint32_t nValue) const
+    {
+        const uint32_t nKey = nValue >> 16;
+        const size_t   nChunk = DoFindChunk(nKey);
+
+        if ((nChunk < mChunks.size()) && (mChunks[nChunk].mnKey == nKey))
+            return DoSeek(nChunk, nValue & 0xFFFF);
+        return DoSeek(nChunk, 0);
+    }
+
+
+    // Inserts nValue and sets nChunk to the index of its chunk. If nChunk already
+    // is the index of the chunk for nValue's high bits, the search is skipped.
+    template <typename T>
+    inline bool bitmap_set<T>::DoInsert(uint32_t nValue, size_t& nChunk)
+    {
+        const uint32_t nKey = nValue >> 16;
+
+        if ((nChunk >= mChunks.size()) || (mChunks[nChunk].mnKey != nKey))
+        {
+            nChunk = DoFindChunk(nKey);
+            if ((nChunk == mChunks.size()) || (mChunks[nChunk].mnKey != nKey))
+                mChunks.insert(mChunks.begin() + nChunk, container_type((uint16_t)nKey));
+        }
+
+        if (!Internal::BitmapInsert(mChunks[nChunk], nValue & 0xFFFF))
+            return false;
+
+        ++mnSize;
+        return true;
+    }
+
+} // namespace easy
+
+#endif // __EASY_BITMAP_SET_H__
@@ -0,0 +1,203 @@
+#ifndef __EASY_FIXED_MAP_H__
+#define __EASY_FIXED_MAP_H__
+
+/**
+ * 节点存放在对象内部的easy::map/easy::set, 不使用堆内存
+ */
+
+#include <stddef.h>
+#include "Map.h"
+#include "Set.h"
+
+namespace easy
+{
+    /// fixed_node_allocator
+    ///
+    /// Hands out nodes of nNodeSize bytes from an array of nNodeCount of them which is
+    /// part of the allocator object itself. Freed nodes go on an intrusive free list, and
+    /// nodes which were never used are handed out in array order, so constructing the
+    /// allocator doesn't touch the array.
+    ///
+    /// When the array is full, allocate falls back to the heap if bEnableOverflow is
+    /// true, and returns NULL otherwise, which makes the container's insert fail.
+    ///
+    /// Copying an allocator gives an empty one; the nodes belong to the container
+    /// which holds them.
+    ///
+    template <size_t nNodeSize, size_t nNodeCount, size_t nNodeAlignment, bool bEnableOverflow>
+    class fixed_node_allocator
+    {
+    public:
+        typedef fixed_node_allocator<nNodeSize, nNodeCount, nNodeAlignment, bEnableOverflow> this_type;
+
+        static const size_t kNodeSize = ((nNodeSize > sizeof(void*) ? nNodeSize : sizeof(void*)) + nNodeAlignment - 1) / nNodeAlignment * nNodeAlignment;
+        static const size_t kNodeCount = nNodeCount;
+
+    public:
+        fixed_node_allocator()
+            : mpFreeList(NULL),
+            mnNextUnused(0),
+            mnOverflowCount(0) {}
+
+        fixed_node_allocator(const this_type&)
+            : mpFreeList(NULL),
+            mnNextUnused(0),
+            mnOverflowCount(0) {}
+
+        this_type& operator=(const this_type&) { return *this; }
+
+        void* allocate(size_t n)
+        {
+            if (n <= kNodeSize)
+            {
+                if (mpFreeList)
+                {
+                    free_node* const pNode = mpFreeList;
+                    mpFreeList = pNode->mpNext;
+                    return pNode;
+                }
+
+                if (mnNextUnused < nNodeCount)
+                    return mBuffer + (kNodeSize * mnNextUnused++);
+            }
+
+            if (!bEnableOverflow)
+                return NULL;
+
+            ++mnOverflowCount;
+            return ::operator new(n);
+        }
+
+        void deallocate(void* p, size_t /*n*/)
+        {
+            if (owns(p))
+            {
+                free_node* const pNode = static_cast<free_node*>(p);
+                pNode->mpNext = mpFreeList;
+                mpFreeList = pNode;
+            } else
+            {
+                --mnOverflowCount;
+                ::operator delete(p);
+            }
+        }
+
+        /// Returns true if p points into the inline node array.
+        bool owns(const void* p) const
+        {
+            return (static_cast<const char*>(p) >= mBuffer) && (static_cast<const char*>(p) < (mBuffer + sizeof(mBuffer)));
+        }
+
+        /// Returns the number of live nodes which had to be allocated on the heap.
+        size_t overflow_count() const { return mnOverflowCount; }
+
+    protected:
+        struct free_node
+        {
+            free_node* mpNext;
+        };
+
+        alignas(nNodeAlignment) char mBuffer[kNodeSize * nNodeCount];
+        free_node*                   mpFreeList;
+        size_t                       mnNextUnused;      // Nodes at and after this index have never been handed out.
+        size_t                       mnOverflowCount;
+    };
+
+
+
+    /// fixed_map
+    ///
+    /// A map whose nodes live in an array inside the map object, so that it never uses
+    /// the heap while it holds at most nodeCount elements. Everything else is easy::map.
+    ///
+    /// bEnableOverflow picks what happens when a new element doesn't fit: if true the
+    /// node comes from the heap, and if false insert fails, returning an end()/false pair.
+    ///
+    /// The tree links its nodes, and its own anchor node, by address, so a fixed_map
+    /// can't be moved with memcpy even if Key and T can. It can be copied, which
+    /// rebuilds the links without allocating.
+    ///
+    /// Example usage:
+    ///     easy::fixed_map<int, int, 256, false> routes; // Never allocates.
+    ///     if (!routes.insert(easy::make_pair(1, 2)).second)
+    ///         ... // Full, or 1 was already there.
+    ///
+    template <typename Key, typename T, size_t nodeCount, bool bEnableOverflow = true, typename Compare = easy::less<Key> >
+    class fixed_map
+        : public map<Key, T, Compare,
+                     fixed_node_allocator<sizeof(rbtree_node<easy::pair<Key, T> >), nodeCount,
+                                          alignof(rbtree_node<easy::pair<Key, T> >), bEnableOverflow> >
+    {
+    public:
+        typedef fixed_node_allocator<sizeof(rbtree_node<easy::pair<Key, T> >), nodeCount,
+                                     alignof(rbtree_node<easy::pair<Key, T> >), bEnableOverflow>   allocator_type;
+        typedef map<Key, T, Compare, allocator_type>                                              base_type;
+        typedef fixed_map<Key, T, nodeCount, bEnableOverflow, Compare>                            this_type;
+        typedef typename base_type::size_type                                                     size_type;
+
+        static const size_type kMaxSize = nodeCount;
+
+        using base_type::mAllocator;
+        using base_type::mnSize;
+
+    public:
+        fixed_map() : base_type() {}
+        fixed_map(const Compare& compare) : base_type(compare) {}
+        fixed_map(const this_type& x) : base_type(x) {}
+
+        template <typename Iterator>
+        fixed_map(Iterator itBegin, Iterator itEnd) : base_type(itBegin, itEnd) {}
+
+        this_type& operator=(const this_type& x) { base_type::operator=(x); return *this; }
+
+        /// Returns the number of elements that fit without using the heap.
+        size_type capacity() const { return (size_type)nodeCount; }
+
+        /// Returns true if the next insertion can't be served from the inline array.
+        bool full() const { return (mnSize - mAllocator.overflow_count()) >= nodeCount; }
+
+        /// Returns true if some elements are stored on the heap.
+        bool has_overflowed() const { return mAllocator.overflow_count() != 0; }
+    }; // fixed_map
+
+
+
+    /// fixed_set
+    ///
+    /// A set whose nodes live in an array inside the set object. See fixed_map.
+    ///
+    template <typename Key, size_t nodeCount, bool bEnableOverflow = true, typename Compare = easy::less<Key> >
+    class fixed_set
+        : public set<Key, Compare,
+                     fixed_node_allocator<sizeof(rbtree_node<Key>), nodeCount, alignof(rbtree_node<Key>), bEnableOverflow> >
+    {
+    public:
+        typedef fixed_node_allocator<sizeof(rbtree_node<Key>), nodeCount,
+                                     alignof(rbtree_node<Key>), bEnableOverflow>    allocator_type;
+        typedef set<Key, Compare, allocator_type>                                   base_type;
+        typedef fixed_set<Key, nodeCount, bEnableOverflow, Compare>                 this_type;
+        typedef typename base_type::size_type                                       size_type;
+
+        static const size_type kMaxSize = nodeCount;
+
+        using base_type::mAllocator;
+        using base_type::mnSize;
+
+    public:
+        fixed_set() : base_type() {}
+        fixed_set(const Compare& compare) : base_type(compare) {}
+        fixed_set(const this_type& x) : base_type(x) {}
+
+        template <typename Iterator>
+        fixed_set(Iterator itBegin, Iterator itEnd) : base_type(itBegin, itEnd) {}
+
+        this_type& operator=(const this_type& x) { base_type::operator=(x); return *this; }
+
+        size_type capacity() const { return (size_type)nodeCount; }
+        bool      full() const { return (mnSize - mAllocator.overflow_count()) >= nodeCount; }
+        bool      has_overflowed() const { return mAllocator.overflow_count() != 0; }
+    }; // fixed_set
+
+} // namespace easy
+
+#endif // __EASY_FIXED_MAP_H__
@@ -0,0 +1,634 @@
+#ifndef __EASY_FROZEN_SET_H__
+#define __EASY_FROZEN_SET_H__
+
+/**
+ * 只读的压缩整数集合: 按块存差值的定宽位打包, 带跳表索引, 可以直接映射磁盘上的文件
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+#include "MappedMap.h"
+#include "Set.h"
+
+namespace easy
+{
+    /// Frozen set layout
+    ///
+    /// A frozen_set is one position independent image, which starts with a
+    /// frozen_set_header and is the same in memory and in a file. The values are
+    /// cut into blocks of kFrozenBlockSize. Each block has an entry in the skip
+    /// index, which holds its first value, and stores the gaps between the values
+    /// after that, less 1, bit-packed at the width of its largest gap. The data is
+    /// followed by a spare word, so that a gap can always be read with two loads.
+    ///
+    /// All integers are stored in the byte order of the writer.
+    ///
+    static const uint32_t kFrozenSetVersion = 1;
+    static const uint32_t kFrozenBlockSize = 128;
+
+    struct frozen_set_header
+    {
+        char     mMagic[8];          // "EASYFRZ" followed by a zero byte.
+        uint32_t mVersion;           // kFrozenSetVersion.
+        uint32_t mHeaderSize;        // sizeof(frozen_set_header).
+        uint64_t mFileSize;
+        uint64_t mCount;             // Number of values.
+        uint32_t mValueSize;         // sizeof(T).
+        uint32_t mBlockSize;         // kFrozenBlockSize.
+        uint64_t mBlockCount;
+        uint64_t mBlockOffset;       // The skip index: mBlockCount frozen_set_blocks.
+        uint64_t mDataOffset;        // The bit-packed gaps, in uint64_t words.
+        uint64_t mDataWords;         // Including the spare word.
+    };
+
+    struct frozen_set_block
+    {
+        uint64_t mnFirst;            // The first value of the block.
+        uint64_t mnBitOffset;        // Where the gaps of the block start in the data.
+        uint32_t mnWidth;            // Bits per gap, 0 to 64.
+        uint32_t mnCount;            // Values in the block, kFrozenBlockSize except in the last one.
+    };
+
+
+    namespace Internal
+    {
+        // Returns the number of bits needed to store n.
+        inline uint32_t FrozenBitWidth(uint64_t n)
+        {
+            uint32_t nWidth = 0;
+            for (; n; n >>= 1)
+                ++nWidth;
+            return nWidth;
+        }
+
+        // Reads nWidth bits at nBit. The field spans at most two words, and the
+        // spare word at the end of the data makes the second load always safe.
+        inline uint64_t FrozenReadBits(const uint64_t* pWords, uint64_t nBit, uint32_t nWidth)
+        {
+            const uint64_t* const p = pWords + (nBit >> 6);
+            const uint32_t nShift = (uint32_t)(nBit & 63);
+            uint64_t n = p[0] >> nShift;
+
+            if (nShift && ((nShift + nWidth) > 64))
+                n |= p[1] << (64 - nShift);
+            return (nWidth == 64) ? n : (n & ((1ULL << nWidth) - 1));
+        }
+
+        // Appends nWidth bits of n to a bit-packed stream of nBitCount bits.
+        inline void FrozenWriteBits(std::vector<uint64_t>& words, uint64_t& nBitCount, uint64_t n, uint32_t nWidth)
+        {
+            if (nWidth == 0)
+                return;
+
+            const uint32_t nShift = (uint32_t)(nBitCount & 63);
+            if (nShift == 0)
+                words.push_back(0);
+
+            words.back() |= n << nShift;
+            if ((nShift + nWidth) > 64)
+                words.push_back(n >> (64 - nShift));
+            nBitCount += nWidth;
+        }
+
+        inline uint64_t FrozenAlign(uint64_t n)
+        {
+            return (n + kSnapshotAlignment - 1) & ~(kSnapshotAlignment - 1);
+        }
+    }
+
+
+    /// frozen_set
+    ///
+    /// An immutable, compressed set of unsigned integers, for sets and posting
+    /// lists which are built once and then read for a long time. The values take
+    /// about as many bits each as the gaps between them need (see the layout
+    /// above), e.g. under a byte for ids that are a quarter of their range, and 3
+    /// bytes for random ids below 2^40, against the 8 bytes of a sorted array and
+    /// the 48 of an easy::set node.
+    ///
+    /// lower_bound and find binary search the skip index, then decode at most one
+    /// block, so they are O(log n). Iterating decodes one gap per step with a
+    /// shift and a mask; for_each decodes a block at a time in a tight loop.
+    ///
+    /// The whole set is one position independent image (data() and data_size()),
+    /// which write saves and open maps straight from the file, so opening is O(1)
+    /// and the pages are shared by all processes which map the file. view uses an
+    /// image held somewhere else, e.g. in a larger file mapped by the caller,
+    /// without copying it. Copying a frozen_set copies the image.
+    ///
+    /// Example usage:
+    ///     easy::frozen_set<uint64_t> ids(mySet.begin(), mySet.end());
+    ///     ids.write("ids.frozen");
+    ///
+    ///     easy::frozen_set<uint64_t> mapped;
+    ///     if (mapped.open("ids.frozen") && mapped.contains(42))
+    ///         ...
+    ///
+    template <typename T = uint64_t>
+    class frozen_set
+    {
+        static_assert(std::is_integral<T>::value && std::is_unsigned<T>::value,
+                      "frozen_set holds unsigned integers");
+
+    public:
+        typedef frozen_set<T>   this_type;
+        typedef T               key_type;
+        typedef T               value_type;
+        typedef uint64_t        size_type;
+
+        /// const_iterator
+        ///
+        /// Holds the value it is at and its index, and decodes the next or
+        /// previous gap to move. operator* returns the value, not a reference.
+        ///
+        class const_iterator
+        {
+        public:
+            typedef std::bidirectional_iterator_tag iterator_category;
+            typedef T                               value_type;
+            typedef ptrdiff_t                       difference_type;
+            typedef const T*                        pointer;
+            typedef T                               reference;
+
+        public:
+            const_iterator() : mpSet(NULL), mnIndex(0), mValue(0) {}
+            const_iterator(const this_type* pSet, uint64_t nIndex, T value) : mpSet(pSet), mnIndex(nIndex), mValue(value) {}
+
+            reference operator*() const { return mValue; }
+
+            const_iterator& operator++();
+            const_iterator  operator++(int) { const_iterator temp(*this); ++*this; return temp; }
+            const_iterator& operator--();
+            const_iterator  operator--(int) { const_iterator temp(*this); --*this; return temp; }
+
+            uint64_t index() const { return mnIndex; }
+
+            bool operator==(const const_iterator& x) const { return mnIndex == x.mnIndex; }
+            bool operator!=(const const_iterator& x) const { return mnIndex != x.mnIndex; }
+
+        private:
+            const this_type* mpSet;
+            uint64_t         mnIndex;
+            T                mValue;
+        };
+
+        typedef const_iterator iterator;
+
+    public:
+        frozen_set();
+
+        /// Encodes the values. They needn't be sorted or unique.
+        template <typename InputIterator>
+        frozen_set(InputIterator first, InputIterator last);
+
+        frozen_set(const this_type& x);
+        this_type& operator=(const this_type& x);
+
+        template <typename InputIterator>
+        void assign(InputIterator first, InputIterator last);
+
+        /// Maps a file written by write. Returns false if it can't be mapped or
+        /// isn't a frozen_set of T, in which case the set is empty.
+        bool open(const char* path);
+
+        /// Uses the image at pData, which must stay valid and unchanged while the
+        /// set uses it, and be aligned to 8 bytes. Returns false if it isn't a
+        /// frozen_set of T, in which case the set is empty. An empty set has no
+        /// image, so a size of 0 views an empty set, whatever pData is.
+        bool view(const void* pData, size_t nSize);
+
+        /// Writes the image to path. Returns false if the file could not be written.
+        bool write(const char* path) const;
+
+        void clear();
+
+        const void* data() const { return mpBase; }
+        size_t      data_size() const { return mpBase ? (size_t)header().mFileSize : 0; }
+
+        const_iterator begin() const;
+        const_iterator end() const { return const_iterator(this, size(), 0); }
+
+        bool      empty() const { return size() == 0; }
+        size_type size() const { return mpBase ? header().mCount : 0; }
+
+        const_iterator find(T value) const;
+        size_type      count(T value) const { return contains(value) ? 1 : 0; }
+        bool           contains(T value) const { return find(value) != end(); }
+        const_iterator lower_bound(T value) const;
+        const_iterator upper_bound(T value) const;
+
+        /// Calls f(value) for every value in order.
+        template <typename Function>
+        void for_each(Function f) const;
+
+        /// Returns the values as an easy::set.
+        easy::set<T> to_set() const;
+
+    protected:
+        const frozen_set_header& header() const { return *reinterpret_cast<const frozen_set_header*>(mpBase); }
+        const frozen_set_block*  blocks() const { return reinterpret_cast<const frozen_set_block*>(mpBase + header().mBlockOffset); }
+        const uint64_t*          words() const { return reinterpret_cast<const uint64_t*>(mpBase + header().mDataOffset); }
+
+        T    DoLast(uint64_t nBlock) const;
+        bool DoValidate(const char* pBase, uint64_t nSize) const;
+
+    protected:
+        std::vector<uint64_t> mStorage;  // The image, when the set owns it.
+        mapped_file           mFile;     // The mapping, when the set was opened from a file.
+        const char*           mpBase;    // The image, or NULL if the set is empty.
+    }; // frozen_set
+
+
+
+    ///////////////////////////////////////////////////////////////////////
+    // frozen_set::const_iterator
+    ///////////////////////////////////////////////////////////////////////
+
+    template <typename T>
+    inline typename frozen_set<T>::const_iterator& frozen_set<T>::const_iterator::operator++()
+    {
+        if (++mnIndex < mpSet->size())
+        {
+            const frozen_set_block& block = mpSet->blocks()[mnIndex / kFrozenBlockSize];
+            const uint64_t          nInBlock = mnIndex % kFrozenBlockSize;
+
+            if (nInBlock == 0)
+                mValue = (T)block.mnFirst;
+            else
+                mValue = (T)(mValue + Internal::FrozenReadBits(mpSet->words(), block.mnBitOffset + (nInBlock - 1) * block.mnWidth, block.mnWidth) + 1);
+        }
+        else
+            mValue = 0;
+        return *this;
+    }
+
+
+    template <typename T>
+    inline typename frozen_set<T>::const_iterator& frozen_set<T>::const_iterator::operator--()
+    {
+        const uint64_t nInBlock = mnIndex % kFrozenBlockSize;
+
+        if ((nInBlock == 0) || (mnIndex == mpSet->size()))
+            mValue = mpSet->DoLast((mnIndex - 1) / kFrozenBlockSize); // The end has no gap to undo.
+        else
+        {
+            const frozen_set_block& block = mpSet->blocks()[mnIndex / kFrozenBlockSize];
+            mValue = (T)(mValue - Internal::FrozenReadBits(mpSet->words(), block.mnBitOffset + (nInBlock - 1) * block.mnWidth, block.mnWidth) - 1);
+        }
+        --mnIndex;
+        return *this;
+    }
+
+
+
+    ///////////////////////////////////////////////////////////////////////
+    // frozen_set
+    ///////////////////////////////////////////////////////////////////////
+
+    template <typename T>
+    inline frozen_set<T>::frozen_set()
+        : mStorage(),
+        mFile(),
+        mpBase(NULL)
+    {
+    }
+
+
+    template <typename T>
+    template <typename InputIterator>
+    inline frozen_set<T>::frozen_set(InputIterator first, InputIterator last)
+        : mStorage(),
+        mFile(),
+        mpBase(NULL)
+    {
+        assign(first, last);
+    }
+
+
+    template <typename T>
+    inline frozen_set<T>::frozen_set(const this_type& x)
+        : mStorage(),
+        mFile(),
+        mpBase(NULL)
+    {
+        *this = x;
+    }
+
+
+    template <typename T>
+    inline typename frozen_set<T>::this_type& frozen_set<T>::operator=(const this_type& x)
+    {
+        if (this != &x)
+        {
+            std::vector<uint64_t> storage((x.data_size() + 7) / 8);
+            if (x.mpBase)
+                memcpy(&storage[0], x.mpBase, x.data_size());
+
+            clear();
+            mStorage.swap(storage);
+            mpBase = mStorage.empty() ? NULL : (const char*)&mStorage[0];
+        }
+        return *this;
+    }
+
+
+    template <typename T>
+    template <typename InputIterator>
+    void frozen_set<T>::assign(InputIterator first, InputIterator last)
+    {
+        std::vector<T> values;
+        for (; first != last; ++first)
+            values.push_back(*first);
+
+        if (!std::is_sorted(values.begin(), values.end()))
+            std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+
+        clear();
+        if (values.empty())
+            return;
+
+        // Pack the gaps first; the header and skip index go in front of them.
+        const uint64_t nBlockCount = (values.size() + kFrozenBlockSize - 1) / kFrozenBlockSize;
+        std::vector<frozen_set_block> blockList((size_t)nBlockCount);
+        std::vector<uint64_t>         data;
+        uint64_t                      nBitCount = 0;
+
+        for (uint64_t b = 0; b < nBlockCount; ++b)
+        {
+            const size_t nBegin = (size_t)(b * kFrozenBlockSize);
+            const size_t nEnd = std::min(nBegin + kFrozenBlockSize, values.size());
+
+            uint64_t nMaxGap = 0;
+            for (size_t i = nBegin + 1; i < nEnd; ++i)
+                nMaxGap = std::max(nMaxGap, (uint64_t)(values[i] - values[i - 1] - 1));
+
+            frozen_set_block& block = blockList[(size_t)b];
+            block.mnFirst = values[nBegin];
+            block.mnBitOffset = nBitCount;
+            block.mnWidth = Internal::FrozenBitWidth(nMaxGap);
+            block.mnCount = (uint32_t)(nEnd - nBegin);
+
+            for (size_t i = nBegin + 1; i < nEnd; ++i)
+                Internal::FrozenWriteBits(data, nBitCount, (uint64_t)(values[i] - values[i - 1] - 1), block.mnWidth);
+        }
+        data.push_back(0); // The spare word.
+
+        frozen_set_header header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.mMagic, "EASYFRZ", 8);
+        header.mVersion = kFrozenSetVersion;
+        header.mHeaderSize = sizeof(frozen_set_header);
+        header.mCount = values.size();
+        header.mValueSize = sizeof(T);
+        header.mBlockSize = kFrozenBlockSize;
+        header.mBlockCount = nBlockCount;
+        header.mBlockOffset = Internal::FrozenAlign(sizeof(frozen_set_header));
+        header.mDataOffset = Internal::FrozenAlign(header.mBlockOffset + nBlockCount * sizeof(frozen_set_block));
+        header.mDataWords = data.size();
+        header.mFileSize = header.mDataOffset + data.size() * sizeof(uint64_t);
+
+        mStorage.resize((size_t)(header.mFileSize / sizeof(uint64_t)));
+        char* const pBase = (char*)&mStorage[0];
+        memcpy(pBase, &header, sizeof(header));
+        memcpy(pBase + header.mBlockOffset, &blockList[0], blockList.size() * sizeof(frozen_set_block));
+        memcpy(pBase + header.mDataOffset, &data[0], data.size() * sizeof(uint64_t));
+        mpBase = pBase;
+    }
+
+
+    template <typename T>
+    bool frozen_set<T>::open(const char* path)
+    {
+        clear();
+
+        if (!mFile.open(path, sizeof(frozen_set_header)) || !DoValidate(mFile.data(), mFile.size()))
+        {
+            mFile.close();
+            return false;
+        }
+
+        mpBase = mFile.data();
+        return true;
+    }
+
+
+    template <typename T>
+    bool frozen_set<T>::view(const void* pData, size_t nSize)
+    {
+        clear();
+
+        if (nSize == 0) // What data() and data_size() of an empty set return.
+            return true;
+
+        if (((uintptr_t)pData % sizeof(uint64_t)) || (nSize < sizeof(frozen_set_header)) || !DoValidate((const char*)pData, nSize))
+            return false;
+
+        mpBase = (const char*)pData;
+        return true;
+    }
+
+
+    template <typename T>
+    bool frozen_set<T>::write(const char* path) const
+    {
+        FILE* const pFile = fopen(path, "wb");
+        if (pFile == NULL)
+            return false;
+
+        frozen_set_header empty;
+        const char*       pData = mpBase;
+
+        if (!pData) // An empty set is written as a header, so that it can be opened.
+        {
+            memset(&empty, 0, sizeof(empty));
+            memcpy(empty.mMagic, "EASYFRZ", 8);
+            empty.mVersion = kFrozenSetVersion;
+            empty.mHeaderSize = sizeof(frozen_set_header);
+            empty.mFileSize = sizeof(frozen_set_header);
+            empty.mValueSize = sizeof(T);
+            empty.mBlockSize = kFrozenBlockSize;
+            pData = (const char*)&empty;
+        }
+
+        const size_t nSize = (size_t)reinterpret_cast<const frozen_set_header*>(pData)->mFileSize;
+        bool         bResult = (fwrite(pData, nSize, 1, pFile) == 1);
+
+        bResult = (fclose(pFile) == 0) && bResult;
+        return bResult;
+    }
+
+
+    template <typename T>
+    inline void frozen_set<T>::clear()
+    {
+        std::vector<uint64_t>().swap(mStorage);
+        mFile.close();
+        mpBase = NULL;
+    }
+
+
+    template <typename T>
+    inline typename frozen_set<T>::const_iterator frozen_set<T>::begin() const
+    {
+        return empty() ? end() : const_iterator(this, 0, (T)blocks()[0].mnFirst);
+    }
+
+
+    template <typename T>
+    inline typename frozen_set<T>::const_iterator frozen_set<T>::find(T value) const
+    {
+        const const_iterator it(lower_bound(value));
+
+        if ((it != end()) && (*it == value))
+            return it;
+        return end();
+    }
+
+
+    template <typename T>
+    typename frozen_set<T>::const_iterator frozen_set<T>::lower_bound(T value) const
+    {
+        if (empty())
+            return end();
+
+        // Find the last block whose first value is <= value.
+        const frozen_set_block* const pBlocks = blocks();
+        uint64_t nLow = 0;
+        uint64_t nCount = header().mBlockCount;
+
+        while (nCount > 0)
+        {
+            const uint64_t nHalf = nCount / 2;
+
+            if (pBlocks[nLow + nHalf].mnFirst <= (uint64_t)value)
+            {
+                nLow += nHalf + 1;
+                nCount -= nHalf + 1;
+            } else
+                nCount = nHalf;
+        }
+
+        if (nLow == 0)
+            return begin();
+
+        // Then decode it up to value. If every value of the block is smaller, the
+        // answer is the first value of the next block.
+        const uint64_t          nBlock = nLow - 1;
+        const frozen_set_block& block = pBlocks[nBlock];
+        const uint64_t* const   pWords = words();
+        uint64_t                nBit = block.mnBitOffset;
+        T                       current = (T)block.mnFirst;
+
+        for (uint32_t i = 0; ; ++i)
+        {
+            if (current >= value)
+                return const_iterator(this, nBlock * kFrozenBlockSize + i, current);
+            if ((i + 1) == block.mnCount)
+                break;
+            current = (T)(current + Internal::FrozenReadBits(pWords, nBit, block.mnWidth) + 1);
+            nBit += block.mnWidth;
+        }
+
+        if ((nBlock + 1) == header().mBlockCount)
+            return end();
+        return const_iterator(this, (nBlock + 1) * kFrozenBlockSize, (T)pBlocks[nBlock + 1].mnFirst);
+    }
+
+
+    template <typename T>
+    inline typename frozen_set<T>::const_iterator frozen_set<T>::upper_bound(T value) const
+    {
+        const_iterator it(lower_bound(value));
+
+        if ((it != end()) && (*it == value))
+            ++it;
+        return it;
+    }
+
+
+    template <typename T>
+    template <typename Function>
+    void frozen_set<T>::for_each(Function f) const
+    {
+        if (empty())
+            return;
+
+        const frozen_set_block* const pBlocks = blocks();
+        const uint64_t* const         pWords = words();
+        T                             values[kFrozenBlockSize];
+
+        for (uint64_t b = 0, nBlockCount = header().mBlockCount; b < nBlockCount; ++b)
+        {
+            // Unpack the gaps, then turn them into values with a running sum, so
+            // that the unpacking loop has no dependency from one gap to the next.
+            const frozen_set_block& block = pBlocks[b];
+            const uint32_t          nWidth = block.mnWidth;
+            const uint64_t          nBitOffset = block.mnBitOffset;
+
+            values[0] = (T)block.mnFirst;
+            for (uint32_t i = 1; i < block.mnCount; ++i)
+                values[i] = (T)(Internal::FrozenReadBits(pWords, nBitOffset + (uint64_t)(i - 1) * nWidth, nWidth) + 1);
+            for (uint32_t i = 1; i < block.mnCount; ++i)
+                values[i] = (T)(values[i] + values[i - 1]);
+
+            for (uint32_t i = 0; i < block.mnCount; ++i)
+                f(values[i]);
+        }
+    }
+
+
+    template <typename T>
+    easy::set<T> frozen_set<T>::to_set() const
+    {
+        easy::set<T> result;
+        for_each([&result](T value) { result.insert(result.end(), value); });
+        return result;
+    }
+
+
+    // Decodes the last value of block nBlock.
+    template <typename T>
+    inline T frozen_set<T>::DoLast(uint64_t nBlock) const
+    {
+        const frozen_set_block& block = blocks()[nBlock];
+        const uint64_t* const   pWords = words();
+        T                       value = (T)block.mnFirst;
+
+        for (uint32_t i = 1; i < block.mnCount; ++i)
+            value = (T)(value + Internal::FrozenReadBits(pWords, block.mnBitOffset + (uint64_t)(i - 1) * block.mnWidth, block.mnWidth) + 1);
+        return value;
+    }
+
+
+    template <typename T>
+    bool frozen_set<T>::DoValidate(const char* pBase, uint64_t nSize) const
+    {
+        const frozen_set_header& h = *reinterpret_cast<const frozen_set_header*>(pBase);
+
+        if ((memcmp(h.mMagic, "EASYFRZ", 8) != 0) || (h.mVersion != kFrozenSetVersion) ||
+            (h.mHeaderSize < sizeof(frozen_set_header)) || (h.mFileSize > nSize))
+            return false;
+
+        if ((h.mValueSize != sizeof(T)) || (h.mBlockSize != kFrozenBlockSize))
+            return false; // The set was written for a different value type.
+
+        if (h.mCount == 0)
+            return true;
+
+        // Make sure the skip index and the data lie within the image. We don't
+        // check each block, as that would make opening O(n).
+        return (h.mBlockCount == ((h.mCount + kFrozenBlockSize - 1) / kFrozenBlockSize)) &&
+               (h.mBlockOffset + h.mBlockCount * sizeof(frozen_set_block) <= h.mDataOffset) &&
+               ((h.mBlockOffset % sizeof(uint64_t)) == 0) && ((h.mDataOffset % sizeof(uint64_t)) == 0) &&
+               (h.mDataWords > 0) && (h.mDataOffset + h.mDataWords * sizeof(uint64_t) <= h.mFileSize);
+    }
+
+} // namespace easy
+
+#endif // __EASY_FROZEN_SET_H__
@@ -0,0 +1,92 @@
+#ifndef __EASY_HASH_MAP_H__
+#define __EASY_HASH_MAP_H__
+
+/**
+ * 无序的easy::map, 基于开放寻址的hashtable
+ */
+
+#include "HashTable.h"
+
+namespace easy
+{
+    /// hash_map
+    ///
+    /// A map without ordering, for the many maps which are only ever searched by key.
+    /// find, insert and erase take constant time on average, instead of a logarithmic
+    /// number of comparisons, and the elements are stored in one array instead of one
+    /// node each.
+    ///
+    /// The interface is that of easy::map, minus everything that depends on the order
+    /// (lower_bound, upper_bound, reverse iteration, append_sorted), plus reserve,
+    /// rehash and find_as. Iteration visits the elements in no particular order, and
+    /// unlike easy::map an insertion may move every element (see hashtable).
+    ///
+    /// Example usage:
+    ///     easy::hash_map<std::string, IService*> services;
+    ///     services.insert(easy::make_pair(std::string("audio"), pAudio));
+    ///     services.find_as("audio"); // No std::string is constructed.
+    ///
+    template <typename Key, typename T, typename Hash = easy::hash<Key>, typename Equal = easy::equal_to<Key>,
+              typename Allocator = easy::allocator>
+    class hash_map
+        : public hashtable<Key, easy::pair<Key, T>, Hash, Equal, easy::use_first<easy::pair<Key, T> >, true, Allocator>
+    {
+    public:
+        typedef hashtable<Key, easy::pair<Key, T>, Hash, Equal,
+            easy::use_first<easy::pair<Key, T> >, true, Allocator>                 base_type;
+        typedef hash_map<Key, T, Hash, Equal, Allocator>                            this_type;
+        typedef typename base_type::size_type                                       size_type;
+        typedef typename base_type::key_type                                        key_type;
+        typedef T                                                                   mapped_type;
+        typedef typename base_type::value_type                                      value_type;
+        typedef typename base_type::iterator                                        iterator;
+        typedef typename base_type::const_iterator                                  const_iterator;
+        typedef typename base_type::insert_return_type                              insert_return_type;
+        // Other types are inherited from the base class.
+
+    public:
+        hash_map();
+        explicit hash_map(size_type nElementCount, const Hash& hashFunction = Hash(), const Equal& equal = Equal());
+        hash_map(const this_type& x);
+
+        template <typename Iterator>
+        hash_map(Iterator itBegin, Iterator itEnd);
+    }; // hash_map
+
+
+
+    ///////////////////////////////////////////////////////////////////////
+    // hash_map
+    ///////////////////////////////////////////////////////////////////////
+
+    template <typename Key, typename T, typename Hash, typename Equal, typename Allocator>
+    inline hash_map<Key, T, Hash, Equal, Allocator>::hash_map()
+        : base_type()
+    {
+    }
+
+
+    template <typename Key, typename T, typename Hash, typename Equal, typename Allocator>
+    inline hash_map<Key, T, Hash, Equal, Allocator>::hash_map(size_type nElementCount, const Hash& hashFunction, const Equal& equal)
+        : base_type(nElementCount, hashFunction, equal)
+    {
+    }
+
+
+    template <typename Key, typename T, typename Hash, typename Equal, typename Allocator>
+    inline hash_map<Key, T, Hash, Equal, Allocator>::hash_map(const this_type& x)
+        : base_type(x)
+    {
+    }
+
+
+    template <typename Key, typename T, typename Hash, typename Equal, typename Allocator>
+    template <typename Iterator>
+    inline hash_map<Key, T, Hash, Equal, Allocator>::hash_map(Iterator itBegin, Iterator itEnd)
+        : base_type(itBegin, itEnd)
+    {
+    }
+
+} // namespace easy
+
+#endif // __EASY_HASH_MAP_H__
@@ -0,0 +1,78 @@
+#ifndef __EASY_HASH_SET_H__
+#define __EASY_HASH_SET_H__
+
+/**
+ * 无序的easy::set, 基于开放寻址的hashtable
+ */
+
+#include "HashTable.h"
+
+namespace easy
+{
+    /// hash_set
+    ///
+    /// A set without ordering. See hash_map.
+    ///
+    /// As with easy::set, iterator is the same as const_iterator, since changing an
+    /// element would change its hash.
+    ///
+    template <typename Key, typename Hash = easy::hash<Key>, typename Equal = easy::equal_to<Key>,
+              typename Allocator = easy::allocator>
+    class hash_set
+        : public hashtable<Key, Key, Hash, Equal, easy::use_self<Key>, false, Allocator>
+    {
+    public:
+        typedef hashtable<Key, Key, Hash, Equal, easy::use_self<Key>, false, Allocator> base_type;
+        typedef hash_set<Key, Hash, Equal, Allocator>                                   this_type;
+        typedef typename base_type::size_type                                           size_type;
+        typedef typename base_type::value_type                                          value_type;
+        typedef typename base_type::iterator                                            iterator;
+        typedef typename base_type::const_iterator                                      const_iterator;
+        // Other types are inherited from the base class.
+
+    public:
+        hash_set();
+        explicit hash_set(size_type nElementCount, const Hash& hashFunction = Hash(), const Equal& equal = Equal());
+        hash_set(const this_type& x);
+
+        template <typename Iterator>
+        hash_set(Iterator itBegin, Iterator itEnd);
+    }; // hash_set
+
+
+
+    ///////////////////////////////////////////////////////////////////////
+    // hash_set
+    ///////////////////////////////////////////////////////////////////////
+
+    template <typename Key, typename Hash, typename Equal, typename Allocator>
+    inline hash_set<Key, Hash, Equal, Allocator>::hash_set()
+        : base_type()
+    {
+    }
+
+
+    template <typename Key, typename Hash, typename Equal, typename Allocator>
+    inline hash_set<Key, Hash, Equal, Allocator>::hash_set(size_type nElementCount, const Hash& hashFunction, const Equal& equal)
+        : base_type(nElementCount, hashFunction, equal)
+    {
+    }
+
+
+    template <typename Key, typename Hash, typename Equal, typename Allocator>
+    inline hash_set<Key, Hash, Equal, Allocator>::hash_set(const this_type& x)
+        : base_type(x)
+    {
+    }
+
+
+    template <typename Key, typename Hash, typename Equal, typename Allocator>
+    template <typename Iterator>
+    inline hash_set<Key, Hash, Equal, Allocator>::hash_set(Iterator itBegin, Iterator itEnd)
+        : base_type(itBegin, itEnd)
+    {
+    }
+
+} // namespace easy
+
+#endif // __EASY_HASH_SET_H__
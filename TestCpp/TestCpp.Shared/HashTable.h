@@ -0,0 +1,1194 @@
+#ifndef __EASY_HASHTABLE_H__
+#define __EASY_HASHTABLE_H__
+
+/**
+ * 开放寻址的哈希表, 以16个控制字节为一组探测(Swiss table), hash_map/hash_set的实现
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <new>
+#include <string>
+#include "RbTree.h"
+
+// The control bytes of a group are matched with SSE2 where the compiler targets it,
+// and one byte at a time otherwise, e.g. on ARM.
+#ifndef EASY_HASHTABLE_SSE2
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define EASY_HASHTABLE_SSE2 1
+#else
+#define EASY_HASHTABLE_SSE2 0
+#endif
+#endif
+
+#if EASY_HASHTABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace easy
+{
+    /// hash
+    ///
+    /// The default Hash of hash_map and hash_set. Integers and pointers hash to
+    /// their value, which the table mixes before use, so they needn't be spread.
+    /// C strings hash their characters, the same way std::string does, so that a
+    /// hash_map keyed by std::string can be searched with a const char* (see
+    /// hashtable::find_as).
+    ///
+    template <typename T>
+    struct hash;
+
+    namespace Internal
+    {
+        template <typename T>
+        struct hash_integral
+        {
+            size_t operator()(T x) const
+            {
+                // Folds the upper half in where size_t is 32 bits.
+                return static_cast<size_t>((uint64_t)x ^ ((uint64_t)x >> 32));
+            }
+        };
+
+        // Hashes 8 bytes at a time. The result depends on the byte order of the
+        // machine, so it mustn't be stored.
+        inline size_t HashBytes(const char* p, size_t n)
+        {
+            uint64_t nHash = 0x9E3779B97F4A7C15ull ^ n;
+            uint64_t nWord;
+
+            for (; n >= 8; p += 8, n -= 8)
+            {
+                memcpy(&nWord, p, 8);
+                nHash = (nHash ^ nWord) * 0xFF51AFD7ED558CCDull;
+                nHash ^= nHash >> 32;
+            }
+
+            if (n)
+            {
+                nWord = 0;
+                memcpy(&nWord, p, n);
+                nHash = (nHash ^ nWord) * 0xFF51AFD7ED558CCDull;
+                nHash ^= nHash >> 32;
+            }
+
+            return static_cast<size_t>(nHash);
+        }
+    }
+
+    template <> struct hash<bool>               : public Internal::hash_integral<bool> {};
+    template <> struct hash<char>               : public Internal::hash_integral<char> {};
+    template <> struct hash<signed char>        : public Internal::hash_integral<signed char> {};
+    template <> struct hash<unsigned char>      : public Internal::hash_integral<unsigned char> {};
+    template <> struct hash<wchar_t>            : public Internal::hash_integral<wchar_t> {};
+    template <> struct hash<short>              : public Internal::hash_integral<short> {};
+    template <> struct hash<unsigned short>     : public Internal::hash_integral<unsigned short> {};
+    template <> struct hash<int>                : public Internal::hash_integral<int> {};
+    template <> struct hash<unsigned int>       : public Internal::hash_integral<unsigned int> {};
+    template <> struct hash<long>               : public Internal::hash_integral<long> {};
+    template <> struct hash<unsigned long>      : public Internal::hash_integral<unsigned long> {};
+    template <> struct hash<long long>          : public Internal::hash_integral<long long> {};
+    template <> struct hash<unsigned long long> : public Internal::hash_integral<unsigned long long> {};
+
+    template <typename T>
+    struct hash<T*>
+    {
+        size_t operator()(T* p) const { return static_cast<size_t>(reinterpret_cast<uintptr_t>(p)); }
+    };
+
+    template <>
+    struct hash<const char*>
+    {
+        size_t operator()(const char* p) const { return Internal::HashBytes(p, strlen(p)); }
+    };
+
+    template <>
+    struct hash<char*>
+    {
+        size_t operator()(const char* p) const { return Internal::HashBytes(p, strlen(p)); }
+    };
+
+    template <>
+    struct hash<std::string>
+    {
+        size_t operator()(const std::string& s) const { return Internal::HashBytes(s.data(), s.size()); }
+    };
+
+
+    /// equal_to
+    ///
+    template <typename T = void>
+    struct equal_to : public binary_function<T, T, bool>
+    {
+        bool operator()(const T& a, const T& b) const
+        {
+            return a == b;
+        }
+    };
+
+    /// equal_to_2
+    ///
+    /// Compares a key with a value of another type, such as a std::string with a
+    /// const char*, without converting either.
+    ///
+    template <typename T, typename U>
+    struct equal_to_2 : public binary_function<T, U, bool>
+    {
+        bool operator()(const T& a, const U& b) const { return a == b; }
+        bool operator()(const U& b, const T& a) const { return b == a; }
+    };
+
+    template <typename T>
+    struct equal_to_2<T, T> : public equal_to<T> {};
+
+
+
+    /// HashTableControl
+    ///
+    /// Every slot of a hashtable has a control byte. A full slot's byte holds the
+    /// low 7 bits of the hash of its key, which rules out most non-matching slots
+    /// without reading them. The other states are negative.
+    ///
+    enum HashTableControl
+    {
+        kHashTableEmpty    = -128,
+        kHashTableDeleted  = -2,    // A tombstone: erased from a group which was full at the time.
+        kHashTableSentinel = -1     // Follows the last slot, and stops iteration.
+    };
+
+    namespace Internal
+    {
+        static const size_t kHashTableGroupWidth = 16;
+
+        // The control bytes of an empty table which has never allocated. Searches
+        // stop at the first group, and nothing ever writes to it.
+        inline int8_t* HashTableEmptyGroup()
+        {
+            static const int8_t kEmptyGroup[kHashTableGroupWidth] =
+            {
+                kHashTableEmpty, kHashTableEmpty, kHashTableEmpty, kHashTableEmpty,
+                kHashTableEmpty, kHashTableEmpty, kHashTableEmpty, kHashTableEmpty,
+                kHashTableEmpty, kHashTableEmpty, kHashTableEmpty, kHashTableEmpty,
+                kHashTableEmpty, kHashTableEmpty, kHashTableEmpty, kHashTableEmpty
+            };
+            return const_cast<int8_t*>(kEmptyGroup);
+        }
+
+        // Spreads the bits of a hash which may have been the key itself. The low 7
+        // bits of the result go in the control byte and the rest pick the group.
+        inline uint64_t HashTableMix(size_t nHash)
+        {
+            const uint64_t n = (uint64_t)nHash * 0x9E3779B97F4A7C15ull;
+            return n ^ (n >> 32);
+        }
+
+        inline uint32_t HashTableLowestBit(uint32_t nMask)
+        {
+#if defined(_MSC_VER)
+            unsigned long nIndex;
+            _BitScanForward(&nIndex, nMask);
+            return (uint32_t)nIndex;
+#elif defined(__GNUC__) || defined(__clang__)
+            return (uint32_t)__builtin_ctz(nMask);
+#else
+            uint32_t nIndex = 0;
+            while (!(nMask & 1))
+            {
+                nMask >>= 1;
+                ++nIndex;
+            }
+            return nIndex;
+#endif
+        }
+
+        // The type find_as(u) hashes and compares: string literals are looked up as
+        // const char*.
+        template <typename U>
+        struct hashtable_lookup_type { typedef U type; };
+
+        template <typename U, size_t N>
+        struct hashtable_lookup_type<U[N]> { typedef const U* type; };
+
+        // The control bytes of 16 consecutive slots. Each Match returns a mask with
+        // bit i set if slot i matches.
+        struct hashtable_group
+        {
+#if EASY_HASHTABLE_SSE2
+            __m128i mControl;
+
+            explicit hashtable_group(const int8_t* pControl)
+                : mControl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pControl))) {}
+
+            uint32_t Match(int8_t nHash) const
+            {
+                return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(nHash), mControl));
+            }
+
+            uint32_t MatchEmpty() const
+            {
+                return Match(kHashTableEmpty);
+            }
+
+            uint32_t MatchEmptyOrDeleted() const
+            {
+                return (uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(kHashTableSentinel), mControl));
+            }
+#else
+            const int8_t* mpControl;
+
+            explicit hashtable_group(const int8_t* pControl)
+                : mpControl(pControl) {}
+
+            uint32_t Match(int8_t nHash) const
+            {
+                uint32_t nMask = 0;
+                for (uint32_t i = 0; i < kHashTableGroupWidth; ++i)
+                    nMask |= (uint32_t)(mpControl[i] == nHash) << i;
+                return nMask;
+            }
+
+            uint32_t MatchEmpty() const
+            {
+                return Match(kHashTableEmpty);
+            }
+
+            uint32_t MatchEmptyOrDeleted() const
+            {
+                uint32_t nMask = 0;
+                for (uint32_t i = 0; i < kHashTableGroupWidth; ++i)
+                    nMask |= (uint32_t)(mpControl[i] < kHashTableSentinel) << i;
+                return nMask;
+            }
+#endif
+        };
+    }
+
+
+
+    /// hashtable_iterator
+    ///
+    /// Visits the full slots in slot order, which has nothing to do with the order
+    /// of the keys. Inserting may rehash, which invalidates all iterators; erasing
+    /// invalidates only iterators to the erased element.
+    ///
+    template <typename T, typename Pointer, typename Reference>
+    struct hashtable_iterator
+    {
+        typedef hashtable_iterator<T, Pointer, Reference>   this_type;
+        typedef hashtable_iterator<T, T*, T&>               iterator;
+        typedef hashtable_iterator<T, const T*, const T&>   const_iterator;
+        typedef unsigned int                                size_type;
+        typedef int                                         difference_type;
+        typedef T                                           value_type;
+        typedef Pointer                                     pointer;
+        typedef Reference                                   reference;
+
+    public:
+        const int8_t* mpControl;    // The control byte of the slot, which is the sentinel for end().
+        T*            mpValue;
+
+    public:
+        hashtable_iterator();
+        hashtable_iterator(const int8_t* pControl, const T* pValue);
+        hashtable_iterator(const iterator& x);
+
+        reference operator*() const;
+        pointer   operator->() const;
+
+        hashtable_iterator& operator++();
+        hashtable_iterator  operator++(int);
+    }; // hashtable_iterator
+
+
+
+    /// hashtable
+    ///
+    /// An open addressing hash table in the style of Abseil's Swiss table. The values
+    /// are stored in one array of slots, and a parallel array holds one control byte
+    /// per slot (see HashTableControl). The slots are probed 16 at a time: one SSE2
+    /// compare of the group's control bytes with the low 7 bits of the hash finds the
+    /// few slots worth comparing keys with, and a search ends at the first group that
+    /// has an empty slot. Groups are probed in triangular order, so every group is
+    /// visited once the table is full enough to need it.
+    ///
+    /// The number of slots is 0 or a power of 2 of at least 16, and at most 7/8 of
+    /// them are used, counting tombstones. When an insertion would go over, the table
+    /// is rebuilt, at twice the size unless tombstones make up most of the load, in
+    /// which case it is rebuilt at the same size.
+    ///
+    /// Unlike the rbtree, the elements move when the table grows, so pointers and
+    /// iterators to them are invalidated by any insertion which grows it. Call reserve
+    /// beforehand to keep them.
+    ///
+    /// The allocator's allocate may return NULL, in which case an insertion which
+    /// needed to grow fails, returning an end()/false pair, and the table is unchanged.
+    ///
+    template <typename Key, typename Value, typename Hash, typename Equal, typename ExtractKey,
+              bool bMutableIterators, typename Allocator>
+    class hashtable
+    {
+    public:
+        typedef int                                                                             difference_type;
+        typedef unsigned int                                                                    size_type;
+        typedef Key                                                                             key_type;
+        typedef Value                                                                           value_type;
+        typedef value_type&                                                                     reference;
+        typedef const value_type&                                                               const_reference;
+        typedef value_type*                                                                     pointer;
+        typedef const value_type*                                                               const_pointer;
+
+        typedef typename type_select<bMutableIterators,
+            hashtable_iterator<value_type, value_type*, value_type&>,
+            hashtable_iterator<value_type, const value_type*, const value_type&> >::type        iterator;
+        typedef hashtable_iterator<value_type, const value_type*, const value_type&>           const_iterator;
+
+        typedef Hash                                                                            hasher;
+        typedef Equal                                                                           key_equal;
+        typedef ExtractKey                                                                      extract_key;
+        typedef Allocator                                                                       allocator_type;
+        typedef easy::pair<iterator, bool>                                                      insert_return_type;
+        typedef hashtable<Key, Value, Hash, Equal, ExtractKey, bMutableIterators, Allocator>    this_type;
+
+        static const size_type kMinCapacity = (size_type)Internal::kHashTableGroupWidth;
+
+    public:
+        int8_t*        mpControl;       /// mnCapacity control bytes followed by a kHashTableSentinel, or HashTableEmptyGroup().
+        value_type*    mpValues;        /// mnCapacity slots, in the same allocation as the control bytes.
+        size_type      mnSize;
+        size_type      mnCapacity;
+        size_type      mnGrowthLeft;    /// Empty slots which may still be used before rebuilding the table.
+        hasher         mHash;
+        key_equal      mEqual;
+        allocator_type mAllocator;
+
+    public:
+        hashtable();
+        explicit hashtable(size_type nElementCount, const Hash& hashFunction = Hash(), const Equal& equal = Equal());
+        hashtable(const this_type& x);
+
+        template <typename InputIterator>
+        hashtable(InputIterator first, InputIterator last);
+
+        ~hashtable();
+
+        this_type& operator=(const this_type& x);
+
+        void swap(this_type& x);
+
+    public:
+        const hasher&         hash_function() const { return mHash; }
+        const key_equal&      key_eq() const { return mEqual; }
+        const allocator_type& get_allocator() const { return mAllocator; }
+        allocator_type&       get_allocator() { return mAllocator; }
+
+    public:
+        iterator        begin();
+        const_iterator  begin() const;
+        const_iterator  cbegin() const;
+
+        iterator        end();
+        const_iterator  end() const;
+        const_iterator  cend() const;
+
+    public:
+        bool      empty() const { return mnSize == 0; }
+        size_type size() const { return mnSize; }
+
+        /// Returns the number of slots, used or not.
+        size_type bucket_count() const { return mnCapacity; }
+
+        float load_factor() const { return mnCapacity ? ((float)mnSize / (float)mnCapacity) : 0.f; }
+        float max_load_factor() const { return 0.875f; }
+
+        /// Makes room for nElementCount elements, so that inserting up to that many
+        /// doesn't rebuild the table or invalidate iterators.
+        void reserve(size_type nElementCount);
+
+        /// Rebuilds the table with at least nBucketCount slots, or fewer if fewer are
+        /// enough for the current elements, which drops the tombstones. rehash(0)
+        /// shrinks the table to fit its elements, and frees it if it is empty.
+        void rehash(size_type nBucketCount);
+
+    public:
+        insert_return_type insert(const value_type& value);
+
+        /// The hint is ignored; it's there so that insert_iterator works.
+        iterator insert(const_iterator position, const value_type& value);
+
+        template <typename InputIterator>
+        void insert(InputIterator first, InputIterator last);
+
+        iterator  erase(const_iterator position);
+        iterator  erase(const_iterator first, const_iterator last);
+        size_type erase(const key_type& key);
+
+        /// Destroys the elements but keeps the slots.
+        void clear();
+
+        iterator       find(const key_type& key);
+        const_iterator find(const key_type& key) const;
+
+        /// Finds a key which compares equal with u without converting u to a key_type,
+        /// e.g. a std::string key from a const char*. uhash(u) must equal the table's
+        /// hash of every key which predicate(key, u) says is equal to u.
+        ///
+        /// Example usage:
+        ///     hash_map<std::string, int> m;
+        ///     m.find_as("hello"); // Uses hash<const char*> and equal_to_2<std::string, const char*>.
+        ///     m.find_as("hello", hash<const char*>(), equal_to_2<std::string, const char*>());
+        ///
+        template <typename U, typename UHash, typename BinaryPredicate>
+        iterator       find_as(const U& u, UHash uhash, BinaryPredicate predicate);
+
+        template <typename U, typename UHash, typename BinaryPredicate>
+        const_iterator find_as(const U& u, UHash uhash, BinaryPredicate predicate) const;
+
+        template <typename U>
+        iterator       find_as(const U& u);
+
+        template <typename U>
+        const_iterator find_as(const U& u) const;
+
+        size_type count(const key_type& key) const;
+
+        easy::pair<iterator, iterator>             equal_range(const key_type& key);
+        easy::pair<const_iterator, const_iterator> equal_range(const key_type& key) const;
+
+        bool validate() const;
+
+    protected:
+        iterator DoMakeIterator(size_type nIndex) const
+        {
+            return iterator(mpControl + nIndex, mpValues + nIndex);
+        }
+
+        size_type DoGroupMask() const
+        {
+            return mnCapacity ? (size_type)((mnCapacity / Internal::kHashTableGroupWidth) - 1) : 0;
+        }
+
+        uint64_t DoHash(const key_type& key) const
+        {
+            return Internal::HashTableMix(mHash(key));
+        }
+
+        static size_type DoGrowthLimit(size_type nCapacity)
+        {
+            return nCapacity - (nCapacity / 8);
+        }
+
+        template <typename U, typename BinaryPredicate>
+        size_type DoFind(const U& u, uint64_t nHash, BinaryPredicate predicate) const;
+
+        size_type DoFindFreeSlot(uint64_t nHash) const;
+        size_type DoClaimSlot(uint64_t nHash);
+        size_type DoInsertNew(const value_type& value, uint64_t nHash);
+        void      DoEraseSlot(size_type nIndex);
+        bool      DoGrow();
+        bool      DoRehash(size_type nCapacity);
+        bool      DoAllocate(size_type nCapacity, int8_t*& pControl, value_type*& pValues);
+        void      DoFree(int8_t* pControl, value_type* pValues, size_type nCapacity);
+        void      DoDestroyValues();
+        void      DoCopyFrom(const this_type& x);
+
+        static size_type DoCapacityFor(size_type nElementCount);
+    }; // hashtable
+
+
+
+
+    ///////////////////////////////////////////////////////////////////////
+    // hashtable_iterator functions
+    ///////////////////////////////////////////////////////////////////////
+
+    template <typename T, typename Pointer, typename Reference>
+    hashtable_iterator<T, Pointer, Reference>::hashtable_iterator()
+        : mpControl(NULL), mpValue(NULL) { }
+
+
+    template <typename T, typename Pointer, typename Reference>
+    hashtable_iterator<T, Pointer, Reference>::hashtable_iterator(const int8_t* pControl, const T* pValue)
+        : mpControl(pControl), mpValue(const_cast<T*>(pValue)) { }
+
+
+    template <typename T, typename Pointer, typename Reference>
+    hashtable_iterator<T, Pointer, Reference>::hashtable_iterator(const iterator& x)
+        : mpControl(x.mpControl), mpValue(x.mpValue) { }
+
+
+    template <typename T, typename Pointer, typename Reference>
+    typename hashtable_iterator<T, Pointer, Reference>::reference
+        hashtable_iterator<T, Pointer, Reference>::operator*() const
+    {
+        return *mpValue;
+    }
+
+
+    template <typename T, typename Pointer, typename Reference>
+    typename hashtable_iterator<T, Pointer, Reference>::pointer
+        hashtable_iterator<T, Pointer, Reference>::operator->() const
+    {
+        return mpValue;
+    }
+
+
+    template <typename T, typename Pointer, typename Reference>
+    typename hashtable_iterator<T, Pointer, Reference>::this_type&
+        hashtable_iterator<T, Pointer, Reference>::operator++()
+    {
+        // Empty and deleted slots are below the sentinel, full slots above it.
+        do
+        {
+            ++mpControl;
+            ++mpValue;
+        } while (*mpControl < kHashTableSentinel);
+
+        return *this;
+    }
+
+
+    template <typename T, typename Pointer, typename Reference>
+    typename hashtable_iterator<T, Pointer, Reference>::this_type
+        hashtable_iterator<T, Pointer, Reference>::operator++(int)
+    {
+        this_type temp(*this);
+        ++*this;
+        return temp;
+    }
+
+
+    template <typename T, typename PointerA, typename ReferenceA, typename PointerB, typename ReferenceB>
+    inline bool operator==(const hashtable_iterator<T, PointerA, ReferenceA>& a,
+        const hashtable_iterator<T, PointerB, ReferenceB>& b)
+    {
+        return a.mpControl == b.mpControl;
+    }
+
+
+    template <typename T, typename PointerA, typename ReferenceA, typename PointerB, typename ReferenceB>
+    inline bool operator!=(const hashtable_iterator<T, PointerA, ReferenceA>& a,
+        const hashtable_iterator<T, PointerB, ReferenceB>& b)
+    {
+        return a.mpControl != b.mpControl;
+    }
+
+
+    template <typename T, typename Pointer, typename Reference>
+    inline bool operator!=(const hashtable_iterator<T, Pointer, Reference>& a,
+        const hashtable_iterator<T, Pointer, Reference>& b)
+    {
+        return a.mpControl != b.mpControl;
+    }
+
+
+
+
+    ///////////////////////////////////////////////////////////////////////
+    // hashtable functions
+    ///////////////////////////////////////////////////////////////////////
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline hashtable<K, V, H, Q, E, bM, A>::hashtable()
+        : mpControl(Internal::HashTableEmptyGroup()),
+        mpValues(NULL),
+        mnSize(0),
+        mnCapacity(0),
+        mnGrowthLeft(0),
+        mHash(),
+        mEqual(),
+        mAllocator()
+    {
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline hashtable<K, V, H, Q, E, bM, A>::hashtable(size_type nElementCount, const H& hashFunction, const Q& equal)
+        : mpControl(Internal::HashTableEmptyGroup()),
+        mpValues(NULL),
+        mnSize(0),
+        mnCapacity(0),
+        mnGrowthLeft(0),
+        mHash(hashFunction),
+        mEqual(equal),
+        mAllocator()
+    {
+        reserve(nElementCount);
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline hashtable<K, V, H, Q, E, bM, A>::hashtable(const this_type& x)
+        : mpControl(Internal::HashTableEmptyGroup()),
+        mpValues(NULL),
+        mnSize(0),
+        mnCapacity(0),
+        mnGrowthLeft(0),
+        mHash(x.mHash),
+        mEqual(x.mEqual),
+        mAllocator(x.mAllocator)
+    {
+        DoCopyFrom(x);
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    template <typename InputIterator>
+    inline hashtable<K, V, H, Q, E, bM, A>::hashtable(InputIterator first, InputIterator last)
+        : mpControl(Internal::HashTableEmptyGroup()),
+        mpValues(NULL),
+        mnSize(0),
+        mnCapacity(0),
+        mnGrowthLeft(0),
+        mHash(),
+        mEqual(),
+        mAllocator()
+    {
+        insert(first, last);
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline hashtable<K, V, H, Q, E, bM, A>::~hashtable()
+    {
+        DoDestroyValues();
+        DoFree(mpControl, mpValues, mnCapacity);
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline typename hashtable<K, V, H, Q, E, bM, A>::this_type&
+        hashtable<K, V, H, Q, E, bM, A>::operator=(const this_type& x)
+    {
+        if (this != &x)
+        {
+            clear();
+            mHash = x.mHash;
+            mEqual = x.mEqual;
+            DoCopyFrom(x);
+        }
+        return *this;
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline void hashtable<K, V, H, Q, E, bM, A>::swap(this_type& x)
+    {
+        easy::swap(mpControl, x.mpControl);
+        easy::swap(mpValues, x.mpValues);
+        easy::swap(mnSize, x.mnSize);
+        easy::swap(mnCapacity, x.mnCapacity);
+        easy::swap(mnGrowthLeft, x.mnGrowthLeft);
+        easy::swap(mHash, x.mHash);
+        easy::swap(mEqual, x.mEqual);
+        easy::swap(mAllocator, x.mAllocator);
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline typename hashtable<K, V, H, Q, E, bM, A>::iterator
+        hashtable<K, V, H, Q, E, bM, A>::begin()
+    {
+        if (mnSize == 0)
+            return end();
+
+        size_type i = 0;
+        while (mpControl[i] < 0)
+            ++i;
+        return DoMakeIterator(i);
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline typename hashtable<K, V, H, Q, E, bM, A>::const_iterator
+        hashtable<K, V, H, Q, E, bM, A>::begin() const
+    {
+        return const_iterator(const_cast<this_type*>(this)->begin());
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline typename hashtable<K, V, H, Q, E, bM, A>::const_iterator
+        hashtable<K, V, H, Q, E, bM, A>::cbegin() const
+    {
+        return begin();
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline typename hashtable<K, V, H, Q, E, bM, A>::iterator
+        hashtable<K, V, H, Q, E, bM, A>::end()
+    {
+        return DoMakeIterator(mnCapacity);
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline typename hashtable<K, V, H, Q, E, bM, A>::const_iterator
+        hashtable<K, V, H, Q, E, bM, A>::end() const
+    {
+        return const_iterator(DoMakeIterator(mnCapacity));
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline typename hashtable<K, V, H, Q, E, bM, A>::const_iterator
+        hashtable<K, V, H, Q, E, bM, A>::cend() const
+    {
+        return end();
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline void hashtable<K, V, H, Q, E, bM, A>::reserve(size_type nElementCount)
+    {
+        if (nElementCount > (mnSize + mnGrowthLeft))
+            DoRehash(DoCapacityFor(nElementCount));
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline void hashtable<K, V, H, Q, E, bM, A>::rehash(size_type nBucketCount)
+    {
+        size_type nCapacity = mnSize ? DoCapacityFor(mnSize) : 0;
+
+        while (nCapacity < nBucketCount)
+            nCapacity = nCapacity ? (nCapacity * 2) : kMinCapacity;
+
+        DoRehash(nCapacity);
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline typename hashtable<K, V, H, Q, E, bM, A>::insert_return_type
+        hashtable<K, V, H, Q, E, bM, A>::insert(const value_type& value)
+    {
+        const key_type& key = extract_key()(value);
+        const uint64_t  nHash = DoHash(key);
+        const size_type nIndex = DoFind(key, nHash, mEqual);
+
+        if (nIndex != mnCapacity)
+            return insert_return_type(DoMakeIterator(nIndex), false);
+
+        if ((mnGrowthLeft == 0) && !DoGrow())
+            return insert_return_type(end(), false);
+
+        return insert_return_type(DoMakeIterator(DoInsertNew(value, nHash)), true);
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline typename hashtable<K, V, H, Q, E, bM, A>::iterator
+        hashtable<K, V, H, Q, E, bM, A>::insert(const_iterator /*position*/, const value_type& value)
+    {
+        return insert(value).first;
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    template <typename InputIterator>
+    inline void hashtable<K, V, H, Q, E, bM, A>::insert(InputIterator first, InputIterator last)
+    {
+        for (; first != last; ++first)
+            insert(*first);
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline typename hashtable<K, V, H, Q, E, bM, A>::iterator
+        hashtable<K, V, H, Q, E, bM, A>::erase(const_iterator position)
+    {
+        iterator itNext(position.mpControl, position.mpValue);
+        ++itNext;
+
+        DoEraseSlot((size_type)(position.mpControl - mpControl));
+        return itNext;
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline typename hashtable<K, V, H, Q, E, bM, A>::iterator
+        hashtable<K, V, H, Q, E, bM, A>::erase(const_iterator first, const_iterator last)
+    {
+        while (first != last)
+            first = erase(first);
+        return iterator(last.mpControl, last.mpValue);
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline typename hashtable<K, V, H, Q, E, bM, A>::size_type
+        hashtable<K, V, H, Q, E, bM, A>::erase(const key_type& key)
+    {
+        const size_type nIndex = DoFind(key, DoHash(key), mEqual);
+
+        if (nIndex == mnCapacity)
+            return 0;
+
+        DoEraseSlot(nIndex);
+        return 1;
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline void hashtable<K, V, H, Q, E, bM, A>::clear()
+    {
+        if (mnCapacity)
+        {
+            DoDestroyValues();
+            memset(mpControl, kHashTableEmpty, mnCapacity);
+            mnSize = 0;
+            mnGrowthLeft = DoGrowthLimit(mnCapacity);
+        }
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline typename hashtable<K, V, H, Q, E, bM, A>::iterator
+        hashtable<K, V, H, Q, E, bM, A>::find(const key_type& key)
+    {
+        return DoMakeIterator(DoFind(key, DoHash(key), mEqual));
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline typename hashtable<K, V, H, Q, E, bM, A>::const_iterator
+        hashtable<K, V, H, Q, E, bM, A>::find(const key_type& key) const
+    {
+        return const_iterator(DoMakeIterator(DoFind(key, DoHash(key), mEqual)));
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    template <typename U, typename UHash, typename BinaryPredicate>
+    inline typename hashtable<K, V, H, Q, E, bM, A>::iterator
+        hashtable<K, V, H, Q, E, bM, A>::find_as(const U& u, UHash uhash, BinaryPredicate predicate)
+    {
+        return DoMakeIterator(DoFind(u, Internal::HashTableMix(uhash(u)), predicate));
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    template <typename U, typename UHash, typename BinaryPredicate>
+    inline typename hashtable<K, V, H, Q, E, bM, A>::const_iterator
+        hashtable<K, V, H, Q, E, bM, A>::find_as(const U& u, UHash uhash, BinaryPredicate predicate) const
+    {
+        return const_iterator(DoMakeIterator(DoFind(u, Internal::HashTableMix(uhash(u)), predicate)));
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    template <typename U>
+    inline typename hashtable<K, V, H, Q, E, bM, A>::iterator
+        hashtable<K, V, H, Q, E, bM, A>::find_as(const U& u)
+    {
+        typedef typename Internal::hashtable_lookup_type<U>::type lookup_type;
+        return find_as(u, easy::hash<lookup_type>(), easy::equal_to_2<K, lookup_type>());
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    template <typename U>
+    inline typename hashtable<K, V, H, Q, E, bM, A>::const_iterator
+        hashtable<K, V, H, Q, E, bM, A>::find_as(const U& u) const
+    {
+        typedef typename Internal::hashtable_lookup_type<U>::type lookup_type;
+        return find_as(u, easy::hash<lookup_type>(), easy::equal_to_2<K, lookup_type>());
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline typename hashtable<K, V, H, Q, E, bM, A>::size_type
+        hashtable<K, V, H, Q, E, bM, A>::count(const key_type& key) const
+    {
+        return (DoFind(key, DoHash(key), mEqual) != mnCapacity) ? 1 : 0;
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline easy::pair<typename hashtable<K, V, H, Q, E, bM, A>::iterator,
+                      typename hashtable<K, V, H, Q, E, bM, A>::iterator>
+        hashtable<K, V, H, Q, E, bM, A>::equal_range(const key_type& key)
+    {
+        const iterator it(find(key));
+
+        if (it == end())
+            return easy::pair<iterator, iterator>(it, it);
+
+        iterator itNext(it);
+        return easy::pair<iterator, iterator>(it, ++itNext);
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline easy::pair<typename hashtable<K, V, H, Q, E, bM, A>::const_iterator,
+                      typename hashtable<K, V, H, Q, E, bM, A>::const_iterator>
+        hashtable<K, V, H, Q, E, bM, A>::equal_range(const key_type& key) const
+    {
+        const easy::pair<iterator, iterator> range(const_cast<this_type*>(this)->equal_range(key));
+        return easy::pair<const_iterator, const_iterator>(range.first, range.second);
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline bool hashtable<K, V, H, Q, E, bM, A>::validate() const
+    {
+        if (mnCapacity == 0)
+            return (mnSize == 0) && (mnGrowthLeft == 0) && (mpControl == Internal::HashTableEmptyGroup());
+
+        if ((mnCapacity < kMinCapacity) || (mnCapacity & (mnCapacity - 1)) || (mpControl[mnCapacity] != kHashTableSentinel))
+            return false;
+
+        size_type nFull = 0, nDeleted = 0;
+
+        for (size_type i = 0; i < mnCapacity; ++i)
+        {
+            if (mpControl[i] == kHashTableDeleted)
+                ++nDeleted;
+            else if (mpControl[i] >= 0)
+            {
+                ++nFull;
+
+                const key_type& key = extract_key()(mpValues[i]);
+                const uint64_t  nHash = DoHash(key);
+
+                // Each element must be in a slot of its own hash, and found from it.
+                if ((mpControl[i] != (int8_t)(nHash & 0x7F)) || (DoFind(key, nHash, mEqual) != i))
+                    return false;
+            } else if (mpControl[i] != kHashTableEmpty)
+                return false;
+        }
+
+        return (nFull == mnSize) && ((mnSize + nDeleted + mnGrowthLeft) == DoGrowthLimit(mnCapacity));
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    template <typename U, typename BinaryPredicate>
+    inline typename hashtable<K, V, H, Q, E, bM, A>::size_type
+        hashtable<K, V, H, Q, E, bM, A>::DoFind(const U& u, uint64_t nHash, BinaryPredicate predicate) const
+    {
+        const int8_t    nControl = (int8_t)(nHash & 0x7F);
+        const size_type nGroupMask = DoGroupMask();
+        size_type       nGroup = (size_type)(nHash >> 7) & nGroupMask;
+
+        for (size_type nStep = 1; ; ++nStep)
+        {
+            const size_type                 nFirst = nGroup * (size_type)Internal::kHashTableGroupWidth;
+            const Internal::hashtable_group group(mpControl + nFirst);
+
+            for (uint32_t nMatch = group.Match(nControl); nMatch; nMatch &= (nMatch - 1))
+            {
+                const size_type nIndex = nFirst + Internal::HashTableLowestBit(nMatch);
+
+                if (EASY_LIKELY(predicate(extract_key()(mpValues[nIndex]), u)))
+                    return nIndex;
+            }
+
+            // No element was ever moved past a group with an empty slot.
+            if (group.MatchEmpty())
+                return mnCapacity;
+
+            nGroup = (nGroup + nStep) & nGroupMask;
+        }
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline typename hashtable<K, V, H, Q, E, bM, A>::size_type
+        hashtable<K, V, H, Q, E, bM, A>::DoFindFreeSlot(uint64_t nHash) const
+    {
+        const size_type nGroupMask = DoGroupMask();
+        size_type       nGroup = (size_type)(nHash >> 7) & nGroupMask;
+
+        for (size_type nStep = 1; ; ++nStep)
+        {
+            const size_type nFirst = nGroup * (size_type)Internal::kHashTableGroupWidth;
+            const uint32_t  nFree = Internal::hashtable_group(mpControl + nFirst).MatchEmptyOrDeleted();
+
+            if (nFree)
+                return nFirst + Internal::HashTableLowestBit(nFree);
+
+            nGroup = (nGroup + nStep) & nGroupMask;
+        }
+    }
+
+
+    // Marks a free slot for a value with the given hash as full and returns it, for
+    // the caller to construct the value in. There must be growth left.
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline typename hashtable<K, V, H, Q, E, bM, A>::size_type
+        hashtable<K, V, H, Q, E, bM, A>::DoClaimSlot(uint64_t nHash)
+    {
+        const size_type nIndex = DoFindFreeSlot(nHash);
+
+        // Reusing a tombstone doesn't bring the table closer to a rebuild.
+        if (mpControl[nIndex] == kHashTableEmpty)
+            --mnGrowthLeft;
+
+        mpControl[nIndex] = (int8_t)(nHash & 0x7F);
+        ++mnSize;
+        return nIndex;
+    }
+
+
+    // Inserts a value whose key isn't in the table. There must be growth left.
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline typename hashtable<K, V, H, Q, E, bM, A>::size_type
+        hashtable<K, V, H, Q, E, bM, A>::DoInsertNew(const value_type& value, uint64_t nHash)
+    {
+        const size_type nIndex = DoClaimSlot(nHash);
+
+        ::new(static_cast<void*>(mpValues + nIndex)) value_type(value);
+        return nIndex;
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline void hashtable<K, V, H, Q, E, bM, A>::DoEraseSlot(size_type nIndex)
+    {
+        mpValues[nIndex].~value_type();
+        --mnSize;
+
+        // A search for another key may have gone past this slot only if its group
+        // was full at the time. If the group has an empty slot, it never was since
+        // the last rebuild, and the slot can be emptied; otherwise it must stay
+        // occupied, as a tombstone, so that such searches carry on past it.
+        const size_type nFirst = nIndex & ~(size_type)(Internal::kHashTableGroupWidth - 1);
+
+        if (Internal::hashtable_group(mpControl + nFirst).MatchEmpty())
+        {
+            mpControl[nIndex] = kHashTableEmpty;
+            ++mnGrowthLeft;
+        } else
+            mpControl[nIndex] = kHashTableDeleted;
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline bool hashtable<K, V, H, Q, E, bM, A>::DoGrow()
+    {
+        // If at least half of the load is tombstones, dropping them makes as much
+        // room as doubling would.
+        if (mnCapacity && (mnSize <= (DoGrowthLimit(mnCapacity) / 2)))
+            return DoRehash(mnCapacity);
+
+        return DoRehash(mnCapacity ? (mnCapacity * 2) : kMinCapacity);
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    bool hashtable<K, V, H, Q, E, bM, A>::DoRehash(size_type nCapacity)
+    {
+        int8_t*     pOldControl = mpControl;
+        value_type* pOldValues = mpValues;
+        size_type   nOldCapacity = mnCapacity;
+
+        if (nCapacity == 0)
+        {
+            mpControl = Internal::HashTableEmptyGroup();
+            mpValues = NULL;
+            mnCapacity = 0;
+            mnGrowthLeft = 0;
+            DoFree(pOldControl, pOldValues, nOldCapacity);
+            return true;
+        }
+
+        int8_t*     pControl;
+        value_type* pValues;
+
+        if (!DoAllocate(nCapacity, pControl, pValues))
+            return false;
+
+        mpControl = pControl;
+        mpValues = pValues;
+        mnSize = 0;
+        mnCapacity = nCapacity;
+        mnGrowthLeft = DoGrowthLimit(nCapacity);
+
+        // The values move to their new slots with memcpy if they are relocatable.
+        for (size_type i = 0; i < nOldCapacity; ++i)
+        {
+            if (pOldControl[i] >= 0)
+                Internal::RelocateValues(mpValues + DoClaimSlot(DoHash(extract_key()(pOldValues[i]))), pOldValues + i, 1);
+        }
+
+        DoFree(pOldControl, pOldValues, nOldCapacity);
+        return true;
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline bool hashtable<K, V, H, Q, E, bM, A>::DoAllocate(size_type nCapacity, int8_t*& pControl, value_type*& pValues)
+    {
+        // The slots come first, so that they are aligned as the allocator aligns
+        // memory, then the control bytes and the sentinel.
+        void* const p = mAllocator.allocate(((size_t)nCapacity * sizeof(value_type)) + nCapacity + 1);
+
+        if (!p)
+            return false;
+
+        pValues = static_cast<value_type*>(p);
+        pControl = reinterpret_cast<int8_t*>(pValues + nCapacity);
+        memset(pControl, kHashTableEmpty, nCapacity);
+        pControl[nCapacity] = kHashTableSentinel;
+        return true;
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline void hashtable<K, V, H, Q, E, bM, A>::DoFree(int8_t* /*pControl*/, value_type* pValues, size_type nCapacity)
+    {
+        if (nCapacity)
+            mAllocator.deallocate(pValues, ((size_t)nCapacity * sizeof(value_type)) + nCapacity + 1);
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline void hashtable<K, V, H, Q, E, bM, A>::DoDestroyValues()
+    {
+        for (size_type i = 0; i < mnCapacity; ++i)
+        {
+            if (mpControl[i] >= 0)
+                mpValues[i].~value_type();
+        }
+    }
+
+
+    // Copies x into this table, which must be empty. The copy gets as many slots as
+    // x's elements need, without x's tombstones.
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline void hashtable<K, V, H, Q, E, bM, A>::DoCopyFrom(const this_type& x)
+    {
+        reserve(x.mnSize);
+
+        if (mnGrowthLeft < x.mnSize) // If the allocation failed...
+            return;
+
+        for (size_type i = 0; i < x.mnCapacity; ++i)
+        {
+            if (x.mpControl[i] >= 0)
+                DoInsertNew(x.mpValues[i], DoHash(extract_key()(x.mpValues[i])));
+        }
+    }
+
+
+    template <typename K, typename V, typename H, typename Q, typename E, bool bM, typename A>
+    inline typename hashtable<K, V, H, Q, E, bM, A>::size_type
+        hashtable<K, V, H, Q, E, bM, A>::DoCapacityFor(size_type nElementCount)
+    {
+        size_type nCapacity = kMinCapacity;
+
+        while (DoGrowthLimit(nCapacity) < nElementCount)
+            nCapacity *= 2;
+
+        return nCapacity;
+    }
+
+} // namespace easy
+
+#endif // __EASY_HASHTABLE_H__
@@ -1,6 +1,6 @@
 ﻿#include "IServiceManager.h"
 #include <mutex>
-#include <map>
+#include "HashMap.h"
 #include <cassert>
 
 #define E_NO_ERROR                    0
@@ -36,7 +36,7 @@ namespace easy {
                 return E_ERROR_ALREADY_EXISTS;
             }
 
-            mServices.insert(std::make_pair(serviceName, service));
+            mServices.insert(easy::make_pair(serviceName, service));
             return E_NO_ERROR;
         }
 
@@ -46,12 +46,11 @@ namespace easy {
             if (name == nullptr)
                 return nullptr;
 
-            std::string serviceName = name;
-            if (serviceName.empty())
+            if (*name == '\0')
                 return nullptr;
 
             std::lock_guard<std::mutex> lock(mMutex);
-            auto it = mServices.find(serviceName);
+            auto it = mServices.find_as(name);
             if (it != mServices.end()) {
                 return it->second;
             } else {
@@ -61,7 +60,7 @@ namespace easy {
         }
 
     private:
-        std::map<std::string, IService*> mServices;
+        easy::hash_map<std::string, IService*> mServices;
         std::mutex mMutex;
     };
 
@@ -0,0 +1,371 @@
+#ifndef __EASY_INTERVAL_MAP_H__
+#define __EASY_INTERVAL_MAP_H__
+
+/**
+ * 区间树: 基于easy::rbtree, 每个节点记录子树中最大的区间终点
+ */
+
+#include "RbTree.h"
+
+namespace easy
+{
+    /// interval
+    ///
+    /// A half-open interval [start, end).
+    ///
+    template <typename K>
+    struct interval
+    {
+        typedef K key_type;
+
+        K start;
+        K end;
+
+        interval()
+            : start(),
+            end() {}
+
+        interval(const K& start_, const K& end_)
+            : start(start_),
+            end(end_) {}
+    };
+
+    template <typename K>
+    inline interval<K> make_interval(const K& start, const K& end)
+    {
+        return easy::interval<K>(start, end);
+    }
+
+
+    /// interval_less
+    ///
+    /// Orders intervals by start, then by end.
+    ///
+    template <typename K, typename Compare = easy::less<K> >
+    struct interval_less
+    {
+        bool operator()(const interval<K>& a, const interval<K>& b) const
+        {
+            Compare compare;
+
+            if (compare(a.start, b.start))
+                return true;
+            if (compare(b.start, a.start))
+                return false;
+            return compare(a.end, b.end);
+        }
+    };
+
+
+    /// interval_map_value
+    ///
+    /// The value_type of interval_map. It is a pair of interval and mapped value,
+    /// plus the largest end point in the subtree of the node that holds it, which
+    /// is maintained by the tree and must not be modified.
+    ///
+    template <typename K, typename T, typename Compare>
+    struct interval_map_value : public easy::pair<interval<K>, T>
+    {
+        typedef easy::pair<interval<K>, T> base_type;
+
+        K mMaxEnd;
+
+        interval_map_value()
+            : base_type(),
+            mMaxEnd() {}
+
+        interval_map_value(const interval<K>& key, const T& value)
+            : base_type(key, value),
+            mMaxEnd(key.end) {}
+
+        interval_map_value(const base_type& x)
+            : base_type(x),
+            mMaxEnd(x.first.end) {}
+    };
+
+
+    /// rbtree_augment
+    /// Keeps interval_map_value::mMaxEnd up to date.
+    ///
+    template <typename K, typename T, typename Compare>
+    struct rbtree_augment<interval_map_value<K, T, Compare> >
+    {
+        typedef rbtree_node<interval_map_value<K, T, Compare> > node_type;
+
+        static const bool kEnabled = true;
+
+        static void Update(rbtree_node_base* pNodeBase)
+        {
+            node_type* const pNode = static_cast<node_type*>(pNodeBase);
+            const K*         pMaxEnd = &pNode->mValue.first.end;
+            Compare          compare;
+
+            if (pNode->mpNodeLeft && compare(*pMaxEnd, static_cast<node_type*>(pNode->mpNodeLeft)->mValue.mMaxEnd))
+                pMaxEnd = &static_cast<node_type*>(pNode->mpNodeLeft)->mValue.mMaxEnd;
+            if (pNode->mpNodeRight && compare(*pMaxEnd, static_cast<node_type*>(pNode->mpNodeRight)->mValue.mMaxEnd))
+                pMaxEnd = &static_cast<node_type*>(pNode->mpNodeRight)->mValue.mMaxEnd;
+
+            pNode->mValue.mMaxEnd = *pMaxEnd;
+        }
+    };
+
+
+
+    /// interval_map
+    ///
+    /// A multimap from half-open intervals [start, end) to values, which answers
+    /// overlap and stabbing queries without scanning. It is an rbtree ordered by
+    /// (start, end) in which every node also records the largest end point in its
+    /// subtree (see rbtree_augment). A query skips every subtree whose largest end
+    /// point is <= the query start, and stops at the first node whose start is >=
+    /// the query end, so reporting k intervals visits O(min(n, (k + 1) log n))
+    /// nodes, and far fewer when the matches are next to each other.
+    ///
+    /// Compare orders the end points and must be default constructible, as the
+    /// tree creates its own instances of it.
+    ///
+    /// Example usage:
+    ///     easy::interval_map<int, const char*> im;
+    ///     im.insert(0, 10, "a");
+    ///     im.insert(5, 15, "b");
+    ///     im.for_each_overlapping(8, 12, [](const easy::interval_map<int, const char*>::value_type& x) { ... }); // a and b
+    ///     im.for_each_containing(12, [](const easy::interval_map<int, const char*>::value_type& x) { ... });    // b
+    ///
+    template <typename K, typename T, typename Compare = easy::less<K> >
+    class interval_map
+        : public rbtree<interval<K>, interval_map_value<K, T, Compare>, interval_less<K, Compare>,
+                        easy::use_first<interval_map_value<K, T, Compare> >, true, false>
+    {
+    public:
+        typedef rbtree<interval<K>, interval_map_value<K, T, Compare>, interval_less<K, Compare>,
+            easy::use_first<interval_map_value<K, T, Compare> >, true, false>   base_type;
+        typedef interval_map<K, T, Compare>                                     this_type;
+        typedef typename base_type::size_type                                   size_type;
+        typedef typename base_type::key_type                                    key_type;
+        typedef K                                                               point_type;
+        typedef T                                                               mapped_type;
+        typedef typename base_type::value_type                                  value_type;
+        typedef typename base_type::node_type                                   node_type;
+        typedef typename base_type::iterator                                    iterator;
+        typedef typename base_type::const_iterator                              const_iterator;
+        typedef typename base_type::extract_key                                 extract_key;
+        // Other types are inherited from the base class.
+
+        using base_type::begin;
+        using base_type::end;
+        using base_type::find;
+        using base_type::lower_bound;
+        using base_type::upper_bound;
+        using base_type::insert;
+        using base_type::erase;
+
+    public:
+        interval_map();
+        interval_map(const this_type& x);
+
+        template <typename Iterator>
+        interval_map(Iterator itBegin, Iterator itEnd);
+
+    public:
+        iterator insert(const K& start, const K& end, const T& value);
+
+        /// Bulk loads a range of pair<interval<K>, T> (or value_type) which is sorted by
+        /// (start, end). See rbtree::append_sorted.
+        template <typename Iterator>
+        void insert_sorted(Iterator itBegin, Iterator itEnd);
+
+        /// Erases every element whose interval is equal to key and returns how many there were.
+        size_type erase(const key_type& key);
+
+        /// Calls f(value) in order for every element whose interval overlaps [lo, hi),
+        /// which is every [start, end) with start < hi and lo < end. lo must be < hi.
+        template <typename Function>
+        void for_each_overlapping(const K& lo, const K& hi, Function f);
+        template <typename Function>
+        void for_each_overlapping(const K& lo, const K& hi, Function f) const;
+
+        /// Calls f(value) in order for every element whose interval contains point.
+        template <typename Function>
+        void for_each_containing(const K& point, Function f);
+        template <typename Function>
+        void for_each_containing(const K& point, Function f) const;
+
+        /// Returns the first element (in key order) whose interval overlaps [lo, hi), or end().
+        iterator       find_overlapping(const K& lo, const K& hi);
+        const_iterator find_overlapping(const K& lo, const K& hi) const;
+
+        /// Returns true if any interval overlaps [lo, hi).
+        bool overlaps(const K& lo, const K& hi) const;
+
+    protected:
+        template <typename Visitor>
+        node_type* DoVisitOverlapping(rbtree_node_base* pNode, const K& lo, const K& hi, bool bClosed, Visitor& visitor);
+
+        template <typename Reference, typename Function>
+        struct visit_all
+        {
+            Function& mFunction;
+            visit_all(Function& function) : mFunction(function) {}
+            bool operator()(node_type* pNode) { mFunction(static_cast<Reference>(pNode->mValue)); return false; }
+        };
+
+        struct visit_first
+        {
+            bool operator()(node_type*) { return true; }
+        };
+    }; // interval_map
+
+
+
+    ///////////////////////////////////////////////////////////////////////
+    // interval_map
+    ///////////////////////////////////////////////////////////////////////
+
+    template <typename K, typename T, typename Compare>
+    inline interval_map<K, T, Compare>::interval_map()
+        : base_type()
+    {
+    }
+
+
+    template <typename K, typename T, typename Compare>
+    inline interval_map<K, T, Compare>::interval_map(const this_type& x)
+        : base_type(x)
+    {
+    }
+
+
+    template <typename K, typename T, typename Compare>
+    template <typename Iterator>
+    inline interval_map<K, T, Compare>::interval_map(Iterator itBegin, Iterator itEnd)
+        : base_type()
+    {
+        for (; itBegin != itEnd; ++itBegin)
+            base_type::insert(value_type(*itBegin));
+    }
+
+
+    template <typename K, typename T, typename Compare>
+    inline typename interval_map<K, T, Compare>::iterator
+        interval_map<K, T, Compare>::insert(const K& start, const K& end, const T& value)
+    {
+        return base_type::insert(value_type(interval<K>(start, end), value));
+    }
+
+
+    template <typename K, typename T, typename Compare>
+    template <typename Iterator>
+    inline void interval_map<K, T, Compare>::insert_sorted(Iterator itBegin, Iterator itEnd)
+    {
+        base_type::append_sorted(itBegin, itEnd);
+    }
+
+
+    template <typename K, typename T, typename Compare>
+    inline typename interval_map<K, T, Compare>::size_type
+        interval_map<K, T, Compare>::erase(const key_type& key)
+    {
+        node_type* pLower;
+        node_type* pUpper;
+        const size_type n = base_type::size();
+
+        base_type::DoGetEqualRange(key, pLower, pUpper);
+        base_type::erase(const_iterator(pLower), const_iterator(pUpper));
+        return n - base_type::size();
+    }
+
+
+    template <typename K, typename T, typename Compare>
+    template <typename Visitor>
+    typename interval_map<K, T, Compare>::node_type*
+        interval_map<K, T, Compare>::DoVisitOverlapping(rbtree_node_base* pNode, const K& lo, const K& hi, bool bClosed, Visitor& visitor)
+    {
+        // Visits, in order, the nodes in pNode's subtree with start < hi (start <= hi if bClosed)
+        // and lo < end. Returns the node at which the visitor asked to stop, or NULL.
+        Compare compare;
+
+        while (pNode && compare(lo, static_cast<node_type*>(pNode)->mValue.mMaxEnd)) // If some interval in this subtree ends after lo...
+        {
+            if (node_type* const pNodeFound = DoVisitOverlapping(pNode->mpNodeLeft, lo, hi, bClosed, visitor))
+                return pNodeFound;
+
+            node_type* const        pNodeCur = static_cast<node_type*>(pNode);
+            const interval<K>&      i = pNodeCur->mValue.first;
+
+            if (bClosed ? compare(hi, i.start) : !compare(i.start, hi)) // This node and everything to its right start too late.
+                return NULL;
+
+            if (compare(lo, i.end) && visitor(pNodeCur))
+                return pNodeCur;
+
+            pNode = pNode->mpNodeRight;
+        }
+
+        return NULL;
+    }
+
+
+    template <typename K, typename T, typename Compare>
+    template <typename Function>
+    inline void interval_map<K, T, Compare>::for_each_overlapping(const K& lo, const K& hi, Function f)
+    {
+        visit_all<typename iterator::reference, Function> visitor(f);
+        DoVisitOverlapping(base_type::mAnchor.mpNodeParent, lo, hi, false, visitor);
+    }
+
+
+    template <typename K, typename T, typename Compare>
+    template <typename Function>
+    inline void interval_map<K, T, Compare>::for_each_overlapping(const K& lo, const K& hi, Function f) const
+    {
+        visit_all<typename const_iterator::reference, Function> visitor(f);
+        const_cast<this_type*>(this)->DoVisitOverlapping(base_type::mAnchor.mpNodeParent, lo, hi, false, visitor);
+    }
+
+
+    template <typename K, typename T, typename Compare>
+    template <typename Function>
+    inline void interval_map<K, T, Compare>::for_each_containing(const K& point, Function f)
+    {
+        // start <= point && point < end
+        visit_all<typename iterator::reference, Function> visitor(f);
+        DoVisitOverlapping(base_type::mAnchor.mpNodeParent, point, point, true, visitor);
+    }
+
+
+    template <typename K, typename T, typename Compare>
+    template <typename Function>
+    inline void interval_map<K, T, Compare>::for_each_containing(const K& point, Function f) const
+    {
+        visit_all<typename const_iterator::reference, Function> visitor(f);
+        const_cast<this_type*>(this)->DoVisitOverlapping(base_type::mAnchor.mpNodeParent, point, point, true, visitor);
+    }
+
+
+    template <typename K, typename T, typename Compare>
+    inline typename interval_map<K, T, Compare>::iterator
+        interval_map<K, T, Compare>::find_overlapping(const K& lo, const K& hi)
+    {
+        visit_first visitor;
+        node_type* const pNode = DoVisitOverlapping(base_type::mAnchor.mpNodeParent, lo, hi, false, visitor);
+        return pNode ? iterator(pNode) : end();
+    }
+
+
+    template <typename K, typename T, typename Compare>
+    inline typename interval_map<K, T, Compare>::const_iterator
+        interval_map<K, T, Compare>::find_overlapping(const K& lo, const K& hi) const
+    {
+        return const_iterator(const_cast<this_type*>(this)->find_overlapping(lo, hi));
+    }
+
+
+    template <typename K, typename T, typename Compare>
+    inline bool interval_map<K, T, Compare>::overlaps(const K& lo, const K& hi) const
+    {
+        return find_overlapping(lo, hi) != end();
+    }
+
+} // namespace easy
+
+#endif // __EASY_INTERVAL_MAP_H__
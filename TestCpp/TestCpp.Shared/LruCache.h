@@ -0,0 +1,534 @@
+#ifndef __EASY_LRU_CACHE_H__
+#define __EASY_LRU_CACHE_H__
+
+/**
+ * 有容量上限的LRU缓存, 最近使用顺序的链表嵌在easy::map的节点里; 以及按键分片加锁的线程安全版本
+ */
+
+#include <stddef.h>
+#include <mutex>
+#include "HashTable.h"
+#include "RbTree.h"
+
+namespace easy
+{
+    /// lru_unit_weigher
+    ///
+    /// The default Weigher of lru_cache: every entry weighs 1, so the capacity is a
+    /// number of entries. To bound the cache in bytes instead, use a Weigher which
+    /// returns the size of the entry, e.g. sizeof(Key) + value.size().
+    ///
+    struct lru_unit_weigher
+    {
+        template <typename Key, typename T>
+        size_t operator()(const Key&, const T&) const { return 1; }
+    };
+
+
+    /// lru_ignore_eviction
+    ///
+    /// The default EvictCallback of lru_cache, which does nothing.
+    ///
+    struct lru_ignore_eviction
+    {
+        template <typename Key, typename T>
+        void operator()(const Key&, T&) const {}
+    };
+
+
+    /// lru_cache_value
+    ///
+    /// The value_type of lru_cache's tree: the key/value pair, the weight it was
+    /// given, and the links of the recency list, which point to the neighbouring
+    /// tree nodes. Keeping the list in the nodes saves the separate list node (and
+    /// its allocation) of the usual map + std::list cache.
+    ///
+    template <typename Key, typename T>
+    struct lru_cache_value : public easy::pair<Key, T>
+    {
+        typedef easy::pair<Key, T>                          base_type;
+        typedef rbtree_node<lru_cache_value<Key, T> >       node_type;
+
+        node_type* mpMoreRecent;
+        node_type* mpLessRecent;
+        size_t     mnWeight;
+
+        lru_cache_value()
+            : base_type(),
+            mpMoreRecent(NULL),
+            mpLessRecent(NULL),
+            mnWeight(0) {}
+
+        lru_cache_value(const Key& key, const T& value)
+            : base_type(key, value),
+            mpMoreRecent(NULL),
+            mpLessRecent(NULL),
+            mnWeight(0) {}
+    };
+
+
+
+    /// lru_cache
+    ///
+    /// A map with a capacity which, when full, evicts the entries used least recently.
+    /// get and put make an entry the most recently used by relinking its node at the
+    /// front of a list which runs through the nodes, without allocating; only a put
+    /// of a new key allocates, once. Finding the node is the usual tree search.
+    ///
+    /// The capacity is in units of Weigher, entries by default. put evicts from the
+    /// back of the list until the total weight fits. An entry heavier than the whole
+    /// capacity isn't stored. EvictCallback is called with each evicted entry before
+    /// it is destroyed, but not for entries removed by erase, clear or destruction.
+    ///
+    /// A cache can't be copied, as its list links point into its own nodes.
+    ///
+    /// Example usage:
+    ///     easy::lru_cache<int, std::string> cache(1000);
+    ///     cache.put(1, "one");
+    ///     if (std::string* p = cache.get(1))
+    ///         ... // Hit; 1 is now the most recently used key.
+    ///
+    template <typename Key, typename T, typename Compare = easy::less<Key>, typename Weigher = lru_unit_weigher,
+              typename EvictCallback = lru_ignore_eviction, typename Allocator = easy::allocator>
+    class lru_cache
+    {
+    public:
+        typedef lru_cache_value<Key, T>                                                         value_type;
+        typedef rbtree<Key, value_type, Compare, easy::use_first<value_type>, true, true, Allocator> tree_type;
+        typedef lru_cache<Key, T, Compare, Weigher, EvictCallback, Allocator>                  this_type;
+        typedef typename tree_type::size_type                                                   size_type;
+        typedef typename tree_type::node_type                                                   node_type;
+        typedef Key                                                                             key_type;
+        typedef T                                                                               mapped_type;
+
+    public:
+        explicit lru_cache(size_t nCapacity = 0, const Weigher& weigher = Weigher(), const EvictCallback& evictCallback = EvictCallback());
+
+        lru_cache(const this_type&) = delete;
+        this_type& operator=(const this_type&) = delete;
+
+    public:
+        /// Returns the value of key, or NULL if it isn't cached, and makes key the
+        /// most recently used. The pointer stays valid until the entry is evicted or erased.
+        T* get(const Key& key);
+
+        /// Like get, but doesn't change the recency order.
+        const T* peek(const Key& key) const;
+
+        bool contains(const Key& key) const;
+
+        /// Caches value as the most recently used entry for key, replacing the value
+        /// key had, and evicts until the cache fits its capacity. Returns false if the
+        /// entry is heavier than the capacity, in which case key is no longer cached,
+        /// or if the allocator failed.
+        bool put(const Key& key, const T& value);
+
+        /// Removes key without calling EvictCallback. Returns false if it wasn't cached.
+        bool erase(const Key& key);
+
+        void clear();
+
+        bool      empty() const { return mTree.empty(); }
+        size_type size() const { return mTree.size(); }
+        size_t    weight() const { return mnWeight; }
+        size_t    capacity() const { return mnCapacity; }
+
+        /// Changes the capacity, evicting entries if it shrinks.
+        void set_capacity(size_t nCapacity);
+
+        const Weigher&       get_weigher() const { return mWeigher; }
+        Weigher&             get_weigher() { return mWeigher; }
+        const EvictCallback& get_evict_callback() const { return mEvictCallback; }
+        EvictCallback&       get_evict_callback() { return mEvictCallback; }
+
+        /// Calls f(key, value) for every entry, from the most to the least recently used.
+        template <typename Function>
+        void for_each_recent(Function f) const;
+
+    protected:
+        void DoUnlink(node_type* pNode);
+        void DoPushFront(node_type* pNode);
+        void DoErase(node_type* pNode);
+        void DoEvict();
+
+    protected:
+        tree_type     mTree;
+        node_type*    mpMostRecent;
+        node_type*    mpLeastRecent;
+        size_t        mnWeight;
+        size_t        mnCapacity;
+        Weigher       mWeigher;
+        EvictCallback mEvictCallback;
+    }; // lru_cache
+
+
+
+    /// sharded_lru_cache
+    ///
+    /// A thread safe lru_cache, split into nShardCount independent caches by the hash
+    /// of the key, each with its own mutex and an equal share of the capacity. Threads
+    /// working on keys of different shards don't contend, and evictions are per shard,
+    /// so the entry evicted is the least recently used of its shard, not of the whole
+    /// cache.
+    ///
+    /// A capacity smaller than nShardCount is split over only as many shards as it
+    /// has units, so that every shard in use can hold an entry; shard_count() tells
+    /// how many that is. Since an entry must fit its shard, put returns false for an
+    /// entry heavier than capacity / shard_count() (rounded up for some shards), not
+    /// only for one heavier than the whole capacity.
+    ///
+    /// get copies the value out, since another thread may evict it as soon as the
+    /// lock is released. EvictCallback runs with the shard's lock held, so it must not
+    /// call back into the cache.
+    ///
+    template <typename Key, typename T, size_t nShardCount = 16, typename Hash = easy::hash<Key>,
+              typename Compare = easy::less<Key>, typename Weigher = lru_unit_weigher,
+              typename EvictCallback = lru_ignore_eviction, typename Allocator = easy::allocator>
+    class sharded_lru_cache
+    {
+    public:
+        typedef lru_cache<Key, T, Compare, Weigher, EvictCallback, Allocator>                      cache_type;
+        typedef sharded_lru_cache<Key, T, nShardCount, Hash, Compare, Weigher, EvictCallback, Allocator> this_type;
+        typedef Key                                                                                 key_type;
+        typedef T                                                                                   mapped_type;
+
+        static const size_t kShardCount = nShardCount;
+
+    public:
+        explicit sharded_lru_cache(size_t nCapacity, const Weigher& weigher = Weigher(), const EvictCallback& evictCallback = EvictCallback());
+
+        sharded_lru_cache(const this_type&) = delete;
+        this_type& operator=(const this_type&) = delete;
+
+    public:
+        /// Copies the value of key to value and makes key the most recently used of its shard.
+        bool get(const Key& key, T& value);
+
+        bool contains(const Key& key) const;
+        bool put(const Key& key, const T& value);
+        bool erase(const Key& key);
+        void clear();
+
+        /// Sums the shards, which may change while they are being counted.
+        size_t size() const;
+        size_t weight() const;
+
+        /// Returns the number of shards the keys are spread over, which is less than
+        /// nShardCount when the capacity is.
+        size_t shard_count() const { return mnShardCount; }
+
+    protected:
+        // Each shard on its own cache line, so that locking one doesn't slow down its neighbours.
+        struct alignas(64) shard
+        {
+            mutable std::mutex mMutex;
+            cache_type         mCache;
+
+            shard() : mMutex(), mCache() {}
+        };
+
+        shard& DoShard(const Key& key) const
+        {
+            return const_cast<shard&>(mShards[Internal::HashTableMix(mHash(key)) % mnShardCount]);
+        }
+
+    protected:
+        shard  mShards[nShardCount];
+        size_t mnShardCount; // The shards in use, the first mnShardCount of mShards.
+        Hash   mHash;
+    }; // sharded_lru_cache
+
+
+
+
+    ///////////////////////////////////////////////////////////////////////
+    // lru_cache
+    ///////////////////////////////////////////////////////////////////////
+
+    template <typename Key, typename T, typename Compare, typename Weigher, typename EvictCallback, typename Allocator>
+    inline lru_cache<Key, T, Compare, Weigher, EvictCallback, Allocator>::lru_cache(size_t nCapacity, const Weigher& weigher, const EvictCallback& evictCallback)
+        : mTree(),
+        mpMostRecent(NULL),
+        mpLeastRecent(NULL),
+        mnWeight(0),
+        mnCapacity(nCapacity),
+        mWeigher(weigher),
+        mEvictCallback(evictCallback)
+    {
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename Weigher, typename EvictCallback, typename Allocator>
+    inline T* lru_cache<Key, T, Compare, Weigher, EvictCallback, Allocator>::get(const Key& key)
+    {
+        const typename tree_type::iterator it(mTree.find(key));
+
+        if (it == mTree.end())
+            return NULL;
+
+        if (it.mpNode != mpMostRecent)
+        {
+            DoUnlink(it.mpNode);
+            DoPushFront(it.mpNode);
+        }
+
+        return &it.mpNode->mValue.second;
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename Weigher, typename EvictCallback, typename Allocator>
+    inline const T* lru_cache<Key, T, Compare, Weigher, EvictCallback, Allocator>::peek(const Key& key) const
+    {
+        const typename tree_type::const_iterator it(mTree.find(key));
+        return (it != mTree.end()) ? &it->second : NULL;
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename Weigher, typename EvictCallback, typename Allocator>
+    inline bool lru_cache<Key, T, Compare, Weigher, EvictCallback, Allocator>::contains(const Key& key) const
+    {
+        return mTree.find(key) != mTree.end();
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename Weigher, typename EvictCallback, typename Allocator>
+    inline bool lru_cache<Key, T, Compare, Weigher, EvictCallback, Allocator>::put(const Key& key, const T& value)
+    {
+        const size_t nWeight = mWeigher(key, value);
+
+        if (nWeight > mnCapacity)
+        {
+            erase(key);
+            return false;
+        }
+
+        const typename tree_type::iterator itFound(mTree.find(key));
+        node_type*                         pNode;
+
+        if (itFound != mTree.end())
+        {
+            pNode = itFound.mpNode;
+            DoUnlink(pNode);
+            mnWeight -= pNode->mValue.mnWeight;
+            pNode->mValue.second = value;
+        } else
+        {
+            const typename tree_type::insert_return_type result(mTree.insert(value_type(key, value)));
+
+            if (!result.second) // If the allocator failed...
+                return false;
+
+            pNode = result.first.mpNode;
+        }
+
+        // Make room before linking the entry, so that it isn't evicted itself.
+        mnWeight += nWeight;
+        pNode->mValue.mnWeight = nWeight;
+        DoEvict();
+        DoPushFront(pNode);
+        return true;
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename Weigher, typename EvictCallback, typename Allocator>
+    inline bool lru_cache<Key, T, Compare, Weigher, EvictCallback, Allocator>::erase(const Key& key)
+    {
+        const typename tree_type::iterator it(mTree.find(key));
+
+        if (it == mTree.end())
+            return false;
+
+        DoUnlink(it.mpNode);
+        DoErase(it.mpNode);
+        return true;
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename Weigher, typename EvictCallback, typename Allocator>
+    inline void lru_cache<Key, T, Compare, Weigher, EvictCallback, Allocator>::clear()
+    {
+        mTree.clear();
+        mpMostRecent = NULL;
+        mpLeastRecent = NULL;
+        mnWeight = 0;
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename Weigher, typename EvictCallback, typename Allocator>
+    inline void lru_cache<Key, T, Compare, Weigher, EvictCallback, Allocator>::set_capacity(size_t nCapacity)
+    {
+        mnCapacity = nCapacity;
+        DoEvict();
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename Weigher, typename EvictCallback, typename Allocator>
+    template <typename Function>
+    inline void lru_cache<Key, T, Compare, Weigher, EvictCallback, Allocator>::for_each_recent(Function f) const
+    {
+        for (const node_type* pNode = mpMostRecent; pNode; pNode = pNode->mValue.mpLessRecent)
+            f(pNode->mValue.first, pNode->mValue.second);
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename Weigher, typename EvictCallback, typename Allocator>
+    inline void lru_cache<Key, T, Compare, Weigher, EvictCallback, Allocator>::DoUnlink(node_type* pNode)
+    {
+        value_type& value = pNode->mValue;
+
+        if (value.mpMoreRecent)
+            value.mpMoreRecent->mValue.mpLessRecent = value.mpLessRecent;
+        else
+            mpMostRecent = value.mpLessRecent;
+
+        if (value.mpLessRecent)
+            value.mpLessRecent->mValue.mpMoreRecent = value.mpMoreRecent;
+        else
+            mpLeastRecent = value.mpMoreRecent;
+
+        value.mpMoreRecent = NULL;
+        value.mpLessRecent = NULL;
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename Weigher, typename EvictCallback, typename Allocator>
+    inline void lru_cache<Key, T, Compare, Weigher, EvictCallback, Allocator>::DoPushFront(node_type* pNode)
+    {
+        pNode->mValue.mpMoreRecent = NULL;
+        pNode->mValue.mpLessRecent = mpMostRecent;
+
+        if (mpMostRecent)
+            mpMostRecent->mValue.mpMoreRecent = pNode;
+        else
+            mpLeastRecent = pNode;
+
+        mpMostRecent = pNode;
+    }
+
+
+    // Removes an entry which is already unlinked from the recency list.
+    template <typename Key, typename T, typename Compare, typename Weigher, typename EvictCallback, typename Allocator>
+    inline void lru_cache<Key, T, Compare, Weigher, EvictCallback, Allocator>::DoErase(node_type* pNode)
+    {
+        mnWeight -= pNode->mValue.mnWeight;
+        mTree.erase(typename tree_type::const_iterator(pNode));
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename Weigher, typename EvictCallback, typename Allocator>
+    inline void lru_cache<Key, T, Compare, Weigher, EvictCallback, Allocator>::DoEvict()
+    {
+        while ((mnWeight > mnCapacity) && mpLeastRecent)
+        {
+            node_type* const pNode = mpLeastRecent;
+
+            DoUnlink(pNode);
+            mEvictCallback(static_cast<const Key&>(pNode->mValue.first), pNode->mValue.second);
+            DoErase(pNode);
+        }
+    }
+
+
+
+
+    ///////////////////////////////////////////////////////////////////////
+    // sharded_lru_cache
+    ///////////////////////////////////////////////////////////////////////
+
+    template <typename Key, typename T, size_t nShardCount, typename Hash, typename Compare, typename Weigher, typename EvictCallback, typename Allocator>
+    inline sharded_lru_cache<Key, T, nShardCount, Hash, Compare, Weigher, EvictCallback, Allocator>::sharded_lru_cache(size_t nCapacity, const Weigher& weigher, const EvictCallback& evictCallback)
+        : mnShardCount((nCapacity < nShardCount) ? ((nCapacity > 0) ? nCapacity : 1) : nShardCount),
+        mHash()
+    {
+        // The first shards get the remainder, so that the capacities add up to nCapacity.
+        // The shards past mnShardCount stay empty with no capacity.
+        for (size_t i = 0; i < mnShardCount; ++i)
+        {
+            mShards[i].mCache.get_weigher() = weigher;
+            mShards[i].mCache.get_evict_callback() = evictCallback;
+            mShards[i].mCache.set_capacity((nCapacity / mnShardCount) + ((i < (nCapacity % mnShardCount)) ? 1 : 0));
+        }
+    }
+
+
+    template <typename Key, typename T, size_t nShardCount, typename Hash, typename Compare, typename Weigher, typename EvictCallback, typename Allocator>
+    inline bool sharded_lru_cache<Key, T, nShardCount, Hash, Compare, Weigher, EvictCallback, Allocator>::get(const Key& key, T& value)
+    {
+        shard&                      s = DoShard(key);
+        std::lock_guard<std::mutex> lock(s.mMutex);
+
+        if (const T* const pValue = s.mCache.get(key))
+        {
+            value = *pValue;
+            return true;
+        }
+        return false;
+    }
+
+
+    template <typename Key, typename T, size_t nShardCount, typename Hash, typename Compare, typename Weigher, typename EvictCallback, typename Allocator>
+    inline bool sharded_lru_cache<Key, T, nShardCount, Hash, Compare, Weigher, EvictCallback, Allocator>::contains(const Key& key) const
+    {
+        const shard&                s = DoShard(key);
+        std::lock_guard<std::mutex> lock(s.mMutex);
+        return s.mCache.contains(key);
+    }
+
+
+    template <typename Key, typename T, size_t nShardCount, typename Hash, typename Compare, typename Weigher, typename EvictCallback, typename Allocator>
+    inline bool sharded_lru_cache<Key, T, nShardCount, Hash, Compare, Weigher, EvictCallback, Allocator>::put(const Key& key, const T& value)
+    {
+        shard&                      s = DoShard(key);
+        std::lock_guard<std::mutex> lock(s.mMutex);
+        return s.mCache.put(key, value);
+    }
+
+
+    template <typename Key, typename T, size_t nShardCount, typename Hash, typename Compare, typename Weigher, typename EvictCallback, typename Allocator>
+    inline bool sharded_lru_cache<Key, T, nShardCount, Hash, Compare, Weigher, EvictCallback, Allocator>::erase(const Key& key)
+    {
+        shard&                      s = DoShard(key);
+        std::lock_guard<std::mutex> lock(s.mMutex);
+        return s.mCache.erase(key);
+    }
+
+
+    template <typename Key, typename T, size_t nShardCount, typename Hash, typename Compare, typename Weigher, typename EvictCallback, typename Allocator>
+    inline void sharded_lru_cache<Key, T, nShardCount, Hash, Compare, Weigher, EvictCallback, Allocator>::clear()
+    {
+        for (size_t i = 0; i < mnShardCount; ++i)
+        {
+            std::lock_guard<std::mutex> lock(mShards[i].mMutex);
+            mShards[i].mCache.clear();
+        }
+    }
+
+
+    template <typename Key, typename T, size_t nShardCount, typename Hash, typename Compare, typename Weigher, typename EvictCallback, typename Allocator>
+    inline size_t sharded_lru_cache<Key, T, nShardCount, Hash, Compare, Weigher, EvictCallback, Allocator>::size() const
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < mnShardCount; ++i)
+        {
+            std::lock_guard<std::mutex> lock(mShards[i].mMutex);
+            n += mShards[i].mCache.size();
+        }
+        return n;
+    }
+
+
+    template <typename Key, typename T, size_t nShardCount, typename Hash, typename Compare, typename Weigher, typename EvictCallback, typename Allocator>
+    inline size_t sharded_lru_cache<Key, T, nShardCount, Hash, Compare, Weigher, EvictCallback, Allocator>::weight() const
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < mnShardCount; ++i)
+        {
+            std::lock_guard<std::mutex> lock(mShards[i].mMutex);
+            n += mShards[i].mCache.weight();
+        }
+        return n;
+    }
+
+} // namespace easy
+
+#endif // __EASY_LRU_CACHE_H__
@@ -12,14 +12,14 @@ namespace easy {
     /// The large majority of the implementation of this class is found in the rbtree
     /// base class. We control the behaviour of rbtree via template parameters.
     ///
-    template <typename Key, typename T, typename Compare = easy::less<Key> >
+    template <typename Key, typename T, typename Compare = easy::less<Key>, typename Allocator = easy::allocator>
     class map
-        : public rbtree<Key, easy::pair<Key, T>, Compare, easy::use_first<easy::pair<Key, T> >, true, true>
+        : public rbtree<Key, easy::pair<Key, T>, Compare, easy::use_first<easy::pair<Key, T> >, true, true, Allocator>
     {
     public:
         typedef rbtree<Key, easy::pair<Key, T>, Compare,
-            easy::use_first<easy::pair<Key, T> >, true, true>   base_type;
-        typedef map<Key, T, Compare>                                     this_type;
+            easy::use_first<easy::pair<Key, T> >, true, true, Allocator>   base_type;
+        typedef map<Key, T, Compare, Allocator>                                     this_type;
         typedef typename base_type::size_type                                       size_type;
         typedef typename base_type::key_type                                        key_type;
         typedef T                                                                   mapped_type;
@@ -81,45 +81,45 @@ namespace easy {
     // map
     ///////////////////////////////////////////////////////////////////////
 
-    template <typename Key, typename T, typename Compare>
-    inline map<Key, T, Compare>::map()
+    template <typename Key, typename T, typename Compare, typename Allocator>
+    inline map<Key, T, Compare, Allocator>::map()
         : base_type()
     {
     }
 
 
-    template <typename Key, typename T, typename Compare>
-    inline map<Key, T, Compare>::map(const Compare& compare)
+    template <typename Key, typename T, typename Compare, typename Allocator>
+    inline map<Key, T, Compare, Allocator>::map(const Compare& compare)
         : base_type(compare)
     {
     }
 
 
-    template <typename Key, typename T, typename Compare>
-    inline map<Key, T, Compare>::map(const this_type& x)
+    template <typename Key, typename T, typename Compare, typename Allocator>
+    inline map<Key, T, Compare, Allocator>::map(const this_type& x)
         : base_type(x)
     {
     }
 
-    template <typename Key, typename T, typename Compare>
+    template <typename Key, typename T, typename Compare, typename Allocator>
     template <typename Iterator>
-    inline map<Key, T, Compare>::map(Iterator itBegin, Iterator itEnd)
+    inline map<Key, T, Compare, Allocator>::map(Iterator itBegin, Iterator itEnd)
         : base_type(itBegin, itEnd, Compare())
     {
     }
 
 
-    template <typename Key, typename T, typename Compare>
-    inline typename map<Key, T, Compare>::value_compare
-        map<Key, T, Compare>::value_comp() const
+    template <typename Key, typename T, typename Compare, typename Allocator>
+    inline typename map<Key, T, Compare, Allocator>::value_compare
+        map<Key, T, Compare, Allocator>::value_comp() const
     {
         return value_compare(mCompare);
     }
 
 
-    template <typename Key, typename T, typename Compare>
-    inline typename map<Key, T, Compare>::size_type
-        map<Key, T, Compare>::erase(const Key& key)
+    template <typename Key, typename T, typename Compare, typename Allocator>
+    inline typename map<Key, T, Compare, Allocator>::size_type
+        map<Key, T, Compare, Allocator>::erase(const Key& key)
     {
         const iterator it(find(key));
 
@@ -132,24 +132,34 @@ namespace easy {
     }
 
 
-    template <typename Key, typename T, typename Compare>
-    inline typename map<Key, T, Compare>::size_type
-        map<Key, T, Compare>::count(const Key& key) const
+    template <typename Key, typename T, typename Compare, typename Allocator>
+    inline typename map<Key, T, Compare, Allocator>::size_type
+        map<Key, T, Compare, Allocator>::count(const Key& key) const
     {
         const const_iterator it(find(key));
         return (it != end()) ? 1 : 0;
     }
 
 
-    template <typename Key, typename T, typename Compare>
-    inline easy::pair<typename map<Key, T, Compare>::iterator,
-        typename map<Key, T, Compare>::iterator>
-        map<Key, T, Compare>::equal_range(const Key& key)
+    template <typename Key, typename T, typename Compare, typename Allocator>
+    inline easy::pair<typename map<Key, T, Compare, Allocator>::iterator,
+        typename map<Key, T, Compare, Allocator>::iterator>
+        map<Key, T, Compare, Allocator>::equal_range(const Key& key)
     {
         // The resulting range will either be empty or have one element,
         // so instead of doing two tree searches (one for lower_bound and 
         // one for upper_bound), we do just lower_bound and see if the 
-        // result is a range of size zero or one.
+        // result is a range of size zero or one. A three-way Compare
+        // finds the range in one descent that stops at an equal key.
+        if (rbtree_three_way<Compare>::kEnabled)
+        {
+            node_type* pLower;
+            node_type* pUpper;
+
+            base_type::DoGetEqualRange(key, pLower, pUpper);
+            return easy::pair<iterator, iterator>(iterator(pLower), iterator(pUpper));
+        }
+
         const iterator itLower(lower_bound(key));
 
         if ((itLower == end()) || mCompare(key, itLower.mpNode->mValue.first)) // If at the end or if (key is < itLower)...
@@ -160,12 +170,18 @@ namespace easy {
     }
 
 
-    template <typename Key, typename T, typename Compare>
-    inline easy::pair<typename map<Key, T, Compare>::const_iterator,
-        typename map<Key, T, Compare>::const_iterator>
-        map<Key, T, Compare>::equal_range(const Key& key) const
+    template <typename Key, typename T, typename Compare, typename Allocator>
+    inline easy::pair<typename map<Key, T, Compare, Allocator>::const_iterator,
+        typename map<Key, T, Compare, Allocator>::const_iterator>
+        map<Key, T, Compare, Allocator>::equal_range(const Key& key) const
     {
         // See equal_range above for comments.
+        if (rbtree_three_way<Compare>::kEnabled)
+        {
+            const easy::pair<iterator, iterator> range(const_cast<this_type*>(this)->equal_range(key));
+            return easy::pair<const_iterator, const_iterator>(range.first, range.second);
+        }
+
         const const_iterator itLower(lower_bound(key));
 
         if ((itLower == end()) || mCompare(key, itLower.mpNode->mValue.first)) // If at the end or if (key is < itLower)...
@@ -176,5 +192,180 @@ namespace easy {
     }
 
 
+    /// multimap
+    ///
+    /// Implements a canonical multimap.
+    ///
+    /// The large majority of the implementation of this class is found in the rbtree
+    /// base class. We control the behaviour of rbtree via template parameters.
+    ///
+    /// Duplicate keys are stored as separate nodes next to each other in the tree, 
+    /// in insertion order, so there is no need for a map of vectors. equal_range does
+    /// a single descent. Each node also records the size of its subtree, so count is 
+    /// O(log n) however many elements share the key.
+    ///
+    template <typename Key, typename T, typename Compare = easy::less<Key>, typename Allocator = easy::allocator>
+    class multimap
+        : public rbtree<Key, easy::pair<Key, T>, Compare, easy::use_first<easy::pair<Key, T> >, true, false, Allocator>
+    {
+    public:
+        typedef rbtree<Key, easy::pair<Key, T>, Compare,
+            easy::use_first<easy::pair<Key, T> >, true, false, Allocator>  base_type;
+        typedef multimap<Key, T, Compare, Allocator>                                this_type;
+        typedef typename base_type::size_type                                       size_type;
+        typedef typename base_type::key_type                                        key_type;
+        typedef T                                                                   mapped_type;
+        typedef typename base_type::value_type                                      value_type;
+        typedef typename base_type::node_type                                       node_type;
+        typedef typename base_type::iterator                                        iterator;
+        typedef typename base_type::const_iterator                                  const_iterator;
+        typedef typename base_type::insert_return_type                              insert_return_type;
+        typedef typename base_type::extract_key                                     extract_key;
+        // Other types are inherited from the base class.
+
+        using base_type::begin;
+        using base_type::end;
+        using base_type::find;
+        using base_type::lower_bound;
+        using base_type::upper_bound;
+        using base_type::mCompare;
+        using base_type::insert;
+        using base_type::erase;
+
+        class value_compare
+        {
+        protected:
+            friend class multimap;
+            Compare compare;
+            value_compare(Compare c) : compare(c) {}
+
+        public:
+            typedef bool       result_type;
+            typedef value_type first_argument_type;
+            typedef value_type second_argument_type;
+
+            bool operator()(const value_type& x, const value_type& y) const
+            {
+                return compare(x.first, y.first);
+            }
+        };
+
+    public:
+        multimap();
+        multimap(const Compare& compare);
+        multimap(const this_type& x);
+
+        template <typename Iterator>
+        multimap(Iterator itBegin, Iterator itEnd);
+
+    public:
+        value_compare value_comp() const;
+
+        /// Inserts a range that is sorted by key. Runs that sort after the current 
+        /// last element are linked in as a balanced subtree, and the rest is inserted 
+        /// right after the previously inserted element whenever possible.
+        template <typename Iterator>
+        void insert_equal_sorted(Iterator itBegin, Iterator itEnd);
+
+        size_type erase(const Key& key);
+        size_type count(const Key& key) const;
+
+        easy::pair<iterator, iterator>             equal_range(const Key& key);
+        easy::pair<const_iterator, const_iterator> equal_range(const Key& key) const;
+    }; // multimap
+
+
+    ///////////////////////////////////////////////////////////////////////
+    // multimap
+    ///////////////////////////////////////////////////////////////////////
+
+    template <typename Key, typename T, typename Compare, typename Allocator>
+    inline multimap<Key, T, Compare, Allocator>::multimap()
+        : base_type()
+    {
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename Allocator>
+    inline multimap<Key, T, Compare, Allocator>::multimap(const Compare& compare)
+        : base_type(compare)
+    {
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename Allocator>
+    inline multimap<Key, T, Compare, Allocator>::multimap(const this_type& x)
+        : base_type(x)
+    {
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename Allocator>
+    template <typename Iterator>
+    inline multimap<Key, T, Compare, Allocator>::multimap(Iterator itBegin, Iterator itEnd)
+        : base_type(itBegin, itEnd, Compare())
+    {
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename Allocator>
+    inline typename multimap<Key, T, Compare, Allocator>::value_compare
+        multimap<Key, T, Compare, Allocator>::value_comp() const
+    {
+        return value_compare(mCompare);
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename Allocator>
+    template <typename Iterator>
+    inline void multimap<Key, T, Compare, Allocator>::insert_equal_sorted(Iterator itBegin, Iterator itEnd)
+    {
+        base_type::append_sorted(itBegin, itEnd);
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename Allocator>
+    inline typename multimap<Key, T, Compare, Allocator>::size_type
+        multimap<Key, T, Compare, Allocator>::erase(const Key& key)
+    {
+        const easy::pair<iterator, iterator> range(equal_range(key));
+        const size_type n = base_type::size();
+
+        base_type::erase(range.first, range.second);
+        return n - base_type::size();
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename Allocator>
+    inline typename multimap<Key, T, Compare, Allocator>::size_type
+        multimap<Key, T, Compare, Allocator>::count(const Key& key) const
+    {
+        return base_type::DoCountKey(key);
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename Allocator>
+    inline easy::pair<typename multimap<Key, T, Compare, Allocator>::iterator,
+        typename multimap<Key, T, Compare, Allocator>::iterator>
+        multimap<Key, T, Compare, Allocator>::equal_range(const Key& key)
+    {
+        node_type* pLower;
+        node_type* pUpper;
+
+        base_type::DoGetEqualRange(key, pLower, pUpper);
+        return easy::pair<iterator, iterator>(iterator(pLower), iterator(pUpper));
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename Allocator>
+    inline easy::pair<typename multimap<Key, T, Compare, Allocator>::const_iterator,
+        typename multimap<Key, T, Compare, Allocator>::const_iterator>
+        multimap<Key, T, Compare, Allocator>::equal_range(const Key& key) const
+    {
+        const easy::pair<iterator, iterator> range(const_cast<this_type*>(this)->equal_range(key));
+        return easy::pair<const_iterator, const_iterator>(const_iterator(range.first), const_iterator(range.second));
+    }
+
+
 }// end of namespace
 #endif // __EASY_MAP_H__
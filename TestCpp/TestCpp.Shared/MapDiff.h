@@ -0,0 +1,148 @@
+#ifndef __EASY_MAP_DIFF_H__
+#define __EASY_MAP_DIFF_H__
+
+/**
+ * 两个easy::map/easy::set之间的差异: 线性归并, 可多线程分段执行
+ */
+
+#include <stddef.h>
+#include <vector>
+#include "ParallelMap.h"
+#include "RbTree.h"
+
+namespace easy
+{
+    namespace Internal
+    {
+        // Whether two elements with the same key differ. Map elements differ if their
+        // mapped values do; set elements are all key, so never.
+        template <typename K, typename T>
+        inline bool DiffSame(const easy::pair<K, T>& a, const easy::pair<K, T>& b)
+        {
+            return a.second == b.second;
+        }
+
+        template <typename T>
+        inline bool DiffSame(const T& /*a*/, const T& /*b*/)
+        {
+            return true;
+        }
+
+        // Merges [itA, itAEnd) with [itB, itBEnd), which hold the same range of keys.
+        template <typename Container, typename OnAdded, typename OnRemoved, typename OnChanged>
+        void DiffRange(const Container& a, typename Container::const_iterator itA, typename Container::const_iterator itAEnd,
+                       typename Container::const_iterator itB, typename Container::const_iterator itBEnd,
+                       OnAdded& onAdded, OnRemoved& onRemoved, OnChanged& onChanged)
+        {
+            typename Container::extract_key extractKey;
+            const typename Container::key_compare& compare = a.key_comp();
+
+            while ((itA != itAEnd) && (itB != itBEnd))
+            {
+                if (compare(extractKey(*itA), extractKey(*itB)))
+                    onRemoved(*itA++);
+                else if (compare(extractKey(*itB), extractKey(*itA)))
+                    onAdded(*itB++);
+                else
+                {
+                    if (!DiffSame(*itA, *itB))
+                        onChanged(*itA, *itB);
+                    ++itA;
+                    ++itB;
+                }
+            }
+
+            for (; itA != itAEnd; ++itA)
+                onRemoved(*itA);
+            for (; itB != itBEnd; ++itB)
+                onAdded(*itB);
+        }
+
+        template <typename Container, typename OnAdded, typename OnRemoved, typename OnChanged>
+        struct parallel_diff_task
+        {
+            typedef typename Container::const_iterator const_iterator;
+            typedef typename Container::node_type      node_type;
+
+            const Container&                  mA;
+            const Container&                  mB;
+            const std::vector<parallel_part>& mParts;
+            OnAdded&                          mOnAdded;
+            OnRemoved&                        mOnRemoved;
+            OnChanged&                        mOnChanged;
+
+            // Part i holds the keys after the top node of part i - 1, up to and
+            // including its own top node. The last part has none and runs to the end.
+            const_iterator Bound(const Container& c, size_t i) const
+            {
+                if ((i == mParts.size()) || (mParts[i].mpNode == NULL))
+                    return c.end();
+
+                typename Container::extract_key extractKey;
+                return c.upper_bound(extractKey(static_cast<const node_type*>(mParts[i].mpNode)->mValue));
+            }
+
+            void operator()(size_t i)
+            {
+                const_iterator itA = i ? Bound(mA, i - 1) : mA.begin();
+                const_iterator itB = i ? Bound(mB, i - 1) : mB.begin();
+                DiffRange(mA, itA, Bound(mA, i), itB, Bound(mB, i), mOnAdded, mOnRemoved, mOnChanged);
+            }
+        };
+    }
+
+
+    /// diff
+    ///
+    /// Reports how b differs from a, in key order: onAdded(y) for each element of
+    /// b whose key isn't in a, onRemoved(x) for each element of a whose key isn't
+    /// in b, and onChanged(x, y) for each key in both whose mapped values differ
+    /// by operator==. Sets only report additions and removals.
+    ///
+    /// The two containers are merged as two sorted sequences, so the diff costs
+    /// O(|a| + |b|) compares, where calling find on b for each element of a costs
+    /// O(n log n). Both are ordered by a's key_comp(). A container diffed with
+    /// itself returns at once.
+    ///
+    /// For a multimap or multiset, equal keys are paired up in order.
+    ///
+    /// Example usage:
+    ///     easy::diff(yesterday, today,
+    ///         [](const easy::pair<int, int>& y) { ... },                              // added
+    ///         [](const easy::pair<int, int>& x) { ... },                              // removed
+    ///         [](const easy::pair<int, int>& x, const easy::pair<int, int>& y) { ... }); // changed
+    ///
+    template <typename Container, typename OnAdded, typename OnRemoved, typename OnChanged>
+    void diff(const Container& a, const Container& b, OnAdded onAdded, OnRemoved onRemoved, OnChanged onChanged)
+    {
+        if (&a != &b)
+            Internal::DiffRange(a, a.begin(), a.end(), b.begin(), b.end(), onAdded, onRemoved, onChanged);
+    }
+
+
+    /// parallel_diff
+    ///
+    /// diff spread over nThreads threads (0 means one per hardware thread). The
+    /// larger container is split into parts as parallel_for_each splits it, and
+    /// the keys at the part boundaries split the other one with upper_bound, so
+    /// each part is an independent merge of one range of keys. Within a part the
+    /// callbacks come in key order, but the parts run concurrently, so the
+    /// callbacks must be safe to call from several threads at once. Neither
+    /// container may be modified during the call.
+    ///
+    template <typename Container, typename OnAdded, typename OnRemoved, typename OnChanged>
+    void parallel_diff(const Container& a, const Container& b, OnAdded onAdded, OnRemoved onRemoved, OnChanged onChanged, size_t nThreads = 0)
+    {
+        if (&a == &b)
+            return;
+
+        std::vector<Internal::parallel_part> parts;
+        nThreads = Internal::ParallelPrepare((a.size() >= b.size()) ? a : b, nThreads, parts);
+
+        Internal::parallel_diff_task<Container, OnAdded, OnRemoved, OnChanged> task = { a, b, parts, onAdded, onRemoved, onChanged };
+        Internal::ParallelRun(parts.size(), nThreads, task);
+    }
+
+} // namespace easy
+
+#endif // __EASY_MAP_DIFF_H__
@@ -0,0 +1,743 @@
+#ifndef __EASY_MAPPED_MAP_H__
+#define __EASY_MAPPED_MAP_H__
+
+/**
+ * easy::map的磁盘快照格式及基于mmap的只读视图
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <new>
+#include <string>
+#include <type_traits>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "RbTree.h"
+
+namespace easy
+{
+    /// Snapshot file layout
+    ///
+    /// A snapshot is a single file which starts with a snapshot_header. All other
+    /// locations in the file are stored as byte offsets from the start of the file,
+    /// so the image is position independent and can be mapped anywhere (and by
+    /// several processes at once).
+    ///
+    /// Each of the key and value columns is stored in one of two ways:
+    ///     kSnapshotKindFixed:  a packed array of count elements of mKeySize/mValueSize
+    ///                          bytes each, at mKeyDataOffset/mValueDataOffset.
+    ///     kSnapshotKindString: an index of count uint64_t offsets at mKeyIndexOffset/
+    ///                          mValueIndexOffset, each pointing to a uint32_t length
+    ///                          followed by the string bytes.
+    ///
+    /// Keys are stored in sorted order, so lookups are a binary search over the
+    /// key column. All integers are stored in the byte order of the writer.
+    ///
+    enum SnapshotKind
+    {
+        kSnapshotKindFixed,
+        kSnapshotKindString
+    };
+
+    static const uint32_t kSnapshotVersion = 1;
+    static const uint64_t kSnapshotAlignment = 16; // Alignment of each section within the file.
+
+    struct snapshot_header
+    {
+        char     mMagic[8];          // "EASYMAP" followed by a zero byte.
+        uint32_t mVersion;           // kSnapshotVersion.
+        uint32_t mHeaderSize;        // sizeof(snapshot_header), so the header can grow in later versions.
+        uint64_t mFileSize;
+        uint64_t mCount;             // Number of key/value pairs.
+        uint32_t mKeyKind;           // SnapshotKind.
+        uint32_t mKeySize;           // sizeof(Key) for kSnapshotKindFixed, otherwise 0.
+        uint32_t mValueKind;
+        uint32_t mValueSize;
+        uint64_t mKeyIndexOffset;    // Only used for kSnapshotKindString.
+        uint64_t mKeyDataOffset;
+        uint64_t mValueIndexOffset;
+        uint64_t mValueDataOffset;
+    };
+
+
+    /// snapshot_string
+    ///
+    /// A non-owning reference to a length-prefixed string inside a mapped snapshot.
+    ///
+    struct snapshot_string
+    {
+        const char* mpData;
+        uint32_t    mnSize;
+
+        snapshot_string() : mpData(NULL), mnSize(0) {}
+        snapshot_string(const char* pData, uint32_t nSize) : mpData(pData), mnSize(nSize) {}
+
+        const char* data() const { return mpData; }
+        uint32_t    size() const { return mnSize; }
+        std::string str()  const { return std::string(mpData, mnSize); }
+
+        int compare(const char* pData, size_t nSize) const
+        {
+            const int result = memcmp(mpData, pData, (mnSize < nSize) ? mnSize : nSize);
+            if (result != 0)
+                return result;
+            return (mnSize < nSize) ? -1 : ((mnSize > nSize) ? 1 : 0);
+        }
+    };
+
+
+    /// snapshot_string_less
+    ///
+    /// Orders snapshot strings and std::strings the same way std::string::compare does,
+    /// which is the order a map<std::string, T> with the default Compare is in.
+    ///
+    struct snapshot_string_less
+    {
+        bool operator()(const snapshot_string& a, const std::string& b) const { return a.compare(b.data(), b.size()) < 0; }
+        bool operator()(const std::string& a, const snapshot_string& b) const { return b.compare(a.data(), a.size()) > 0; }
+        bool operator()(const snapshot_string& a, const snapshot_string& b) const { return a.compare(b.data(), b.size()) < 0; }
+    };
+
+
+    /// snapshot_traits
+    ///
+    /// Describes how a key or value type is written to and read from a snapshot.
+    /// The default covers trivially copyable types, which are stored as raw bytes
+    /// and read back in place. std::string is specialized below.
+    ///
+    template <typename T>
+    struct snapshot_traits
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot_traits: only trivially copyable types and std::string are supported");
+
+        typedef const T&      view_type;
+        typedef easy::less<T> compare_type;
+
+        static const uint32_t kKind = kSnapshotKindFixed;
+        static const uint32_t kSize = sizeof(T);
+
+        static uint64_t stored_size(const T&)
+        {
+            return sizeof(T);
+        }
+
+        static bool write(FILE* pFile, const T& value)
+        {
+            return fwrite(&value, sizeof(T), 1, pFile) == 1;
+        }
+
+        static view_type view(const char* pBase, const snapshot_header& /*header*/, uint64_t nDataOffset, uint64_t /*nIndexOffset*/, uint64_t i)
+        {
+            return *reinterpret_cast<const T*>(pBase + nDataOffset + i * sizeof(T));
+        }
+    };
+
+
+    template <>
+    struct snapshot_traits<std::string>
+    {
+        typedef snapshot_string      view_type;
+        typedef snapshot_string_less compare_type;
+
+        static const uint32_t kKind = kSnapshotKindString;
+        static const uint32_t kSize = 0;
+
+        static uint64_t stored_size(const std::string& value)
+        {
+            return sizeof(uint32_t) + value.size();
+        }
+
+        static bool write(FILE* pFile, const std::string& value)
+        {
+            const uint32_t nSize = (uint32_t)value.size();
+            return (fwrite(&nSize, sizeof(nSize), 1, pFile) == 1) &&
+                   (value.empty() || fwrite(value.data(), value.size(), 1, pFile) == 1);
+        }
+
+        /// The index entry and length of each string are checked against the file
+        /// size as it is read, so a corrupt entry reads as an empty string instead
+        /// of reading outside the mapping, and opening stays O(1).
+        static view_type view(const char* pBase, const snapshot_header& header, uint64_t /*nDataOffset*/, uint64_t nIndexOffset, uint64_t i)
+        {
+            const uint64_t nOffset = reinterpret_cast<const uint64_t*>(pBase + nIndexOffset)[i];
+            uint32_t       nSize;
+
+            if ((nOffset < header.mHeaderSize) || (nOffset > (header.mFileSize - sizeof(nSize))))
+                return snapshot_string(pBase, 0);
+
+            memcpy(&nSize, pBase + nOffset, sizeof(nSize)); // The length prefix isn't necessarily aligned.
+
+            if (nSize > (header.mFileSize - nOffset - sizeof(nSize)))
+                return snapshot_string(pBase, 0);
+
+            return snapshot_string(pBase + nOffset + sizeof(nSize), nSize);
+        }
+    };
+
+
+    namespace Internal
+    {
+        inline bool SnapshotPad(FILE* pFile, uint64_t& nPosition)
+        {
+            static const char zeros[kSnapshotAlignment] = { 0 };
+            const uint64_t nPad = (kSnapshotAlignment - (nPosition % kSnapshotAlignment)) % kSnapshotAlignment;
+
+            nPosition += nPad;
+            return (nPad == 0) || (fwrite(zeros, (size_t)nPad, 1, pFile) == 1);
+        }
+
+        // Writes one column (keys or values) of the snapshot. For string columns the index
+        // is written first; its entries are computed up front from the string lengths.
+        template <typename T, typename Iterator, typename Get>
+        bool SnapshotWriteColumn(FILE* pFile, uint64_t& nPosition, Iterator first, Iterator last, uint64_t nCount,
+                                 Get get, uint64_t& nIndexOffset, uint64_t& nDataOffset)
+        {
+            typedef snapshot_traits<T> traits;
+
+            nIndexOffset = 0;
+
+            if (traits::kKind == kSnapshotKindString)
+            {
+                if (!SnapshotPad(pFile, nPosition))
+                    return false;
+
+                nIndexOffset = nPosition;
+                uint64_t nOffset = nPosition + nCount * sizeof(uint64_t);
+
+                nOffset += (kSnapshotAlignment - (nOffset % kSnapshotAlignment)) % kSnapshotAlignment; // Skip the padding SnapshotPad adds below.
+
+                for (Iterator it = first; it != last; ++it)
+                {
+                    if (fwrite(&nOffset, sizeof(nOffset), 1, pFile) != 1)
+                        return false;
+                    nOffset += traits::stored_size(get(*it));
+                }
+                nPosition += nCount * sizeof(uint64_t);
+            }
+
+            if (!SnapshotPad(pFile, nPosition))
+                return false;
+
+            nDataOffset = nPosition;
+
+            for (Iterator it = first; it != last; ++it)
+            {
+                if (!traits::write(pFile, get(*it)))
+                    return false;
+                nPosition += traits::stored_size(get(*it));
+            }
+
+            return true;
+        }
+
+        template <typename Pair>
+        struct snapshot_get_first
+        {
+            const typename Pair::first_type& operator()(const Pair& x) const { return x.first; }
+        };
+
+        template <typename Pair>
+        struct snapshot_get_second
+        {
+            const typename Pair::second_type& operator()(const Pair& x) const { return x.second; }
+        };
+    }
+
+
+    /// mapped_file
+    ///
+    /// A read-only mapping of a whole file, which mapped_map and the other views of
+    /// files written by this library sit on. It can't be copied, as it owns the
+    /// mapping.
+    ///
+    class mapped_file
+    {
+    public:
+        mapped_file();
+        ~mapped_file();
+
+        /// Maps the file at path. Returns false if it can't be mapped or is smaller
+        /// than nMinSize bytes.
+        bool open(const char* path, uint64_t nMinSize = 0);
+        void close();
+        bool is_open() const { return mpBase != NULL; }
+
+        const char* data() const { return mpBase; }
+        uint64_t    size() const { return mnSize; }
+
+    private:
+        mapped_file(const mapped_file&);
+        mapped_file& operator=(const mapped_file&);
+
+    private:
+        const char* mpBase;
+        uint64_t    mnSize;
+#if defined(_WIN32)
+        HANDLE      mhFile;
+        HANDLE      mhMapping;
+#endif
+    };
+
+
+    /// write_snapshot
+    ///
+    /// Writes the contents of a map (or any container with sorted, unique keys
+    /// and pair-like elements) to path in the snapshot format described above.
+    /// Returns false if the file could not be written.
+    ///
+    /// The snapshot is searched with mapped_map's Compare, so the map must be
+    /// ordered the same way. For std::string keys that is the default ordering.
+    ///
+    template <typename Map>
+    bool write_snapshot(const Map& m, const char* path)
+    {
+        typedef typename Map::key_type       key_type;
+        typedef typename Map::mapped_type    mapped_type;
+        typedef typename Map::value_type     value_type;
+
+        FILE* const pFile = fopen(path, "wb");
+        if (pFile == NULL)
+            return false;
+
+        snapshot_header header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.mMagic, "EASYMAP", 8);
+        header.mVersion = kSnapshotVersion;
+        header.mHeaderSize = sizeof(snapshot_header);
+        header.mCount = m.size();
+        header.mKeyKind = snapshot_traits<key_type>::kKind;
+        header.mKeySize = snapshot_traits<key_type>::kSize;
+        header.mValueKind = snapshot_traits<mapped_type>::kKind;
+        header.mValueSize = snapshot_traits<mapped_type>::kSize;
+
+        uint64_t nPosition = sizeof(snapshot_header);
+        bool     bResult = (fwrite(&header, sizeof(header), 1, pFile) == 1); // Written again below once the offsets are known.
+
+        bResult = bResult && Internal::SnapshotWriteColumn<key_type>(pFile, nPosition, m.begin(), m.end(), header.mCount,
+            Internal::snapshot_get_first<value_type>(), header.mKeyIndexOffset, header.mKeyDataOffset);
+        bResult = bResult && Internal::SnapshotWriteColumn<mapped_type>(pFile, nPosition, m.begin(), m.end(), header.mCount,
+            Internal::snapshot_get_second<value_type>(), header.mValueIndexOffset, header.mValueDataOffset);
+
+        header.mFileSize = nPosition;
+
+        bResult = bResult && (fseek(pFile, 0, SEEK_SET) == 0) && (fwrite(&header, sizeof(header), 1, pFile) == 1);
+        bResult = (fclose(pFile) == 0) && bResult;
+        return bResult;
+    }
+
+
+    /// mapped_map
+    ///
+    /// A read-only view of a snapshot written by write_snapshot. The file is mapped
+    /// into memory and find, lower_bound, upper_bound and iteration work directly on
+    /// the mapped pages, so opening is O(1) regardless of the number of elements and
+    /// the memory is shared with every other process that maps the same file.
+    ///
+    /// Keys and values are returned as snapshot_traits<T>::view_type, which is a
+    /// const reference for trivially copyable types and a snapshot_string for
+    /// std::string. References are valid until the mapped_map is closed.
+    ///
+    /// Example usage:
+    ///     easy::write_snapshot(myMap, "my.map");
+    ///
+    ///     easy::mapped_map<int, std::string> mapped;
+    ///     if (mapped.open("my.map")) {
+    ///         easy::mapped_map<int, std::string>::const_iterator it = mapped.find(5);
+    ///         if (it != mapped.end())
+    ///             std::cout << it->second.str();
+    ///     }
+    ///
+    template <typename Key, typename T, typename Compare = typename snapshot_traits<Key>::compare_type>
+    class mapped_map
+    {
+    public:
+        typedef mapped_map<Key, T, Compare>                      this_type;
+        typedef Key                                              key_type;
+        typedef T                                                mapped_type;
+        typedef typename snapshot_traits<Key>::view_type         key_view_type;
+        typedef typename snapshot_traits<T>::view_type           mapped_view_type;
+        typedef uint64_t                                         size_type;
+        typedef Compare                                          key_compare;
+
+        /// value_type
+        ///
+        /// A pair of views. This is not an easy::pair because the views may be references.
+        ///
+        struct value_type
+        {
+            key_view_type    first;
+            mapped_view_type second;
+
+            value_type(key_view_type first_, mapped_view_type second_) : first(first_), second(second_) {}
+        };
+        /// const_iterator
+        ///
+        /// A random access position in the snapshot. Dereferencing builds a small
+        /// pair of views on the fly; nothing is copied out of the mapping.
+        ///
+        class const_iterator
+        {
+        public:
+            const_iterator() : mpMap(NULL), mnIndex(0) {}
+            const_iterator(const this_type* pMap, uint64_t nIndex) : mpMap(pMap), mnIndex(nIndex) {}
+
+            key_view_type    key()   const { return mpMap->key_at(mnIndex); }
+            mapped_view_type value() const { return mpMap->value_at(mnIndex); }
+
+            value_type        operator*()  const { return value_type(key(), value()); }
+            const value_type* operator->() const { mValue.reset(key(), value()); return mValue.get(); }
+
+            const_iterator& operator++() { ++mnIndex; return *this; }
+            const_iterator  operator++(int) { const_iterator temp(*this); ++mnIndex; return temp; }
+            const_iterator& operator--() { --mnIndex; return *this; }
+            const_iterator  operator--(int) { const_iterator temp(*this); --mnIndex; return temp; }
+
+            uint64_t index() const { return mnIndex; }
+
+            bool operator==(const const_iterator& x) const { return mnIndex == x.mnIndex; }
+            bool operator!=(const const_iterator& x) const { return mnIndex != x.mnIndex; }
+
+        private:
+            // value_type may hold references, so it can't be assigned. We rebuild it in place instead.
+            struct value_holder
+            {
+                union { char mBuffer[sizeof(value_type)]; uint64_t mAlign; };
+                bool mbConstructed;
+
+                value_holder() : mbConstructed(false) {}
+                value_holder(const value_holder&) : mbConstructed(false) {}
+                value_holder& operator=(const value_holder&) { return *this; }
+                ~value_holder() { destroy(); }
+
+                void reset(key_view_type k, mapped_view_type v) { destroy(); new(mBuffer) value_type(k, v); mbConstructed = true; }
+                void destroy() { if (mbConstructed) { get()->~value_type(); mbConstructed = false; } }
+                value_type* get() { return reinterpret_cast<value_type*>(mBuffer); }
+            };
+
+            const this_type*     mpMap;
+            uint64_t             mnIndex;
+            mutable value_holder mValue;
+        };
+
+        typedef const_iterator iterator;
+
+    public:
+        mapped_map();
+        explicit mapped_map(const Compare& compare);
+        ~mapped_map();
+
+        /// Maps the snapshot at path. Returns false if the file can't be mapped or
+        /// isn't a snapshot of this key and value type.
+        bool open(const char* path);
+        void close();
+        bool is_open() const { return mpBase != NULL; }
+
+        const_iterator begin() const { return const_iterator(this, 0); }
+        const_iterator end()   const { return const_iterator(this, size()); }
+
+        bool      empty() const { return size() == 0; }
+        size_type size()  const { return mpBase ? header().mCount : 0; }
+
+        key_view_type    key_at(uint64_t i) const;
+        mapped_view_type value_at(uint64_t i) const;
+
+        template <typename U> const_iterator find(const U& key) const;
+        template <typename U> const_iterator lower_bound(const U& key) const;
+        template <typename U> const_iterator upper_bound(const U& key) const;
+        template <typename U> size_type      count(const U& key) const { return (find(key) != end()) ? 1 : 0; }
+
+    protected:
+        const snapshot_header& header() const { return *reinterpret_cast<const snapshot_header*>(mpBase); }
+        bool DoValidate(uint64_t nFileSize) const;
+        bool DoColumnFits(uint64_t nOffset, uint64_t nElementSize, uint64_t nFileSize) const;
+
+    private:
+        mapped_map(const this_type&);             // Not copyable, as the mapping is owned.
+        this_type& operator=(const this_type&);
+
+    protected:
+        Compare     mCompare;
+        mapped_file mFile;
+        const char* mpBase;   // mFile.data(), once the snapshot is validated.
+    }; // mapped_map
+
+
+
+    ///////////////////////////////////////////////////////////////////////
+    // mapped_file
+    ///////////////////////////////////////////////////////////////////////
+
+    inline mapped_file::mapped_file()
+        : mpBase(NULL),
+        mnSize(0)
+#if defined(_WIN32)
+        , mhFile(INVALID_HANDLE_VALUE),
+        mhMapping(NULL)
+#endif
+    {
+    }
+
+
+    inline mapped_file::~mapped_file()
+    {
+        close();
+    }
+
+
+    inline bool mapped_file::open(const char* path, uint64_t nMinSize)
+    {
+        close();
+
+#if defined(_WIN32)
+        mhFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (mhFile == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(mhFile, &size) || (size.QuadPart < (LONGLONG)nMinSize) || (size.QuadPart == 0))
+        {
+            close();
+            return false;
+        }
+
+        mhMapping = CreateFileMappingA(mhFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mhMapping)
+            mpBase = (const char*)MapViewOfFile(mhMapping, FILE_MAP_READ, 0, 0, 0);
+        mnSize = (uint64_t)size.QuadPart;
+#else
+        const int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        if ((fstat(fd, &st) != 0) || (st.st_size < (off_t)nMinSize) || (st.st_size == 0))
+        {
+            ::close(fd);
+            return false;
+        }
+
+        void* const pMapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd); // The mapping keeps its own reference to the file.
+
+        if (pMapping != MAP_FAILED)
+            mpBase = (const char*)pMapping;
+        mnSize = (uint64_t)st.st_size;
+#endif
+
+        if (!mpBase)
+        {
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+
+    inline void mapped_file::close()
+    {
+#if defined(_WIN32)
+        if (mpBase)
+            UnmapViewOfFile(mpBase);
+        if (mhMapping)
+            CloseHandle(mhMapping);
+        if (mhFile != INVALID_HANDLE_VALUE)
+            CloseHandle(mhFile);
+        mhMapping = NULL;
+        mhFile = INVALID_HANDLE_VALUE;
+#else
+        if (mpBase)
+            munmap(const_cast<char*>(mpBase), (size_t)mnSize);
+#endif
+        mpBase = NULL;
+        mnSize = 0;
+    }
+
+
+
+    ///////////////////////////////////////////////////////////////////////
+    // mapped_map
+    ///////////////////////////////////////////////////////////////////////
+
+    template <typename Key, typename T, typename Compare>
+    inline mapped_map<Key, T, Compare>::mapped_map()
+        : mCompare(),
+        mFile(),
+        mpBase(NULL)
+    {
+    }
+
+
+    template <typename Key, typename T, typename Compare>
+    inline mapped_map<Key, T, Compare>::mapped_map(const Compare& compare)
+        : mCompare(compare),
+        mFile(),
+        mpBase(NULL)
+    {
+    }
+
+
+    template <typename Key, typename T, typename Compare>
+    inline mapped_map<Key, T, Compare>::~mapped_map()
+    {
+        close();
+    }
+
+
+    template <typename Key, typename T, typename Compare>
+    bool mapped_map<Key, T, Compare>::open(const char* path)
+    {
+        close();
+
+        if (!mFile.open(path, sizeof(snapshot_header)))
+            return false;
+
+        mpBase = mFile.data();
+
+        if (!DoValidate(mFile.size()))
+        {
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+
+    template <typename Key, typename T, typename Compare>
+    void mapped_map<Key, T, Compare>::close()
+    {
+        mFile.close();
+        mpBase = NULL;
+    }
+
+
+    template <typename Key, typename T, typename Compare>
+    bool mapped_map<Key, T, Compare>::DoValidate(uint64_t nFileSize) const
+    {
+        const snapshot_header& h = header();
+
+        if ((memcmp(h.mMagic, "EASYMAP", 8) != 0) || (h.mVersion != kSnapshotVersion) ||
+            (h.mHeaderSize < sizeof(snapshot_header)) || (h.mFileSize != nFileSize))
+            return false;
+
+        if ((h.mKeyKind != snapshot_traits<Key>::kKind) || (h.mKeySize != snapshot_traits<Key>::kSize) ||
+            (h.mValueKind != snapshot_traits<T>::kKind) || (h.mValueSize != snapshot_traits<T>::kSize))
+            return false; // The snapshot was written for a different key or value type.
+
+        // Make sure the columns lie within the file. Each string is checked against the
+        // file size when it is read (see snapshot_traits<std::string>::view), as checking
+        // them all here would make opening O(n).
+        const bool bKeysFit = (h.mKeyKind == kSnapshotKindString) ? DoColumnFits(h.mKeyIndexOffset, sizeof(uint64_t), nFileSize)
+                                                                  : DoColumnFits(h.mKeyDataOffset, h.mKeySize, nFileSize);
+        const bool bValuesFit = (h.mValueKind == kSnapshotKindString) ? DoColumnFits(h.mValueIndexOffset, sizeof(uint64_t), nFileSize)
+                                                                      : DoColumnFits(h.mValueDataOffset, h.mValueSize, nFileSize);
+
+        return bKeysFit && bValuesFit;
+    }
+
+
+    template <typename Key, typename T, typename Compare>
+    bool mapped_map<Key, T, Compare>::DoColumnFits(uint64_t nOffset, uint64_t nElementSize, uint64_t nFileSize) const
+    {
+        // Divides instead of multiplying, as a corrupt count could wrap the product around.
+        const snapshot_header& h = header();
+
+        return (nOffset >= h.mHeaderSize) && (nOffset <= nFileSize) && ((nOffset % kSnapshotAlignment) == 0) &&
+               (h.mCount <= ((nFileSize - nOffset) / nElementSize));
+    }
+
+
+    template <typename Key, typename T, typename Compare>
+    inline typename mapped_map<Key, T, Compare>::key_view_type
+        mapped_map<Key, T, Compare>::key_at(uint64_t i) const
+    {
+        const snapshot_header& h = header();
+        return snapshot_traits<Key>::view(mpBase, h, h.mKeyDataOffset, h.mKeyIndexOffset, i);
+    }
+
+
+    template <typename Key, typename T, typename Compare>
+    inline typename mapped_map<Key, T, Compare>::mapped_view_type
+        mapped_map<Key, T, Compare>::value_at(uint64_t i) const
+    {
+        const snapshot_header& h = header();
+        return snapshot_traits<T>::view(mpBase, h, h.mValueDataOffset, h.mValueIndexOffset, i);
+    }
+
+
+    template <typename Key, typename T, typename Compare>
+    template <typename U>
+    typename mapped_map<Key, T, Compare>::const_iterator
+        mapped_map<Key, T, Compare>::lower_bound(const U& key) const
+    {
+        uint64_t nLow = 0;
+        uint64_t nCount = size();
+
+        while (nCount > 0) // Branch-light binary search over the sorted key column.
+        {
+            const uint64_t nHalf = nCount / 2;
+
+            if (mCompare(key_at(nLow + nHalf), key)) // If the middle key is < key...
+            {
+                nLow += nHalf + 1;
+                nCount -= nHalf + 1;
+            } else
+                nCount = nHalf;
+        }
+
+        return const_iterator(this, nLow);
+    }
+
+
+    template <typename Key, typename T, typename Compare>
+    template <typename U>
+    typename mapped_map<Key, T, Compare>::const_iterator
+        mapped_map<Key, T, Compare>::upper_bound(const U& key) const
+    {
+        uint64_t nLow = 0;
+        uint64_t nCount = size();
+
+        while (nCount > 0)
+        {
+            const uint64_t nHalf = nCount / 2;
+
+            if (!mCompare(key, key_at(nLow + nHalf))) // If the middle key is <= key...
+            {
+                nLow += nHalf + 1;
+                nCount -= nHalf + 1;
+            } else
+                nCount = nHalf;
+        }
+
+        return const_iterator(this, nLow);
+    }
+
+
+    template <typename Key, typename T, typename Compare>
+    template <typename U>
+    typename mapped_map<Key, T, Compare>::const_iterator
+        mapped_map<Key, T, Compare>::find(const U& key) const
+    {
+        const const_iterator it(lower_bound(key));
+
+        if ((it.index() != size()) && !mCompare(key, key_at(it.index())))
+            return it;
+        return end();
+    }
+
+} // namespace easy
+
+#endif // __EASY_MAPPED_MAP_H__
@@ -0,0 +1,299 @@
+#ifndef __EASY_MERGED_VIEW_H__
+#define __EASY_MERGED_VIEW_H__
+
+/**
+ * 多个easy::map/easy::set的有序合并遍历(k路归并)
+ */
+
+#include <vector>
+#include "RbTree.h"
+
+namespace easy
+{
+    /// MergeDuplicates
+    ///
+    /// Tells a merge_view what to do when more than one source contains the same key.
+    ///
+    enum MergeDuplicates
+    {
+        kMergeKeepAll,      // Visit every element. Equal keys are visited in source order.
+        kMergeFirstWins,    // Visit only the element from the lowest numbered source.
+        kMergeLastWins      // Visit only the element from the highest numbered source.
+    };
+
+
+    /// merge_view
+    ///
+    /// An ordered, read-only view over any number of maps or sets of the same type.
+    /// Iteration does a k-way merge of the sources with a binary heap of per-source
+    /// cursors, so each step costs O(log N) comparisons for N sources, and nothing is
+    /// copied out of the sources. Iterators allocate their cursor array once when they
+    /// are created; stepping never allocates.
+    ///
+    /// The sources must outlive the view and must not be modified while it is in use.
+    /// All sources are ordered with the key_comp() of the first source.
+    ///
+    /// Example usage:
+    ///     easy::map<int, int> shard0, shard1, shard2;
+    ///     ...
+    ///     auto view = easy::merged_view(shard0, shard1, shard2);
+    ///     for (auto it = view.lower_bound(100); it != view.end(); ++it)
+    ///         std::cout << it->first << " from shard " << it.source() << std::endl;
+    ///
+    template <typename Container>
+    class merge_view
+    {
+    public:
+        typedef merge_view<Container>                       this_type;
+        typedef typename Container::key_type                key_type;
+        typedef typename Container::value_type              value_type;
+        typedef typename Container::key_compare             key_compare;
+        typedef typename Container::extract_key             extract_key;
+        typedef typename Container::const_iterator          source_iterator;
+        typedef const value_type&                           reference;
+        typedef const value_type*                           pointer;
+        typedef size_t                                      size_type;
+
+        class const_iterator
+        {
+        public:
+            const_iterator() : mpView(NULL) {}
+
+            reference operator*()  const { return *mCursors[mHeap[0]].mIt; }
+            pointer   operator->() const { return &*mCursors[mHeap[0]].mIt; }
+
+            /// Returns the index of the source the current element comes from.
+            size_type source() const { return mHeap[0]; }
+
+            const_iterator& operator++() { DoIncrement(); return *this; }
+            const_iterator  operator++(int) { const_iterator temp(*this); DoIncrement(); return temp; }
+
+            // All end iterators are equal, as are iterators that point to the same element.
+            bool operator==(const const_iterator& x) const
+            {
+                if (mHeap.empty() || x.mHeap.empty())
+                    return mHeap.empty() && x.mHeap.empty();
+                return (mHeap[0] == x.mHeap[0]) && (mCursors[mHeap[0]].mIt == x.mCursors[x.mHeap[0]].mIt);
+            }
+
+            bool operator!=(const const_iterator& x) const { return !(*this == x); }
+
+        protected:
+            friend class merge_view;
+
+            struct cursor
+            {
+                source_iterator mIt;
+                source_iterator mEnd;
+            };
+
+            const_iterator(const this_type* pView, bool bLowerBound, const key_type* pKey);
+
+            bool DoLess(size_type a, size_type b) const;
+            void DoSiftDown(size_type i);
+            void DoPop();
+            void DoAdvanceTop();
+            void DoIncrement();
+
+        protected:
+            const this_type*       mpView;
+            std::vector<cursor>    mCursors;  // One per source, indexed by source number.
+            std::vector<size_type> mHeap;     // Source numbers of the non-exhausted cursors, as a min-heap on the current key.
+        };
+
+        typedef const_iterator iterator;
+
+    public:
+        explicit merge_view(MergeDuplicates duplicates = kMergeKeepAll);
+
+        /// Adds a source. Sources are numbered in the order they are added, which
+        /// matters for kMergeFirstWins and kMergeLastWins.
+        this_type& add(const Container& source);
+
+        void            set_duplicates(MergeDuplicates duplicates) { mDuplicates = duplicates; }
+        MergeDuplicates duplicates() const { return mDuplicates; }
+
+        size_type source_count() const { return mSources.size(); }
+
+        const_iterator begin() const { return const_iterator(this, false, NULL); }
+        const_iterator end()   const { return const_iterator(); }
+
+        /// Returns an iterator to the first element whose key is not less than key,
+        /// by seeking every source with its own lower_bound.
+        const_iterator lower_bound(const key_type& key) const { return const_iterator(this, true, &key); }
+
+    protected:
+        std::vector<const Container*> mSources;
+        MergeDuplicates               mDuplicates;
+    }; // merge_view
+
+
+
+    ///////////////////////////////////////////////////////////////////////
+    // merge_view
+    ///////////////////////////////////////////////////////////////////////
+
+    template <typename Container>
+    inline merge_view<Container>::merge_view(MergeDuplicates duplicates)
+        : mSources(),
+        mDuplicates(duplicates)
+    {
+    }
+
+
+    template <typename Container>
+    inline typename merge_view<Container>::this_type&
+        merge_view<Container>::add(const Container& source)
+    {
+        mSources.push_back(&source);
+        return *this;
+    }
+
+
+    template <typename Container>
+    merge_view<Container>::const_iterator::const_iterator(const this_type* pView, bool bLowerBound, const key_type* pKey)
+        : mpView(pView)
+    {
+        const size_type n = pView->mSources.size();
+
+        mCursors.resize(n);
+        mHeap.reserve(n);
+
+        for (size_type i = 0; i < n; ++i)
+        {
+            const Container& source = *pView->mSources[i];
+
+            mCursors[i].mIt = bLowerBound ? source.lower_bound(*pKey) : source.begin();
+            mCursors[i].mEnd = source.end();
+
+            if (mCursors[i].mIt != mCursors[i].mEnd)
+                mHeap.push_back(i);
+        }
+
+        for (size_type i = mHeap.size() / 2; i-- > 0; ) // Heapify.
+            DoSiftDown(i);
+    }
+
+
+    template <typename Container>
+    inline bool merge_view<Container>::const_iterator::DoLess(size_type a, size_type b) const
+    {
+        // Orders cursors by key, then by source number. With kMergeLastWins the source order
+        // is reversed so that the highest numbered source of a group of equal keys is on top.
+        extract_key        extractKey;
+        const key_compare& compare = mpView->mSources[0]->key_comp();
+        const key_type&    keyA = extractKey(*mCursors[a].mIt);
+        const key_type&    keyB = extractKey(*mCursors[b].mIt);
+
+        if (compare(keyA, keyB))
+            return true;
+        if (compare(keyB, keyA))
+            return false;
+        return (mpView->mDuplicates == kMergeLastWins) ? (a > b) : (a < b);
+    }
+
+
+    template <typename Container>
+    void merge_view<Container>::const_iterator::DoSiftDown(size_type i)
+    {
+        const size_type n = mHeap.size();
+        const size_type nSource = mHeap[i];
+
+        for (size_type nChild = (2 * i) + 1; nChild < n; nChild = (2 * i) + 1)
+        {
+            if (((nChild + 1) < n) && DoLess(mHeap[nChild + 1], mHeap[nChild]))
+                ++nChild;
+
+            if (!DoLess(mHeap[nChild], nSource))
+                break;
+
+            mHeap[i] = mHeap[nChild];
+            i = nChild;
+        }
+
+        mHeap[i] = nSource;
+    }
+
+
+    template <typename Container>
+    inline void merge_view<Container>::const_iterator::DoPop()
+    {
+        mHeap[0] = mHeap.back();
+        mHeap.pop_back();
+
+        if (!mHeap.empty())
+            DoSiftDown(0);
+    }
+
+
+    template <typename Container>
+    inline void merge_view<Container>::const_iterator::DoAdvanceTop()
+    {
+        cursor& c = mCursors[mHeap[0]];
+
+        if (++c.mIt == c.mEnd)
+            DoPop();
+        else
+            DoSiftDown(0); // The cursor's key only got larger, so it can only move down.
+    }
+
+
+    template <typename Container>
+    void merge_view<Container>::const_iterator::DoIncrement()
+    {
+        if (mpView->mDuplicates == kMergeKeepAll)
+        {
+            DoAdvanceTop();
+            return;
+        }
+
+        // Skip the current element and every other source's element with an equal key.
+        // Those are all at the top of the heap, right after the current one.
+        extract_key        extractKey;
+        const key_compare& compare = mpView->mSources[0]->key_comp();
+        const key_type&    key = extractKey(*mCursors[mHeap[0]].mIt); // The sources don't change, so the key stays put.
+
+        do
+        {
+            DoAdvanceTop();
+        } while (!mHeap.empty() && !compare(key, extractKey(*mCursors[mHeap[0]].mIt)));
+    }
+
+
+
+    ///////////////////////////////////////////////////////////////////////
+    // merged_view
+    ///////////////////////////////////////////////////////////////////////
+
+    namespace Internal
+    {
+        template <typename Container>
+        inline void MergedViewAdd(merge_view<Container>&)
+        {
+        }
+
+        template <typename Container, typename... Containers>
+        inline void MergedViewAdd(merge_view<Container>& view, const Container& source, const Containers&... sources)
+        {
+            view.add(source);
+            MergedViewAdd(view, sources...);
+        }
+    }
+
+
+    /// merged_view
+    ///
+    /// Convenience function which returns a merge_view over the given sources,
+    /// numbered in argument order.
+    ///
+    template <typename Container, typename... Containers>
+    inline merge_view<Container> merged_view(const Container& source, const Containers&... sources)
+    {
+        merge_view<Container> view;
+        Internal::MergedViewAdd(view, source, sources...);
+        return view;
+    }
+
+} // namespace easy
+
+#endif // __EASY_MERGED_VIEW_H__
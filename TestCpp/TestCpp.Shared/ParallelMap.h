@@ -0,0 +1,276 @@
+#ifndef __EASY_PARALLEL_MAP_H__
+#define __EASY_PARALLEL_MAP_H__
+
+/**
+ * easy::map/easy::set的多线程遍历和归约
+ */
+
+#include <stddef.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <type_traits>
+#include "RbTree.h"
+
+namespace easy
+{
+    namespace Internal
+    {
+        /// parallel_part
+        ///
+        /// One unit of parallel work: an entire subtree followed (in key order)
+        /// by a single node from the top of the tree. Either may be NULL.
+        ///
+        struct parallel_part
+        {
+            rbtree_node_base* mpSubtree;
+            rbtree_node_base* mpNode;
+        };
+
+        // Splits the tree at nDepth levels below pNode. The top nDepth levels are distributed
+        // one node per part, and everything below them is handed out as whole subtrees. The
+        // parts come out in key order, which is what makes the reductions deterministic.
+        inline void ParallelSplit(rbtree_node_base* pNode, size_t nDepth, std::vector<parallel_part>& parts)
+        {
+            if ((nDepth == 0) || (pNode == NULL))
+            {
+                const parallel_part part = { pNode, NULL };
+                parts.push_back(part);
+                return;
+            }
+
+            ParallelSplit(pNode->mpNodeLeft, nDepth - 1, parts);
+            parts.back().mpNode = pNode; // The last part pushed always ends with a subtree, so it has room for pNode.
+            ParallelSplit(pNode->mpNodeRight, nDepth - 1, parts);
+        }
+
+        // In-order walk of a subtree with an explicit stack. See rbtree::for_each.
+        template <typename Node, typename Reference, typename Function>
+        void ParallelVisitSubtree(rbtree_node_base* pNode, Function& f)
+        {
+            rbtree_node_base* stack[2 * 8 * sizeof(void*)];
+            size_t            nDepth = 0;
+
+            for (;;)
+            {
+                for (; pNode; pNode = pNode->mpNodeLeft)
+                {
+                    EASY_PREFETCH(pNode->mpNodeRight);
+                    stack[nDepth++] = pNode;
+                }
+
+                if (nDepth == 0)
+                    return;
+
+                pNode = stack[--nDepth];
+                f(static_cast<Reference>(static_cast<Node*>(pNode)->mValue));
+                pNode = pNode->mpNodeRight;
+            }
+        }
+
+        template <typename Node, typename Reference, typename Function>
+        inline void ParallelVisitPart(const parallel_part& part, Function& f)
+        {
+            ParallelVisitSubtree<Node, Reference>(part.mpSubtree, f);
+
+            if (part.mpNode)
+                f(static_cast<Reference>(static_cast<Node*>(part.mpNode)->mValue));
+        }
+
+        // Runs task(i) for every i in [0, nTasks) on nThreads threads, including the calling
+        // thread. The tasks are claimed from a shared counter, so a thread that finishes its
+        // part early simply takes the next unclaimed one. As the parts are independent and
+        // don't spawn more work, this balances load the same way work stealing would.
+        template <typename Task>
+        void ParallelRun(size_t nTasks, size_t nThreads, Task& task)
+        {
+            std::atomic<size_t> nNext(0);
+
+            struct worker
+            {
+                std::atomic<size_t>& mnNext;
+                size_t               mnTasks;
+                Task&                mTask;
+
+                void operator()()
+                {
+                    for (size_t i = mnNext.fetch_add(1, std::memory_order_relaxed); i < mnTasks; i = mnNext.fetch_add(1, std::memory_order_relaxed))
+                        mTask(i);
+                }
+            };
+
+            worker                   w = { nNext, nTasks, task };
+            std::vector<std::thread> threads;
+
+            if (nThreads > nTasks)
+                nThreads = nTasks;
+
+            for (size_t i = 1; i < nThreads; ++i)
+                threads.push_back(std::thread(w));
+
+            w();
+
+            for (size_t i = 0; i < threads.size(); ++i)
+                threads[i].join();
+        }
+
+        // Picks the thread count and splits the tree into about kPartsPerThread parts per thread.
+        template <typename Container>
+        size_t ParallelPrepare(const Container& c, size_t nThreads, std::vector<parallel_part>& parts)
+        {
+            static const size_t kMinParallelSize = 8192; // Smaller containers aren't worth starting threads for.
+            static const size_t kPartsPerThread = 8;
+
+            if (nThreads == 0)
+                nThreads = std::thread::hardware_concurrency();
+            if ((nThreads == 0) || (c.size() < kMinParallelSize))
+                nThreads = 1;
+
+            size_t nDepth = 0;
+
+            if (nThreads > 1)
+            {
+                while (((size_t)1 << nDepth) < (nThreads * kPartsPerThread))
+                    ++nDepth;
+            }
+
+            ParallelSplit(c.mAnchor.mpNodeParent, nDepth, parts);
+            return nThreads;
+        }
+
+        template <typename Container>
+        struct parallel_traits
+        {
+            typedef typename std::remove_const<Container>::type                      container_type;
+            typedef typename container_type::node_type                               node_type;
+            typedef typename type_select<std::is_const<Container>::value,
+                typename container_type::const_reference,
+                typename container_type::iterator::reference>::type                  reference;
+        };
+
+        template <typename Node, typename Reference, typename Function>
+        struct parallel_for_each_task
+        {
+            const std::vector<parallel_part>& mParts;
+            Function&                         mFunction;
+
+            void operator()(size_t i) { ParallelVisitPart<Node, Reference>(mParts[i], mFunction); }
+        };
+
+        template <typename T, typename Reference, typename Op>
+        struct parallel_accumulate
+        {
+            T&  mValue;
+            Op& mOp;
+
+            void operator()(Reference x) { mValue = mOp(mValue, x); }
+        };
+
+        // Holds one part's result. This keeps std::vector<bool> from being used for T == bool.
+        template <typename T>
+        struct parallel_result
+        {
+            T mValue;
+            parallel_result(const T& value) : mValue(value) {}
+        };
+
+        template <typename Node, typename Reference, typename T, typename Op>
+        struct parallel_reduce_task
+        {
+            const std::vector<parallel_part>&   mParts;
+            std::vector<parallel_result<T> >&   mResults;
+            Op&                                 mOp;
+
+            void operator()(size_t i)
+            {
+                parallel_accumulate<T, Reference, Op> accumulate = { mResults[i].mValue, mOp };
+                ParallelVisitPart<Node, Reference>(mParts[i], accumulate);
+            }
+        };
+
+        template <typename Predicate>
+        struct parallel_count_op
+        {
+            Predicate& mPredicate;
+
+            template <typename U>
+            size_t operator()(size_t n, const U& x) { return mPredicate(x) ? (n + 1) : n; }
+        };
+
+        struct parallel_count_combine
+        {
+            size_t operator()(size_t a, size_t b) const { return a + b; }
+        };
+    }
+
+
+    /// parallel_for_each
+    ///
+    /// Calls f(value) for every element of a map, set, multimap or multiset, spread
+    /// over nThreads threads (0 means one per hardware thread). The tree is split
+    /// into balanced parts by descending a fixed number of levels from the root, and
+    /// each part is walked in order. Elements are visited concurrently, in no particular
+    /// order, so f must be safe to call from several threads at once. If the container
+    /// is non-const, map values may be modified. The container must not be modified
+    /// structurally during the call.
+    ///
+    template <typename Container, typename Function>
+    void parallel_for_each(Container& c, Function f, size_t nThreads = 0)
+    {
+        typedef Internal::parallel_traits<Container> traits;
+
+        std::vector<Internal::parallel_part> parts;
+        nThreads = Internal::ParallelPrepare(c, nThreads, parts);
+
+        Internal::parallel_for_each_task<typename traits::node_type, typename traits::reference, Function> task = { parts, f };
+        Internal::ParallelRun(parts.size(), nThreads, task);
+    }
+
+
+    /// parallel_reduce
+    ///
+    /// Computes op(...op(op(init, x0), x1)..., xn) for each part of the container in
+    /// parallel, then joins the per-part results with combine in key order. init must be
+    /// an identity for combine (0 for +, 1 for *, an empty container for append). How the
+    /// container is split only depends on its shape and the thread count, never on timing,
+    /// and if combine is associative the result is the same as that of a serial reduction.
+    ///
+    /// Example usage:
+    ///     long long sum = easy::parallel_reduce(myMap, 0LL,
+    ///         [](long long acc, const easy::pair<int, int>& x) { return acc + x.second; },
+    ///         [](long long a, long long b) { return a + b; });
+    ///
+    template <typename Container, typename T, typename Op, typename Combine>
+    T parallel_reduce(Container& c, const T& init, Op op, Combine combine, size_t nThreads = 0)
+    {
+        typedef Internal::parallel_traits<Container> traits;
+
+        std::vector<Internal::parallel_part> parts;
+        nThreads = Internal::ParallelPrepare(c, nThreads, parts);
+
+        std::vector<Internal::parallel_result<T> > results(parts.size(), Internal::parallel_result<T>(init));
+
+        Internal::parallel_reduce_task<typename traits::node_type, typename traits::reference, T, Op> task = { parts, results, op };
+        Internal::ParallelRun(parts.size(), nThreads, task);
+
+        T result(results[0].mValue);
+        for (size_t i = 1; i < results.size(); ++i)
+            result = combine(result, results[i].mValue);
+        return result;
+    }
+
+
+    /// parallel_count_if
+    ///
+    /// Returns the number of elements for which pred returns true. See parallel_reduce.
+    ///
+    template <typename Container, typename Predicate>
+    size_t parallel_count_if(Container& c, Predicate pred, size_t nThreads = 0)
+    {
+        Internal::parallel_count_op<Predicate> op = { pred };
+        return parallel_reduce(c, (size_t)0, op, Internal::parallel_count_combine(), nThreads);
+    }
+
+} // namespace easy
+
+#endif // __EASY_PARALLEL_MAP_H__
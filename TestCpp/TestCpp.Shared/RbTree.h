@@ -4,6 +4,15 @@
  * 红黑树，暂不支持reverse_iterator
  */
 
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 #ifndef EASTL_API // If the build file hasn't already defined this to be dllexport...
 #if EASTL_DLL 
 #if defined(_MSC_VER)
@@ -33,6 +42,39 @@
 #define EASY_VALIDATE_COMPARE(expression)
 #define EA_ANALYSIS_ASSUME(x)
 
+// EASY_PREFETCH
+// Hints that the memory at the given address will be read soon. Prefetching
+// NULL is harmless, so callers don't need to check.
+#if defined(__GNUC__) || defined(__clang__)
+#define EASY_PREFETCH(p) __builtin_prefetch(p)
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <xmmintrin.h>
+#define EASY_PREFETCH(p) _mm_prefetch((const char*)(p), _MM_HINT_T0)
+#else
+#define EASY_PREFETCH(p)
+#endif
+
+// EASY_RBTREE_COUNT_INCREMENTS
+// When defined to 1, every rbtree iterator increment and decrement bumps a
+// process-wide counter, which rbtree::stats reports. Off by default.
+#ifndef EASY_RBTREE_COUNT_INCREMENTS
+#define EASY_RBTREE_COUNT_INCREMENTS 0
+#endif
+
+#if EASY_RBTREE_COUNT_INCREMENTS
+#include <atomic>
+#endif
+
+// EASY_IS_TRIVIALLY_COPYABLE
+// The compiler's test for trivially copyable types. The standard library of the
+// Android toolchain has no std::is_trivially_copyable, so this uses the builtin
+// which the standard libraries use, or its older approximation.
+#if defined(_MSC_VER) || defined(__clang__) || (defined(__GNUC__) && (__GNUC__ >= 5))
+#define EASY_IS_TRIVIALLY_COPYABLE(T) __is_trivially_copyable(T)
+#else
+#define EASY_IS_TRIVIALLY_COPYABLE(T) (__has_trivial_copy(T) && __has_trivial_destructor(T))
+#endif
+
 namespace easy
 {
     template <typename T, T v>
@@ -53,9 +95,41 @@ namespace easy
     typedef integral_constant<bool, true>  true_type;
     typedef integral_constant<bool, false> false_type;
 
+    /// piecewise_construct_t
+    ///
+    /// Selects the pair constructor which builds first and second from a tuple of
+    /// arguments each, like std::piecewise_construct.
+    ///
+    struct piecewise_construct_t
+    {
+        piecewise_construct_t() {}
+    };
+
+    static const piecewise_construct_t piecewise_construct = piecewise_construct_t();
+
+
+    namespace Internal
+    {
+        template <size_t... I>
+        struct index_sequence {};
+
+        template <size_t N, size_t... I>
+        struct make_index_sequence : public make_index_sequence<N - 1, N - 1, I...> {};
+
+        template <size_t... I>
+        struct make_index_sequence<0, I...> { typedef index_sequence<I...> type; };
+
+        template <typename T1, typename T2, typename U1, typename U2>
+        struct pair_convertible
+            : public integral_constant<bool, std::is_convertible<U1, T1>::value && std::is_convertible<U2, T2>::value> {};
+    }
+
+
     /// pair
     ///
-    /// Implements a simple pair, just like the C++ std::pair.
+    /// Implements a simple pair, just like the C++ std::pair. The members are
+    /// initialized from the constructor arguments, forwarded, and the copy and move
+    /// operations are the implicit ones, so pair<int, int> is trivially copyable.
     ///
     template <typename T1, typename T2>
     struct pair
@@ -71,22 +145,110 @@ namespace easy
             : first(),
             second() {}
 
-        pair(const T1 &first_, const T2 &second_)
+        pair(const T1& first_, const T2& second_)
+            : first(first_),
+            second(second_) {}
+
+        template <typename U1, typename U2,
+                  typename = typename std::enable_if<Internal::pair_convertible<T1, T2, U1&&, U2&&>::value>::type>
+        pair(U1&& first_, U2&& second_)
+            : first(std::forward<U1>(first_)),
+            second(std::forward<U2>(second_)) {}
+
+        template <typename U1, typename U2,
+                  typename = typename std::enable_if<Internal::pair_convertible<T1, T2, const U1&, const U2&>::value>::type>
+        pair(const pair<U1, U2>& x)
+            : first(x.first),
+            second(x.second) {}
+
+        template <typename U1, typename U2,
+                  typename = typename std::enable_if<Internal::pair_convertible<T1, T2, U1&&, U2&&>::value>::type>
+        pair(pair<U1, U2>&& x)
+            : first(std::forward<U1>(x.first)),
+            second(std::forward<U2>(x.second)) {}
+
+        /// Constructs first from the elements of args1 and second from those of args2.
+        template <typename... Args1, typename... Args2>
+        pair(piecewise_construct_t, std::tuple<Args1...> args1, std::tuple<Args2...> args2)
+            : pair(args1, args2, typename Internal::make_index_sequence<sizeof...(Args1)>::type(),
+                   typename Internal::make_index_sequence<sizeof...(Args2)>::type()) {}
+
+        pair(const pair&) = default;
+        pair(pair&&) = default;
+        pair& operator=(const pair&) = default;
+        pair& operator=(pair&&) = default;
+
+    private:
+        template <typename... Args1, typename... Args2, size_t... I1, size_t... I2>
+        pair(std::tuple<Args1...>& args1, std::tuple<Args2...>& args2, Internal::index_sequence<I1...>, Internal::index_sequence<I2...>)
+            : first(std::forward<Args1>(std::get<I1>(args1))...),
+            second(std::forward<Args2>(std::get<I2>(args2))...) {}
+    };
+
+    template <typename T1, typename T2>
+    inline pair<typename std::decay<T1>::type, typename std::decay<T2>::type> make_pair(T1&& a, T2&& b)
+    {
+        return easy::pair<typename std::decay<T1>::type, typename std::decay<T2>::type>(std::forward<T1>(a), std::forward<T2>(b));
+    }
+
+
+    /// is_trivially_relocatable
+    ///
+    /// True if a T can be moved to another address with memcpy, leaving nothing to
+    /// destroy at the old one. The containers use it to move elements in bulk, such
+    /// as when a hash table grows. It holds for trivially copyable types and for
+    /// pairs of relocatable types. Specialize it for other types which don't point
+    /// into themselves and have no registered address, such as a handle class which
+    /// owns a heap block:
+    ///     namespace easy { template <> struct is_trivially_relocatable<Buffer> : public true_type {}; }
+    ///
+    template <typename T>
+    struct is_trivially_relocatable : public integral_constant<bool, EASY_IS_TRIVIALLY_COPYABLE(T)> {};
+
+    template <typename T1, typename T2>
+    struct is_trivially_relocatable<pair<T1, T2> >
+        : public integral_constant<bool, is_trivially_relocatable<T1>::value && is_trivially_relocatable<T2>::value> {};
+
+
+    namespace Internal
+    {
+        template <typename T>
+        inline void RelocateValues(T* pDest, T* pSource, size_t n, true_type)
         {
-            first = first_;
-            second = second_;
+            memmove(static_cast<void*>(pDest), static_cast<const void*>(pSource), n * sizeof(T));
         }
-        pair(const pair<T1, T2> & pair_)
+
+        template <typename T>
+        inline void RelocateValues(T* pDest, T* pSource, size_t n, false_type)
         {
-            first = pair_.first;
-            second = pair_.second;
+            if (pDest == pSource)
+                return;
+
+            // Go the way that doesn't overwrite sources not yet moved.
+            if (pDest < pSource)
+            {
+                for (size_t i = 0; i < n; ++i)
+                {
+                    ::new(static_cast<void*>(pDest + i)) T(std::move(pSource[i]));
+                    pSource[i].~T();
+                }
+            } else
+            {
+                for (size_t i = n; i > 0; --i)
+                {
+                    ::new(static_cast<void*>(pDest + i - 1)) T(std::move(pSource[i - 1]));
+                    pSource[i - 1].~T();
+                }
+            }
         }
-    };
 
-    template <typename T1, typename T2>
-    inline pair<T1, T2> make_pair(const T1& a, const T2& b)
-    {
-        return easy::pair<T1, T2>(a, b);
+        // Moves the n values at pSource to the uninitialized memory at pDest, which
+        // may overlap them, and ends their lifetime at pSource.
+        template <typename T>
+        inline void RelocateValues(T* pDest, T* pSource, size_t n)
+        {
+            RelocateValues(pDest, pSource, n, typename is_trivially_relocatable<T>::type());
+        }
     }
 
     // type_select
@@ -230,6 +392,198 @@ namespace easy
     };
 
 
+    /// rbtree_counted_node
+    ///
+    /// The node of a tree with non-unique keys. It also records the number of nodes
+    /// in its subtree, so a run of equal keys is counted from the sizes of the
+    /// subtrees beside its two boundary paths, in O(log n).
+    ///
+    template <typename Value>
+    struct rbtree_counted_node : public rbtree_node<Value>
+    {
+        size_t mnSubtreeSize;
+    };
+
+
+    /// rbtree_augment
+    ///
+    /// Lets a value type keep a summary of its subtree in each node, such as the
+    /// largest end point in an interval tree. Specialize this for the value type,
+    /// set kEnabled to true and implement Update, which recomputes the summary of
+    /// pNode from pNode's own value and its (already up to date) children. rbtree
+    /// calls Update on every node whose subtree changes: after each rotation, and
+    /// on the path from a linked or unlinked node to the root. When kEnabled is
+    /// false none of this code is generated.
+    ///
+    template <typename Value>
+    struct rbtree_augment
+    {
+        static const bool kEnabled = false;
+
+        static void Update(rbtree_node_base* /*pNode*/) {}
+    };
+
+
+    /// allocator
+    ///
+    /// The default node allocator of rbtree. allocate may return NULL instead of
+    /// throwing, e.g. when a fixed capacity allocator is full, in which case the 
+    /// insertion fails and returns end() (or an end()/false pair). 
+    ///
+    struct allocator
+    {
+        void* allocate(size_t n) { return ::operator new(n); }
+        void  deallocate(void* p, size_t /*n*/) { ::operator delete(p); }
+    };
+
+
+    /// RBTreeCounter
+    ///
+    enum RBTreeCounter
+    {
+        kRBTreeCounterCompare,
+        kRBTreeCounterRotate,
+        kRBTreeCounterRecolor,     // Color changes made while rebalancing.
+        kRBTreeCounterAllocate,
+        kRBTreeCounterFree,
+        kRBTreeCounterCount
+    };
+
+
+    /// rbtree_instrumentation
+    ///
+    /// Lets a Compare type collect operation counts for the tree that owns it.
+    /// The tree reports rotations, recolorings, allocations and frees through Add,
+    /// and the comparator counts its own calls. When kEnabled is false, which is 
+    /// the default, no counting code is generated. See instrumented_compare.
+    ///
+    template <typename Compare>
+    struct rbtree_instrumentation
+    {
+        static const bool kEnabled = false;
+
+        static void   Add(const Compare& /*compare*/, RBTreeCounter /*counter*/, size_t /*n*/) {}
+        static size_t Get(const Compare& /*compare*/, RBTreeCounter /*counter*/) { return 0; }
+        static void   Reset(const Compare& /*compare*/) {}
+    };
+
+
+    /// rbtree_three_way
+    ///
+    /// Lets a Compare type order two keys with a single call that returns <0, 0 or
+    /// >0, so that a descent compares once per level and stops at an equal key.
+    /// When kEnabled is false, which is the default, the tree uses operator() as a
+    /// less, and Order is its two-call equivalent. See three_way_less.
+    ///
+    template <typename Compare>
+    struct rbtree_three_way
+    {
+        static const bool kEnabled = false;
+
+        template <typename A, typename B>
+        static int Order(const Compare& compare, const A& a, const B& b)
+        {
+            return compare(a, b) ? -1 : (compare(b, a) ? 1 : 0);
+        }
+    };
+
+
+    /// rbtree_batch_op
+    ///
+    /// One change for rbtree::apply_batch. An upsert inserts mValue, or assigns it to
+    /// the element with the same key. An erase removes the element with mValue's key;
+    /// the rest of mValue is ignored.
+    ///
+    /// Example usage:
+    ///     typedef easy::map<int, int>::batch_op_type op;
+    ///     op ops[] = { op::upsert(easy::make_pair(1, 10)), op::erase(easy::make_pair(2, 0)) };
+    ///     myMap.apply_batch(ops, ops + 2);
+    ///
+    template <typename Value>
+    struct rbtree_batch_op
+    {
+        Value mValue;
+        bool  mbErase;
+
+        rbtree_batch_op() : mValue(), mbErase(false) {}
+        rbtree_batch_op(const Value& value, bool bErase) : mValue(value), mbErase(bErase) {}
+
+        static rbtree_batch_op upsert(const Value& value) { return rbtree_batch_op(value, false); }
+        static rbtree_batch_op erase(const Value& value) { return rbtree_batch_op(value, true); }
+    };
+
+
+    /// rbtree_stats
+    ///
+    /// The result of rbtree::stats.
+    ///
+    struct rbtree_stats
+    {
+        size_t size;
+        size_t height;          // Number of nodes on the longest path from the root to a leaf.
+        size_t black_height;    // Number of black nodes on every path from the root to a leaf.
+        double average_depth;   // Average number of nodes from the root to a node, both included.
+        size_t node_bytes;      // Memory held by the nodes, not counting allocator overhead.
+
+        // Zero unless the tree's Compare is instrumented.
+        size_t compares;
+        size_t rotations;
+        size_t recolors;
+        size_t allocations;
+        size_t frees;
+
+        // Zero unless the tree's Compare keeps a filter.
+        size_t filter_lookups;          // finds that asked the filter.
+        size_t filter_negatives;        // finds the filter answered without a descent.
+        size_t filter_false_positives;  // finds that passed the filter and found nothing.
+        size_t filter_bytes;
+
+        // Process-wide, and zero unless EASY_RBTREE_COUNT_INCREMENTS is 1.
+        size_t increments;
+    };
+
+
+    /// rbtree_filter
+    ///
+    /// Lets a Compare type keep a membership filter over the tree's keys, which
+    /// find asks before it descends. The tree adds a key when it creates a node
+    /// and removes it when it destroys one, clears the filter in clear, and calls
+    /// Regrow once it has grown, which resizes the filter and returns true when
+    /// the tree must add its keys again. When kEnabled is false, which is the
+    /// default, no filter code is generated. See filtered_compare.
+    ///
+    template <typename Compare>
+    struct rbtree_filter
+    {
+        static const bool kEnabled = false;
+
+        template <typename Key>
+        static void Add(Compare& /*compare*/, const Key& /*key*/) {}
+        template <typename Key>
+        static void Remove(Compare& /*compare*/, const Key& /*key*/) {}
+        static void Clear(Compare& /*compare*/) {}
+        static bool Regrow(Compare& /*compare*/, size_t /*nSize*/) { return false; }
+        template <typename Key>
+        static bool MayContain(const Compare& /*compare*/, const Key& /*key*/) { return true; }
+        static void OnFalsePositive(const Compare& /*compare*/) {}
+        static void Get(const Compare& /*compare*/, rbtree_stats& s)
+        {
+            s.filter_lookups = s.filter_negatives = s.filter_false_positives = s.filter_bytes = 0;
+        }
+        static void Reset(const Compare& /*compare*/) {}
+    };
+
+
+#if EASY_RBTREE_COUNT_INCREMENTS
+    /// Returns the process-wide count of rbtree iterator increments and decrements.
+    inline std::atomic<size_t>& rbtree_increment_counter()
+    {
+        static std::atomic<size_t> nCount(0);
+        return nCount;
+    }
+#endif
+
+
 
     /// rbtree_iterator
     ///
@@ -254,6 +608,7 @@ namespace easy
         rbtree_iterator();
         explicit rbtree_iterator(const node_type* pNode);
         rbtree_iterator(const iterator& x);
+        rbtree_iterator& operator=(const iterator& x); // For iterator, the constructor above is the copy constructor, so this is its copy assignment.
 
         reference operator*() const;
         pointer   operator->() const;
@@ -293,6 +648,36 @@ namespace easy
             return const_cast<rbtree_node_base*>(pNode);
         }
 
+        /// RBTreeDecrement
+        /// Returns the previous item in a sorted red-black tree. Decrementing end()
+        /// gives the last item, as the anchor is the only red node whose grandparent
+        /// is itself.
+        ///
+        EASTL_API rbtree_node_base* RBTreeDecrement(const rbtree_node_base* pNode)
+        {
+            if ((pNode->mpNodeParent->mpNodeParent == pNode) && (pNode->mColor == kRBTreeColorRed))
+                return pNode->mpNodeRight;
+            else if (pNode->mpNodeLeft)
+            {
+                rbtree_node_base* pNodeTemp = pNode->mpNodeLeft;
+
+                while (pNodeTemp->mpNodeRight)
+                    pNodeTemp = pNodeTemp->mpNodeRight;
+
+                return pNodeTemp;
+            }
+
+            rbtree_node_base* pNodeTemp = pNode->mpNodeParent;
+
+            while (pNode == pNodeTemp->mpNodeLeft)
+            {
+                pNode = pNodeTemp;
+                pNodeTemp = pNodeTemp->mpNodeParent;
+            }
+
+            return const_cast<rbtree_node_base*>(pNodeTemp);
+        }
+
     }; // rbtree_iterator
 
 
@@ -422,6 +807,9 @@ namespace easy
     /// can be multiple instances of a given key. It will be true for set and map 
     /// and false for multiset and multimap.
     ///
+    /// Allocator: Where the nodes come from. See easy::allocator. A tree copy or
+    /// assignment never copies the allocator; each tree keeps its own.
+    ///
     /// To consider: Add an option for relaxed tree balancing. This could result 
     /// in performance improvements but would require a more complicated implementation.
     ///
@@ -435,17 +823,18 @@ namespace easy
     /// for more documentation on this.
     ///
     template <typename Key, typename Value, typename Compare,
-        typename ExtractKey, bool bMutableIterators, bool bUniqueKeys>
+        typename ExtractKey, bool bMutableIterators, bool bUniqueKeys, typename Allocator = easy::allocator>
     class rbtree
         : public rb_base<Key, Value, Compare, ExtractKey, bUniqueKeys,
-        rbtree<Key, Value, Compare, ExtractKey, bMutableIterators, bUniqueKeys> >
+        rbtree<Key, Value, Compare, ExtractKey, bMutableIterators, bUniqueKeys, Allocator> >
     {
     public:
         typedef int                                                                             difference_type;
         typedef unsigned int                                                                    size_type;     // See config.h for the definition of eastl_size_t, which defaults to uint32_t.
         typedef Key                                                                             key_type;
         typedef Value                                                                           value_type;
-        typedef rbtree_node<value_type>                                                         node_type;
+        typedef typename type_select<bUniqueKeys,
+            rbtree_node<value_type>, rbtree_counted_node<value_type> >::type                     node_type;     // Non-unique keys also count their subtree.
         typedef value_type&                                                                     reference;
         typedef const value_type&                                                               const_reference;
         typedef value_type*                                                                     pointer;
@@ -457,18 +846,22 @@ namespace easy
         typedef rbtree_iterator<value_type, const value_type*, const value_type&>               const_iterator;
 
         typedef Compare                                                                         key_compare;
+        typedef Allocator                                                                       allocator_type;
         typedef typename type_select<bUniqueKeys, easy::pair<iterator, bool>, iterator>::type  insert_return_type;  // map/set::insert return a pair, multimap/multiset::iterator return an iterator.
         typedef rbtree<Key, Value, Compare,
-            ExtractKey, bMutableIterators, bUniqueKeys>                             this_type;
+            ExtractKey, bMutableIterators, bUniqueKeys, Allocator>                  this_type;
         typedef rb_base<Key, Value, Compare, ExtractKey, bUniqueKeys, this_type>                base_type;
         typedef integral_constant<bool, bUniqueKeys>                                            has_unique_keys_type;
         typedef typename base_type::extract_key                                                 extract_key;
+        typedef rbtree_batch_op<value_type>                                                     batch_op_type;
 
         using base_type::mCompare;
 
     public:
         rbtree_node_base  mAnchor;      /// This node acts as end() and its mpLeft points to begin(), and mpRight points to rbegin() (the last node on the right).
         size_type         mnSize;       /// Stores the count of nodes in the tree (not counting the anchor node).
+        allocator_type    mAllocator;   /// Where nodes are allocated from. Declared here so that an empty allocator fits in the padding after mnSize.
+        rbtree_node_base* mpFinger;     /// The most recently inserted node, or NULL. Used as an automatic insertion hint.
 
     public:
         // ctor/dtor
@@ -486,6 +879,9 @@ namespace easy
         const key_compare& key_comp() const { return mCompare; }
         key_compare&       key_comp() { return mCompare; }
 
+        const allocator_type& get_allocator() const { return mAllocator; }
+        allocator_type&       get_allocator() { return mAllocator; }
+
         this_type& operator=(const this_type& x);
 
         void swap(this_type& x);
@@ -522,20 +918,73 @@ namespace easy
         template <typename InputIterator>
         void insert(InputIterator first, InputIterator last);
 
+        /// Appends a range which is sorted according to the tree's Compare.
+        /// The run of values that sort after the current last element is linked 
+        /// into a balanced subtree and joined onto the right spine in a single
+        /// step, so no per-node rebalancing is done. Values which are out of order
+        /// (or duplicates in a tree with unique keys) go through the regular insert.
+        template <typename InputIterator>
+        void append_sorted(InputIterator first, InputIterator last);
+
         iterator erase(const_iterator position);
         iterator erase(const_iterator first, const_iterator last);
 
         // For some reason, multiple STL versions make a specialization 
         // for erasing an array of key_types. I'm pretty sure we don't
         // need this, but just to be safe we will follow suit. 
-        // The implementation is trivial. Returns void because the values
-        // could well be randomly distributed throughout the tree and thus
-        // a return value would be nearly meaningless.
+        // Returns void because the values could well be randomly distributed
+        // throughout the tree and thus a return value would be nearly meaningless.
+        // If the keys are sorted, each search starts where the one before it ended.
         void erase(const key_type* first, const key_type* last);
 
+        /// Applies a range of batch_op_type as if one at a time, in order, so the last
+        /// operation on a key wins, but in a single pass over the tree. The operations
+        /// are sorted by key (stably, unless they already are). A batch that is small
+        /// next to the tree then searches for each key starting from where the search
+        /// for the key before it ended, so close keys cost a few steps each instead of
+        /// a descent from the root. A batch with more operations than the tree has
+        /// elements is instead merged with all of the tree's nodes, and the result is
+        /// rebuilt balanced at the end instead of rebalancing after every change.
+        /// Either way the nodes of erased elements are reused for inserted ones. Upserts
+        /// which the allocator has no room for are dropped. Only for unique keys.
+        ///
+        /// Example usage:
+        ///     std::vector<easy::map<int, int>::batch_op_type> ops;
+        ///     ops.push_back(easy::map<int, int>::batch_op_type::upsert(easy::make_pair(7, 49)));
+        ///     myMap.apply_batch(ops.begin(), ops.end());
+        ///
+        template <typename ForwardIterator>
+        void apply_batch(ForwardIterator first, ForwardIterator last);
+
         void clear();
         void reset_lose_memory(); // This is a unilateral reset to an initially empty state. No destructors are called, no deallocation occurs.
 
+        /// Moves every node to newly allocated memory, in key order, and links the new
+        /// nodes in place of the old ones. After hours of inserts and erases the nodes
+        /// of a long-lived tree are spread across the heap, and in-order iteration
+        /// misses the cache or the TLB on most elements. All the new nodes are
+        /// allocated before the old ones are freed, so the default allocator hands
+        /// out mostly adjacent blocks, at the cost of twice the node memory while it
+        /// runs. The values are relocated (see is_trivially_relocatable), not copied,
+        /// and the contents and shape of the tree don't change. Invalidates all
+        /// iterators, pointers and references to elements. Returns false if the
+        /// allocator failed, in which case the nodes not yet moved stay where they are.
+        bool compact();
+
+        /// Does the work of compact a bit at a time: moves up to nBudget nodes, starting
+        /// at position, and returns the position to carry on from, which is end() once
+        /// the pass is complete. Only iterators to the moved nodes are invalidated, so
+        /// the tree can be modified between steps as long as the returned iterator
+        /// stays valid. Stops early if the allocator fails. An allocator which reuses
+        /// freed blocks first, as the default one does, gives each step the blocks the
+        /// step before it freed, so the nodes only end up adjacent within a step; use
+        /// compact where the memory and the pause can be afforded.
+        ///
+        /// Example usage:
+        ///     itCompact = myMap.compact_step(itCompact, 256); // Once per tick, starting from begin().
+        ///
+        iterator compact_step(const_iterator position, size_type nBudget);
+
         iterator       find(const key_type& key);
         const_iterator find(const key_type& key) const;
 
@@ -561,28 +1010,222 @@ namespace easy
 
         iterator       upper_bound(const key_type& key);
         const_iterator upper_bound(const key_type& key) const;
+
+        /// Traversal functions
+        ///
+        /// These visit elements in order like an iterator loop does, but walk the tree
+        /// with an explicit stack instead of climbing parent pointers in RBTreeIncrement.
+        /// Every node is touched once, the right child of each stacked node is prefetched
+        /// before it is needed, and the visitor is a template parameter so it can be inlined.
+        /// The tree must not be modified from within the visitor.
+        ///
+        /// Example usage:
+        ///     int sum = 0;
+        ///     myMap.for_each([&](const easy::pair<int, int>& x) { sum += x.second; });
+        ///     myMap.for_each_range(10, 20, [&](const easy::pair<int, int>& x) { ... }); // Visits [10, 20).
+        ///     it = myMap.visit_until(10, [](const easy::pair<int, int>& x) { return x.second < 0; });
+        ///
+        template <typename Function>
+        void for_each(Function f);
+        template <typename Function>
+        void for_each(Function f) const;
+
+        /// Visits the elements whose keys are in the half-open range [lo, hi).
+        template <typename Function>
+        void for_each_range(const key_type& lo, const key_type& hi, Function f);
+        template <typename Function>
+        void for_each_range(const key_type& lo, const key_type& hi, Function f) const;
+
+        /// Visits elements starting at lower_bound(lo) until pred returns true, and returns an
+        /// iterator to the element for which it did. Returns end() if pred never returns true.
+        template <typename Predicate>
+        iterator       visit_until(const key_type& lo, Predicate pred);
+        template <typename Predicate>
+        const_iterator visit_until(const key_type& lo, Predicate pred) const;
+
+        /// Returns the shape of the tree and, if Compare is instrumented, how many
+        /// operations of each kind it has done, or if it is filtered, how its filter
+        /// answered. Walks the whole tree, so it is O(n).
+        ///
+        /// Example usage:
+        ///     easy::map<int, int, easy::instrumented_compare<easy::less<int> > > myMap;
+        ///     ...
+        ///     easy::rbtree_stats s = myMap.stats();
+        ///     printf("height %u, %u compares\n", (unsigned)s.height, (unsigned)s.compares);
+        ///
+        rbtree_stats stats() const;
+
+        /// Sets the operation counts of an instrumented Compare, or the filter counts
+        /// of a filtered one, back to zero.
+        void reset_counters();
+
     protected:
         void       DoFreeNode(node_type* pNode);
 
         node_type* DoCreateNode(const value_type& value);
         node_type* DoCreateNode(const node_type* pNodeSource, node_type* pNodeParent);
 
+        node_type* DoRelocateNode(node_type* pNode, void* pMemory);
+
         node_type* DoCopySubtree(const node_type* pNodeSource, node_type* pNodeDest);
         void       DoNukeSubtree(node_type* pNode);
 
         easy::pair<iterator, bool> DoInsertValue(true_type, const value_type& value);
         iterator DoInsertValue(false_type, const value_type& value);
         iterator DoInsertValueImpl(node_type* pNodeParent, bool bForceToLeft, const key_type& key, const value_type& value);
+        iterator DoInsertValueAt(node_type* pNodeParent, RBTreeSide side, const value_type& value);
 
         iterator DoInsertValueHint(true_type, const_iterator position, const value_type& value);
         iterator DoInsertValueHint(false_type, const_iterator position, const value_type& value);
 
-        node_type* DoGetKeyInsertionPositionUniqueKeys(bool& canInsert, const key_type& key);
+        node_type* DoGetKeyInsertionPositionUniqueKeys(bool& canInsert, RBTreeSide& side, const key_type& key);
         node_type* DoGetKeyInsertionPositionNonuniqueKeys(const key_type& key);
 
         node_type* DoGetKeyInsertionPositionUniqueKeysHint(const_iterator position, bool& bForceToLeft, const key_type& key);
         node_type* DoGetKeyInsertionPositionNonuniqueKeysHint(const_iterator position, bool& bForceToLeft, const key_type& key);
 
+        node_type* DoGetKeyInsertionPositionFinger(true_type, bool& bForceToLeft, const key_type& key);
+        node_type* DoGetKeyInsertionPositionFinger(false_type, bool& bForceToLeft, const key_type& key);
+
+        void       DoGetEqualRange(const key_type& key, node_type*& pLower, node_type*& pUpper);
+        size_type  DoCountKey(const key_type& key) const;
+
+        void       DoAppendNodes(rbtree_node_base* pNodeList, size_type n);
+
+        // Helpers for apply_batch. Nodes taken out of the tree for reuse have no value
+        // and are chained through mpNodeLeft.
+        node_type* DoLowerBoundFrom(node_type* pNode, const key_type& key);
+        void       DoLinkBefore(node_type* pPosition, node_type* pNodeNew);
+        node_type* DoTakeNode(node_type*& pNodeFree, const value_type& value);
+        node_type* DoReleaseNode(node_type* pNode, node_type*& pNodeFree);
+        const batch_op_type* DoTakeBatchOp(const batch_op_type* const*& ppOps, const batch_op_type* const* ppOpsEnd);
+        void       DoApplyBatchSearch(const batch_op_type* const* ppOps, const batch_op_type* const* ppOpsEnd, node_type*& pNodeFree);
+        void       DoApplyBatchRebuild(const batch_op_type* const* ppOps, const batch_op_type* const* ppOpsEnd, node_type*& pNodeFree);
+
+        void       DoCount(RBTreeCounter counter, size_t n) const
+        {
+            if (rbtree_instrumentation<Compare>::kEnabled)
+                rbtree_instrumentation<Compare>::Add(mCompare, counter, n);
+        }
+
+        int        DoOrder(const key_type& a, const key_type& b) const
+        {
+            return rbtree_three_way<Compare>::Order(mCompare, a, b);
+        }
+
+        // Keep a filtering Compare's filter in step with the values in nodes.
+        void       DoFilterAdd(const node_type* pNode)
+        {
+            if (rbtree_filter<Compare>::kEnabled)
+                rbtree_filter<Compare>::Add(mCompare, extract_key()(pNode->mValue));
+        }
+
+        void       DoFilterRemove(const node_type* pNode)
+        {
+            if (rbtree_filter<Compare>::kEnabled)
+                rbtree_filter<Compare>::Remove(mCompare, extract_key()(pNode->mValue));
+        }
+
+        void       DoFilterRegrow();
+
+        template <typename Visitor>
+        node_type* DoVisitInOrder(const key_type* pKeyLower, Visitor& visitor);
+
+        // Visitor adapters for DoVisitInOrder. A visitor returns true to stop the traversal.
+        template <typename Reference, typename Function>
+        struct visit_all
+        {
+            Function& mFunction;
+            visit_all(Function& function) : mFunction(function) {}
+            bool operator()(node_type* pNode) { mFunction(static_cast<Reference>(pNode->mValue)); return false; }
+        };
+
+        template <typename Reference, typename Function>
+        struct visit_range
+        {
+            Function&       mFunction;
+            const key_type& mKeyEnd;
+            const Compare&  mCompare;
+            visit_range(Function& function, const key_type& keyEnd, const Compare& compare) : mFunction(function), mKeyEnd(keyEnd), mCompare(compare) {}
+            bool operator()(node_type* pNode)
+            {
+                extract_key extractKey;
+                if (!mCompare(extractKey(pNode->mValue), mKeyEnd)) // If pNode is >= the end of the range...
+                    return true;
+                mFunction(static_cast<Reference>(pNode->mValue));
+                return false;
+            }
+        };
+
+        template <typename Reference, typename Predicate>
+        struct visit_until_true
+        {
+            Predicate& mPredicate;
+            visit_until_true(Predicate& predicate) : mPredicate(predicate) {}
+            bool operator()(node_type* pNode) { return mPredicate(static_cast<Reference>(pNode->mValue)) ? true : false; }
+        };
+
+        // Merges a sorted batch into the visited nodes, chaining the nodes that stay or
+        // are new into a sorted list through mpNodeRight. A visited node's mpNodeRight
+        // is only written once the walk has gone past it.
+        struct visit_merge
+        {
+            this_type&                  mTree;
+            const batch_op_type* const* mppOps;
+            const batch_op_type* const* mppOpsEnd;
+            node_type*&                 mpNodeFree;
+            rbtree_node_base*           mpNodeList;
+            rbtree_node_base**          mppNodeTail;
+            size_type                   mnCount;
+
+            visit_merge(this_type& tree, const batch_op_type* const* ppOps, const batch_op_type* const* ppOpsEnd, node_type*& pNodeFree)
+                : mTree(tree), mppOps(ppOps), mppOpsEnd(ppOpsEnd), mpNodeFree(pNodeFree), mpNodeList(NULL), mppNodeTail(&mpNodeList), mnCount(0) {}
+
+            void Append(rbtree_node_base* pNode)
+            {
+                *mppNodeTail = pNode;
+                mppNodeTail = &pNode->mpNodeRight;
+                ++mnCount;
+            }
+
+            void Insert(const batch_op_type* pOp)
+            {
+                if (!pOp->mbErase)
+                {
+                    if (node_type* const pNodeNew = mTree.DoTakeNode(mpNodeFree, pOp->mValue))
+                        Append(pNodeNew);
+                }
+            }
+
+            bool operator()(node_type* pNode)
+            {
+                extract_key extractKey;
+
+                while ((mppOps != mppOpsEnd) && mTree.mCompare(extractKey((*mppOps)->mValue), extractKey(pNode->mValue)))
+                    Insert(mTree.DoTakeBatchOp(mppOps, mppOpsEnd));
+
+                if ((mppOps != mppOpsEnd) && !mTree.mCompare(extractKey(pNode->mValue), extractKey((*mppOps)->mValue)))
+                {
+                    const batch_op_type* const pOp = mTree.DoTakeBatchOp(mppOps, mppOpsEnd);
+
+                    if (pOp->mbErase)
+                    {
+                        mTree.DoFilterRemove(pNode);
+                        pNode->mValue.~value_type();
+                        pNode->mpNodeLeft = mpNodeFree; // The walk is done with the left subtree.
+                        mpNodeFree = pNode;
+                        return false;
+                    }
+
+                    pNode->mValue = pOp->mValue;
+                }
+
+                Append(pNode);
+                return false;
+            }
+        };
+        rbtree_node_base* DoBuildSubtree(rbtree_node_base*& pNodeList, size_type n, size_type nDepth, size_type nRedDepth);
+
     private:
         // rbtree_node_base functions
         //
@@ -681,6 +1324,10 @@ namespace easy
             pNodeTemp->mpNodeLeft = pNode;
             pNode->mpNodeParent = pNodeTemp;
 
+            RBTreeAugmentUpdate(pNode);
+            RBTreeAugmentUpdate(pNodeTemp);
+            DoCount(kRBTreeCounterRotate, 1);
+
             return pNodeRoot;
         }
 
@@ -710,6 +1357,10 @@ namespace easy
             pNodeTemp->mpNodeRight = pNode;
             pNode->mpNodeParent = pNodeTemp;
 
+            RBTreeAugmentUpdate(pNode);
+            RBTreeAugmentUpdate(pNodeTemp);
+            DoCount(kRBTreeCounterRotate, 1);
+
             return pNodeRoot;
         }
 
@@ -725,8 +1376,6 @@ namespace easy
             rbtree_node_base* pNodeAnchor,
             RBTreeSide insertionSide)
         {
-            rbtree_node_base*& pNodeRootRef = pNodeAnchor->mpNodeParent;
-
             // Initialize fields in new node to insert.
             pNode->mpNodeParent = pNodeParent;
             pNode->mpNodeRight = NULL;
@@ -752,7 +1401,22 @@ namespace easy
                     pNodeAnchor->mpNodeRight = pNode; // Maintain rightmost pointing to max node
             }
 
-            // Rebalance the tree.
+            RBTreeAugmentPropagate(pNode, pNodeAnchor);
+            RBTreeRebalanceInsert(pNode, pNodeAnchor);
+
+        } // RBTreeInsert
+
+
+
+        /// RBTreeRebalanceInsert
+        /// Restores the red-black properties after pNode has been linked into the
+        /// tree as a red node. pNode's subtrees must already be valid and of equal
+        /// black height; pNode need not be a leaf.
+        ///
+        EASTL_API void RBTreeRebalanceInsert(rbtree_node_base* pNode, rbtree_node_base* pNodeAnchor)
+        {
+            rbtree_node_base*& pNodeRootRef = pNodeAnchor->mpNodeParent;
+
             while ((pNode != pNodeRootRef) && (pNode->mpNodeParent->mColor == kRBTreeColorRed))
             {
                 EA_ANALYSIS_ASSUME(pNode->mpNodeParent != NULL);
@@ -767,6 +1431,7 @@ namespace easy
                         pNode->mpNodeParent->mColor = kRBTreeColorBlack;
                         pNodeTemp->mColor = kRBTreeColorBlack;
                         pNodeParentParent->mColor = kRBTreeColorRed;
+                        DoCount(kRBTreeCounterRecolor, 3);
                         pNode = pNodeParentParent;
                     } else
                     {
@@ -779,6 +1444,7 @@ namespace easy
                         EA_ANALYSIS_ASSUME(pNode->mpNodeParent != NULL);
                         pNode->mpNodeParent->mColor = kRBTreeColorBlack;
                         pNodeParentParent->mColor = kRBTreeColorRed;
+                        DoCount(kRBTreeCounterRecolor, 2);
                         pNodeRootRef = RBTreeRotateRight(pNodeParentParent, pNodeRootRef);
                     }
                 } else
@@ -790,6 +1456,7 @@ namespace easy
                         pNode->mpNodeParent->mColor = kRBTreeColorBlack;
                         pNodeTemp->mColor = kRBTreeColorBlack;
                         pNodeParentParent->mColor = kRBTreeColorRed;
+                        DoCount(kRBTreeCounterRecolor, 3);
                         pNode = pNodeParentParent;
                     } else
                     {
@@ -803,15 +1470,17 @@ namespace easy
 
                         pNode->mpNodeParent->mColor = kRBTreeColorBlack;
                         pNodeParentParent->mColor = kRBTreeColorRed;
+                        DoCount(kRBTreeCounterRecolor, 2);
                         pNodeRootRef = RBTreeRotateLeft(pNodeParentParent, pNodeRootRef);
                     }
                 }
             }
 
             EA_ANALYSIS_ASSUME(pNodeRootRef != NULL);
+            DoCount(kRBTreeCounterRecolor, (pNodeRootRef->mColor == kRBTreeColorRed) ? 1 : 0);
             pNodeRootRef->mColor = kRBTreeColorBlack;
 
-        } // RBTreeInsert
+        } // RBTreeRebalanceInsert
 
 
 
@@ -918,6 +1587,10 @@ namespace easy
                 easy::swap(pNodeSuccessor->mColor, pNode->mColor);
             }
 
+            // Every node whose subtree lost pNode (or had pNodeSuccessor moved out of it) is 
+            // on the path from pNodeChildParent to the root. Rotations below keep it that way.
+            RBTreeAugmentPropagate(pNodeChildParent, pNodeAnchor);
+
             // Here we do tree balancing as per the conventional red-black tree algorithm.
             if (pNode->mColor == kRBTreeColorBlack)
             {
@@ -931,6 +1604,7 @@ namespace easy
                         {
                             pNodeTemp->mColor = kRBTreeColorBlack;
                             pNodeChildParent->mColor = kRBTreeColorRed;
+                            DoCount(kRBTreeCounterRecolor, 2);
                             pNodeRootRef = RBTreeRotateLeft(pNodeChildParent, pNodeRootRef);
                             pNodeTemp = pNodeChildParent->mpNodeRight;
                         }
@@ -939,6 +1613,7 @@ namespace easy
                             ((pNodeTemp->mpNodeRight == NULL) || (pNodeTemp->mpNodeRight->mColor == kRBTreeColorBlack)))
                         {
                             pNodeTemp->mColor = kRBTreeColorRed;
+                            DoCount(kRBTreeCounterRecolor, 1);
                             pNodeChild = pNodeChildParent;
                             pNodeChildParent = pNodeChildParent->mpNodeParent;
                         } else
@@ -947,12 +1622,14 @@ namespace easy
                             {
                                 pNodeTemp->mpNodeLeft->mColor = kRBTreeColorBlack;
                                 pNodeTemp->mColor = kRBTreeColorRed;
+                                DoCount(kRBTreeCounterRecolor, 2);
                                 pNodeRootRef = RBTreeRotateRight(pNodeTemp, pNodeRootRef);
                                 pNodeTemp = pNodeChildParent->mpNodeRight;
                             }
 
                             pNodeTemp->mColor = pNodeChildParent->mColor;
                             pNodeChildParent->mColor = kRBTreeColorBlack;
+                            DoCount(kRBTreeCounterRecolor, pNodeTemp->mpNodeRight ? 3 : 2);
 
                             if (pNodeTemp->mpNodeRight)
                                 pNodeTemp->mpNodeRight->mColor = kRBTreeColorBlack;
@@ -969,6 +1646,7 @@ namespace easy
                         {
                             pNodeTemp->mColor = kRBTreeColorBlack;
                             pNodeChildParent->mColor = kRBTreeColorRed;
+                            DoCount(kRBTreeCounterRecolor, 2);
 
                             pNodeRootRef = RBTreeRotateRight(pNodeChildParent, pNodeRootRef);
                             pNodeTemp = pNodeChildParent->mpNodeLeft;
@@ -978,6 +1656,7 @@ namespace easy
                             ((pNodeTemp->mpNodeLeft == NULL) || (pNodeTemp->mpNodeLeft->mColor == kRBTreeColorBlack)))
                         {
                             pNodeTemp->mColor = kRBTreeColorRed;
+                            DoCount(kRBTreeCounterRecolor, 1);
                             pNodeChild = pNodeChildParent;
                             pNodeChildParent = pNodeChildParent->mpNodeParent;
                         } else
@@ -986,6 +1665,7 @@ namespace easy
                             {
                                 pNodeTemp->mpNodeRight->mColor = kRBTreeColorBlack;
                                 pNodeTemp->mColor = kRBTreeColorRed;
+                                DoCount(kRBTreeCounterRecolor, 2);
 
                                 pNodeRootRef = RBTreeRotateLeft(pNodeTemp, pNodeRootRef);
                                 pNodeTemp = pNodeChildParent->mpNodeLeft;
@@ -993,6 +1673,7 @@ namespace easy
 
                             pNodeTemp->mColor = pNodeChildParent->mColor;
                             pNodeChildParent->mColor = kRBTreeColorBlack;
+                            DoCount(kRBTreeCounterRecolor, pNodeTemp->mpNodeLeft ? 3 : 2);
 
                             if (pNodeTemp->mpNodeLeft)
                                 pNodeTemp->mpNodeLeft->mColor = kRBTreeColorBlack;
@@ -1004,29 +1685,89 @@ namespace easy
                 }
 
                 if (pNodeChild)
+                {
+                    DoCount(kRBTreeCounterRecolor, (pNodeChild->mColor == kRBTreeColorRed) ? 1 : 0);
                     pNodeChild->mColor = kRBTreeColorBlack;
+                }
             }
 
         } // RBTreeErase
 
-    }; // rbtree
 
 
-    // The rest of the functions are non-trivial and are found in 
-    // the corresponding .cpp file to this file.
+        /// RBTreeAugmentUpdate
+        /// Recomputes the rbtree_augment summary of a single node.
+        ///
+        static void RBTreeAugmentUpdate(rbtree_node_base* pNode)
+        {
+            RBTreeSubtreeSizeUpdate(pNode, has_unique_keys_type());
 
+            if (rbtree_augment<Value>::kEnabled)
+                rbtree_augment<Value>::Update(pNode);
+        }
 
 
-    ///////////////////////////////////////////////////////////////////////
-    // rbtree_iterator functions
-    ///////////////////////////////////////////////////////////////////////
+        /// RBTreeAugmentPropagate
+        /// Recomputes the rbtree_augment summary of pNode and all of its ancestors.
+        ///
+        static void RBTreeAugmentPropagate(rbtree_node_base* pNode, rbtree_node_base* pNodeAnchor)
+        {
+            if (rbtree_augment<Value>::kEnabled || !bUniqueKeys)
+            {
+                for (; pNode != pNodeAnchor; pNode = pNode->mpNodeParent)
+                    RBTreeAugmentUpdate(pNode);
+            }
+        }
 
-    template <typename T, typename Pointer, typename Reference>
-    rbtree_iterator<T, Pointer, Reference>::rbtree_iterator()
-        : mpNode(NULL) { }
 
+        /// RBTreeSubtreeSize
+        /// The number of nodes in the subtree at pNode, for trees with non-unique keys.
+        ///
+        static size_type RBTreeSubtreeSize(const rbtree_node_base* pNode)
+        {
+            return pNode ? (size_type)static_cast<const node_type*>(pNode)->mnSubtreeSize : 0;
+        }
 
-    template <typename T, typename Pointer, typename Reference>
+
+        /// RBTreeSubtreeSizeUpdate
+        /// Recomputes the subtree size of a single node. Nodes of trees with unique keys have none.
+        ///
+        static void RBTreeSubtreeSizeUpdate(rbtree_node_base* /*pNode*/, true_type) {}
+
+        static void RBTreeSubtreeSizeUpdate(rbtree_node_base* pNode, false_type)
+        {
+            static_cast<node_type*>(pNode)->mnSubtreeSize = 1 + RBTreeSubtreeSize(pNode->mpNodeLeft) + RBTreeSubtreeSize(pNode->mpNodeRight);
+        }
+
+
+        /// RBTreeSubtreeSizeCopy
+        /// Gives pNode the subtree size of pNodeSource, which has the same shape below it.
+        ///
+        static void RBTreeSubtreeSizeCopy(node_type* /*pNode*/, const node_type* /*pNodeSource*/, true_type) {}
+
+        static void RBTreeSubtreeSizeCopy(node_type* pNode, const node_type* pNodeSource, false_type)
+        {
+            pNode->mnSubtreeSize = pNodeSource->mnSubtreeSize;
+        }
+
+    }; // rbtree
+
+
+    // The rest of the functions are non-trivial and are found in 
+    // the corresponding .cpp file to this file.
+
+
+
+    ///////////////////////////////////////////////////////////////////////
+    // rbtree_iterator functions
+    ///////////////////////////////////////////////////////////////////////
+
+    template <typename T, typename Pointer, typename Reference>
+    rbtree_iterator<T, Pointer, Reference>::rbtree_iterator()
+        : mpNode(NULL) { }
+
+
+    template <typename T, typename Pointer, typename Reference>
     rbtree_iterator<T, Pointer, Reference>::rbtree_iterator(const node_type* pNode)
         : mpNode(static_cast<node_type*>(const_cast<node_type*>(pNode))) { }
 
@@ -1036,6 +1777,15 @@ namespace easy
         : mpNode(x.mpNode) { }
 
 
+    template <typename T, typename Pointer, typename Reference>
+    inline rbtree_iterator<T, Pointer, Reference>&
+        rbtree_iterator<T, Pointer, Reference>::operator=(const iterator& x)
+    {
+        mpNode = x.mpNode;
+        return *this;
+    }
+
+
     template <typename T, typename Pointer, typename Reference>
     typename rbtree_iterator<T, Pointer, Reference>::reference
         rbtree_iterator<T, Pointer, Reference>::operator*() const
@@ -1056,6 +1806,9 @@ namespace easy
     typename rbtree_iterator<T, Pointer, Reference>::this_type&
         rbtree_iterator<T, Pointer, Reference>::operator++()
     {
+#if EASY_RBTREE_COUNT_INCREMENTS
+        rbtree_increment_counter().fetch_add(1, std::memory_order_relaxed);
+#endif
         mpNode = static_cast<node_type*>(RBTreeIncrement(mpNode));
         return *this;
     }
@@ -1066,6 +1819,9 @@ namespace easy
         rbtree_iterator<T, Pointer, Reference>::operator++(int)
     {
         this_type temp(*this);
+#if EASY_RBTREE_COUNT_INCREMENTS
+        rbtree_increment_counter().fetch_add(1, std::memory_order_relaxed);
+#endif
         mpNode = static_cast<node_type*>(RBTreeIncrement(mpNode));
         return temp;
     }
@@ -1075,6 +1831,9 @@ namespace easy
     typename rbtree_iterator<T, Pointer, Reference>::this_type&
         rbtree_iterator<T, Pointer, Reference>::operator--()
     {
+#if EASY_RBTREE_COUNT_INCREMENTS
+        rbtree_increment_counter().fetch_add(1, std::memory_order_relaxed);
+#endif
         mpNode = static_cast<node_type*>(RBTreeDecrement(mpNode));
         return *this;
     }
@@ -1085,6 +1844,9 @@ namespace easy
         rbtree_iterator<T, Pointer, Reference>::operator--(int)
     {
         this_type temp(*this);
+#if EASY_RBTREE_COUNT_INCREMENTS
+        rbtree_increment_counter().fetch_add(1, std::memory_order_relaxed);
+#endif
         mpNode = static_cast<node_type*>(RBTreeDecrement(mpNode));
         return temp;
     }
@@ -1125,29 +1887,32 @@ namespace easy
     // rbtree functions
     ///////////////////////////////////////////////////////////////////////
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    inline rbtree<K, V, C, E, bM, bU>::rbtree()
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline rbtree<K, V, C, E, bM, bU, A>::rbtree()
         : mAnchor(),
-        mnSize(0)
+        mnSize(0),
+        mpFinger(NULL)
     {
         reset_lose_memory();
     }
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    inline rbtree<K, V, C, E, bM, bU>::rbtree(const C& compare)
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline rbtree<K, V, C, E, bM, bU, A>::rbtree(const C& compare)
         : base_type(compare),
         mAnchor(),
-        mnSize(0)
+        mnSize(0),
+        mpFinger(NULL)
     {
         reset_lose_memory();
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    inline rbtree<K, V, C, E, bM, bU>::rbtree(const this_type& x)
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline rbtree<K, V, C, E, bM, bU, A>::rbtree(const this_type& x)
         : base_type(x.mCompare),
         mAnchor(),
-        mnSize(0)
+        mnSize(0),
+        mpFinger(NULL)
     {
         reset_lose_memory();
 
@@ -1157,16 +1922,18 @@ namespace easy
             mAnchor.mpNodeRight = RBTreeGetMaxChild(mAnchor.mpNodeParent);
             mAnchor.mpNodeLeft = RBTreeGetMinChild(mAnchor.mpNodeParent);
             mnSize = x.mnSize;
+            DoFilterRegrow();
         }
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
     template <typename InputIterator>
-    inline rbtree<K, V, C, E, bM, bU>::rbtree(InputIterator first, InputIterator last, const C& compare)
+    inline rbtree<K, V, C, E, bM, bU, A>::rbtree(InputIterator first, InputIterator last, const C& compare)
         : base_type(compare),
         mAnchor(),
-        mnSize(0)
+        mnSize(0),
+        mpFinger(NULL)
     {
         reset_lose_memory();
 
@@ -1175,8 +1942,8 @@ namespace easy
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    inline rbtree<K, V, C, E, bM, bU>::~rbtree()
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline rbtree<K, V, C, E, bM, bU, A>::~rbtree()
     {
         // Erase the entire tree. DoNukeSubtree is not a 
         // conventional erase function, as it does no rebalancing.
@@ -1184,71 +1951,71 @@ namespace easy
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    inline typename rbtree<K, V, C, E, bM, bU>::size_type
-        rbtree<K, V, C, E, bM, bU>::size() const 
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline typename rbtree<K, V, C, E, bM, bU, A>::size_type
+        rbtree<K, V, C, E, bM, bU, A>::size() const 
     {
         return mnSize;
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    inline bool rbtree<K, V, C, E, bM, bU>::empty() const 
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline bool rbtree<K, V, C, E, bM, bU, A>::empty() const 
     {
         return (mnSize == 0);
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    inline typename rbtree<K, V, C, E, bM, bU>::iterator
-        rbtree<K, V, C, E, bM, bU>::begin() 
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline typename rbtree<K, V, C, E, bM, bU, A>::iterator
+        rbtree<K, V, C, E, bM, bU, A>::begin() 
     {
         return iterator(static_cast<node_type*>(mAnchor.mpNodeLeft));
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    inline typename rbtree<K, V, C, E, bM, bU>::const_iterator
-        rbtree<K, V, C, E, bM, bU>::begin() const 
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline typename rbtree<K, V, C, E, bM, bU, A>::const_iterator
+        rbtree<K, V, C, E, bM, bU, A>::begin() const 
     {
         return const_iterator(static_cast<node_type*>(const_cast<rbtree_node_base*>(mAnchor.mpNodeLeft)));
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    inline typename rbtree<K, V, C, E, bM, bU>::const_iterator
-        rbtree<K, V, C, E, bM, bU>::cbegin() const 
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline typename rbtree<K, V, C, E, bM, bU, A>::const_iterator
+        rbtree<K, V, C, E, bM, bU, A>::cbegin() const 
     {
         return const_iterator(static_cast<node_type*>(const_cast<rbtree_node_base*>(mAnchor.mpNodeLeft)));
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    inline typename rbtree<K, V, C, E, bM, bU>::iterator
-        rbtree<K, V, C, E, bM, bU>::end() 
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline typename rbtree<K, V, C, E, bM, bU, A>::iterator
+        rbtree<K, V, C, E, bM, bU, A>::end() 
     {
         return iterator(static_cast<node_type*>(&mAnchor));
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    inline typename rbtree<K, V, C, E, bM, bU>::const_iterator
-        rbtree<K, V, C, E, bM, bU>::end() const 
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline typename rbtree<K, V, C, E, bM, bU, A>::const_iterator
+        rbtree<K, V, C, E, bM, bU, A>::end() const 
     {
         return const_iterator(static_cast<node_type*>(const_cast<rbtree_node_base*>(&mAnchor)));
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    inline typename rbtree<K, V, C, E, bM, bU>::const_iterator
-        rbtree<K, V, C, E, bM, bU>::cend() const 
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline typename rbtree<K, V, C, E, bM, bU, A>::const_iterator
+        rbtree<K, V, C, E, bM, bU, A>::cend() const 
     {
         return const_iterator(static_cast<node_type*>(const_cast<rbtree_node_base*>(&mAnchor)));
     }
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    inline typename rbtree<K, V, C, E, bM, bU>::this_type&
-        rbtree<K, V, C, E, bM, bU>::operator=(const this_type& x)
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline typename rbtree<K, V, C, E, bM, bU, A>::this_type&
+        rbtree<K, V, C, E, bM, bU, A>::operator=(const this_type& x)
     {
         if (this != &x)
         {
@@ -1262,14 +2029,15 @@ namespace easy
                 mAnchor.mpNodeRight = RBTreeGetMaxChild(mAnchor.mpNodeParent);
                 mAnchor.mpNodeLeft = RBTreeGetMinChild(mAnchor.mpNodeParent);
                 mnSize = x.mnSize;
+                DoFilterRegrow();
             }
         }
         return *this;
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    void rbtree<K, V, C, E, bM, bU>::swap(this_type& x)
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    void rbtree<K, V, C, E, bM, bU, A>::swap(this_type& x)
     {
         const this_type temp(*this); // Can't call easy::swap because that would
         *this = x;                   // itself call this member swap function.
@@ -1277,30 +2045,57 @@ namespace easy
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    inline typename rbtree<K, V, C, E, bM, bU>::insert_return_type // map/set::insert return a pair, multimap/multiset::iterator return an iterator.
-        rbtree<K, V, C, E, bM, bU>::insert(const value_type& value)
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline typename rbtree<K, V, C, E, bM, bU, A>::insert_return_type // map/set::insert return a pair, multimap/multiset::iterator return an iterator.
+        rbtree<K, V, C, E, bM, bU, A>::insert(const value_type& value)
     {
         return DoInsertValue(has_unique_keys_type(), value);
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    typename rbtree<K, V, C, E, bM, bU>::iterator
-        rbtree<K, V, C, E, bM, bU>::insert(const_iterator position, const value_type& value)
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    typename rbtree<K, V, C, E, bM, bU, A>::iterator
+        rbtree<K, V, C, E, bM, bU, A>::insert(const_iterator position, const value_type& value)
     {
         return DoInsertValueHint(has_unique_keys_type(), position, value);
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    typename rbtree<K, V, C, E, bM, bU>::node_type*
-        rbtree<K, V, C, E, bM, bU>::DoGetKeyInsertionPositionUniqueKeys(bool& canInsert, const key_type& key)
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    typename rbtree<K, V, C, E, bM, bU, A>::node_type*
+        rbtree<K, V, C, E, bM, bU, A>::DoGetKeyInsertionPositionUniqueKeys(bool& canInsert, RBTreeSide& side, const key_type& key)
     {
         // This code is essentially a slightly modified copy of the the rbtree::insert 
         // function whereby this version takes a key and not a full value_type.
+        // side is set to the side of the returned parent that the new node goes on.
         extract_key extractKey;
 
+        if (rbtree_three_way<C>::kEnabled) // An equal key ends the descent, so there is no check against the predecessor.
+        {
+            node_type* pCurrent = (node_type*)mAnchor.mpNodeParent;
+            node_type* pParent = (node_type*)&mAnchor;
+
+            side = kRBTreeSideLeft;
+
+            while (EASY_LIKELY(pCurrent))
+            {
+                const int order = DoOrder(key, extractKey(pCurrent->mValue));
+
+                if (order == 0)
+                {
+                    canInsert = false;
+                    return pCurrent;
+                }
+
+                pParent = pCurrent;
+                side = (order < 0) ? kRBTreeSideLeft : kRBTreeSideRight;
+                pCurrent = (node_type*)((order < 0) ? pCurrent->mpNodeLeft : pCurrent->mpNodeRight);
+            }
+
+            canInsert = true;
+            return pParent;
+        }
+
         node_type* pCurrent = (node_type*)mAnchor.mpNodeParent; // Start with the root node.
         node_type* pLowerBound = (node_type*)&mAnchor;             // Set it to the container end for now.
         node_type* pParent;                                        // This will be where we insert the new node.
@@ -1335,6 +2130,7 @@ namespace easy
             } else
             {
                 canInsert = true;
+                side = kRBTreeSideLeft;
                 return pLowerBound;
             }
         }
@@ -1344,6 +2140,7 @@ namespace easy
         {
             EASY_VALIDATE_COMPARE(!mCompare(key, extractKey(pLowerBound->mValue))); // Validate that the compare function is sane.
             canInsert = true;
+            side = ((pParent == &mAnchor) || bValueLessThanNode) ? kRBTreeSideLeft : kRBTreeSideRight;
             return pParent;
         }
 
@@ -1353,9 +2150,9 @@ namespace easy
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    typename rbtree<K, V, C, E, bM, bU>::node_type*
-        rbtree<K, V, C, E, bM, bU>::DoGetKeyInsertionPositionNonuniqueKeys(const key_type& key)
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    typename rbtree<K, V, C, E, bM, bU, A>::node_type*
+        rbtree<K, V, C, E, bM, bU, A>::DoGetKeyInsertionPositionNonuniqueKeys(const key_type& key)
     {
         // This is the pathway for insertion of non-unique keys (multimap and multiset, but not map and set).
         node_type* pCurrent = (node_type*)mAnchor.mpNodeParent; // Start with the root node.
@@ -1378,40 +2175,56 @@ namespace easy
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    easy::pair<typename rbtree<K, V, C, E, bM, bU>::iterator, bool>
-        rbtree<K, V, C, E, bM, bU>::DoInsertValue(true_type, const value_type& value) // true_type means keys are unique.
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    easy::pair<typename rbtree<K, V, C, E, bM, bU, A>::iterator, bool>
+        rbtree<K, V, C, E, bM, bU, A>::DoInsertValue(true_type, const value_type& value) // true_type means keys are unique.
     {
         extract_key extractKey;
         key_type    key(extractKey(value));
         bool        canInsert;
-        node_type*  pPosition = DoGetKeyInsertionPositionUniqueKeys(canInsert, extractKey(value));
+        bool        bForceToLeft;
+        RBTreeSide  side;
+        node_type*  pPosition = DoGetKeyInsertionPositionFinger(has_unique_keys_type(), bForceToLeft, key);
+
+        if (pPosition) // If the value goes at the end or right after the previous insertion...
+        {
+            const iterator itResult(DoInsertValueImpl(pPosition, bForceToLeft, key, value));
+            return pair<iterator, bool>(itResult, itResult.mpNode != &mAnchor); // It's only end() if the allocator is out of capacity.
+        }
+
+        pPosition = DoGetKeyInsertionPositionUniqueKeys(canInsert, side, key);
 
         if (canInsert)
         {
-            const iterator itResult(DoInsertValueImpl(pPosition, false, key, value));
-            return pair<iterator, bool>(itResult, true);
+            const iterator itResult(DoInsertValueAt(pPosition, side, value));
+            return pair<iterator, bool>(itResult, itResult.mpNode != &mAnchor);
         }
 
         return pair<iterator, bool>(iterator(pPosition), false);
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    typename rbtree<K, V, C, E, bM, bU>::iterator
-        rbtree<K, V, C, E, bM, bU>::DoInsertValue(false_type, const value_type& value) // false_type means keys are not unique.
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    typename rbtree<K, V, C, E, bM, bU, A>::iterator
+        rbtree<K, V, C, E, bM, bU, A>::DoInsertValue(false_type, const value_type& value) // false_type means keys are not unique.
     {
         extract_key extractKey;
         key_type    key(extractKey(value));
-        node_type*  pPosition = DoGetKeyInsertionPositionNonuniqueKeys(key);
+        bool        bForceToLeft;
+        node_type*  pPosition = DoGetKeyInsertionPositionFinger(has_unique_keys_type(), bForceToLeft, key);
+
+        if (pPosition) // If the value goes at the end or right after the previous insertion...
+            return DoInsertValueImpl(pPosition, bForceToLeft, key, value);
+
+        pPosition = DoGetKeyInsertionPositionNonuniqueKeys(key);
 
         return DoInsertValueImpl(pPosition, false, key, value);
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    typename rbtree<K, V, C, E, bM, bU>::iterator
-        rbtree<K, V, C, E, bM, bU>::DoInsertValueImpl(node_type* pNodeParent, bool bForceToLeft, const key_type& key, const value_type& value)
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    typename rbtree<K, V, C, E, bM, bU, A>::iterator
+        rbtree<K, V, C, E, bM, bU, A>::DoInsertValueImpl(node_type* pNodeParent, bool bForceToLeft, const key_type& key, const value_type& value)
     {
         RBTreeSide  side;
         extract_key extractKey;
@@ -1424,17 +2237,31 @@ namespace easy
         else
             side = kRBTreeSideRight;
 
+        return DoInsertValueAt(pNodeParent, side, value);
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    typename rbtree<K, V, C, E, bM, bU, A>::iterator
+        rbtree<K, V, C, E, bM, bU, A>::DoInsertValueAt(node_type* pNodeParent, RBTreeSide side, const value_type& value)
+    {
         node_type* const pNodeNew = DoCreateNode(value); // Note that pNodeNew->mpLeft, mpRight, mpParent, will be uninitialized.
+
+        if (!pNodeNew)
+            return iterator((node_type*)&mAnchor);
+
         RBTreeInsert(pNodeNew, pNodeParent, &mAnchor, side);
         mnSize++;
+        mpFinger = pNodeNew;
+        DoFilterRegrow();
 
         return iterator(pNodeNew);
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    typename rbtree<K, V, C, E, bM, bU>::node_type*
-        rbtree<K, V, C, E, bM, bU>::DoGetKeyInsertionPositionUniqueKeysHint(const_iterator position, bool& bForceToLeft, const key_type& key)
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    typename rbtree<K, V, C, E, bM, bU, A>::node_type*
+        rbtree<K, V, C, E, bM, bU, A>::DoGetKeyInsertionPositionUniqueKeysHint(const_iterator position, bool& bForceToLeft, const key_type& key)
     {
         extract_key extractKey;
 
@@ -1461,11 +2288,11 @@ namespace easy
                     if (position.mpNode->mpNodeRight)
                     {
                         bForceToLeft = true; // Specifically insert in front of (to the left of) itNext (and thus after 'position').
-                        return itNext.mpNode;
+                        return (node_type*)itNext.mpNode;
                     }
 
                     bForceToLeft = false;
-                    return position.mpNode;
+                    return (node_type*)position.mpNode;
                 }
             }
 
@@ -1485,9 +2312,9 @@ namespace easy
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    typename rbtree<K, V, C, E, bM, bU>::node_type*
-        rbtree<K, V, C, E, bM, bU>::DoGetKeyInsertionPositionNonuniqueKeysHint(const_iterator position, bool& bForceToLeft, const key_type& key)
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    typename rbtree<K, V, C, E, bM, bU, A>::node_type*
+        rbtree<K, V, C, E, bM, bU, A>::DoGetKeyInsertionPositionNonuniqueKeysHint(const_iterator position, bool& bForceToLeft, const key_type& key)
     {
         extract_key extractKey;
 
@@ -1505,11 +2332,11 @@ namespace easy
                 if (position.mpNode->mpNodeRight) // If there are any nodes to the right... [this expression will always be true as long as we aren't at the end()]
                 {
                     bForceToLeft = true; // Specifically insert in front of (to the left of) itNext (and thus after 'position').
-                    return itNext.mpNode;
+                    return (node_type*)itNext.mpNode;
                 }
 
                 bForceToLeft = false;
-                return position.mpNode;
+                return (node_type*)position.mpNode;
             }
 
             bForceToLeft = false;
@@ -1529,9 +2356,200 @@ namespace easy
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    typename rbtree<K, V, C, E, bM, bU>::iterator
-        rbtree<K, V, C, E, bM, bU>::DoInsertValueHint(true_type, const_iterator position, const value_type& value) // true_type means keys are unique.
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    typename rbtree<K, V, C, E, bM, bU, A>::node_type*
+        rbtree<K, V, C, E, bM, bU, A>::DoGetKeyInsertionPositionFinger(true_type, bool& bForceToLeft, const key_type& key)
+    {
+        // Appends are the most common ordered insertion pattern, so check the end first
+        // (one comparison). Then try right after the previous insertion, which handles
+        // ascending runs that land in the middle of the tree (two comparisons).
+        node_type* pPosition = DoGetKeyInsertionPositionUniqueKeysHint(end(), bForceToLeft, key);
+
+        if (!pPosition && mpFinger && (mpFinger != mAnchor.mpNodeRight))
+            pPosition = DoGetKeyInsertionPositionUniqueKeysHint(const_iterator((node_type*)mpFinger), bForceToLeft, key);
+
+        return pPosition; // NULL means the caller needs to do a regular descent from the root.
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    typename rbtree<K, V, C, E, bM, bU, A>::node_type*
+        rbtree<K, V, C, E, bM, bU, A>::DoGetKeyInsertionPositionFinger(false_type, bool& bForceToLeft, const key_type& key)
+    {
+        // See the unique keys version above for comments. An unhinted insert goes after
+        // all equal keys, so the end check accepts value >= *last, but the finger is only
+        // used if value >= *finger and value < *next. The user hint version accepts
+        // value <= *next, which could put the value in front of keys equal to it.
+        node_type* pPosition = DoGetKeyInsertionPositionNonuniqueKeysHint(end(), bForceToLeft, key);
+
+        if (!pPosition && mpFinger && (mpFinger != mAnchor.mpNodeRight))
+        {
+            extract_key extractKey;
+            node_type*  pFinger = (node_type*)mpFinger;
+            iterator    itNext(pFinger);
+            ++itNext;
+
+            if (!mCompare(key, extractKey(pFinger->mValue)) &&     // If value >= *finger &&
+                mCompare(key, extractKey(itNext.mpNode->mValue)))  // if value < *itNext...
+            {
+                if (pFinger->mpNodeRight)
+                {
+                    bForceToLeft = true; // Insert in front of itNext, and thus after the finger.
+                    return (node_type*)itNext.mpNode;
+                }
+
+                bForceToLeft = false;
+                return pFinger;
+            }
+        }
+
+        return pPosition;
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    rbtree_node_base* rbtree<K, V, C, E, bM, bU, A>::DoBuildSubtree(rbtree_node_base*& pNodeList, size_type n, size_type nDepth, size_type nRedDepth)
+    {
+        // Builds a perfectly balanced subtree out of the first n nodes of pNodeList (chained 
+        // through mpNodeRight) and advances pNodeList past them. Every level is full except 
+        // possibly the deepest one, whose nodes are colored red so that all paths have the
+        // same black height.
+        if (n == 0)
+            return NULL;
+
+        const size_type   nLeft = (n - 1) / 2;
+        rbtree_node_base* pNodeLeft = DoBuildSubtree(pNodeList, nLeft, nDepth + 1, nRedDepth);
+        rbtree_node_base* pNode = pNodeList;
+
+        pNodeList = pNodeList->mpNodeRight;
+
+        pNode->mpNodeLeft = pNodeLeft;
+        pNode->mpNodeRight = DoBuildSubtree(pNodeList, n - 1 - nLeft, nDepth + 1, nRedDepth);
+        pNode->mColor = (nDepth == nRedDepth) ? kRBTreeColorRed : kRBTreeColorBlack;
+
+        if (pNode->mpNodeLeft)
+            pNode->mpNodeLeft->mpNodeParent = pNode;
+        if (pNode->mpNodeRight)
+            pNode->mpNodeRight->mpNodeParent = pNode;
+
+        RBTreeAugmentUpdate(pNode);
+        return pNode;
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    void rbtree<K, V, C, E, bM, bU, A>::DoAppendNodes(rbtree_node_base* pNodeList, size_type n)
+    {
+        // pNodeList is a sorted list of n nodes (chained through mpNodeRight) which all
+        // belong after the current last node. We take the first node as a pivot, build 
+        // the rest into a balanced subtree S and then do a red-black tree join: the pivot 
+        // is linked in on the spine of the taller tree at a black node whose black height
+        // equals that of the shorter tree, and a single insertion fixup repairs the colors.
+        if (n == 0)
+            return;
+
+        size_type nLog2 = 0;
+
+        if (mnSize == 0) // If the tree is empty, the whole list simply becomes the tree.
+        {
+            for (size_type i = n + 1; i > 1; i >>= 1)
+                ++nLog2;
+
+            mAnchor.mpNodeParent = DoBuildSubtree(pNodeList, n, 0, nLog2);
+            mAnchor.mpNodeParent->mpNodeParent = &mAnchor;
+            mAnchor.mpNodeLeft = RBTreeGetMinChild(mAnchor.mpNodeParent);
+            mAnchor.mpNodeRight = RBTreeGetMaxChild(mAnchor.mpNodeParent);
+            mnSize = n;
+            mpFinger = mAnchor.mpNodeRight;
+            return;
+        }
+
+        for (size_type i = n; i > 1; i >>= 1)
+            ++nLog2;
+
+        rbtree_node_base* const pNodePivot = pNodeList;
+        rbtree_node_base*       pNodeRest = pNodeList->mpNodeRight;
+        rbtree_node_base* const pNodeS = DoBuildSubtree(pNodeRest, n - 1, 0, nLog2); // S has a black root and a black height of nLog2.
+        rbtree_node_base* const pNodeRoot = mAnchor.mpNodeParent;
+        const size_type         nBlackS = nLog2;
+        size_type               nBlackT = 0;
+
+        for (rbtree_node_base* pNode = pNodeRoot; pNode; pNode = pNode->mpNodeRight)
+        {
+            if (pNode->mColor == kRBTreeColorBlack)
+                ++nBlackT;
+        }
+
+        pNodePivot->mColor = kRBTreeColorRed;
+
+        if (nBlackT >= nBlackS)
+        {
+            // Walk down the right spine of the existing tree.
+            rbtree_node_base* pNodeParent = &mAnchor;
+            rbtree_node_base* pNode = pNodeRoot;
+            size_type         nBlack = nBlackT;
+
+            while (pNode && ((pNode->mColor == kRBTreeColorRed) || (nBlack > nBlackS)))
+            {
+                if (pNode->mColor == kRBTreeColorBlack)
+                    --nBlack;
+                pNodeParent = pNode;
+                pNode = pNode->mpNodeRight;
+            }
+
+            pNodePivot->mpNodeLeft = pNode;
+            pNodePivot->mpNodeRight = pNodeS;
+            pNodePivot->mpNodeParent = pNodeParent;
+
+            if (pNode)
+                pNode->mpNodeParent = pNodePivot;
+            if (pNodeS)
+                pNodeS->mpNodeParent = pNodePivot;
+
+            if (pNodeParent == &mAnchor)
+                mAnchor.mpNodeParent = pNodePivot;
+            else
+                pNodeParent->mpNodeRight = pNodePivot;
+        } else
+        {
+            // Walk down the left spine of S.
+            rbtree_node_base* pNodeParent = pNodeS;
+            rbtree_node_base* pNode = pNodeS;
+            size_type         nBlack = nBlackS;
+
+            while (pNode && ((pNode->mColor == kRBTreeColorRed) || (nBlack > nBlackT)))
+            {
+                if (pNode->mColor == kRBTreeColorBlack)
+                    --nBlack;
+                pNodeParent = pNode;
+                pNode = pNode->mpNodeLeft;
+            }
+
+            pNodePivot->mpNodeLeft = pNodeRoot;
+            pNodePivot->mpNodeRight = pNode;
+            pNodePivot->mpNodeParent = pNodeParent;
+            pNodeRoot->mpNodeParent = pNodePivot;
+
+            if (pNode)
+                pNode->mpNodeParent = pNodePivot;
+
+            pNodeParent->mpNodeLeft = pNodePivot;
+            pNodeS->mpNodeParent = &mAnchor;
+            mAnchor.mpNodeParent = pNodeS;
+        }
+
+        mAnchor.mpNodeRight = pNodeS ? RBTreeGetMaxChild(pNodeS) : pNodePivot;
+        mnSize += n;
+        mpFinger = mAnchor.mpNodeRight;
+
+        RBTreeAugmentPropagate(pNodePivot, &mAnchor);
+        RBTreeRebalanceInsert(pNodePivot, &mAnchor);
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    typename rbtree<K, V, C, E, bM, bU, A>::iterator
+        rbtree<K, V, C, E, bM, bU, A>::DoInsertValueHint(true_type, const_iterator position, const value_type& value) // true_type means keys are unique.
     {
         // This is the pathway for insertion of unique keys (map and set, but not multimap and multiset).
         //
@@ -1550,9 +2568,9 @@ namespace easy
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    typename rbtree<K, V, C, E, bM, bU>::iterator
-        rbtree<K, V, C, E, bM, bU>::DoInsertValueHint(false_type, const_iterator position, const value_type& value) // false_type means keys are not unique.
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    typename rbtree<K, V, C, E, bM, bU, A>::iterator
+        rbtree<K, V, C, E, bM, bU, A>::DoInsertValueHint(false_type, const_iterator position, const value_type& value) // false_type means keys are not unique.
     {
         // This is the pathway for insertion of non-unique keys (multimap and multiset, but not map and set).
         //
@@ -1570,26 +2588,74 @@ namespace easy
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
     template <typename InputIterator>
-    void rbtree<K, V, C, E, bM, bU>::insert(InputIterator first, InputIterator last)
+    void rbtree<K, V, C, E, bM, bU, A>::insert(InputIterator first, InputIterator last)
     {
         for (; first != last; ++first)
-            DoInsertValue(has_unique_keys_type(), *first); // Or maybe we should call 'insert(end(), *first)' instead. If the first-last range was sorted then this might make some sense.
+            DoInsertValue(has_unique_keys_type(), *first); // DoInsertValue tries the end and the previous insertion position first, so sorted ranges are cheap.
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    inline void rbtree<K, V, C, E, bM, bU>::clear()
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    template <typename InputIterator>
+    void rbtree<K, V, C, E, bM, bU, A>::append_sorted(InputIterator first, InputIterator last)
+    {
+        extract_key       extractKey;
+        rbtree_node_base* pNodeHead = NULL;  // Pending nodes, chained through mpNodeRight in sorted order.
+        rbtree_node_base* pNodeTail = NULL;
+        size_type         n = 0;
+
+        for (; first != last; ++first)
+        {
+            const node_type* const pNodeLast = pNodeTail ? (node_type*)pNodeTail : (mnSize ? (node_type*)mAnchor.mpNodeRight : NULL);
+
+            // With unique keys the value must be > the last value, otherwise it must be >= the last value.
+            if (!pNodeLast || (bU ? mCompare(extractKey(pNodeLast->mValue), extractKey(*first))
+                                  : !mCompare(extractKey(*first), extractKey(pNodeLast->mValue))))
+            {
+                node_type* const pNodeNew = DoCreateNode(*first);
+
+                if (!pNodeNew) // If the allocator is out of capacity, keep what fit and drop the rest.
+                    break;
+
+                pNodeNew->mpNodeRight = NULL;
+
+                if (pNodeTail)
+                    pNodeTail->mpNodeRight = pNodeNew;
+                else
+                    pNodeHead = pNodeNew;
+                pNodeTail = pNodeNew;
+                ++n;
+            } else
+            {
+                // The range isn't sorted after the pending nodes, so attach them before doing a regular insert.
+                DoAppendNodes(pNodeHead, n);
+                pNodeHead = pNodeTail = NULL;
+                n = 0;
+                DoInsertValue(has_unique_keys_type(), *first);
+            }
+        }
+
+        DoAppendNodes(pNodeHead, n);
+        DoFilterRegrow();
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline void rbtree<K, V, C, E, bM, bU, A>::clear()
     {
         // Erase the entire tree. DoNukeSubtree is not a 
         // conventional erase function, as it does no rebalancing.
         DoNukeSubtree((node_type*)mAnchor.mpNodeParent);
         reset_lose_memory();
+
+        if (rbtree_filter<C>::kEnabled)
+            rbtree_filter<C>::Clear(mCompare);
     }
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    inline void rbtree<K, V, C, E, bM, bU>::reset_lose_memory()
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline void rbtree<K, V, C, E, bM, bU, A>::reset_lose_memory()
     {
         // The reset_lose_memory function is a special extension function which unilaterally 
         // resets the container to an empty state without freeing the memory of 
@@ -1600,25 +2666,80 @@ namespace easy
         mAnchor.mpNodeParent = NULL;
         mAnchor.mColor = kRBTreeColorRed;
         mnSize = 0;
+        mpFinger = NULL;
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    inline typename rbtree<K, V, C, E, bM, bU>::iterator
-        rbtree<K, V, C, E, bM, bU>::erase(const_iterator position)
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline typename rbtree<K, V, C, E, bM, bU, A>::iterator
+        rbtree<K, V, C, E, bM, bU, A>::erase(const_iterator position)
     {
         const iterator iErase(position.mpNode);
         --mnSize; // Interleave this between the two references to itNext. We expect no exceptions to occur during the code below.
         ++position;
+        if (iErase.mpNode == mpFinger)
+            mpFinger = NULL;
         RBTreeErase(iErase.mpNode, &mAnchor);
-        DoFreeNode(iErase.mpNode);
+        DoFilterRemove((node_type*)iErase.mpNode);
+        DoFreeNode((node_type*)iErase.mpNode);
         return iterator(position.mpNode);
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    typename rbtree<K, V, C, E, bM, bU>::iterator
-        rbtree<K, V, C, E, bM, bU>::erase(const_iterator first, const_iterator last)
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline bool rbtree<K, V, C, E, bM, bU, A>::compact()
+    {
+        return compact_step(begin(), mnSize).mpNode == &mAnchor;
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    typename rbtree<K, V, C, E, bM, bU, A>::iterator
+        rbtree<K, V, C, E, bM, bU, A>::compact_step(const_iterator position, size_type nBudget)
+    {
+        // Allocate all of the new nodes before freeing any of the old ones, or each
+        // new node would likely reuse the block of the one moved just before it. The
+        // blocks wait in a list linked through their first bytes, in allocation order.
+        void*  pFirst = NULL;
+        void** ppLast = &pFirst;
+
+        for (size_type i = 0; (i < nBudget) && (i < mnSize); ++i)
+        {
+            void* const pMemory = mAllocator.allocate(sizeof(node_type));
+
+            if (!pMemory) // If the allocator is out of capacity...
+                break;
+
+            *ppLast = pMemory;
+            ppLast = static_cast<void**>(pMemory);
+        }
+        *ppLast = NULL;
+
+        iterator it(position.mpNode);
+
+        while (pFirst && (it.mpNode != &mAnchor))
+        {
+            void* const pMemory = pFirst;
+            pFirst = *static_cast<void**>(pMemory);
+
+            it = iterator(DoRelocateNode(it.mpNode, pMemory));
+            ++it;
+        }
+
+        while (pFirst) // If the pass ended before the budget did...
+        {
+            void* const pMemory = pFirst;
+            pFirst = *static_cast<void**>(pMemory);
+            mAllocator.deallocate(pMemory, sizeof(node_type));
+        }
+
+        return it;
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    typename rbtree<K, V, C, E, bM, bU, A>::iterator
+        rbtree<K, V, C, E, bM, bU, A>::erase(const_iterator first, const_iterator last)
     {
         // We expect that if the user means to clear the container, they will call clear.
         if (EASY_LIKELY((first.mpNode != mAnchor.mpNodeLeft) || (last.mpNode != &mAnchor))) // If (first != begin or last != end) ...
@@ -1647,20 +2768,264 @@ namespace easy
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    inline void rbtree<K, V, C, E, bM, bU>::erase(const key_type* first, const key_type* last)
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    void rbtree<K, V, C, E, bM, bU, A>::erase(const key_type* first, const key_type* last)
     {
-        // We have no choice but to run a loop like this, as the first/last range could
-        // have values that are discontiguously located in the tree. And some may not 
-        // even be in the tree.
-        while (first != last)
-            erase(*first++);
+        // The range could have values that are discontiguously located in the tree.
+        // And some may not even be in the tree. But while the keys ascend, each lower
+        // bound is at or after the one before it, so the search can start from there.
+        extract_key extractKey;
+        node_type*  pNode = (node_type*)mAnchor.mpNodeLeft;
+
+        for (const key_type* pKey = first; pKey != last; ++pKey)
+        {
+            if ((pKey != first) && mCompare(*pKey, pKey[-1]))
+                pNode = (node_type*)lower_bound(*pKey).mpNode;
+            else
+                pNode = DoLowerBoundFrom(pNode, *pKey);
+
+            while ((pNode != &mAnchor) && !mCompare(*pKey, extractKey(pNode->mValue)))
+                pNode = (node_type*)erase(const_iterator(pNode)).mpNode;
+        }
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    typename rbtree<K, V, C, E, bM, bU>::iterator
-        rbtree<K, V, C, E, bM, bU>::find(const key_type& key)
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    template <typename ForwardIterator>
+    void rbtree<K, V, C, E, bM, bU, A>::apply_batch(ForwardIterator first, ForwardIterator last)
+    {
+        static_assert(bU, "apply_batch needs unique keys");
+
+        std::vector<const batch_op_type*> ops;
+
+        for (; first != last; ++first)
+            ops.push_back(&*first);
+
+        if (ops.empty())
+            return;
+
+        // Sorting pointers keeps the operations on a key in batch order, so the one
+        // that wins is the last of its run.
+        extract_key extractKey;
+        const C&    compare = mCompare;
+        const auto  opLess = [&compare, &extractKey](const batch_op_type* pA, const batch_op_type* pB)
+            { return compare(extractKey(pA->mValue), extractKey(pB->mValue)); };
+
+        if (!std::is_sorted(ops.begin(), ops.end(), opLess))
+        {
+            // Sorts positions instead of the pointers themselves, whose swap would find
+            // easy::swap as well as std::swap.
+            std::vector<size_t>               order(ops.size());
+            std::vector<const batch_op_type*> sorted(ops.size());
+
+            for (size_t i = 0; i < order.size(); ++i)
+                order[i] = i;
+
+            std::stable_sort(order.begin(), order.end(), [&ops, &opLess](size_t a, size_t b) { return opLess(ops[a], ops[b]); });
+
+            for (size_t i = 0; i < order.size(); ++i)
+                sorted[i] = ops[order[i]];
+
+            ops.swap(sorted);
+        }
+
+        const batch_op_type* const* const ppOps = &ops[0];
+        node_type*                        pNodeFree = NULL;
+
+        // Walking every node costs a cache miss per node in a tree that has seen churn,
+        // so the rebuild only pays off for batches about as large as the tree.
+        if (ops.size() > mnSize)
+            DoApplyBatchRebuild(ppOps, ppOps + ops.size(), pNodeFree);
+        else
+            DoApplyBatchSearch(ppOps, ppOps + ops.size(), pNodeFree);
+
+        while (pNodeFree)
+        {
+            node_type* const pNode = pNodeFree;
+            pNodeFree = (node_type*)pNode->mpNodeLeft;
+            DoCount(kRBTreeCounterFree, 1);
+            mAllocator.deallocate(pNode, sizeof(node_type));
+        }
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    void rbtree<K, V, C, E, bM, bU, A>::DoApplyBatchSearch(const batch_op_type* const* ppOps, const batch_op_type* const* ppOpsEnd, node_type*& pNodeFree)
+    {
+        extract_key extractKey;
+        node_type*  pNode = (node_type*)mAnchor.mpNodeLeft; // The lower bound of the key before, where the next search starts.
+
+        while (ppOps != ppOpsEnd)
+        {
+            const batch_op_type* const pOp = DoTakeBatchOp(ppOps, ppOpsEnd);
+            const key_type&            key = extractKey(pOp->mValue);
+
+            pNode = DoLowerBoundFrom(pNode, key);
+
+            if ((pNode != &mAnchor) && !mCompare(key, extractKey(pNode->mValue))) // If the key is in the tree...
+            {
+                if (pOp->mbErase)
+                    pNode = DoReleaseNode(pNode, pNodeFree);
+                else
+                {
+                    pNode->mValue = pOp->mValue;
+                    RBTreeAugmentPropagate(pNode, &mAnchor);
+                }
+            } else if (!pOp->mbErase)
+            {
+                node_type* const pNodeNew = DoTakeNode(pNodeFree, pOp->mValue);
+
+                if (pNodeNew)
+                {
+                    DoLinkBefore(pNode, pNodeNew);
+                    pNode = pNodeNew;
+                }
+            }
+        }
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    void rbtree<K, V, C, E, bM, bU, A>::DoApplyBatchRebuild(const batch_op_type* const* ppOps, const batch_op_type* const* ppOpsEnd, node_type*& pNodeFree)
+    {
+        visit_merge merge(*this, ppOps, ppOpsEnd, pNodeFree);
+
+        DoVisitInOrder(NULL, merge);
+
+        while (merge.mppOps != ppOpsEnd)
+            merge.Insert(DoTakeBatchOp(merge.mppOps, ppOpsEnd));
+
+        *merge.mppNodeTail = NULL;
+
+        // The old links are all stale now, so build the list into a new tree.
+        reset_lose_memory();
+        DoAppendNodes(merge.mpNodeList, merge.mnCount);
+        DoFilterRegrow();
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline const typename rbtree<K, V, C, E, bM, bU, A>::batch_op_type*
+        rbtree<K, V, C, E, bM, bU, A>::DoTakeBatchOp(const batch_op_type* const*& ppOps, const batch_op_type* const* ppOpsEnd)
+    {
+        // Returns the last of the sorted operations on the next key, and moves past all of them.
+        extract_key                extractKey;
+        const batch_op_type*       pOp = *ppOps++;
+
+        while ((ppOps != ppOpsEnd) && !mCompare(extractKey(pOp->mValue), extractKey((*ppOps)->mValue)))
+            pOp = *ppOps++;
+
+        return pOp;
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    typename rbtree<K, V, C, E, bM, bU, A>::node_type*
+        rbtree<K, V, C, E, bM, bU, A>::DoLowerBoundFrom(node_type* pNode, const key_type& key)
+    {
+        // pNode is the lower bound of a key that is <= key, or end(), so every node before
+        // it is < key. Climb until pNode is a left child whose parent is >= key; the lower
+        // bound is then in pNode's subtree or is that parent. Reaching the root means it
+        // is in the root's subtree or is end().
+        extract_key             extractKey;
+        rbtree_node_base* const pNodeRoot = mAnchor.mpNodeParent;
+        rbtree_node_base*       pNodeBound = &mAnchor;
+
+        if ((pNode == &mAnchor) || !mCompare(extractKey(pNode->mValue), key)) // If pNode is end() or >= key, it is the lower bound.
+            return pNode;
+
+        while (pNode != pNodeRoot)
+        {
+            node_type* const pNodeParent = (node_type*)pNode->mpNodeParent;
+
+            if ((pNodeParent->mpNodeLeft == pNode) && !mCompare(extractKey(pNodeParent->mValue), key))
+            {
+                pNodeBound = pNodeParent;
+                break;
+            }
+
+            pNode = pNodeParent;
+        }
+
+        for (rbtree_node_base* pNodeCurrent = pNode; pNodeCurrent; )
+        {
+            if (!mCompare(extractKey(((node_type*)pNodeCurrent)->mValue), key)) // If pNodeCurrent is >= key...
+            {
+                pNodeBound = pNodeCurrent;
+                pNodeCurrent = pNodeCurrent->mpNodeLeft;
+            } else
+                pNodeCurrent = pNodeCurrent->mpNodeRight;
+        }
+
+        return (node_type*)pNodeBound;
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    void rbtree<K, V, C, E, bM, bU, A>::DoLinkBefore(node_type* pPosition, node_type* pNodeNew)
+    {
+        // Links pNodeNew in right before pPosition, as the left child of pPosition
+        // or as the right child of the node before it.
+        rbtree_node_base* pNodeParent;
+        RBTreeSide        side = kRBTreeSideRight;
+
+        if (pPosition == &mAnchor)
+            pNodeParent = mnSize ? mAnchor.mpNodeRight : &mAnchor;
+        else if (pPosition->mpNodeLeft)
+            pNodeParent = RBTreeGetMaxChild(pPosition->mpNodeLeft);
+        else
+        {
+            pNodeParent = pPosition;
+            side = kRBTreeSideLeft;
+        }
+
+        if (pNodeParent == &mAnchor)
+            side = kRBTreeSideLeft;
+
+        RBTreeInsert(pNodeNew, pNodeParent, &mAnchor, side);
+        ++mnSize;
+        mpFinger = pNodeNew;
+        DoFilterRegrow(); // The nodes waiting for reuse hold no values, so the tree has them all.
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline typename rbtree<K, V, C, E, bM, bU, A>::node_type*
+        rbtree<K, V, C, E, bM, bU, A>::DoTakeNode(node_type*& pNodeFree, const value_type& value)
+    {
+        if (!pNodeFree)
+            return DoCreateNode(value);
+
+        node_type* const pNode = pNodeFree;
+        pNodeFree = (node_type*)pNode->mpNodeLeft;
+        ::new(static_cast<void*>(&pNode->mValue)) value_type(value);
+        DoFilterAdd(pNode);
+        return pNode;
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    typename rbtree<K, V, C, E, bM, bU, A>::node_type*
+        rbtree<K, V, C, E, bM, bU, A>::DoReleaseNode(node_type* pNode, node_type*& pNodeFree)
+    {
+        // Like erase, but keeps the node for DoTakeNode. Returns the node after pNode.
+        const_iterator itNext(pNode);
+        ++itNext;
+        --mnSize;
+        if (pNode == mpFinger)
+            mpFinger = NULL;
+        RBTreeErase(pNode, &mAnchor);
+        DoFilterRemove(pNode);
+        pNode->mValue.~value_type();
+        pNode->mpNodeLeft = pNodeFree;
+        pNodeFree = pNode;
+        return (node_type*)itNext.mpNode;
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    typename rbtree<K, V, C, E, bM, bU, A>::iterator
+        rbtree<K, V, C, E, bM, bU, A>::find(const key_type& key)
     {
         // To consider: Implement this instead via calling lower_bound and 
         // inspecting the result. The following is an implementation of this:
@@ -1670,9 +3035,39 @@ namespace easy
         // find a lot with trees, but very uncommonly call lower_bound.
         extract_key extractKey;
 
+        if (rbtree_filter<C>::kEnabled && !rbtree_filter<C>::MayContain(mCompare, key))
+            return iterator((node_type*)&mAnchor);
+
         node_type* pCurrent = (node_type*)mAnchor.mpNodeParent; // Start with the root node.
         node_type* pRangeEnd = (node_type*)&mAnchor;             // Set it to the container end for now.
 
+        if (rbtree_three_way<C>::kEnabled)
+        {
+            // One comparison per level. With unique keys the first equal node is the
+            // answer; otherwise keep going left to the first of the equal nodes.
+            while (EASY_LIKELY(pCurrent))
+            {
+                const int order = DoOrder(key, extractKey(pCurrent->mValue));
+
+                if (order > 0)
+                    pCurrent = (node_type*)pCurrent->mpNodeRight;
+                else
+                {
+                    if (order == 0)
+                    {
+                        if (bU)
+                            return iterator(pCurrent);
+                        pRangeEnd = pCurrent;
+                    }
+                    pCurrent = (node_type*)pCurrent->mpNodeLeft;
+                }
+            }
+
+            if (rbtree_filter<C>::kEnabled && (pRangeEnd == &mAnchor))
+                rbtree_filter<C>::OnFalsePositive(mCompare);
+            return iterator(pRangeEnd);
+        }
+
         while (EASY_LIKELY(pCurrent)) // Do a walk down the tree.
         {
             if (EASY_LIKELY(!mCompare(extractKey(pCurrent->mValue), key))) // If pCurrent is >= key...
@@ -1688,23 +3083,26 @@ namespace easy
 
         if (EASY_LIKELY((pRangeEnd != &mAnchor) && !mCompare(key, extractKey(pRangeEnd->mValue))))
             return iterator(pRangeEnd);
+
+        if (rbtree_filter<C>::kEnabled)
+            rbtree_filter<C>::OnFalsePositive(mCompare);
         return iterator((node_type*)&mAnchor);
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    inline typename rbtree<K, V, C, E, bM, bU>::const_iterator
-        rbtree<K, V, C, E, bM, bU>::find(const key_type& key) const
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline typename rbtree<K, V, C, E, bM, bU, A>::const_iterator
+        rbtree<K, V, C, E, bM, bU, A>::find(const key_type& key) const
     {
-        typedef rbtree<K, V, C, E, bM, bU> rbtree_type;
+        typedef rbtree<K, V, C, E, bM, bU, A> rbtree_type;
         return const_iterator(const_cast<rbtree_type*>(this)->find(key));
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
     template <typename U, typename Compare2>
-    typename rbtree<K, V, C, E, bM, bU>::iterator
-        rbtree<K, V, C, E, bM, bU>::find_as(const U& u, Compare2 compare2)
+    typename rbtree<K, V, C, E, bM, bU, A>::iterator
+        rbtree<K, V, C, E, bM, bU, A>::find_as(const U& u, Compare2 compare2)
     {
         extract_key extractKey;
 
@@ -1730,25 +3128,46 @@ namespace easy
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
     template <typename U, typename Compare2>
-    inline typename rbtree<K, V, C, E, bM, bU>::const_iterator
-        rbtree<K, V, C, E, bM, bU>::find_as(const U& u, Compare2 compare2) const
+    inline typename rbtree<K, V, C, E, bM, bU, A>::const_iterator
+        rbtree<K, V, C, E, bM, bU, A>::find_as(const U& u, Compare2 compare2) const
     {
-        typedef rbtree<K, V, C, E, bM, bU> rbtree_type;
+        typedef rbtree<K, V, C, E, bM, bU, A> rbtree_type;
         return const_iterator(const_cast<rbtree_type*>(this)->find_as(u, compare2));
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    typename rbtree<K, V, C, E, bM, bU>::iterator
-        rbtree<K, V, C, E, bM, bU>::lower_bound(const key_type& key)
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    typename rbtree<K, V, C, E, bM, bU, A>::iterator
+        rbtree<K, V, C, E, bM, bU, A>::lower_bound(const key_type& key)
     {
         extract_key extractKey;
 
         node_type* pCurrent = (node_type*)mAnchor.mpNodeParent; // Start with the root node.
         node_type* pRangeEnd = (node_type*)&mAnchor;             // Set it to the container end for now.
 
+        if (rbtree_three_way<C>::kEnabled && bU)
+        {
+            // Same walk, but an equal key is the lower bound and ends it.
+            while (EASY_LIKELY(pCurrent))
+            {
+                const int order = DoOrder(key, extractKey(pCurrent->mValue));
+
+                if (order == 0)
+                    return iterator(pCurrent);
+
+                if (order < 0)
+                {
+                    pRangeEnd = pCurrent;
+                    pCurrent = (node_type*)pCurrent->mpNodeLeft;
+                } else
+                    pCurrent = (node_type*)pCurrent->mpNodeRight;
+            }
+
+            return iterator(pRangeEnd);
+        }
+
         while (EASY_LIKELY(pCurrent)) // Do a walk down the tree.
         {
             if (EASY_LIKELY(!mCompare(extractKey(pCurrent->mValue), key))) // If pCurrent is >= key...
@@ -1766,18 +3185,18 @@ namespace easy
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    inline typename rbtree<K, V, C, E, bM, bU>::const_iterator
-        rbtree<K, V, C, E, bM, bU>::lower_bound(const key_type& key) const
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline typename rbtree<K, V, C, E, bM, bU, A>::const_iterator
+        rbtree<K, V, C, E, bM, bU, A>::lower_bound(const key_type& key) const
     {
-        typedef rbtree<K, V, C, E, bM, bU> rbtree_type;
+        typedef rbtree<K, V, C, E, bM, bU, A> rbtree_type;
         return const_iterator(const_cast<rbtree_type*>(this)->lower_bound(key));
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    typename rbtree<K, V, C, E, bM, bU>::iterator
-        rbtree<K, V, C, E, bM, bU>::upper_bound(const key_type& key)
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    typename rbtree<K, V, C, E, bM, bU, A>::iterator
+        rbtree<K, V, C, E, bM, bU, A>::upper_bound(const key_type& key)
     {
         extract_key extractKey;
 
@@ -1799,33 +3218,397 @@ namespace easy
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    inline typename rbtree<K, V, C, E, bM, bU>::const_iterator
-        rbtree<K, V, C, E, bM, bU>::upper_bound(const key_type& key) const
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline typename rbtree<K, V, C, E, bM, bU, A>::const_iterator
+        rbtree<K, V, C, E, bM, bU, A>::upper_bound(const key_type& key) const
     {
-        typedef rbtree<K, V, C, E, bM, bU> rbtree_type;
+        typedef rbtree<K, V, C, E, bM, bU, A> rbtree_type;
         return const_iterator(const_cast<rbtree_type*>(this)->upper_bound(key));
     }
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    inline void rbtree<K, V, C, E, bM, bU>::DoFreeNode(node_type* pNode)
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    template <typename Function>
+    inline void rbtree<K, V, C, E, bM, bU, A>::for_each(Function f)
+    {
+        visit_all<typename iterator::reference, Function> visitor(f);
+        DoVisitInOrder(NULL, visitor);
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    template <typename Function>
+    inline void rbtree<K, V, C, E, bM, bU, A>::for_each(Function f) const
+    {
+        typedef rbtree<K, V, C, E, bM, bU, A> rbtree_type;
+        visit_all<const_reference, Function> visitor(f);
+        const_cast<rbtree_type*>(this)->DoVisitInOrder(NULL, visitor);
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    template <typename Function>
+    inline void rbtree<K, V, C, E, bM, bU, A>::for_each_range(const key_type& lo, const key_type& hi, Function f)
+    {
+        visit_range<typename iterator::reference, Function> visitor(f, hi, mCompare);
+        DoVisitInOrder(&lo, visitor);
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    template <typename Function>
+    inline void rbtree<K, V, C, E, bM, bU, A>::for_each_range(const key_type& lo, const key_type& hi, Function f) const
+    {
+        typedef rbtree<K, V, C, E, bM, bU, A> rbtree_type;
+        visit_range<const_reference, Function> visitor(f, hi, mCompare);
+        const_cast<rbtree_type*>(this)->DoVisitInOrder(&lo, visitor);
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    template <typename Predicate>
+    inline typename rbtree<K, V, C, E, bM, bU, A>::iterator
+        rbtree<K, V, C, E, bM, bU, A>::visit_until(const key_type& lo, Predicate pred)
+    {
+        visit_until_true<typename iterator::reference, Predicate> visitor(pred);
+        node_type* const pNode = DoVisitInOrder(&lo, visitor);
+        return iterator(pNode ? pNode : (node_type*)&mAnchor);
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    template <typename Predicate>
+    inline typename rbtree<K, V, C, E, bM, bU, A>::const_iterator
+        rbtree<K, V, C, E, bM, bU, A>::visit_until(const key_type& lo, Predicate pred) const
+    {
+        typedef rbtree<K, V, C, E, bM, bU, A> rbtree_type;
+        visit_until_true<const_reference, Predicate> visitor(pred);
+        node_type* const pNode = const_cast<rbtree_type*>(this)->DoVisitInOrder(&lo, visitor);
+        return const_iterator(pNode ? pNode : (node_type*)&mAnchor);
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    rbtree_stats rbtree<K, V, C, E, bM, bU, A>::stats() const
+    {
+        rbtree_stats s;
+
+        s.size = mnSize;
+        s.height = 0;
+        s.black_height = mAnchor.mpNodeParent ? const_cast<this_type*>(this)->RBTreeGetBlackCount(mAnchor.mpNodeParent, mAnchor.mpNodeLeft) : 0;
+        s.node_bytes = mnSize * sizeof(node_type);
+
+        // Preorder walk. Each stacked entry is a pending right subtree (or the root), so
+        // the stack never holds more than one entry per level plus one.
+        const rbtree_node_base* stack[2 * 8 * sizeof(size_type) + 1];
+        size_t                  depthStack[2 * 8 * sizeof(size_type) + 1];
+        size_t                  nStack = 0;
+        size_t                  nDepthSum = 0;
+
+        if (mAnchor.mpNodeParent)
+        {
+            stack[0] = mAnchor.mpNodeParent;
+            depthStack[0] = 1;
+            nStack = 1;
+        }
+
+        while (nStack)
+        {
+            --nStack;
+            const rbtree_node_base* pNode = stack[nStack];
+            size_t                  nDepth = depthStack[nStack];
+
+            for (; pNode; pNode = pNode->mpNodeLeft, ++nDepth)
+            {
+                nDepthSum += nDepth;
+                if (nDepth > s.height)
+                    s.height = nDepth;
+
+                if (pNode->mpNodeRight)
+                {
+                    stack[nStack] = pNode->mpNodeRight;
+                    depthStack[nStack++] = nDepth + 1;
+                }
+            }
+        }
+
+        s.average_depth = mnSize ? ((double)nDepthSum / mnSize) : 0.0;
+
+        s.compares = rbtree_instrumentation<C>::Get(mCompare, kRBTreeCounterCompare);
+        s.rotations = rbtree_instrumentation<C>::Get(mCompare, kRBTreeCounterRotate);
+        s.recolors = rbtree_instrumentation<C>::Get(mCompare, kRBTreeCounterRecolor);
+        s.allocations = rbtree_instrumentation<C>::Get(mCompare, kRBTreeCounterAllocate);
+        s.frees = rbtree_instrumentation<C>::Get(mCompare, kRBTreeCounterFree);
+        rbtree_filter<C>::Get(mCompare, s);
+
+#if EASY_RBTREE_COUNT_INCREMENTS
+        s.increments = rbtree_increment_counter().load(std::memory_order_relaxed);
+#else
+        s.increments = 0;
+#endif
+
+        return s;
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline void rbtree<K, V, C, E, bM, bU, A>::reset_counters()
+    {
+        rbtree_instrumentation<C>::Reset(mCompare);
+        rbtree_filter<C>::Reset(mCompare);
+    }
+
+    // Called after the tree grew, wherever every value in a node is linked into the
+    // tree, so that adding the tree's keys adds all the filter must hold.
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    void rbtree<K, V, C, E, bM, bU, A>::DoFilterRegrow()
+    {
+        if (rbtree_filter<C>::kEnabled && rbtree_filter<C>::Regrow(mCompare, mnSize))
+        {
+            for (const_iterator it = begin(); it != end(); ++it)
+                DoFilterAdd((const node_type*)it.mpNode);
+        }
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    template <typename Visitor>
+    typename rbtree<K, V, C, E, bM, bU, A>::node_type*
+        rbtree<K, V, C, E, bM, bU, A>::DoVisitInOrder(const key_type* pKeyLower, Visitor& visitor)
+    {
+        // A red-black tree with n nodes is at most 2 * log2(n + 1) high, so a
+        // fixed size stack is enough for any tree that size_type can count.
+        node_type*  stack[2 * 8 * sizeof(size_type)];
+        size_type   nDepth = 0;
+        node_type*  pNode = (node_type*)mAnchor.mpNodeParent;
+        extract_key extractKey;
+
+        if (pKeyLower)
+        {
+            // Do the lower_bound descent, stacking the nodes that are >= the key. That is 
+            // exactly the stack an in-order walk has when it reaches the lower bound.
+            while (pNode)
+            {
+                if (!mCompare(extractKey(pNode->mValue), *pKeyLower)) // If pNode is >= key...
+                {
+                    EASY_PREFETCH(pNode->mpNodeRight);
+                    stack[nDepth++] = pNode;
+                    pNode = (node_type*)pNode->mpNodeLeft;
+                } else
+                    pNode = (node_type*)pNode->mpNodeRight;
+            }
+        }
+
+        for (;;)
+        {
+            for (; pNode; pNode = (node_type*)pNode->mpNodeLeft)
+            {
+                EASY_PREFETCH(pNode->mpNodeRight); // We will get to the right subtree after the left subtree and pNode itself.
+                stack[nDepth++] = pNode;
+            }
+
+            if (nDepth == 0)
+                return NULL;
+
+            pNode = stack[--nDepth];
+
+            if (visitor(pNode))
+                return pNode;
+
+            pNode = (node_type*)pNode->mpNodeRight;
+        }
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    void rbtree<K, V, C, E, bM, bU, A>::DoGetEqualRange(const key_type& key, node_type*& pLower, node_type*& pUpper)
+    {
+        // Instead of doing two full tree searches (one for lower_bound and one for 
+        // upper_bound), we descend once until we hit the first node that is equal to 
+        // key. Below that node, the lower bound can only be in its left subtree and
+        // the upper bound can only be in its right subtree. With unique keys, the
+        // equal node is the whole range.
+        extract_key extractKey;
+
+        node_type* pCurrent = (node_type*)mAnchor.mpNodeParent; // Start with the root node.
+        node_type* pRangeEnd = (node_type*)&mAnchor;             // The lowest node seen so far that is > key.
+
+        while (EASY_LIKELY(pCurrent)) // Do a walk down the tree.
+        {
+            const int order = DoOrder(key, extractKey(pCurrent->mValue));
+
+            if (order > 0)       // If pCurrent is < key...
+                pCurrent = (node_type*)pCurrent->mpNodeRight;
+            else if (order < 0)  // If key is < pCurrent...
+            {
+                pRangeEnd = pCurrent;
+                pCurrent = (node_type*)pCurrent->mpNodeLeft;
+            } else if (bU)
+            {
+                iterator itUpper(pCurrent);
+                pLower = pCurrent;
+                pUpper = (node_type*)(++itUpper).mpNode;
+                return;
+            } else
+            {
+                pLower = pCurrent;
+
+                for (node_type* pNode = (node_type*)pCurrent->mpNodeLeft; pNode; ) // lower_bound in the left subtree.
+                {
+                    if (!mCompare(extractKey(pNode->mValue), key))
+                    {
+                        pLower = pNode;
+                        pNode = (node_type*)pNode->mpNodeLeft;
+                    } else
+                        pNode = (node_type*)pNode->mpNodeRight;
+                }
+
+                pUpper = pRangeEnd;
+
+                for (node_type* pNode = (node_type*)pCurrent->mpNodeRight; pNode; ) // upper_bound in the right subtree.
+                {
+                    if (mCompare(key, extractKey(pNode->mValue)))
+                    {
+                        pUpper = pNode;
+                        pNode = (node_type*)pNode->mpNodeLeft;
+                    } else
+                        pNode = (node_type*)pNode->mpNodeRight;
+                }
+                return;
+            }
+        }
+
+        // There is no node equal to key, so the range is empty and positioned at the first node > key.
+        pLower = pUpper = pRangeEnd;
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    typename rbtree<K, V, C, E, bM, bU, A>::size_type
+        rbtree<K, V, C, E, bM, bU, A>::DoCountKey(const key_type& key) const
     {
-        delete pNode;
+        // This follows the same paths as DoGetEqualRange, but instead of remembering the 
+        // bounds it adds up the sizes of the subtrees that hang off the inside of the two 
+        // boundary paths. Those subtrees consist entirely of nodes equal to key, and each 
+        // node records its subtree size, so the count is O(log n) however many keys match.
+        extract_key extractKey;
+
+        const node_type* pCurrent = (const node_type*)mAnchor.mpNodeParent;
+
+        while (EASY_LIKELY(pCurrent))
+        {
+            const int order = DoOrder(key, extractKey(pCurrent->mValue));
+
+            if (order > 0)
+                pCurrent = (const node_type*)pCurrent->mpNodeRight;
+            else if (order < 0)
+                pCurrent = (const node_type*)pCurrent->mpNodeLeft;
+            else
+            {
+                size_type n = 1;
+
+                for (const node_type* pNode = (const node_type*)pCurrent->mpNodeLeft; pNode; )
+                {
+                    if (!mCompare(extractKey(pNode->mValue), key)) // If pNode is equal to key, it and all of its right subtree are in range.
+                    {
+                        n += 1 + RBTreeSubtreeSize(pNode->mpNodeRight);
+                        pNode = (const node_type*)pNode->mpNodeLeft;
+                    } else
+                        pNode = (const node_type*)pNode->mpNodeRight;
+                }
+
+                for (const node_type* pNode = (const node_type*)pCurrent->mpNodeRight; pNode; )
+                {
+                    if (!mCompare(key, extractKey(pNode->mValue))) // If pNode is equal to key, it and all of its left subtree are in range.
+                    {
+                        n += 1 + RBTreeSubtreeSize(pNode->mpNodeLeft);
+                        pNode = (const node_type*)pNode->mpNodeRight;
+                    } else
+                        pNode = (const node_type*)pNode->mpNodeLeft;
+                }
+
+                return n;
+            }
+        }
+
+        return 0;
     }
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    typename rbtree<K, V, C, E, bM, bU>::node_type*
-        rbtree<K, V, C, E, bM, bU>::DoCreateNode(const value_type& value)
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline void rbtree<K, V, C, E, bM, bU, A>::DoFreeNode(node_type* pNode)
     {
-        node_type* const pNode = new node_type();
-        pNode->mValue=value;
+        DoCount(kRBTreeCounterFree, 1);
+        pNode->~node_type();
+        mAllocator.deallocate(pNode, sizeof(node_type));
+    }
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    typename rbtree<K, V, C, E, bM, bU, A>::node_type*
+        rbtree<K, V, C, E, bM, bU, A>::DoCreateNode(const value_type& value)
+    {
+        void* const pMemory = mAllocator.allocate(sizeof(node_type));
+
+        if (!pMemory) // If the allocator is out of capacity...
+            return NULL;
+
+        // The links are left for the caller to set.
+        node_type* const pNode = static_cast<node_type*>(pMemory);
+        ::new(static_cast<void*>(&pNode->mValue)) value_type(value);
+        DoCount(kRBTreeCounterAllocate, 1);
+        DoFilterAdd(pNode);
 
         return pNode;
     }
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    typename rbtree<K, V, C, E, bM, bU>::node_type*
-        rbtree<K, V, C, E, bM, bU>::DoCreateNode(const node_type* pNodeSource, node_type* pNodeParent)
+    // Moves pNode's value into a new node made in pMemory, which takes pNode's place
+    // in the tree, and frees pNode. Returns the new node.
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    typename rbtree<K, V, C, E, bM, bU, A>::node_type*
+        rbtree<K, V, C, E, bM, bU, A>::DoRelocateNode(node_type* pNode, void* pMemory)
+    {
+        node_type* const pNodeNew = static_cast<node_type*>(pMemory);
+        Internal::RelocateValues(&pNodeNew->mValue, &pNode->mValue, 1);
+        DoCount(kRBTreeCounterAllocate, 1);
+
+        pNodeNew->mpNodeLeft = pNode->mpNodeLeft;
+        pNodeNew->mpNodeRight = pNode->mpNodeRight;
+        pNodeNew->mpNodeParent = pNode->mpNodeParent;
+        pNodeNew->mColor = pNode->mColor;
+        RBTreeSubtreeSizeCopy(pNodeNew, pNode, has_unique_keys_type());
+
+        if (pNodeNew->mpNodeLeft)
+            pNodeNew->mpNodeLeft->mpNodeParent = pNodeNew;
+        if (pNodeNew->mpNodeRight)
+            pNodeNew->mpNodeRight->mpNodeParent = pNodeNew;
+
+        // The root's parent is the anchor, whose parent is the root.
+        rbtree_node_base* const pNodeParent = pNodeNew->mpNodeParent;
+
+        if (pNodeParent == &mAnchor)
+            mAnchor.mpNodeParent = pNodeNew;
+        else if (pNodeParent->mpNodeLeft == pNode)
+            pNodeParent->mpNodeLeft = pNodeNew;
+        else
+            pNodeParent->mpNodeRight = pNodeNew;
+
+        if (mAnchor.mpNodeLeft == pNode)
+            mAnchor.mpNodeLeft = pNodeNew;
+        if (mAnchor.mpNodeRight == pNode)
+            mAnchor.mpNodeRight = pNodeNew;
+        if (mpFinger == pNode)
+            mpFinger = pNodeNew;
+
+        // The value has moved out, so there is nothing to destroy.
+        DoCount(kRBTreeCounterFree, 1);
+        mAllocator.deallocate(pNode, sizeof(node_type));
+
+        return pNodeNew;
+    }
+
+
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    typename rbtree<K, V, C, E, bM, bU, A>::node_type*
+        rbtree<K, V, C, E, bM, bU, A>::DoCreateNode(const node_type* pNodeSource, node_type* pNodeParent)
     {
         node_type* const pNode = DoCreateNode(pNodeSource->mValue);
 
@@ -1833,15 +3616,18 @@ namespace easy
         pNode->mpNodeLeft = NULL;
         pNode->mpNodeParent = pNodeParent;
         pNode->mColor = pNodeSource->mColor;
+        RBTreeSubtreeSizeCopy(pNode, pNodeSource, has_unique_keys_type());
 
         return pNode;
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    typename rbtree<K, V, C, E, bM, bU>::node_type*
-        rbtree<K, V, C, E, bM, bU>::DoCopySubtree(const node_type* pNodeSource, node_type* pNodeDest)
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    typename rbtree<K, V, C, E, bM, bU, A>::node_type*
+        rbtree<K, V, C, E, bM, bU, A>::DoCopySubtree(const node_type* pNodeSource, node_type* pNodeDest)
     {
+        // The destination's allocator must be able to hold as many nodes as the source. That is
+        // always the case for trees of the same type, as a fixed allocator can't be outgrown.
         node_type* const pNewNodeRoot = DoCreateNode(pNodeSource, pNodeDest);
 
         // Copy the right side of the tree recursively.
@@ -1867,8 +3653,8 @@ namespace easy
     }
 
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    void rbtree<K, V, C, E, bM, bU>::DoNukeSubtree(node_type* pNode)
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    void rbtree<K, V, C, E, bM, bU, A>::DoNukeSubtree(node_type* pNode)
     {
         while (pNode) // Recursively traverse the tree and destroy items as we go.
         {
@@ -1886,8 +3672,8 @@ namespace easy
     // global operators
     ///////////////////////////////////////////////////////////////////////
 
-    template <typename K, typename V, typename C, typename E, bool bM, bool bU>
-    inline void swap(rbtree<K, V, C, E, bM, bU>& a, rbtree<K, V, C, E, bM, bU>& b)
+    template <typename K, typename V, typename C, typename E, bool bM, bool bU, typename A>
+    inline void swap(rbtree<K, V, C, E, bM, bU, A>& a, rbtree<K, V, C, E, bM, bU, A>& b)
     {
         a.swap(b);
     }
@@ -0,0 +1,320 @@
+#ifndef __EASY_RBTREE_FILTER_H__
+#define __EASY_RBTREE_FILTER_H__
+
+/**
+ * 红黑树查找的否定过滤: 计数布隆过滤器, 以及作为Compare使用的filtered_compare
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <vector>
+#include "HashTable.h"
+#include "RbTree.h"
+
+namespace easy
+{
+    /// counting_bloom_filter
+    ///
+    /// A Bloom filter with a 4-bit counter in place of each bit, so that keys can
+    /// be removed as well as added. The filter is blocked: a key's counters all
+    /// lie in one 64-byte line of 128 counters, picked by the key's hash, so a
+    /// query reads a single cache line.
+    ///
+    /// A counter which reaches 15 stays there, as it can't tell how many more
+    /// keys it counts. Lines with such a counter answer "maybe" more often, but
+    /// the filter never says no to a key it holds.
+    ///
+    /// Sized for capacity() keys at 12.8 counters (6.4 bytes) a key, where under
+    /// 1% of absent keys pass. It doesn't grow by itself, as that needs the keys;
+    /// the owner resets it and adds them again at a larger size.
+    ///
+    class counting_bloom_filter
+    {
+    public:
+        static const size_t kKeysPerLine = 10;  // 12.8 counters a key.
+        static const size_t kProbes = 6;
+        static const size_t kLineWords = 8;     // 64 bytes.
+
+    public:
+        counting_bloom_filter() : mBuffer(), mpLines(NULL), mnLineMask(0), mnCapacity(0) {}
+
+        counting_bloom_filter(const counting_bloom_filter& x)
+            : mBuffer(), mpLines(NULL), mnLineMask(0), mnCapacity(0) { *this = x; }
+
+        counting_bloom_filter& operator=(const counting_bloom_filter& x)
+        {
+            if (this != &x)
+            {
+                if (x.mpLines)
+                {
+                    reset(x.mnCapacity); // The same number of lines, aligned in this buffer.
+                    memcpy(mpLines, x.mpLines, (mnLineMask + 1) * kLineWords * sizeof(uint64_t));
+                }
+                else
+                {
+                    mBuffer.clear();
+                    mpLines = NULL;
+                    mnLineMask = 0;
+                    mnCapacity = 0;
+                }
+            }
+            return *this;
+        }
+
+        /// Empties the filter and sizes it for at least nCapacity keys.
+        void reset(size_t nCapacity)
+        {
+            size_t nLines = 1;
+            while ((nLines * kKeysPerLine) < nCapacity)
+                nLines *= 2;
+
+            mBuffer.assign((nLines + 1) * kLineWords, 0); // One line more, to align to 64 bytes.
+            mpLines = DoAlign(&mBuffer[0]);
+            mnLineMask = nLines - 1;
+            mnCapacity = nLines * kKeysPerLine;
+        }
+
+        /// Zeroes every counter and keeps the size.
+        void clear()
+        {
+            if (mpLines)
+                memset(mpLines, 0, (mnLineMask + 1) * kLineWords * sizeof(uint64_t));
+        }
+
+        size_t capacity() const { return mnCapacity; }
+        size_t memory_usage() const { return mBuffer.size() * sizeof(uint64_t); }
+
+        /// Takes a hash of the key, which needn't be well spread.
+        void add(size_t nHash)    { DoUpdate(nHash, +1); }
+        void remove(size_t nHash) { DoUpdate(nHash, -1); }
+
+        /// Returns false only if no added key has this hash.
+        bool may_contain(size_t nHash) const
+        {
+            if (!mpLines)
+                return true;
+
+            uint64_t        h = DoMix(nHash);
+            const uint64_t* pLine = mpLines + (size_t)((h >> 32) & mnLineMask) * kLineWords;
+            const uint32_t  a = (uint32_t)h & 127, b = ((uint32_t)(h >> 7) & 127) | 1;
+
+            for (uint32_t i = 0, c = a; i < kProbes; ++i, c = (c + b) & 127)
+            {
+                if (((pLine[c >> 4] >> ((c & 15) * 4)) & 15) == 0)
+                    return false;
+            }
+            return true;
+        }
+
+    protected:
+        static uint64_t DoMix(uint64_t h)
+        {
+            // The finalizer of MurmurHash3, as integer keys hash to themselves.
+            h ^= h >> 33;
+            h *= 0xFF51AFD7ED558CCDull;
+            h ^= h >> 33;
+            h *= 0xC4CEB9FE1A85EC53ull;
+            h ^= h >> 33;
+            return h;
+        }
+
+        static uint64_t* DoAlign(uint64_t* p)
+        {
+            return (uint64_t*)(((uintptr_t)p + 63) & ~(uintptr_t)63);
+        }
+
+        void DoUpdate(size_t nHash, int nDelta)
+        {
+            uint64_t       h = DoMix(nHash);
+            uint64_t*      pLine = mpLines + (size_t)((h >> 32) & mnLineMask) * kLineWords;
+            const uint32_t a = (uint32_t)h & 127, b = ((uint32_t)(h >> 7) & 127) | 1;
+
+            for (uint32_t i = 0, c = a; i < kProbes; ++i, c = (c + b) & 127)
+            {
+                const uint32_t nShift = (c & 15) * 4;
+                const uint64_t nCount = (pLine[c >> 4] >> nShift) & 15;
+
+                if (nCount == 15) // Saturated counters stay.
+                    continue;
+                if (nDelta > 0)
+                    pLine[c >> 4] += (uint64_t)1 << nShift;
+                else if (nCount)
+                    pLine[c >> 4] -= (uint64_t)1 << nShift;
+            }
+        }
+
+    protected:
+        std::vector<uint64_t> mBuffer;
+        uint64_t*             mpLines;      // mBuffer rounded up to 64 bytes.
+        size_t                mnLineMask;   // Lines - 1; the line count is a power of 2.
+        size_t                mnCapacity;
+    };
+
+
+
+    /// filtered_compare
+    ///
+    /// A Compare adapter which keeps a counting_bloom_filter over the keys of the
+    /// tree that owns it (see rbtree_filter). find, and with it count and erase of
+    /// a key, asks the filter first and returns without descending the tree for a
+    /// key the filter hasn't seen. That suits maps where most lookups miss.
+    ///
+    /// The tree adds each key to the filter as it creates the node and removes it
+    /// when it frees the node. When the tree outgrows the filter, the next insert
+    /// rebuilds it for twice the size, which costs a hash of each key, amortized
+    /// O(1) an insert. The filter doesn't shrink with the tree.
+    ///
+    /// lookups() counts the finds that consulted the filter, negatives() those it
+    /// answered, and false_positives() those that passed it and found nothing.
+    /// The counters are relaxed atomics, as in instrumented_compare, and are also
+    /// reported by rbtree::stats.
+    ///
+    /// A copy keeps the filter's size and starts empty, for the tree it belongs to
+    /// to fill. Assignment copies the comparison and leaves the filter alone.
+    ///
+    /// Example usage:
+    ///     easy::map<int, int, easy::filtered_compare<int> > myMap;
+    ///     ...
+    ///     double rate = myMap.key_comp().false_positive_rate();
+    ///
+    template <typename Key, typename Compare = easy::less<Key>, typename Hash = easy::hash<Key> >
+    class filtered_compare
+    {
+    public:
+        typedef filtered_compare<Key, Compare, Hash> this_type;
+        typedef Compare                              compare_type;
+
+        static const size_t kMinCapacity = 64;
+
+    public:
+        filtered_compare()
+            : mCompare(), mHash(), mFilter() { mFilter.reset(kMinCapacity); reset_counters(); }
+
+        filtered_compare(const Compare& compare, const Hash& hash = Hash())
+            : mCompare(compare), mHash(hash), mFilter() { mFilter.reset(kMinCapacity); reset_counters(); }
+
+        filtered_compare(const this_type& x)
+            : mCompare(x.mCompare), mHash(x.mHash), mFilter() { mFilter.reset(x.mFilter.capacity()); reset_counters(); }
+
+        this_type& operator=(const this_type& x)
+        {
+            mCompare = x.mCompare;
+            mHash = x.mHash;
+            return *this;
+        }
+
+        template <typename A, typename B>
+        bool operator()(const A& a, const B& b) const
+        {
+            return mCompare(a, b);
+        }
+
+        const Compare& compare() const { return mCompare; }
+        const counting_bloom_filter& filter() const { return mFilter; }
+
+        void add(const Key& key)    { mFilter.add(mHash(key)); }
+        void remove(const Key& key) { mFilter.remove(mHash(key)); }
+        void clear()                { mFilter.clear(); }
+
+        /// Returns whether the filter must grow to hold nSize keys, and if so empties
+        /// it at twice that size, for the caller to add the keys back.
+        bool regrow(size_t nSize)
+        {
+            if (nSize <= mFilter.capacity())
+                return false;
+            mFilter.reset(2 * nSize);
+            return true;
+        }
+
+        bool may_contain(const Key& key) const
+        {
+            DoAdd(mnLookups, 1);
+            if (mFilter.may_contain(mHash(key)))
+                return true;
+            DoAdd(mnNegatives, 1);
+            return false;
+        }
+
+        void on_false_positive() const { DoAdd(mnFalsePositives, 1); }
+
+        size_t lookups() const         { return mnLookups.load(std::memory_order_relaxed); }
+        size_t negatives() const       { return mnNegatives.load(std::memory_order_relaxed); }
+        size_t false_positives() const { return mnFalsePositives.load(std::memory_order_relaxed); }
+
+        /// The fraction of lookups for absent keys that the filter let through.
+        double false_positive_rate() const
+        {
+            const size_t nAbsent = negatives() + false_positives();
+            return nAbsent ? ((double)false_positives() / nAbsent) : 0.0;
+        }
+
+        void reset_counters() const
+        {
+            mnLookups.store(0, std::memory_order_relaxed);
+            mnNegatives.store(0, std::memory_order_relaxed);
+            mnFalsePositives.store(0, std::memory_order_relaxed);
+        }
+
+    protected:
+        static void DoAdd(std::atomic<size_t>& counter, size_t n)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+    protected:
+        Compare                     mCompare;
+        Hash                        mHash;
+        counting_bloom_filter       mFilter;
+        mutable std::atomic<size_t> mnLookups;
+        mutable std::atomic<size_t> mnNegatives;
+        mutable std::atomic<size_t> mnFalsePositives;
+    };
+
+
+    /// rbtree_filter
+    /// Routes the tree's keys and lookups to a filtered_compare.
+    ///
+    template <typename Key, typename Compare, typename Hash>
+    struct rbtree_filter<filtered_compare<Key, Compare, Hash> >
+    {
+        typedef filtered_compare<Key, Compare, Hash> compare_type;
+
+        static const bool kEnabled = true;
+
+        static void Add(compare_type& compare, const Key& key)           { compare.add(key); }
+        static void Remove(compare_type& compare, const Key& key)        { compare.remove(key); }
+        static void Clear(compare_type& compare)                         { compare.clear(); }
+        static bool Regrow(compare_type& compare, size_t nSize)          { return compare.regrow(nSize); }
+        static bool MayContain(const compare_type& compare, const Key& key) { return compare.may_contain(key); }
+        static void OnFalsePositive(const compare_type& compare)         { compare.on_false_positive(); }
+        static void Get(const compare_type& compare, rbtree_stats& s)
+        {
+            s.filter_lookups = compare.lookups();
+            s.filter_negatives = compare.negatives();
+            s.filter_false_positives = compare.false_positives();
+            s.filter_bytes = compare.filter().memory_usage();
+        }
+        static void Reset(const compare_type& compare)                   { compare.reset_counters(); }
+    };
+
+
+    /// rbtree_three_way
+    /// Uses the wrapped Compare's three-way comparison, if it has one.
+    ///
+    template <typename Key, typename Compare, typename Hash>
+    struct rbtree_three_way<filtered_compare<Key, Compare, Hash> >
+    {
+        static const bool kEnabled = rbtree_three_way<Compare>::kEnabled;
+
+        template <typename A, typename B>
+        static int Order(const filtered_compare<Key, Compare, Hash>& compare, const A& a, const B& b)
+        {
+            return rbtree_three_way<Compare>::Order(compare.compare(), a, b);
+        }
+    };
+
+} // namespace easy
+
+#endif // __EASY_RBTREE_FILTER_H__
@@ -0,0 +1,124 @@
+#ifndef __EASY_RBTREE_STATS_H__
+#define __EASY_RBTREE_STATS_H__
+
+/**
+ * 红黑树操作计数: 作为Compare使用的instrumented_compare
+ */
+
+#include <stddef.h>
+#include <atomic>
+#include "RbTree.h"
+
+namespace easy
+{
+    /// instrumented_compare
+    ///
+    /// A Compare adapter which counts its calls, and which lets the tree that owns
+    /// it count rotations, recolorings, allocations and frees (see
+    /// rbtree_instrumentation). The counts are per container and are read with
+    /// rbtree::stats.
+    ///
+    /// The counters are relaxed atomics updated with a plain load and store rather
+    /// than a locked read-modify-write. That costs about as much as incrementing an
+    /// ordinary integer, so it can stay on in production. Concurrent readers of one
+    /// container (e.g. several threads calling find) may lose some counts, but
+    /// there is no data race.
+    ///
+    /// A copy starts with zero counts. Assignment copies the comparison and leaves
+    /// the counts alone, so they always describe the container that holds them.
+    ///
+    /// Example usage:
+    ///     easy::map<int, int, easy::instrumented_compare<easy::less<int> > > myMap;
+    ///     ...
+    ///     easy::rbtree_stats s = myMap.stats();
+    ///
+    template <typename Compare>
+    class instrumented_compare
+    {
+    public:
+        typedef instrumented_compare<Compare> this_type;
+        typedef Compare                       compare_type;
+
+    public:
+        instrumented_compare()
+            : mCompare() { reset(); }
+
+        instrumented_compare(const Compare& compare)
+            : mCompare(compare) { reset(); }
+
+        instrumented_compare(const this_type& x)
+            : mCompare(x.mCompare) { reset(); }
+
+        this_type& operator=(const this_type& x)
+        {
+            mCompare = x.mCompare;
+            return *this;
+        }
+
+        template <typename A, typename B>
+        bool operator()(const A& a, const B& b) const
+        {
+            add(kRBTreeCounterCompare, 1);
+            return mCompare(a, b);
+        }
+
+        const Compare& compare() const { return mCompare; }
+
+        size_t get(RBTreeCounter counter) const
+        {
+            return mCounters[counter].load(std::memory_order_relaxed);
+        }
+
+        void add(RBTreeCounter counter, size_t n) const
+        {
+            mCounters[counter].store(mCounters[counter].load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        void reset() const
+        {
+            for (int i = 0; i < kRBTreeCounterCount; ++i)
+                mCounters[i].store(0, std::memory_order_relaxed);
+        }
+
+    protected:
+        Compare                     mCompare;
+        mutable std::atomic<size_t> mCounters[kRBTreeCounterCount];
+    };
+
+
+    /// rbtree_instrumentation
+    /// Routes the tree's counts to an instrumented_compare.
+    ///
+    template <typename Compare>
+    struct rbtree_instrumentation<instrumented_compare<Compare> >
+    {
+        static const bool kEnabled = true;
+
+        static void   Add(const instrumented_compare<Compare>& compare, RBTreeCounter counter, size_t n) { compare.add(counter, n); }
+        static size_t Get(const instrumented_compare<Compare>& compare, RBTreeCounter counter) { return compare.get(counter); }
+        static void   Reset(const instrumented_compare<Compare>& compare) { compare.reset(); }
+    };
+
+
+    /// rbtree_three_way
+    /// Counts a three-way comparison of the wrapped Compare as one compare.
+    ///
+    template <typename Compare>
+    struct rbtree_three_way<instrumented_compare<Compare> >
+    {
+        static const bool kEnabled = rbtree_three_way<Compare>::kEnabled;
+
+        template <typename A, typename B>
+        static int Order(const instrumented_compare<Compare>& compare, const A& a, const B& b)
+        {
+            if (!kEnabled)
+                return compare(a, b) ? -1 : (compare(b, a) ? 1 : 0);
+
+            compare.add(kRBTreeCounterCompare, 1);
+            return rbtree_three_way<Compare>::Order(compare.compare(), a, b);
+        }
+    };
+
+} // namespace easy
+
+#endif // __EASY_RBTREE_STATS_H__
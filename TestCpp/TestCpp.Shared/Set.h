@@ -20,15 +20,16 @@ namespace easy
     /// these solutions are recommended by the C++ standard defect report.
     /// To consider: Expose the bMutableIterators template policy here at the set level
     /// so the user can have non-const set iterators via a template parameter.
-    template <typename Key, typename Compare = easy::less<Key> >
+    template <typename Key, typename Compare = easy::less<Key>, typename Allocator = easy::allocator>
     class set
-        : public rbtree<Key, Key, Compare, easy::use_self<Key>, false, true>
+        : public rbtree<Key, Key, Compare, easy::use_self<Key>, false, true, Allocator>
     {
     public:
-        typedef rbtree<Key, Key, Compare, easy::use_self<Key>, false, true> base_type;
-        typedef set<Key, Compare>                                            this_type;
+        typedef rbtree<Key, Key, Compare, easy::use_self<Key>, false, true, Allocator> base_type;
+        typedef set<Key, Compare, Allocator>                                            this_type;
         typedef typename base_type::size_type                                           size_type;
         typedef typename base_type::value_type                                          value_type;
+        typedef typename base_type::node_type                                           node_type;
         typedef typename base_type::iterator                                            iterator;
         typedef typename base_type::const_iterator                                      const_iterator;
         typedef Compare                                                                 value_compare;
@@ -67,45 +68,45 @@ namespace easy
        // set
        ///////////////////////////////////////////////////////////////////////
 
-    template <typename Key, typename Compare>
-    inline set<Key, Compare>::set()
+    template <typename Key, typename Compare, typename Allocator>
+    inline set<Key, Compare, Allocator>::set()
         : base_type()
     {
     }
 
 
-    template <typename Key, typename Compare>
-    inline set<Key, Compare>::set(const Compare& compare)
+    template <typename Key, typename Compare, typename Allocator>
+    inline set<Key, Compare, Allocator>::set(const Compare& compare)
         : base_type(compare)
     {
     }
 
 
-    template <typename Key, typename Compare>
-    inline set<Key, Compare>::set(const this_type& x)
+    template <typename Key, typename Compare, typename Allocator>
+    inline set<Key, Compare, Allocator>::set(const this_type& x)
         : base_type(x)
     {
     }
 
-    template <typename Key, typename Compare>
+    template <typename Key, typename Compare, typename Allocator>
     template <typename Iterator>
-    inline set<Key, Compare>::set(Iterator itBegin, Iterator itEnd)
+    inline set<Key, Compare, Allocator>::set(Iterator itBegin, Iterator itEnd)
         : base_type(itBegin, itEnd, Compare())
     {
     }
 
 
-    template <typename Key, typename Compare>
-    inline typename set<Key, Compare>::value_compare
-        set<Key, Compare>::value_comp() const
+    template <typename Key, typename Compare, typename Allocator>
+    inline typename set<Key, Compare, Allocator>::value_compare
+        set<Key, Compare, Allocator>::value_comp() const
     {
         return mCompare;
     }
 
 
-    template <typename Key, typename Compare>
-    inline typename set<Key, Compare>::size_type
-        set<Key, Compare>::erase(const Key& k)
+    template <typename Key, typename Compare, typename Allocator>
+    inline typename set<Key, Compare, Allocator>::size_type
+        set<Key, Compare, Allocator>::erase(const Key& k)
     {
         const iterator it(find(k));
 
@@ -118,9 +119,9 @@ namespace easy
     }
 
 
-    template <typename Key, typename Compare>
-    inline typename set<Key, Compare>::iterator
-        set<Key, Compare>::erase(const_iterator position)
+    template <typename Key, typename Compare, typename Allocator>
+    inline typename set<Key, Compare, Allocator>::iterator
+        set<Key, Compare, Allocator>::erase(const_iterator position)
     {
         // We need to provide this version because we override another version 
         // and C++ hiding rules would make the base version of this hidden.
@@ -128,9 +129,9 @@ namespace easy
     }
 
 
-    template <typename Key, typename Compare>
-    inline typename set<Key, Compare>::iterator
-        set<Key, Compare>::erase(const_iterator first, const_iterator last)
+    template <typename Key, typename Compare, typename Allocator>
+    inline typename set<Key, Compare, Allocator>::iterator
+        set<Key, Compare, Allocator>::erase(const_iterator first, const_iterator last)
     {
         // We need to provide this version because we override another version 
         // and C++ hiding rules would make the base version of this hidden.
@@ -138,24 +139,34 @@ namespace easy
     }
 
 
-    template <typename Key, typename Compare>
-    inline typename set<Key, Compare>::size_type
-        set<Key, Compare>::count(const Key& k) const
+    template <typename Key, typename Compare, typename Allocator>
+    inline typename set<Key, Compare, Allocator>::size_type
+        set<Key, Compare, Allocator>::count(const Key& k) const
     {
         const const_iterator it(find(k));
         return (it != end()) ? (size_type)1 : (size_type)0;
     }
 
 
-    template <typename Key, typename Compare>
-    inline easy::pair<typename set<Key, Compare>::iterator,
-        typename set<Key, Compare>::iterator>
-        set<Key, Compare>::equal_range(const Key& k)
+    template <typename Key, typename Compare, typename Allocator>
+    inline easy::pair<typename set<Key, Compare, Allocator>::iterator,
+        typename set<Key, Compare, Allocator>::iterator>
+        set<Key, Compare, Allocator>::equal_range(const Key& k)
     {
         // The resulting range will either be empty or have one element,
         // so instead of doing two tree searches (one for lower_bound and 
         // one for upper_bound), we do just lower_bound and see if the 
-        // result is a range of size zero or one.
+        // result is a range of size zero or one. A three-way Compare
+        // finds the range in one descent that stops at an equal key.
+        if (rbtree_three_way<Compare>::kEnabled)
+        {
+            node_type* pLower;
+            node_type* pUpper;
+
+            base_type::DoGetEqualRange(k, pLower, pUpper);
+            return easy::pair<iterator, iterator>(iterator(pLower), iterator(pUpper));
+        }
+
         const iterator itLower(lower_bound(k));
 
         if ((itLower == end()) || mCompare(k, *itLower)) // If at the end or if (k is < itLower)...
@@ -166,12 +177,18 @@ namespace easy
     }
 
 
-    template <typename Key, typename Compare>
-    inline easy::pair<typename set<Key, Compare>::const_iterator,
-        typename set<Key, Compare>::const_iterator>
-        set<Key, Compare>::equal_range(const Key& k) const
+    template <typename Key, typename Compare, typename Allocator>
+    inline easy::pair<typename set<Key, Compare, Allocator>::const_iterator,
+        typename set<Key, Compare, Allocator>::const_iterator>
+        set<Key, Compare, Allocator>::equal_range(const Key& k) const
     {
         // See equal_range above for comments.
+        if (rbtree_three_way<Compare>::kEnabled)
+        {
+            const easy::pair<iterator, iterator> range(const_cast<this_type*>(this)->equal_range(k));
+            return easy::pair<const_iterator, const_iterator>(range.first, range.second);
+        }
+
         const const_iterator itLower(lower_bound(k));
 
         if ((itLower == end()) || mCompare(k, *itLower)) // If at the end or if (k is < itLower)...
@@ -181,6 +198,176 @@ namespace easy
         return easy::pair<const_iterator, const_iterator>(itLower, ++itUpper);
     }
 
+    /// multiset
+    ///
+    /// Implements a canonical multiset.
+    ///
+    /// The large majority of the implementation of this class is found in the rbtree
+    /// base class. We control the behaviour of rbtree via template parameters.
+    ///
+    /// See notes above in 'set' regarding mutable iterators. As with multimap, count
+    /// is O(log n) however many elements are equal.
+    ///
+    template <typename Key, typename Compare = easy::less<Key>, typename Allocator = easy::allocator>
+    class multiset
+        : public rbtree<Key, Key, Compare, easy::use_self<Key>, false, false, Allocator>
+    {
+    public:
+        typedef rbtree<Key, Key, Compare, easy::use_self<Key>, false, false, Allocator> base_type;
+        typedef multiset<Key, Compare, Allocator>                                       this_type;
+        typedef typename base_type::size_type                                           size_type;
+        typedef typename base_type::value_type                                          value_type;
+        typedef typename base_type::node_type                                           node_type;
+        typedef typename base_type::iterator                                            iterator;
+        typedef typename base_type::const_iterator                                      const_iterator;
+        typedef Compare                                                                 value_compare;
+        // Other types are inherited from the base class.
+
+        using base_type::begin;
+        using base_type::end;
+        using base_type::find;
+        using base_type::lower_bound;
+        using base_type::upper_bound;
+        using base_type::mCompare;
+
+    public:
+        multiset();
+        multiset(const Compare& compare);
+        multiset(const this_type& x);
+
+        template <typename Iterator>
+        multiset(Iterator itBegin, Iterator itEnd);
+
+    public:
+        value_compare value_comp() const;
+
+        /// Inserts a range that is sorted according to Compare. See multimap::insert_equal_sorted.
+        template <typename Iterator>
+        void insert_equal_sorted(Iterator itBegin, Iterator itEnd);
+
+        size_type erase(const Key& k);
+        iterator  erase(const_iterator position);
+        iterator  erase(const_iterator first, const_iterator last);
+
+        size_type count(const Key& k) const;
+
+        easy::pair<iterator, iterator>             equal_range(const Key& k);
+        easy::pair<const_iterator, const_iterator> equal_range(const Key& k) const;
+
+    }; // multiset
+
+
+       ///////////////////////////////////////////////////////////////////////
+       // multiset
+       ///////////////////////////////////////////////////////////////////////
+
+    template <typename Key, typename Compare, typename Allocator>
+    inline multiset<Key, Compare, Allocator>::multiset()
+        : base_type()
+    {
+    }
+
+
+    template <typename Key, typename Compare, typename Allocator>
+    inline multiset<Key, Compare, Allocator>::multiset(const Compare& compare)
+        : base_type(compare)
+    {
+    }
+
+
+    template <typename Key, typename Compare, typename Allocator>
+    inline multiset<Key, Compare, Allocator>::multiset(const this_type& x)
+        : base_type(x)
+    {
+    }
+
+
+    template <typename Key, typename Compare, typename Allocator>
+    template <typename Iterator>
+    inline multiset<Key, Compare, Allocator>::multiset(Iterator itBegin, Iterator itEnd)
+        : base_type(itBegin, itEnd, Compare())
+    {
+    }
+
+
+    template <typename Key, typename Compare, typename Allocator>
+    inline typename multiset<Key, Compare, Allocator>::value_compare
+        multiset<Key, Compare, Allocator>::value_comp() const
+    {
+        return mCompare;
+    }
+
+
+    template <typename Key, typename Compare, typename Allocator>
+    template <typename Iterator>
+    inline void multiset<Key, Compare, Allocator>::insert_equal_sorted(Iterator itBegin, Iterator itEnd)
+    {
+        base_type::append_sorted(itBegin, itEnd);
+    }
+
+
+    template <typename Key, typename Compare, typename Allocator>
+    inline typename multiset<Key, Compare, Allocator>::size_type
+        multiset<Key, Compare, Allocator>::erase(const Key& k)
+    {
+        const easy::pair<iterator, iterator> range(equal_range(k));
+        const size_type n = base_type::size();
+
+        base_type::erase(range.first, range.second);
+        return n - base_type::size();
+    }
+
+
+    template <typename Key, typename Compare, typename Allocator>
+    inline typename multiset<Key, Compare, Allocator>::iterator
+        multiset<Key, Compare, Allocator>::erase(const_iterator position)
+    {
+        // We need to provide this version because we override another version 
+        // and C++ hiding rules would make the base version of this hidden.
+        return base_type::erase(position);
+    }
+
+
+    template <typename Key, typename Compare, typename Allocator>
+    inline typename multiset<Key, Compare, Allocator>::iterator
+        multiset<Key, Compare, Allocator>::erase(const_iterator first, const_iterator last)
+    {
+        // We need to provide this version because we override another version 
+        // and C++ hiding rules would make the base version of this hidden.
+        return base_type::erase(first, last);
+    }
+
+
+    template <typename Key, typename Compare, typename Allocator>
+    inline typename multiset<Key, Compare, Allocator>::size_type
+        multiset<Key, Compare, Allocator>::count(const Key& k) const
+    {
+        return base_type::DoCountKey(k);
+    }
+
+
+    template <typename Key, typename Compare, typename Allocator>
+    inline easy::pair<typename multiset<Key, Compare, Allocator>::iterator,
+        typename multiset<Key, Compare, Allocator>::iterator>
+        multiset<Key, Compare, Allocator>::equal_range(const Key& k)
+    {
+        node_type* pLower;
+        node_type* pUpper;
+
+        base_type::DoGetEqualRange(k, pLower, pUpper);
+        return easy::pair<iterator, iterator>(iterator(pLower), iterator(pUpper));
+    }
+
+
+    template <typename Key, typename Compare, typename Allocator>
+    inline easy::pair<typename multiset<Key, Compare, Allocator>::const_iterator,
+        typename multiset<Key, Compare, Allocator>::const_iterator>
+        multiset<Key, Compare, Allocator>::equal_range(const Key& k) const
+    {
+        const easy::pair<iterator, iterator> range(const_cast<this_type*>(this)->equal_range(k));
+        return easy::pair<const_iterator, const_iterator>(range.first, range.second);
+    }
+
 } // namespace 
 
 #endif // Header include guard
@@ -0,0 +1,742 @@
+#ifndef __EASY_SMALL_MAP_H__
+#define __EASY_SMALL_MAP_H__
+
+/**
+ * 元素较少时存放在对象内有序数组中的easy::map, 超过容量后转为红黑树
+ */
+
+#include <stddef.h>
+#include <new>
+#include <utility>
+#include "Map.h"
+
+namespace easy
+{
+    /// small_map_iterator
+    ///
+    /// Points either into the inline array of a small_map (mpValue != NULL) or
+    /// into its tree (mpValue == NULL), and steps accordingly.
+    ///
+    template <typename T, typename Pointer, typename Reference>
+    struct small_map_iterator
+    {
+        typedef small_map_iterator<T, Pointer, Reference>   this_type;
+        typedef small_map_iterator<T, T*, T&>               iterator;
+        typedef small_map_iterator<T, const T*, const T&>   const_iterator;
+        typedef rbtree_iterator<T, Pointer, Reference>      tree_iterator;
+        typedef unsigned int                                size_type;
+        typedef int                                         difference_type;
+        typedef T                                           value_type;
+        typedef Pointer                                     pointer;
+        typedef Reference                                   reference;
+
+    public:
+        T*            mpValue;
+        tree_iterator mTreeIterator;
+
+    public:
+        small_map_iterator() : mpValue(NULL), mTreeIterator() {}
+        explicit small_map_iterator(T* pValue) : mpValue(pValue), mTreeIterator() {}
+        explicit small_map_iterator(const tree_iterator& x) : mpValue(NULL), mTreeIterator(x) {}
+        small_map_iterator(const iterator& x) : mpValue(x.mpValue), mTreeIterator(x.mTreeIterator) {}
+
+        reference operator*() const { return mpValue ? *mpValue : *mTreeIterator; }
+        pointer   operator->() const { return mpValue ? mpValue : mTreeIterator.operator->(); }
+
+        this_type& operator++()
+        {
+            if (mpValue)
+                ++mpValue;
+            else
+                ++mTreeIterator;
+            return *this;
+        }
+
+        this_type operator++(int)
+        {
+            this_type temp(*this);
+            ++*this;
+            return temp;
+        }
+
+        this_type& operator--()
+        {
+            if (mpValue)
+                --mpValue;
+            else
+                --mTreeIterator;
+            return *this;
+        }
+
+        this_type operator--(int)
+        {
+            this_type temp(*this);
+            --*this;
+            return temp;
+        }
+    }; // small_map_iterator
+
+
+    template <typename T, typename PointerA, typename ReferenceA, typename PointerB, typename ReferenceB>
+    inline bool operator==(const small_map_iterator<T, PointerA, ReferenceA>& a,
+                           const small_map_iterator<T, PointerB, ReferenceB>& b)
+    {
+        return (a.mpValue == b.mpValue) && (a.mTreeIterator.mpNode == b.mTreeIterator.mpNode);
+    }
+
+    template <typename T, typename PointerA, typename ReferenceA, typename PointerB, typename ReferenceB>
+    inline bool operator!=(const small_map_iterator<T, PointerA, ReferenceA>& a,
+                           const small_map_iterator<T, PointerB, ReferenceB>& b)
+    {
+        return (a.mpValue != b.mpValue) || (a.mTreeIterator.mpNode != b.mTreeIterator.mpNode);
+    }
+
+
+
+    /// small_map
+    ///
+    /// A map which keeps up to N elements sorted in an array inside the object, and
+    /// only moves them into an easy::map when an insertion would make that N + 1.
+    /// Small maps thus cost no heap allocation at all, and a lookup is a scan of one
+    /// contiguous array. Once it has been promoted, the map goes back to the array when
+    /// erasing brings it down to N / 2 elements; the gap keeps a map which hovers
+    /// around N elements from moving back and forth on every insert and erase.
+    ///
+    /// The interface is that of easy::map. In tree mode iterators behave as they do for
+    /// easy::map. In array mode, as for a vector, an insert or erase invalidates the
+    /// iterators to the elements after the position where it happened, and a switch
+    /// between the two modes invalidates all of them.
+    ///
+    /// Example usage:
+    ///     easy::small_map<int, int, 8> attributes;
+    ///     attributes.insert(easy::make_pair(1, 2)); // No allocation up to 8 elements.
+    ///
+    template <typename Key, typename T, size_t N, typename Compare = easy::less<Key> >
+    class small_map
+    {
+    public:
+        typedef small_map<Key, T, N, Compare>                                               this_type;
+        typedef map<Key, T, Compare>                                                        map_type;
+        typedef Key                                                                         key_type;
+        typedef T                                                                           mapped_type;
+        typedef easy::pair<Key, T>                                                          value_type;
+        typedef size_t                                                                      size_type;
+        typedef ptrdiff_t                                                                   difference_type;
+        typedef value_type&                                                                 reference;
+        typedef const value_type&                                                           const_reference;
+        typedef small_map_iterator<value_type, value_type*, value_type&>                    iterator;
+        typedef small_map_iterator<value_type, const value_type*, const value_type&>        const_iterator;
+        typedef easy::pair<iterator, bool>                                                  insert_return_type;
+        typedef Compare                                                                     key_compare;
+
+        static const size_type kInlineSize = N;
+        static const size_type kDemoteSize = N / 2;     // Size at which a promoted map moves back into the array.
+        static const size_type kLinearSearchSize = 16;  // Arrays up to this size are searched linearly.
+
+        static_assert(N > 0, "small_map: N must be at least 1");
+
+    public:
+        small_map();
+        small_map(const Compare& compare);
+        small_map(const this_type& x);
+
+        template <typename Iterator>
+        small_map(Iterator itBegin, Iterator itEnd);
+
+        ~small_map();
+
+        this_type& operator=(const this_type& x);
+        void       swap(this_type& x);
+
+        const key_compare& key_comp() const { return mMap.key_comp(); }
+
+    public:
+        iterator       begin();
+        const_iterator begin() const;
+        const_iterator cbegin() const { return begin(); }
+
+        iterator       end();
+        const_iterator end() const;
+        const_iterator cend() const { return end(); }
+
+        bool      empty() const { return size() == 0; }
+        size_type size() const { return mbInline ? mnInlineSize : mMap.size(); }
+
+        /// Returns true while the elements are held in the inline array.
+        bool is_inline() const { return mbInline; }
+
+        insert_return_type insert(const value_type& value);
+        iterator           insert(const_iterator position, const value_type& value);
+
+        template <typename InputIterator>
+        void insert(InputIterator first, InputIterator last);
+
+        iterator  erase(const_iterator position);
+        iterator  erase(const_iterator first, const_iterator last);
+        size_type erase(const key_type& key);
+
+        void clear();
+
+        iterator       find(const key_type& key);
+        const_iterator find(const key_type& key) const;
+
+        size_type count(const key_type& key) const;
+
+        iterator       lower_bound(const key_type& key);
+        const_iterator lower_bound(const key_type& key) const;
+
+        iterator       upper_bound(const key_type& key);
+        const_iterator upper_bound(const key_type& key) const;
+
+        easy::pair<iterator, iterator>             equal_range(const key_type& key);
+        easy::pair<const_iterator, const_iterator> equal_range(const key_type& key) const;
+
+        /// Traversal functions, as for easy::map.
+        template <typename Function>
+        void for_each(Function f);
+        template <typename Function>
+        void for_each(Function f) const;
+
+        template <typename Function>
+        void for_each_range(const key_type& lo, const key_type& hi, Function f);
+        template <typename Function>
+        void for_each_range(const key_type& lo, const key_type& hi, Function f) const;
+
+    protected:
+        value_type*       DoGetArray() { return reinterpret_cast<value_type*>(mBuffer); }
+        const value_type* DoGetArray() const { return reinterpret_cast<const value_type*>(mBuffer); }
+
+        size_type DoInlineLowerBound(const key_type& key) const;
+        size_type DoInlineUpperBound(const key_type& key) const;
+        size_type DoInlineFind(const key_type& key) const;
+
+        void DoInlineInsert(size_type nIndex, const value_type& value);
+        void DoInlineErase(size_type nFirst, size_type nLast);
+        void DoInlineClear();
+        void DoCopyInline(const this_type& x);
+
+        void     DoPromote();
+        iterator DoDemoteIfSmall(typename map_type::iterator itNext);
+
+    protected:
+        map_type                   mMap;                                // Holds the elements in tree mode, and the comparison in both.
+        alignas(value_type) char   mBuffer[sizeof(value_type) * N];     // Holds the elements in array mode.
+        size_type                  mnInlineSize;
+        bool                       mbInline;
+    }; // small_map
+
+
+
+
+    ///////////////////////////////////////////////////////////////////////
+    // small_map
+    ///////////////////////////////////////////////////////////////////////
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline small_map<Key, T, N, Compare>::small_map()
+        : mMap(),
+        mnInlineSize(0),
+        mbInline(true)
+    {
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline small_map<Key, T, N, Compare>::small_map(const Compare& compare)
+        : mMap(compare),
+        mnInlineSize(0),
+        mbInline(true)
+    {
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline small_map<Key, T, N, Compare>::small_map(const this_type& x)
+        : mMap(x.mMap),
+        mnInlineSize(0),
+        mbInline(x.mbInline)
+    {
+        if (mbInline)
+            DoCopyInline(x);
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    template <typename Iterator>
+    inline small_map<Key, T, N, Compare>::small_map(Iterator itBegin, Iterator itEnd)
+        : mMap(),
+        mnInlineSize(0),
+        mbInline(true)
+    {
+        insert(itBegin, itEnd);
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline small_map<Key, T, N, Compare>::~small_map()
+    {
+        DoInlineClear();
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline typename small_map<Key, T, N, Compare>::this_type&
+        small_map<Key, T, N, Compare>::operator=(const this_type& x)
+    {
+        if (this != &x)
+        {
+            DoInlineClear();
+            mMap = x.mMap; // Empty unless x is in tree mode; either way this copies the comparison.
+            mbInline = x.mbInline;
+
+            if (mbInline)
+                DoCopyInline(x);
+        }
+        return *this;
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline void small_map<Key, T, N, Compare>::swap(this_type& x)
+    {
+        if (!mbInline && !x.mbInline)
+            mMap.swap(x.mMap);
+        else
+        {
+            const this_type temp(*this);
+            *this = x;
+            x = temp;
+        }
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline typename small_map<Key, T, N, Compare>::iterator
+        small_map<Key, T, N, Compare>::begin()
+    {
+        return mbInline ? iterator(DoGetArray()) : iterator(mMap.begin());
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline typename small_map<Key, T, N, Compare>::const_iterator
+        small_map<Key, T, N, Compare>::begin() const
+    {
+        return const_cast<this_type*>(this)->begin();
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline typename small_map<Key, T, N, Compare>::iterator
+        small_map<Key, T, N, Compare>::end()
+    {
+        return mbInline ? iterator(DoGetArray() + mnInlineSize) : iterator(mMap.end());
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline typename small_map<Key, T, N, Compare>::const_iterator
+        small_map<Key, T, N, Compare>::end() const
+    {
+        return const_cast<this_type*>(this)->end();
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    typename small_map<Key, T, N, Compare>::insert_return_type
+        small_map<Key, T, N, Compare>::insert(const value_type& value)
+    {
+        if (mbInline)
+        {
+            const size_type i = DoInlineLowerBound(value.first);
+            value_type* const pArray = DoGetArray();
+
+            if ((i < mnInlineSize) && !mMap.key_comp()(value.first, pArray[i].first))
+                return insert_return_type(iterator(pArray + i), false);
+
+            if (mnInlineSize < N)
+            {
+                DoInlineInsert(i, value);
+                return insert_return_type(iterator(pArray + i), true);
+            }
+
+            DoPromote();
+        }
+
+        const typename map_type::insert_return_type result(mMap.insert(value));
+        return insert_return_type(iterator(result.first), result.second);
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline typename small_map<Key, T, N, Compare>::iterator
+        small_map<Key, T, N, Compare>::insert(const_iterator /*position*/, const value_type& value)
+    {
+        return insert(value).first;
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    template <typename InputIterator>
+    inline void small_map<Key, T, N, Compare>::insert(InputIterator first, InputIterator last)
+    {
+        for (; first != last; ++first)
+            insert(*first);
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    typename small_map<Key, T, N, Compare>::iterator
+        small_map<Key, T, N, Compare>::erase(const_iterator position)
+    {
+        if (mbInline)
+        {
+            const size_type i = (size_type)(position.mpValue - DoGetArray());
+            DoInlineErase(i, i + 1);
+            return iterator(DoGetArray() + i);
+        }
+
+        return DoDemoteIfSmall(mMap.erase(position.mTreeIterator));
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    typename small_map<Key, T, N, Compare>::iterator
+        small_map<Key, T, N, Compare>::erase(const_iterator first, const_iterator last)
+    {
+        if (mbInline)
+        {
+            const size_type i = (size_type)(first.mpValue - DoGetArray());
+            DoInlineErase(i, (size_type)(last.mpValue - DoGetArray()));
+            return iterator(DoGetArray() + i);
+        }
+
+        return DoDemoteIfSmall(mMap.erase(first.mTreeIterator, last.mTreeIterator));
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    typename small_map<Key, T, N, Compare>::size_type
+        small_map<Key, T, N, Compare>::erase(const key_type& key)
+    {
+        const iterator it(find(key));
+
+        if (it == end())
+            return 0;
+
+        erase(it);
+        return 1;
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline void small_map<Key, T, N, Compare>::clear()
+    {
+        DoInlineClear();
+        mMap.clear();
+        mbInline = true;
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline typename small_map<Key, T, N, Compare>::iterator
+        small_map<Key, T, N, Compare>::find(const key_type& key)
+    {
+        if (mbInline)
+            return iterator(DoGetArray() + DoInlineFind(key));
+        return iterator(mMap.find(key));
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline typename small_map<Key, T, N, Compare>::const_iterator
+        small_map<Key, T, N, Compare>::find(const key_type& key) const
+    {
+        return const_cast<this_type*>(this)->find(key);
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline typename small_map<Key, T, N, Compare>::size_type
+        small_map<Key, T, N, Compare>::count(const key_type& key) const
+    {
+        if (mbInline)
+            return (DoInlineFind(key) != mnInlineSize) ? 1 : 0;
+        return mMap.count(key);
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline typename small_map<Key, T, N, Compare>::iterator
+        small_map<Key, T, N, Compare>::lower_bound(const key_type& key)
+    {
+        if (mbInline)
+            return iterator(DoGetArray() + DoInlineLowerBound(key));
+        return iterator(mMap.lower_bound(key));
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline typename small_map<Key, T, N, Compare>::const_iterator
+        small_map<Key, T, N, Compare>::lower_bound(const key_type& key) const
+    {
+        return const_cast<this_type*>(this)->lower_bound(key);
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline typename small_map<Key, T, N, Compare>::iterator
+        small_map<Key, T, N, Compare>::upper_bound(const key_type& key)
+    {
+        if (mbInline)
+            return iterator(DoGetArray() + DoInlineUpperBound(key));
+        return iterator(mMap.upper_bound(key));
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline typename small_map<Key, T, N, Compare>::const_iterator
+        small_map<Key, T, N, Compare>::upper_bound(const key_type& key) const
+    {
+        return const_cast<this_type*>(this)->upper_bound(key);
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline easy::pair<typename small_map<Key, T, N, Compare>::iterator,
+                      typename small_map<Key, T, N, Compare>::iterator>
+        small_map<Key, T, N, Compare>::equal_range(const key_type& key)
+    {
+        const iterator itLower(find(key));
+
+        if (itLower == end())
+            return easy::pair<iterator, iterator>(itLower, itLower);
+
+        iterator itUpper(itLower);
+        return easy::pair<iterator, iterator>(itLower, ++itUpper);
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline easy::pair<typename small_map<Key, T, N, Compare>::const_iterator,
+                      typename small_map<Key, T, N, Compare>::const_iterator>
+        small_map<Key, T, N, Compare>::equal_range(const key_type& key) const
+    {
+        const easy::pair<iterator, iterator> range(const_cast<this_type*>(this)->equal_range(key));
+        return easy::pair<const_iterator, const_iterator>(const_iterator(range.first), const_iterator(range.second));
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    template <typename Function>
+    inline void small_map<Key, T, N, Compare>::for_each(Function f)
+    {
+        if (mbInline)
+        {
+            value_type* const pArray = DoGetArray();
+            for (size_type i = 0; i < mnInlineSize; ++i)
+                f(pArray[i]);
+        } else
+            mMap.for_each(f);
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    template <typename Function>
+    inline void small_map<Key, T, N, Compare>::for_each(Function f) const
+    {
+        if (mbInline)
+        {
+            const value_type* const pArray = DoGetArray();
+            for (size_type i = 0; i < mnInlineSize; ++i)
+                f(pArray[i]);
+        } else
+            mMap.for_each(f);
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    template <typename Function>
+    inline void small_map<Key, T, N, Compare>::for_each_range(const key_type& lo, const key_type& hi, Function f)
+    {
+        if (mbInline)
+        {
+            value_type* const pArray = DoGetArray();
+            for (size_type i = DoInlineLowerBound(lo); (i < mnInlineSize) && mMap.key_comp()(pArray[i].first, hi); ++i)
+                f(pArray[i]);
+        } else
+            mMap.for_each_range(lo, hi, f);
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    template <typename Function>
+    inline void small_map<Key, T, N, Compare>::for_each_range(const key_type& lo, const key_type& hi, Function f) const
+    {
+        if (mbInline)
+        {
+            const value_type* const pArray = DoGetArray();
+            for (size_type i = DoInlineLowerBound(lo); (i < mnInlineSize) && mMap.key_comp()(pArray[i].first, hi); ++i)
+                f(pArray[i]);
+        } else
+            mMap.for_each_range(lo, hi, f);
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    typename small_map<Key, T, N, Compare>::size_type
+        small_map<Key, T, N, Compare>::DoInlineLowerBound(const key_type& key) const
+    {
+        const value_type* const pArray = DoGetArray();
+        const Compare&          compare = mMap.key_comp();
+
+        if (N <= kLinearSearchSize) // Known at compile time. A short scan beats the unpredictable branches of a binary search.
+        {
+            size_type i = 0;
+            while ((i < mnInlineSize) && compare(pArray[i].first, key))
+                ++i;
+            return i;
+        }
+
+        size_type nLo = 0, nCount = mnInlineSize;
+
+        while (nCount > 0)
+        {
+            const size_type nHalf = nCount / 2;
+
+            if (compare(pArray[nLo + nHalf].first, key))
+            {
+                nLo += nHalf + 1;
+                nCount -= nHalf + 1;
+            } else
+                nCount = nHalf;
+        }
+        return nLo;
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline typename small_map<Key, T, N, Compare>::size_type
+        small_map<Key, T, N, Compare>::DoInlineUpperBound(const key_type& key) const
+    {
+        const size_type i = DoInlineLowerBound(key);
+
+        if ((i < mnInlineSize) && !mMap.key_comp()(key, DoGetArray()[i].first))
+            return i + 1; // Keys are unique, so the upper bound of a present key is the next element.
+        return i;
+    }
+
+
+    // Returns the index of the element with the given key, or mnInlineSize if there is none.
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline typename small_map<Key, T, N, Compare>::size_type
+        small_map<Key, T, N, Compare>::DoInlineFind(const key_type& key) const
+    {
+        const size_type i = DoInlineLowerBound(key);
+
+        if ((i < mnInlineSize) && !mMap.key_comp()(key, DoGetArray()[i].first))
+            return i;
+        return mnInlineSize;
+    }
+
+
+    // Inserts value at nIndex, moving the elements from there on up by one. There must be room.
+    template <typename Key, typename T, size_t N, typename Compare>
+    void small_map<Key, T, N, Compare>::DoInlineInsert(size_type nIndex, const value_type& value)
+    {
+        value_type* const pArray = DoGetArray();
+
+        Internal::RelocateValues(pArray + nIndex + 1, pArray + nIndex, mnInlineSize - nIndex);
+        ::new(pArray + nIndex) value_type(value);
+        ++mnInlineSize;
+    }
+
+
+    // Removes the elements in [nFirst, nLast), moving the ones after them down.
+    template <typename Key, typename T, size_t N, typename Compare>
+    void small_map<Key, T, N, Compare>::DoInlineErase(size_type nFirst, size_type nLast)
+    {
+        value_type* const pArray = DoGetArray();
+
+        for (size_type i = nFirst; i < nLast; ++i)
+            pArray[i].~value_type();
+
+        Internal::RelocateValues(pArray + nFirst, pArray + nLast, mnInlineSize - nLast);
+        mnInlineSize -= nLast - nFirst;
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline void small_map<Key, T, N, Compare>::DoInlineClear()
+    {
+        value_type* const pArray = DoGetArray();
+
+        for (size_type i = 0; i < mnInlineSize; ++i)
+            pArray[i].~value_type();
+
+        mnInlineSize = 0;
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline void small_map<Key, T, N, Compare>::DoCopyInline(const this_type& x)
+    {
+        const value_type* const pSource = x.DoGetArray();
+        value_type* const       pArray = DoGetArray();
+
+        for (; mnInlineSize < x.mnInlineSize; ++mnInlineSize)
+            ::new(pArray + mnInlineSize) value_type(pSource[mnInlineSize]);
+    }
+
+
+    // Moves the elements from the full array into the tree. They are already sorted,
+    // so they take the append fast path of the tree.
+    template <typename Key, typename T, size_t N, typename Compare>
+    void small_map<Key, T, N, Compare>::DoPromote()
+    {
+        value_type* const pArray = DoGetArray();
+
+        mMap.append_sorted(pArray, pArray + mnInlineSize);
+        DoInlineClear();
+        mbInline = false;
+    }
+
+
+    // Called after an erase in tree mode with the iterator which follows the erased
+    // elements. Moves the elements back into the array if few enough are left, and
+    // returns the position of that same element.
+    template <typename Key, typename T, size_t N, typename Compare>
+    typename small_map<Key, T, N, Compare>::iterator
+        small_map<Key, T, N, Compare>::DoDemoteIfSmall(typename map_type::iterator itNext)
+    {
+        if (mMap.size() > kDemoteSize)
+            return iterator(itNext);
+
+        value_type* const pArray = DoGetArray();
+        size_type         nNext = 0;
+
+        for (typename map_type::iterator it = mMap.begin(); it != mMap.end(); ++it, ++mnInlineSize)
+        {
+            if (it == itNext)
+                nNext = mnInlineSize;
+            ::new(pArray + mnInlineSize) value_type(std::move(*it)); // The tree is cleared below.
+        }
+
+        if (itNext == mMap.end())
+            nNext = mnInlineSize;
+
+        mMap.clear();
+        mbInline = true;
+        return iterator(pArray + nNext);
+    }
+
+
+    template <typename Key, typename T, size_t N, typename Compare>
+    inline void swap(small_map<Key, T, N, Compare>& a, small_map<Key, T, N, Compare>& b)
+    {
+        a.swap(b);
+    }
+
+} // namespace easy
+
+#endif // __EASY_SMALL_MAP_H__
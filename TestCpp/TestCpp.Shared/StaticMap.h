@@ -0,0 +1,464 @@
+#ifndef __EASY_STATIC_MAP_H__
+#define __EASY_STATIC_MAP_H__
+
+/**
+ * 编译期排序和校验的只读查找表, 接口与easy::map一致
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "RbTree.h"
+
+namespace easy
+{
+    /// static_map_value
+    ///
+    /// The element type of static_map. easy::pair's constructors aren't constexpr,
+    /// and its forwarding ones can't be in C++11, where std::forward isn't, so a
+    /// pair can't be built in a constant expression; this is an aggregate with the
+    /// same first/second members instead.
+    ///
+    template <typename Key, typename T>
+    struct static_map_value
+    {
+        typedef Key first_type;
+        typedef T   second_type;
+
+        Key first;
+        T   second;
+    };
+
+
+    /// static_less
+    ///
+    /// The default comparison of static_map: a constexpr version of easy::less.
+    /// C strings are compared by content, so tables can be keyed by string literals.
+    ///
+    template <typename T>
+    struct static_less : public binary_function<T, T, bool>
+    {
+        constexpr bool operator()(const T& a, const T& b) const
+        {
+            return a < b;
+        }
+    };
+
+
+    /// static_hash
+    ///
+    /// The default hash of static_hash_map. Integers and enums hash to their own
+    /// value; C strings use 64 bit FNV-1a. static_hash_map mixes the result with
+    /// a seed before use, so the hash doesn't need to be well distributed.
+    ///
+    template <typename T>
+    struct static_hash
+    {
+        constexpr uint64_t operator()(const T& x) const
+        {
+            return static_cast<uint64_t>(x);
+        }
+    };
+
+
+    namespace Internal
+    {
+        // Called only if a static_map is given two equivalent keys. Not being constexpr, it
+        // turns that into a compile error which names it when the map is declared constexpr.
+        inline size_t static_map_duplicate_key()
+        {
+            abort();
+            return 0;
+        }
+
+        // Likewise for a static_hash_map for which no perfect hash was found.
+        inline uint64_t static_map_no_perfect_hash()
+        {
+            abort();
+            return 0;
+        }
+
+        constexpr bool StaticStringLess(const char* a, const char* b)
+        {
+            return (*a != *b) ? ((unsigned char)*a < (unsigned char)*b)
+                              : ((*a != 0) && StaticStringLess(a + 1, b + 1));
+        }
+
+        constexpr uint64_t StaticStringHash(const char* s, uint64_t h)
+        {
+            return *s ? StaticStringHash(s + 1, (h ^ (unsigned char)*s) * UINT64_C(0x100000001b3)) : h;
+        }
+
+
+        // C++11 has no std::index_sequence. This builds one in O(log n) instantiation depth.
+        template <size_t... I>
+        struct static_index_sequence { };
+
+        template <typename S1, typename S2>
+        struct static_index_concat;
+
+        template <size_t... I1, size_t... I2>
+        struct static_index_concat<static_index_sequence<I1...>, static_index_sequence<I2...> >
+        {
+            typedef static_index_sequence<I1..., (sizeof...(I1) + I2)...> type;
+        };
+
+        template <size_t N>
+        struct make_static_index_sequence
+        {
+            typedef typename static_index_concat<typename make_static_index_sequence<N / 2>::type,
+                                                 typename make_static_index_sequence<N - N / 2>::type>::type type;
+        };
+
+        template <>
+        struct make_static_index_sequence<0> { typedef static_index_sequence<> type; };
+
+        template <>
+        struct make_static_index_sequence<1> { typedef static_index_sequence<0> type; };
+
+
+        // Constexpr functions in C++11 are a single return statement, so everything below
+        // recurses instead of looping. Scans over the elements split the range in halves,
+        // which keeps the recursion depth logarithmic in the table size.
+
+        template <size_t N>
+        struct static_rank_table
+        {
+            size_t mRanks[N];
+        };
+
+        // Returns the number of elements in [nLo, nHi) whose key is less than that of element j.
+        template <typename Compare, typename Value>
+        constexpr size_t StaticRank(const Value* pValues, size_t j, size_t nLo, size_t nHi)
+        {
+            return ((nHi - nLo) == 1) ? (Compare()(pValues[nLo].first, pValues[j].first) ? 1 : 0)
+                                      : (StaticRank<Compare>(pValues, j, nLo, nLo + (nHi - nLo) / 2) +
+                                         StaticRank<Compare>(pValues, j, nLo + (nHi - nLo) / 2, nHi));
+        }
+
+        template <typename Compare, typename Value, size_t N, size_t... I>
+        constexpr static_rank_table<N> StaticRanks(const Value* pValues, static_index_sequence<I...>)
+        {
+            return static_rank_table<N>{ { StaticRank<Compare>(pValues, I, 0, N)... } };
+        }
+
+        constexpr size_t StaticFirstFound(size_t a, size_t b, size_t nNotFound)
+        {
+            return (a != nNotFound) ? a : b;
+        }
+
+        // Returns the index in [nLo, nHi) of the element of the given rank, or nNotFound.
+        constexpr size_t StaticFindRank(const size_t* pRanks, size_t nRank, size_t nLo, size_t nHi, size_t nNotFound)
+        {
+            return ((nHi - nLo) == 1) ? ((pRanks[nLo] == nRank) ? nLo : nNotFound)
+                                      : StaticFirstFound(StaticFindRank(pRanks, nRank, nLo, nLo + (nHi - nLo) / 2, nNotFound),
+                                                         StaticFindRank(pRanks, nRank, nLo + (nHi - nLo) / 2, nHi, nNotFound), nNotFound);
+        }
+
+        // Returns the index of the element which goes to position nRank of the sorted table.
+        // Equivalent keys have the same rank, which leaves some rank with no element.
+        constexpr size_t StaticCheckFound(size_t j, size_t n)
+        {
+            return (j != n) ? j : static_map_duplicate_key();
+        }
+
+        constexpr size_t StaticSelect(const size_t* pRanks, size_t nRank, size_t n)
+        {
+            return StaticCheckFound(StaticFindRank(pRanks, nRank, 0, n, n), n);
+        }
+
+        template <typename Compare, typename Value>
+        constexpr const Value* StaticLowerBound(const Value* pFirst, size_t n, const typename Value::first_type& key)
+        {
+            return (n == 0) ? pFirst
+                            : Compare()(pFirst[n / 2].first, key) ? StaticLowerBound<Compare>(pFirst + (n / 2) + 1, n - (n / 2) - 1, key)
+                                                                   : StaticLowerBound<Compare>(pFirst, n / 2, key);
+        }
+
+        template <typename Compare, typename Value>
+        constexpr const Value* StaticUpperBound(const Value* pFirst, size_t n, const typename Value::first_type& key)
+        {
+            return (n == 0) ? pFirst
+                            : Compare()(key, pFirst[n / 2].first) ? StaticUpperBound<Compare>(pFirst, n / 2, key)
+                                                                   : StaticUpperBound<Compare>(pFirst + (n / 2) + 1, n - (n / 2) - 1, key);
+        }
+
+
+        template <size_t N>
+        struct static_hash_table
+        {
+            uint64_t mHashes[N];
+        };
+
+        template <typename Hash, typename Value, size_t N, size_t... I>
+        constexpr static_hash_table<N> StaticHashes(const Value* pValues, static_index_sequence<I...>)
+        {
+            return static_hash_table<N>{ { Hash()(pValues[I].first)... } };
+        }
+
+        constexpr uint64_t StaticMix(uint64_t x, unsigned nShift, uint64_t nMultiplier)
+        {
+            return (x ^ (x >> nShift)) * nMultiplier;
+        }
+
+        // Maps a hash to a slot. The seed goes through the MurmurHash3 finalizer along
+        // with the hash, so each seed gives an unrelated assignment of keys to slots.
+        constexpr size_t StaticHashSlot(uint64_t h, uint64_t nSeed, size_t nMask)
+        {
+            return (size_t)(StaticMix(StaticMix(StaticMix(h + (nSeed * UINT64_C(0x9e3779b97f4a7c15)), 33, UINT64_C(0xff51afd7ed558ccd)),
+                                                33, UINT64_C(0xc4ceb9fe1a85ec53)), 33, 1) & nMask);
+        }
+
+        // Returns true if no element in [nLo, nHi) lands in the same slot as element j.
+        constexpr bool StaticNoCollision(const uint64_t* pHashes, size_t j, size_t nLo, size_t nHi, uint64_t nSeed, size_t nMask)
+        {
+            return (nLo >= nHi) ? true
+                 : ((nHi - nLo) == 1) ? (StaticHashSlot(pHashes[nLo], nSeed, nMask) != StaticHashSlot(pHashes[j], nSeed, nMask))
+                 : (StaticNoCollision(pHashes, j, nLo, nLo + (nHi - nLo) / 2, nSeed, nMask) &&
+                    StaticNoCollision(pHashes, j, nLo + (nHi - nLo) / 2, nHi, nSeed, nMask));
+        }
+
+        // Returns true if the elements in [nLo, nHi) don't collide with any element after them.
+        constexpr bool StaticSlotsDistinct(const uint64_t* pHashes, size_t n, size_t nLo, size_t nHi, uint64_t nSeed, size_t nMask)
+        {
+            return ((nHi - nLo) == 1) ? StaticNoCollision(pHashes, nLo, nLo + 1, n, nSeed, nMask)
+                                      : (StaticSlotsDistinct(pHashes, n, nLo, nLo + (nHi - nLo) / 2, nSeed, nMask) &&
+                                         StaticSlotsDistinct(pHashes, n, nLo + (nHi - nLo) / 2, nHi, nSeed, nMask));
+        }
+
+        // Tries seeds in order until one maps every element to its own slot. With at least n * n
+        // slots a seed works more often than not, so this rarely goes past the first few. Giving
+        // up after nMaxSeed keeps a pair of keys with the same hash from recursing forever.
+        constexpr uint64_t StaticFindSeed(const uint64_t* pHashes, size_t n, size_t nMask, uint64_t nSeed, uint64_t nMaxSeed)
+        {
+            return (nSeed == nMaxSeed) ? static_map_no_perfect_hash()
+                 : StaticSlotsDistinct(pHashes, n, 0, n, nSeed, nMask) ? nSeed
+                 : StaticFindSeed(pHashes, n, nMask, nSeed + 1, nMaxSeed);
+        }
+
+        // Returns the index of the element in [nLo, nHi) which lands in nSlot, or nEmpty.
+        constexpr size_t StaticSlotOwner(const uint64_t* pHashes, size_t nSlot, size_t nLo, size_t nHi, uint64_t nSeed, size_t nMask, size_t nEmpty)
+        {
+            return ((nHi - nLo) == 1) ? ((StaticHashSlot(pHashes[nLo], nSeed, nMask) == nSlot) ? nLo : nEmpty)
+                                      : StaticFirstFound(StaticSlotOwner(pHashes, nSlot, nLo, nLo + (nHi - nLo) / 2, nSeed, nMask, nEmpty),
+                                                         StaticSlotOwner(pHashes, nSlot, nLo + (nHi - nLo) / 2, nHi, nSeed, nMask, nEmpty), nEmpty);
+        }
+
+        constexpr size_t StaticNextPowerOf2(size_t n, size_t nPower)
+        {
+            return (nPower >= n) ? nPower : StaticNextPowerOf2(n, nPower * 2);
+        }
+    }
+
+
+    template <>
+    struct static_less<const char*> : public binary_function<const char*, const char*, bool>
+    {
+        constexpr bool operator()(const char* a, const char* b) const
+        {
+            return Internal::StaticStringLess(a, b);
+        }
+    };
+
+    template <>
+    struct static_hash<const char*>
+    {
+        constexpr uint64_t operator()(const char* s) const
+        {
+            return Internal::StaticStringHash(s, UINT64_C(0xcbf29ce484222325));
+        }
+    };
+
+
+
+    /// static_map
+    ///
+    /// A read-only map of N elements held in a sorted array. It is built by a constexpr
+    /// constructor from an unsorted array of elements, so when it is declared constexpr
+    /// the sorting and the check for duplicate keys happen at compile time, and the
+    /// result is placed in read-only data with no code run at startup. Duplicate keys
+    /// are a compile error which mentions static_map_duplicate_key.
+    ///
+    /// Lookups are a binary search and are constexpr as well, so a lookup of a constant
+    /// key in a constexpr map folds to a constant. Iteration is in key order, over plain
+    /// pointers. The element type is static_map_value rather than easy::pair, which has
+    /// the same first and second members.
+    ///
+    /// Compare must be constexpr callable and is default constructed for each comparison.
+    /// The default, static_less, compares C strings by content.
+    ///
+    /// The elements must be given as a named constexpr array, as C++11 can't deduce
+    /// the size of a braced list or index into a std::initializer_list at compile time.
+    /// Sorting takes O(N * N) comparisons in the compiler, which is fine for tables of
+    /// up to a few hundred elements.
+    ///
+    /// Example usage:
+    ///     constexpr easy::static_map_value<const char*, int> kCommandList[] = { { "stop", 2 }, { "go", 1 } };
+    ///     constexpr easy::static_map<const char*, int, 2> kCommands(kCommandList);
+    ///
+    ///     static_assert(kCommands.find("go")->second == 1, "");
+    ///     auto it = kCommands.find(name.c_str()); // A binary search at run time.
+    ///
+    template <typename Key, typename T, size_t N, typename Compare = static_less<Key> >
+    class static_map
+    {
+    public:
+        typedef static_map<Key, T, N, Compare>              this_type;
+        typedef Key                                         key_type;
+        typedef T                                           mapped_type;
+        typedef static_map_value<Key, T>                    value_type;
+        typedef size_t                                      size_type;
+        typedef ptrdiff_t                                   difference_type;
+        typedef const value_type&                           reference;
+        typedef const value_type&                           const_reference;
+        typedef const value_type*                           pointer;
+        typedef const value_type*                           const_pointer;
+        typedef const value_type*                           iterator;
+        typedef const value_type*                           const_iterator;
+        typedef Compare                                     key_compare;
+
+        static_assert(N > 0, "static_map: a table needs at least one element");
+
+    public:
+        constexpr explicit static_map(const value_type (&values)[N])
+            : static_map(values, Internal::StaticRanks<Compare, value_type, N>(values, typename Internal::make_static_index_sequence<N>::type()),
+                         typename Internal::make_static_index_sequence<N>::type()) {}
+
+        constexpr const_iterator begin() const { return mValues; }
+        constexpr const_iterator end() const { return mValues + N; }
+        constexpr const_iterator cbegin() const { return mValues; }
+        constexpr const_iterator cend() const { return mValues + N; }
+
+        constexpr bool      empty() const { return false; }
+        constexpr size_type size() const { return N; }
+
+        constexpr key_compare key_comp() const { return Compare(); }
+
+        constexpr const_iterator find(const key_type& key) const
+        {
+            return DoFindLowerBound(key, lower_bound(key));
+        }
+
+        constexpr size_type count(const key_type& key) const
+        {
+            return (find(key) != end()) ? 1 : 0;
+        }
+
+        constexpr const_iterator lower_bound(const key_type& key) const
+        {
+            return Internal::StaticLowerBound<Compare>(mValues, N, key);
+        }
+
+        constexpr const_iterator upper_bound(const key_type& key) const
+        {
+            return Internal::StaticUpperBound<Compare>(mValues, N, key);
+        }
+
+        easy::pair<const_iterator, const_iterator> equal_range(const key_type& key) const
+        {
+            const const_iterator it(find(key));
+            return easy::pair<const_iterator, const_iterator>(it, (it != end()) ? (it + 1) : it);
+        }
+
+    protected:
+        template <size_t... I>
+        constexpr static_map(const value_type* pValues, const Internal::static_rank_table<N>& ranks, Internal::static_index_sequence<I...>)
+            : mValues{ pValues[Internal::StaticSelect(ranks.mRanks, I, N)]... } {}
+
+        constexpr const_iterator DoFindLowerBound(const key_type& key, const_iterator it) const
+        {
+            return ((it != end()) && !Compare()(key, it->first)) ? it : end();
+        }
+
+        value_type mValues[N];
+    }; // static_map
+
+
+
+    /// static_hash_map
+    ///
+    /// A static_map which also stores a perfect hash of its keys, found at compile time,
+    /// so that find is one hash, one table read and one key comparison instead of a
+    /// binary search. The hash table has a byte per slot and at least N * N slots, which
+    /// is why N is limited to kMaxPerfectHashSize. Iteration, lower_bound and upper_bound
+    /// are those of static_map.
+    ///
+    /// Hash must be constexpr callable and must give equal hashes for keys which Compare
+    /// finds equivalent. If no seed is found which separates the keys, which in practice
+    /// means two keys have the same hash, it is a compile error which mentions
+    /// static_map_no_perfect_hash.
+    ///
+    /// Example usage:
+    ///     constexpr easy::static_hash_map<const char*, int, 2> kCommands(kCommandList);
+    ///
+    template <typename Key, typename T, size_t N, typename Hash = static_hash<Key>, typename Compare = static_less<Key> >
+    class static_hash_map : public static_map<Key, T, N, Compare>
+    {
+    public:
+        typedef static_map<Key, T, N, Compare>              base_type;
+        typedef static_hash_map<Key, T, N, Hash, Compare>   this_type;
+        typedef typename base_type::key_type                key_type;
+        typedef typename base_type::value_type              value_type;
+        typedef typename base_type::size_type               size_type;
+        typedef typename base_type::const_iterator          const_iterator;
+        typedef Hash                                        hasher;
+
+        static const size_t kMaxPerfectHashSize = 32;
+        static const size_t kSlotCount = Internal::StaticNextPowerOf2(N * N, 1);
+        static const size_t kMaxSeed = 256;
+
+        static_assert(N <= kMaxPerfectHashSize, "static_hash_map: use static_map for tables of more than 32 elements");
+
+        using base_type::begin;
+        using base_type::end;
+
+    public:
+        constexpr explicit static_hash_map(const value_type (&values)[N])
+            : static_hash_map(base_type(values)) {}
+
+        constexpr hasher hash_function() const { return Hash(); }
+
+        constexpr const_iterator find(const key_type& key) const
+        {
+            return DoFindSlot(key, mSlots[Internal::StaticHashSlot(Hash()(key), mnSeed, kSlotCount - 1)]);
+        }
+
+        constexpr size_type count(const key_type& key) const
+        {
+            return (find(key) != end()) ? 1 : 0;
+        }
+
+        easy::pair<const_iterator, const_iterator> equal_range(const key_type& key) const
+        {
+            const const_iterator it(find(key));
+            return easy::pair<const_iterator, const_iterator>(it, (it != end()) ? (it + 1) : it);
+        }
+
+    protected:
+        static const unsigned char kEmptySlot = 0xff;
+
+        constexpr explicit static_hash_map(const base_type& sorted)
+            : static_hash_map(sorted, Internal::StaticHashes<Hash, value_type, N>(sorted.begin(), typename Internal::make_static_index_sequence<N>::type())) {}
+
+        constexpr static_hash_map(const base_type& sorted, const Internal::static_hash_table<N>& hashes)
+            : static_hash_map(sorted, hashes, Internal::StaticFindSeed(hashes.mHashes, N, kSlotCount - 1, 0, kMaxSeed),
+                              typename Internal::make_static_index_sequence<kSlotCount>::type()) {}
+
+        template <size_t... I>
+        constexpr static_hash_map(const base_type& sorted, const Internal::static_hash_table<N>& hashes, uint64_t nSeed, Internal::static_index_sequence<I...>)
+            : base_type(sorted),
+              mnSeed(nSeed),
+              mSlots{ (unsigned char)Internal::StaticSlotOwner(hashes.mHashes, I, 0, N, nSeed, kSlotCount - 1, kEmptySlot)... } {}
+
+        constexpr const_iterator DoFindSlot(const key_type& key, unsigned char nSlot) const
+        {
+            return ((nSlot != kEmptySlot) && !Compare()(key, begin()[nSlot].first) && !Compare()(begin()[nSlot].first, key)) ? (begin() + nSlot) : end();
+        }
+
+        uint64_t      mnSeed;
+        unsigned char mSlots[kSlotCount];
+    }; // static_hash_map
+
+} // namespace easy
+
+#endif // __EASY_STATIC_MAP_H__
@@ -0,0 +1,675 @@
+#ifndef __EASY_STRING_MAP_H__
+#define __EASY_STRING_MAP_H__
+
+/**
+ * 以std::string为键的easy::map, 节点内缓存键在公共前缀之后的8个字节以减少比较时的内存访问
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include "RbTree.h"
+
+namespace easy
+{
+    namespace Internal
+    {
+        // Returns the 8 bytes of the string at nOffset as a big-endian integer, padded with
+        // zeros, so that comparing two prefixes as integers compares the bytes as unsigned chars.
+        inline uint64_t PrefixedKeyPrefix(const char* pData, size_t nSize, size_t nOffset = 0)
+        {
+            uint64_t nPrefix = 0;
+
+            for (size_t i = nOffset; i < (nOffset + 8); ++i)
+                nPrefix = (nPrefix << 8) | ((i < nSize) ? (unsigned char)pData[i] : 0);
+
+            return nPrefix;
+        }
+    }
+
+
+    /// prefixed_key
+    ///
+    /// A string key as string_map compares it: a pointer to the characters, their
+    /// count, and the first 8 of them as an integer (see Internal::PrefixedKeyPrefix).
+    /// string_map moves the 8 bytes past the prefix its keys have in common before
+    /// it searches with the key.
+    /// It doesn't own the characters, so it must not outlive the string it was made
+    /// from. The implicit constructors let string_map be searched with a std::string
+    /// or a C string without copying it.
+    ///
+    struct prefixed_key
+    {
+        uint64_t    mnPrefix;
+        const char* mpData;
+        size_t      mnSize;
+
+        prefixed_key(const std::string& s)
+            : mnPrefix(Internal::PrefixedKeyPrefix(s.data(), s.size())),
+            mpData(s.data()),
+            mnSize(s.size()) {}
+
+        prefixed_key(const char* p)
+            : prefixed_key(p, strlen(p)) {}
+
+        prefixed_key(const char* p, size_t n)
+            : mnPrefix(Internal::PrefixedKeyPrefix(p, n)),
+            mpData(p),
+            mnSize(n) {}
+
+        prefixed_key(uint64_t nPrefix, const char* p, size_t n)
+            : mnPrefix(nPrefix),
+            mpData(p),
+            mnSize(n) {}
+    };
+
+
+    /// prefixed_key_less
+    ///
+    /// Orders prefixed_keys the way std::string::compare orders strings. Keys whose
+    /// prefixes differ are told apart by one integer compare, without reading the
+    /// characters. Only keys with the same prefix go on to compare the rest of the
+    /// characters. compare is the three-way form, which string_map's tree uses (see
+    /// rbtree_three_way), so that keys with equal prefixes have their characters read
+    /// once per level, not twice.
+    ///
+    /// The keys compared must all start with the same mnOffset bytes, and their
+    /// prefixes must hold the 8 bytes after those, which string_map arranges.
+    /// mnOffset is 0 unless a string_map has set it.
+    ///
+    struct prefixed_key_less : public binary_function<prefixed_key, prefixed_key, bool>
+    {
+        size_t mnOffset; // The number of leading bytes every compared key shares.
+
+        prefixed_key_less() : mnOffset(0) {}
+
+        bool operator()(const prefixed_key& a, const prefixed_key& b) const
+        {
+            if (EASY_LIKELY(a.mnPrefix != b.mnPrefix))
+                return a.mnPrefix < b.mnPrefix;
+
+            // The first min(size, mnOffset + 8) bytes are equal. If either string is no
+            // longer than that, it is a prefix of the other.
+            const size_t nMinSize = (a.mnSize < b.mnSize) ? a.mnSize : b.mnSize;
+            const size_t nSkip = mnOffset + 8;
+
+            if (nMinSize > nSkip)
+            {
+                const int result = memcmp(a.mpData + nSkip, b.mpData + nSkip, nMinSize - nSkip);
+                if (result != 0)
+                    return result < 0;
+            }
+
+            return a.mnSize < b.mnSize;
+        }
+
+        int compare(const prefixed_key& a, const prefixed_key& b) const
+        {
+            if (EASY_LIKELY(a.mnPrefix != b.mnPrefix))
+                return (a.mnPrefix < b.mnPrefix) ? -1 : 1;
+
+            const size_t nMinSize = (a.mnSize < b.mnSize) ? a.mnSize : b.mnSize;
+            const size_t nSkip = mnOffset + 8;
+
+            if (nMinSize > nSkip)
+            {
+                const int result = memcmp(a.mpData + nSkip, b.mpData + nSkip, nMinSize - nSkip);
+                if (result != 0)
+                    return result;
+            }
+
+            return (a.mnSize < b.mnSize) ? -1 : ((b.mnSize < a.mnSize) ? 1 : 0);
+        }
+    };
+
+
+    template <>
+    struct rbtree_three_way<prefixed_key_less>
+    {
+        static const bool kEnabled = true;
+
+        static int Order(const prefixed_key_less& compare, const prefixed_key& a, const prefixed_key& b)
+        {
+            return compare.compare(a, b);
+        }
+    };
+
+
+    namespace Internal
+    {
+        // string_map's Compare, which also holds the bytes all of the map's keys start
+        // with, so that a key can be checked against them without reading a node.
+        struct string_map_compare : public prefixed_key_less
+        {
+            std::string mCommonPrefix; // mnOffset is its size.
+        };
+
+        struct string_map_prefix
+        {
+            uint64_t mnPrefix;
+
+            string_map_prefix(uint64_t nPrefix) : mnPrefix(nPrefix) {}
+        };
+    }
+
+
+    template <>
+    struct rbtree_three_way<Internal::string_map_compare>
+    {
+        static const bool kEnabled = true;
+
+        static int Order(const Internal::string_map_compare& compare, const prefixed_key& a, const prefixed_key& b)
+        {
+            return compare.compare(a, b);
+        }
+    };
+
+
+    /// string_map_value
+    ///
+    /// The value_type of string_map: a pair of std::string and mapped value, plus
+    /// the prefix of the key, which string_map computes when it inserts the value
+    /// and again if its common prefix gets shorter. The key must not be modified.
+    ///
+    /// The prefix comes first so that it shares a cache line with the links of the
+    /// node and with the data pointer and size of the key, which is everything a
+    /// comparison reads from the node.
+    ///
+    template <typename T>
+    struct string_map_value : public Internal::string_map_prefix, public easy::pair<std::string, T>
+    {
+        typedef easy::pair<std::string, T> base_type;
+
+        string_map_value()
+            : Internal::string_map_prefix(0),
+            base_type() {}
+
+        string_map_value(const std::string& key, const T& value)
+            : Internal::string_map_prefix(Internal::PrefixedKeyPrefix(key.data(), key.size())),
+            base_type(key, value) {}
+
+        string_map_value(const base_type& x)
+            : Internal::string_map_prefix(Internal::PrefixedKeyPrefix(x.first.data(), x.first.size())),
+            base_type(x) {}
+
+        string_map_value(const base_type& x, size_t nOffset)
+            : Internal::string_map_prefix(Internal::PrefixedKeyPrefix(x.first.data(), x.first.size(), nOffset)),
+            base_type(x) {}
+    };
+
+
+    namespace Internal
+    {
+        // Makes the prefixed_key of a node from the prefix stored in it. The size and the
+        // data pointer are in the std::string object, so this doesn't touch the characters.
+        template <typename Value>
+        struct use_prefixed_key
+        {
+            typedef Value        argument_type;
+            typedef prefixed_key result_type;
+
+            prefixed_key operator()(const Value& x) const
+            {
+                return prefixed_key(x.mnPrefix, x.first.data(), x.first.size());
+            }
+        };
+    }
+
+
+
+    /// string_map
+    ///
+    /// A map from std::string to T which keeps, in each node next to the std::string,
+    /// the 8 bytes of the key that follow the prefix all of the map's keys share.
+    /// Searching the tree then usually compares one integer per level instead of
+    /// calling std::string::compare, which reads the characters from a separate heap
+    /// block for strings too long for the small string buffer. The characters are
+    /// read only when two keys agree on those 8 bytes as well.
+    ///
+    /// The shared prefix is kept once, in the map's Compare. A lookup key is checked
+    /// against it first: a key that leaves it orders before or after every element,
+    /// which answers the lookup without a descent, and any other key gets its 8 bytes
+    /// from past the shared prefix too. An insert that shortens the shared prefix
+    /// recomputes the bytes of every node, which can only happen once per byte of
+    /// the first key inserted. Keys such as URLs, which all start the same way, thus
+    /// compare on the bytes where they differ, just like hashes or identifiers do.
+    ///
+    /// The interface is that of easy::map<std::string, T>, except that the element
+    /// type is string_map_value<T>, which converts from easy::pair<std::string, T>,
+    /// and lookups take a prefixed_key, which converts from std::string and const char*.
+    /// apply_batch isn't available, and as the keys of two string_maps skip different
+    /// prefixes, one map's key_comp() can't compare the other's keys, so string_maps
+    /// can't be given to merge_view or diff.
+    ///
+    /// Example usage:
+    ///     easy::string_map<int> m;
+    ///     m.insert(easy::make_pair(std::string("hello"), 1));
+    ///     m.find("hello");
+    ///
+    template <typename T, typename Allocator = easy::allocator>
+    class string_map
+        : public rbtree<prefixed_key, string_map_value<T>, Internal::string_map_compare,
+                        Internal::use_prefixed_key<string_map_value<T> >, true, true, Allocator>
+    {
+    public:
+        typedef rbtree<prefixed_key, string_map_value<T>, Internal::string_map_compare,
+            Internal::use_prefixed_key<string_map_value<T> >, true, true, Allocator>   base_type;
+        typedef string_map<T, Allocator>                                                this_type;
+        typedef typename base_type::size_type                                           size_type;
+        typedef typename base_type::key_type                                            key_type;
+        typedef T                                                                       mapped_type;
+        typedef typename base_type::value_type                                          value_type;
+        typedef easy::pair<std::string, T>                                              pair_type;
+        typedef typename base_type::node_type                                           node_type;
+        typedef typename base_type::iterator                                            iterator;
+        typedef typename base_type::const_iterator                                      const_iterator;
+        typedef typename base_type::reference                                           reference;
+        typedef typename base_type::const_reference                                     const_reference;
+        typedef typename base_type::insert_return_type                                  insert_return_type;
+        typedef typename base_type::extract_key                                         extract_key;
+        // Other types are inherited from the base class.
+
+        using base_type::begin;
+        using base_type::end;
+        using base_type::empty;
+        using base_type::mCompare;
+
+    public:
+        string_map();
+        string_map(const this_type& x);
+
+        template <typename Iterator>
+        string_map(Iterator itBegin, Iterator itEnd);
+
+    public:
+        /// Returns the bytes every key in the map starts with, which the nodes don't
+        /// keep. It is only meaningful while the map isn't empty.
+        const std::string& common_prefix() const { return mCompare.mCommonPrefix; }
+
+        insert_return_type insert(const pair_type& value);
+        iterator           insert(const_iterator position, const pair_type& value);
+
+        template <typename InputIterator>
+        void insert(InputIterator first, InputIterator last);
+
+        template <typename InputIterator>
+        void append_sorted(InputIterator first, InputIterator last);
+
+        iterator  erase(const_iterator position);
+        iterator  erase(const_iterator first, const_iterator last);
+        size_type erase(const key_type& key);
+
+        iterator       find(const key_type& key);
+        const_iterator find(const key_type& key) const;
+        size_type      count(const key_type& key) const;
+
+        iterator       lower_bound(const key_type& key);
+        const_iterator lower_bound(const key_type& key) const;
+        iterator       upper_bound(const key_type& key);
+        const_iterator upper_bound(const key_type& key) const;
+
+        easy::pair<iterator, iterator>             equal_range(const key_type& key);
+        easy::pair<const_iterator, const_iterator> equal_range(const key_type& key) const;
+
+        template <typename Function>
+        void for_each_range(const key_type& lo, const key_type& hi, Function f);
+        template <typename Function>
+        void for_each_range(const key_type& lo, const key_type& hi, Function f) const;
+
+        template <typename Predicate>
+        iterator       visit_until(const key_type& lo, Predicate pred);
+        template <typename Predicate>
+        const_iterator visit_until(const key_type& lo, Predicate pred) const;
+
+    protected:
+        // The values of a batch have their prefixes computed before the map sees them.
+        using base_type::apply_batch;
+
+        void DoAdmit(const std::string& key);
+        void DoRebase(size_t nOffset);
+        int  DoProbe(key_type& key) const;
+    }; // string_map
+
+
+
+    ///////////////////////////////////////////////////////////////////////
+    // string_map
+    ///////////////////////////////////////////////////////////////////////
+
+    template <typename T, typename Allocator>
+    inline string_map<T, Allocator>::string_map()
+        : base_type()
+    {
+    }
+
+
+    template <typename T, typename Allocator>
+    inline string_map<T, Allocator>::string_map(const this_type& x)
+        : base_type(x)
+    {
+    }
+
+
+    template <typename T, typename Allocator>
+    template <typename Iterator>
+    inline string_map<T, Allocator>::string_map(Iterator itBegin, Iterator itEnd)
+        : base_type()
+    {
+        insert(itBegin, itEnd);
+    }
+
+
+    template <typename T, typename Allocator>
+    inline typename string_map<T, Allocator>::insert_return_type
+        string_map<T, Allocator>::insert(const pair_type& value)
+    {
+        DoAdmit(value.first);
+        return base_type::insert(value_type(value, mCompare.mnOffset));
+    }
+
+
+    template <typename T, typename Allocator>
+    inline typename string_map<T, Allocator>::iterator
+        string_map<T, Allocator>::insert(const_iterator position, const pair_type& value)
+    {
+        DoAdmit(value.first);
+        return base_type::insert(position, value_type(value, mCompare.mnOffset));
+    }
+
+
+    template <typename T, typename Allocator>
+    template <typename InputIterator>
+    inline void string_map<T, Allocator>::insert(InputIterator first, InputIterator last)
+    {
+        for (; first != last; ++first)
+            insert(*first);
+    }
+
+
+    template <typename T, typename Allocator>
+    template <typename InputIterator>
+    inline void string_map<T, Allocator>::append_sorted(InputIterator first, InputIterator last)
+    {
+        for (; first != last; ++first)
+            insert(*first); // The tree's insert tries the end first, so each append is a couple of compares.
+    }
+
+
+    template <typename T, typename Allocator>
+    inline typename string_map<T, Allocator>::iterator
+        string_map<T, Allocator>::erase(const_iterator position)
+    {
+        return base_type::erase(position);
+    }
+
+
+    template <typename T, typename Allocator>
+    inline typename string_map<T, Allocator>::iterator
+        string_map<T, Allocator>::erase(const_iterator first, const_iterator last)
+    {
+        return base_type::erase(first, last);
+    }
+
+
+    template <typename T, typename Allocator>
+    inline typename string_map<T, Allocator>::size_type
+        string_map<T, Allocator>::erase(const key_type& key)
+    {
+        const iterator it(find(key));
+
+        if (it != end()) // If it exists...
+        {
+            base_type::erase(it);
+            return 1;
+        }
+        return 0;
+    }
+
+
+    template <typename T, typename Allocator>
+    inline typename string_map<T, Allocator>::iterator
+        string_map<T, Allocator>::find(const key_type& key)
+    {
+        key_type probe(key);
+        return DoProbe(probe) ? end() : base_type::find(probe);
+    }
+
+
+    template <typename T, typename Allocator>
+    inline typename string_map<T, Allocator>::const_iterator
+        string_map<T, Allocator>::find(const key_type& key) const
+    {
+        key_type probe(key);
+        return DoProbe(probe) ? end() : base_type::find(probe);
+    }
+
+
+    template <typename T, typename Allocator>
+    inline typename string_map<T, Allocator>::size_type
+        string_map<T, Allocator>::count(const key_type& key) const
+    {
+        const const_iterator it(find(key));
+        return (it != end()) ? 1 : 0;
+    }
+
+
+    template <typename T, typename Allocator>
+    inline typename string_map<T, Allocator>::iterator
+        string_map<T, Allocator>::lower_bound(const key_type& key)
+    {
+        key_type  probe(key);
+        const int order = DoProbe(probe);
+
+        if (order)
+            return (order < 0) ? begin() : end();
+        return base_type::lower_bound(probe);
+    }
+
+
+    template <typename T, typename Allocator>
+    inline typename string_map<T, Allocator>::const_iterator
+        string_map<T, Allocator>::lower_bound(const key_type& key) const
+    {
+        return const_iterator(const_cast<this_type*>(this)->lower_bound(key));
+    }
+
+
+    template <typename T, typename Allocator>
+    inline typename string_map<T, Allocator>::iterator
+        string_map<T, Allocator>::upper_bound(const key_type& key)
+    {
+        key_type  probe(key);
+        const int order = DoProbe(probe);
+
+        if (order)
+            return (order < 0) ? begin() : end();
+        return base_type::upper_bound(probe);
+    }
+
+
+    template <typename T, typename Allocator>
+    inline typename string_map<T, Allocator>::const_iterator
+        string_map<T, Allocator>::upper_bound(const key_type& key) const
+    {
+        return const_iterator(const_cast<this_type*>(this)->upper_bound(key));
+    }
+
+
+    template <typename T, typename Allocator>
+    inline easy::pair<typename string_map<T, Allocator>::iterator,
+                      typename string_map<T, Allocator>::iterator>
+        string_map<T, Allocator>::equal_range(const key_type& key)
+    {
+        key_type  probe(key);
+        const int order = DoProbe(probe);
+
+        if (order)
+        {
+            const iterator it((order < 0) ? begin() : end());
+            return easy::pair<iterator, iterator>(it, it);
+        }
+
+        node_type* pLower;
+        node_type* pUpper;
+
+        base_type::DoGetEqualRange(probe, pLower, pUpper); // A single descent, as the compare is three-way.
+        return easy::pair<iterator, iterator>(iterator(pLower), iterator(pUpper));
+    }
+
+
+    template <typename T, typename Allocator>
+    inline easy::pair<typename string_map<T, Allocator>::const_iterator,
+                      typename string_map<T, Allocator>::const_iterator>
+        string_map<T, Allocator>::equal_range(const key_type& key) const
+    {
+        const easy::pair<iterator, iterator> range(const_cast<this_type*>(this)->equal_range(key));
+        return easy::pair<const_iterator, const_iterator>(range.first, range.second);
+    }
+
+
+    template <typename T, typename Allocator>
+    template <typename Function>
+    inline void string_map<T, Allocator>::for_each_range(const key_type& lo, const key_type& hi, Function f)
+    {
+        key_type  probeLo(lo);
+        key_type  probeHi(hi);
+        const int orderLo = DoProbe(probeLo);
+        const int orderHi = DoProbe(probeHi);
+
+        if ((orderLo > 0) || (orderHi < 0)) // If the range is past either end of the map...
+            return;
+
+        const key_type* const pKeyLower = orderLo ? NULL : &probeLo;
+
+        if (orderHi)
+        {
+            typename base_type::template visit_all<reference, Function> visitor(f);
+            base_type::DoVisitInOrder(pKeyLower, visitor);
+        }
+        else
+        {
+            typename base_type::template visit_range<reference, Function> visitor(f, probeHi, mCompare);
+            base_type::DoVisitInOrder(pKeyLower, visitor);
+        }
+    }
+
+
+    template <typename T, typename Allocator>
+    template <typename Function>
+    inline void string_map<T, Allocator>::for_each_range(const key_type& lo, const key_type& hi, Function f) const
+    {
+        key_type  probeLo(lo);
+        key_type  probeHi(hi);
+        const int orderLo = DoProbe(probeLo);
+        const int orderHi = DoProbe(probeHi);
+
+        if ((orderLo > 0) || (orderHi < 0))
+            return;
+
+        const key_type* const pKeyLower = orderLo ? NULL : &probeLo;
+        this_type* const      pThis = const_cast<this_type*>(this);
+
+        if (orderHi)
+        {
+            typename base_type::template visit_all<const_reference, Function> visitor(f);
+            pThis->DoVisitInOrder(pKeyLower, visitor);
+        }
+        else
+        {
+            typename base_type::template visit_range<const_reference, Function> visitor(f, probeHi, mCompare);
+            pThis->DoVisitInOrder(pKeyLower, visitor);
+        }
+    }
+
+
+    template <typename T, typename Allocator>
+    template <typename Predicate>
+    inline typename string_map<T, Allocator>::iterator
+        string_map<T, Allocator>::visit_until(const key_type& lo, Predicate pred)
+    {
+        key_type  probe(lo);
+        const int order = DoProbe(probe);
+
+        if (order > 0)
+            return end();
+
+        typename base_type::template visit_until_true<reference, Predicate> visitor(pred);
+        node_type* const pNode = base_type::DoVisitInOrder(order ? NULL : &probe, visitor);
+        return iterator(pNode ? pNode : (node_type*)&this->mAnchor);
+    }
+
+
+    template <typename T, typename Allocator>
+    template <typename Predicate>
+    inline typename string_map<T, Allocator>::const_iterator
+        string_map<T, Allocator>::visit_until(const key_type& lo, Predicate pred) const
+    {
+        key_type  probe(lo);
+        const int order = DoProbe(probe);
+
+        if (order > 0)
+            return end();
+
+        typename base_type::template visit_until_true<const_reference, Predicate> visitor(pred);
+        node_type* const pNode = const_cast<this_type*>(this)->DoVisitInOrder(order ? NULL : &probe, visitor);
+        return const_iterator(pNode ? pNode : (node_type*)&this->mAnchor);
+    }
+
+
+    template <typename T, typename Allocator>
+    void string_map<T, Allocator>::DoAdmit(const std::string& key)
+    {
+        std::string& common = mCompare.mCommonPrefix;
+
+        if (empty()) // The first key is its own common prefix, and its bytes past that are all padding.
+        {
+            common = key;
+            mCompare.mnOffset = key.size();
+            return;
+        }
+
+        const size_t nMax = (key.size() < common.size()) ? key.size() : common.size();
+        size_t       n = 0;
+
+        while ((n < nMax) && (key[n] == common[n]))
+            ++n;
+
+        if (n < common.size())
+            DoRebase(n);
+    }
+
+
+    template <typename T, typename Allocator>
+    void string_map<T, Allocator>::DoRebase(size_t nOffset)
+    {
+        mCompare.mCommonPrefix.resize(nOffset);
+        mCompare.mnOffset = nOffset;
+
+        // Shortening the prefix doesn't change the order, only which bytes the nodes keep.
+        for (iterator it = begin(); it != end(); ++it)
+            it->mnPrefix = Internal::PrefixedKeyPrefix(it->first.data(), it->first.size(), nOffset);
+    }
+
+
+    template <typename T, typename Allocator>
+    int string_map<T, Allocator>::DoProbe(key_type& key) const
+    {
+        // Returns < 0 if key orders before every key of the map, > 0 if it orders after
+        // them all, and otherwise 0, with the prefix of key moved past the common prefix.
+        const std::string& common = mCompare.mCommonPrefix;
+        const size_t       nMin = (key.mnSize < common.size()) ? key.mnSize : common.size();
+        const int          result = memcmp(key.mpData, common.data(), nMin);
+
+        if (result != 0)
+            return result;
+        if (key.mnSize < common.size()) // A proper prefix of every key.
+            return -1;
+
+        key.mnPrefix = Internal::PrefixedKeyPrefix(key.mpData, key.mnSize, common.size());
+        return 0;
+    }
+
+} // namespace easy
+
+#endif // __EASY_STRING_MAP_H__
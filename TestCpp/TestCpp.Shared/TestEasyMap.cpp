@@ -1,6 +1,43 @@
 #include "TestEasyMap.h"
+#include <stdio.h>
+#include <stdlib.h>
 #include <iostream>
 #include <string>
+#include "ArtMap.h"
+#include "FixedMap.h"
+#include "HashMap.h"
+#include "LruCache.h"
+#include "MapDiff.h"
+#include "MappedMap.h"
+#include "MergedView.h"
+#include "ParallelMap.h"
+#include "RbTreeFilter.h"
+#include "RbTreeStats.h"
+#include "SmallMap.h"
+#include "StaticMap.h"
+#include "StringMap.h"
+#include "ThreeWayCompare.h"
+#include "TtlMap.h"
+
+
+namespace
+{
+    constexpr easy::static_map_value<const char*, int> kCommandList[] = { { "stop", 2 }, { "start", 1 }, { "pause", 3 } };
+    constexpr easy::static_map<const char*, int, 3> kCommands(kCommandList);
+    constexpr easy::static_hash_map<const char*, int, 3> kHashedCommands(kCommandList);
+
+    static_assert(kCommands.find("start")->second == 1, "static_map lookups fold at compile time");
+    static_assert(kHashedCommands.find("pause")->second == 3, "so do static_hash_map lookups");
+
+    // A path for a scratch file in the temp directory, so the demo leaves nothing behind.
+    std::string TempPath(const char* pName)
+    {
+        const char* pDir = getenv("TMPDIR");
+        if (!pDir)
+            pDir = getenv("TEMP");
+        return std::string(pDir ? pDir : ".") + "/" + pName;
+    }
+}
 
 
 TestEasyMap::TestEasyMap()
@@ -51,8 +88,221 @@ void TestEasyMap::main()
     myMap.clear();
     print(myMap);
 
+    // Increasing keys take the append fast path instead of a descent from the root.
+    easy::pair<int, int> sorted[] = { easy::make_pair(1, 1), easy::make_pair(2, 4), easy::make_pair(3, 9), easy::make_pair(4, 16) };
+    myMap.append_sorted(sorted, sorted + 4);
+    myMap.insert(easy::make_pair(10, 100));
+    print(myMap);
+
+    int sum = 0;
+    myMap.for_each_range(2, 4, [&sum](const easy::pair<int, int>& x) { sum += x.second; });
+    std::cout << "sum of values in [2, 4):" << sum << std::endl;
+
+    // Moves the nodes next to each other in key order; the contents stay the same.
+    myMap.compact();
+    print(myMap);
+
+    // Sorted by key and applied in one pass; the erase of 1 frees a node that the insert of 6 reuses.
+    typedef easy::map<int, int>::batch_op_type batch_op;
+    batch_op batch[] = { batch_op::upsert(easy::make_pair(6, 36)), batch_op::erase(easy::make_pair(1, 0)), batch_op::upsert(easy::make_pair(2, 5)) };
+    myMap.apply_batch(batch, batch + 3);
+    print(myMap);
+
     easy::map<std::string, std::string> map2;
     map2.insert(easy::make_pair(std::string("aa"), std::string("bb")));
     print(map2);
 
+    easy::multimap<int, int> multiMap;
+    multiMap.insert(easy::make_pair(1, 10));
+    multiMap.insert(easy::make_pair(2, 20));
+    multiMap.insert(easy::make_pair(2, 21));
+    multiMap.insert(easy::make_pair(2, 22));
+    print(multiMap);
+    std::cout << "count of key 2:" << multiMap.count(2) << std::endl;
+
+    auto range = multiMap.equal_range(2);
+    for (auto itRange = range.first; itRange != range.second; ++itRange) {
+        std::cout << itRange->first << " " << itRange->second << std::endl;
+    }
+
+    multiMap.erase(2);
+    print(multiMap);
+
+    // Unhinted inserts go after the keys equal to them: 0:c 1:a 1:b 1:d 2:z.
+    easy::multimap<int, char> orderMap;
+    orderMap.insert(easy::make_pair(2, 'z'));
+    orderMap.insert(easy::make_pair(1, 'a'));
+    orderMap.insert(easy::make_pair(1, 'b'));
+    orderMap.insert(easy::make_pair(0, 'c'));
+    orderMap.insert(easy::make_pair(1, 'd'));
+    print(orderMap);
+
+    // A range that isn't sorted falls back to per element inserts, which keep the same order:
+    // 0:c 1:a 1:b 1:d 1:e 1:g 2:z 2:f 2:h.
+    easy::pair<int, char> unsorted[] = { easy::make_pair(1, 'e'), easy::make_pair(2, 'f'), easy::make_pair(1, 'g'), easy::make_pair(2, 'h') };
+    orderMap.insert_equal_sorted(unsorted, unsorted + 4);
+    print(orderMap);
+
+    // Snapshot a map to disk and serve lookups straight from the mapped file.
+    map2.insert(easy::make_pair(std::string("cc"), std::string("dd")));
+    const std::string snapshotPath(TempPath("TestEasyMap.snapshot"));
+    if (easy::write_snapshot(map2, snapshotPath.c_str())) {
+        easy::mapped_map<std::string, std::string> mappedMap;
+        if (mappedMap.open(snapshotPath.c_str())) {
+            std::cout << "mapped size:" << mappedMap.size() << std::endl;
+            auto itMapped = mappedMap.find(std::string("cc"));
+            if (itMapped != mappedMap.end()) {
+                std::cout << "mapped cc " << itMapped->second.str() << std::endl;
+            }
+        }
+    }
+    remove(snapshotPath.c_str());
+
+    // Ordered iteration over several maps without copying them into one.
+    easy::map<int, int> shard0, shard1;
+    shard0.insert(easy::make_pair(1, 0));
+    shard0.insert(easy::make_pair(4, 0));
+    shard1.insert(easy::make_pair(2, 1));
+    shard1.insert(easy::make_pair(4, 1));
+    auto mergedView = easy::merged_view(shard0, shard1);
+    mergedView.set_duplicates(easy::kMergeLastWins);
+    for (auto itMerged = mergedView.begin(); itMerged != mergedView.end(); ++itMerged) {
+        std::cout << itMerged->first << " " << itMerged->second << std::endl;
+    }
+
+    long long total = easy::parallel_reduce(shard0, 0LL,
+        [](long long acc, const easy::pair<int, int>& x) { return acc + x.first; },
+        [](long long a, long long b) { return a + b; });
+    std::cout << "sum of keys in shard0:" << total << std::endl;
+
+    // What changed between two versions of a map, in one pass over both.
+    easy::map<int, int> yesterday, today;
+    yesterday.insert(easy::make_pair(1, 10));
+    yesterday.insert(easy::make_pair(2, 20));
+    today.insert(easy::make_pair(2, 21));
+    today.insert(easy::make_pair(3, 30));
+    easy::diff(yesterday, today,
+        [](const easy::pair<int, int>& y) { std::cout << "added " << y.first << std::endl; },
+        [](const easy::pair<int, int>& x) { std::cout << "removed " << x.first << std::endl; },
+        [](const easy::pair<int, int>& x, const easy::pair<int, int>& y) { std::cout << "changed " << x.first << ":" << x.second << "->" << y.second << std::endl; });
+
+    // Count what the tree does, to tell comparator cost from tree shape.
+    easy::map<int, int, easy::instrumented_compare<easy::less<int> > > countedMap;
+    for (int i = 0; i < 1000; ++i) {
+        countedMap.insert(easy::make_pair((i * 7919) % 1000, i));
+    }
+    easy::rbtree_stats stats = countedMap.stats();
+    std::cout << "height:" << stats.height << " black height:" << stats.black_height
+        << " average depth:" << stats.average_depth << " compares:" << stats.compares
+        << " rotations:" << stats.rotations << std::endl;
+
+    // Most finds miss; the filter answers them without descending the tree.
+    easy::map<int, int, easy::filtered_compare<int> > filteredMap;
+    for (int i = 0; i < 1000; ++i) {
+        filteredMap.insert(easy::make_pair(i * 2, i));
+    }
+    for (int i = 0; i < 1000; ++i) {
+        filteredMap.find(i * 2 + 1);
+    }
+    std::cout << "filter negatives:" << filteredMap.key_comp().negatives()
+        << " false positives:" << filteredMap.key_comp().false_positives() << std::endl;
+
+    // Nodes live inside the map object; with overflow disabled insert fails once it is full.
+    easy::fixed_map<int, int, 2, false> fixedMap;
+    fixedMap.insert(easy::make_pair(1, 1));
+    fixedMap.insert(easy::make_pair(2, 2));
+    std::cout << "fixed_map full:" << fixedMap.full()
+        << " insert 3:" << fixedMap.insert(easy::make_pair(3, 3)).second << std::endl;
+
+    // Sorted at compile time, no startup code and no heap.
+    print(kCommands);
+    std::string command("stop");
+    std::cout << "stop:" << kHashedCommands.find(command.c_str())->second << std::endl;
+
+    // Up to 4 elements stay in an array inside the map; the 5th moves them into a tree.
+    easy::small_map<int, int, 4> smallMap;
+    for (int i = 0; i < 5; ++i) {
+        smallMap.insert(easy::make_pair(i, i * i));
+        std::cout << "small_map size:" << smallMap.size() << " inline:" << smallMap.is_inline() << std::endl;
+    }
+    smallMap.erase(0);
+    smallMap.erase(1);
+    smallMap.erase(2);
+    print(smallMap);
+    std::cout << "small_map inline after erase:" << smallMap.is_inline() << std::endl;
+
+    // Keys which differ in their first 8 bytes are ordered without reading their characters.
+    easy::string_map<int> stringMap;
+    stringMap.insert(easy::make_pair(std::string("zeta-service"), 3));
+    stringMap.insert(easy::make_pair(std::string("alpha-service"), 1));
+    stringMap.insert(easy::make_pair(std::string("alpha-servicex"), 2));
+    print(stringMap);
+    std::cout << "alpha-servicex:" << stringMap.find("alpha-servicex")->second << std::endl;
+
+    // Keys with a common prefix are ordered by the 8 bytes after it.
+    easy::string_map<int> urlMap;
+    urlMap.insert(easy::make_pair(std::string("https://example.com/users/42"), 42));
+    urlMap.insert(easy::make_pair(std::string("https://example.com/users/7"), 7));
+    urlMap.insert(easy::make_pair(std::string("https://example.com/orders/9"), 9));
+    print(urlMap);
+    std::cout << "string_map common prefix:" << urlMap.common_prefix()
+              << " lower_bound(http://):" << urlMap.lower_bound("http://")->first << std::endl;
+
+    // A radix tree over the key bytes; prefix_range walks only the keys under "/api/".
+    easy::art_map<int> artMap;
+    artMap.insert(easy::make_pair(std::string("/api/users"), 1));
+    artMap.insert(easy::make_pair(std::string("/api/orders"), 2));
+    artMap.insert(easy::make_pair(std::string("/static/app.js"), 3));
+    artMap.insert(easy::make_pair(std::string("/api"), 4));
+    easy::pair<easy::art_map<int>::iterator, easy::art_map<int>::iterator> apiRange = artMap.prefix_range("/api/");
+    for (easy::art_map<int>::iterator it = apiRange.first; it != apiRange.second; ++it)
+        std::cout << "art_map " << it->first << ":" << it->second << std::endl;
+    std::cout << "art_map lower_bound(/b):" << artMap.lower_bound("/b")->first << std::endl;
+
+    // One std::string::compare per level, and find stops at the equal key.
+    easy::map<std::string, int, easy::three_way_less<std::string> > threeWayMap;
+    threeWayMap.insert(easy::make_pair(std::string("beta"), 2));
+    threeWayMap.insert(easy::make_pair(std::string("alpha"), 1));
+    std::cout << "beta:" << threeWayMap.find(std::string("beta"))->second
+        << " gamma:" << (threeWayMap.find(std::string("gamma")) != threeWayMap.end()) << std::endl;
+
+    // Unordered; find_as looks a std::string key up by const char* without copying it.
+    easy::hash_map<std::string, int> hashMap;
+    hashMap.reserve(100);
+    for (int i = 0; i < 100; ++i) {
+        char key[8];
+        snprintf(key, sizeof(key), "%d", i);
+        hashMap.insert(easy::make_pair(std::string(key), i));
+    }
+    hashMap.erase("42");
+    std::cout << "hash_map size:" << hashMap.size() << " buckets:" << hashMap.bucket_count()
+        << " 7:" << hashMap.find_as("7")->second << " 42:" << (hashMap.find_as("42") != hashMap.end()) << std::endl;
+
+    // Holds 2 entries; a get makes an entry the most recent, so the put of 3 evicts 2.
+    easy::lru_cache<int, int> lruCache(2);
+    lruCache.put(1, 10);
+    lruCache.put(2, 20);
+    lruCache.get(1);
+    lruCache.put(3, 30);
+    std::cout << "lru_cache has 1:" << lruCache.contains(1) << " 2:" << lruCache.contains(2) << " 3:" << lruCache.contains(3) << std::endl;
+
+    // A capacity of 4 uses 4 of the 16 shards, one entry each, so every put is stored.
+    easy::sharded_lru_cache<int, int> smallShardedCache(4);
+    bool bAllPut = true;
+    for (int i = 0; i < 100; ++i)
+        bAllPut = smallShardedCache.put(i, i) && bAllPut;
+    std::cout << "sharded_lru_cache shards:" << smallShardedCache.shard_count() << " size:" << smallShardedCache.size()
+              << " all put:" << bAllPut << " has 99:" << smallShardedCache.contains(99) << std::endl;
+
+    // Entries live for 100 ticks; touching 1 at tick 60 keeps it until 160. Lookups
+    // skip 2 at tick 120 before expire reclaims it.
+    easy::ttl_map<int, int> ttlMap(100);
+    ttlMap.put(1, 10, 0);
+    ttlMap.put(2, 20, 0);
+    ttlMap.touch(1, 60);
+    const bool bHas2 = ttlMap.contains(2, 120);
+    const size_t nExpired = ttlMap.expire(120, 16);
+    std::cout << "ttl_map at 120 has 1:" << ttlMap.contains(1, 120) << " 2:" << bHas2
+        << " expired:" << nExpired << " size:" << ttlMap.size() << std::endl;
+
 }
@@ -1,5 +1,7 @@
 ﻿#include "TestEasySet.h"
 #include <iostream>
+#include "BitmapSet.h"
+#include "FrozenSet.h"
 #include "Set.h"
 #include <string>
 
@@ -59,4 +61,44 @@ void TestEasySet::main()
     mySet.insert("dd");
     print(mySet);
 
+    // Ids which share their high 16 bits go into one chunk: a few as an array,
+    // 0 to 9999 as a bitset, or as a single run after optimize.
+    easy::bitmap_set<uint32_t> docIds, lowIds;
+    for (uint32_t i = 0; i < 10000; ++i) {
+        lowIds.insert(i);
+    }
+    docIds.insert(4);
+    docIds.insert(70000);
+    docIds.insert(8);
+    std::cout << "bitmap_set bytes:" << lowIds.memory_usage();
+    lowIds.optimize();
+    std::cout << " optimized:" << lowIds.memory_usage() << std::endl;
+    std::cout << "common ids:" << docIds.intersection_size(lowIds) << " first id from 5:" << *docIds.lower_bound(5) << std::endl;
+    docIds |= lowIds;
+    std::cout << "size:" << docIds.size() << " ids from 9998:";
+    for (auto itId = docIds.lower_bound(9998); itId != docIds.end(); ++itId) {
+        std::cout << " " << *itId;
+    }
+    std::cout << std::endl;
+
+    // Built once from a set, saved, and searched straight from the mapped file.
+    easy::set<uint64_t> postings;
+    for (uint64_t i = 1; i <= 1000; ++i) {
+        postings.insert(i * i);
+    }
+    easy::frozen_set<uint64_t> frozenPostings(postings.begin(), postings.end());
+    if (frozenPostings.write("TestEasySet.frozen")) {
+        easy::frozen_set<uint64_t> mappedPostings;
+        if (mappedPostings.open("TestEasySet.frozen")) {
+            std::cout << "frozen_set size:" << mappedPostings.size() << " bytes:" << mappedPostings.data_size()
+                << " first from 50:" << *mappedPostings.lower_bound(50) << " has 144:" << mappedPostings.contains(144) << std::endl;
+        }
+    }
+
+    // An empty set has no image; viewing its data() and data_size() gives an empty set.
+    easy::frozen_set<uint64_t> frozenEmpty;
+    easy::frozen_set<uint64_t> viewedEmpty;
+    const bool bViewed = viewedEmpty.view(frozenEmpty.data(), frozenEmpty.data_size());
+    std::cout << "frozen_set view of empty:" << bViewed << " size:" << viewedEmpty.size() << std::endl;
+
 }
@@ -0,0 +1,83 @@
+#include "TestIntervalMap.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+TestIntervalMap::TestIntervalMap()
+{
+}
+
+
+TestIntervalMap::~TestIntervalMap()
+{
+}
+
+void TestIntervalMap::main()
+{
+    typedef easy::interval_map<int, const char*> IntervalMap;
+
+    IntervalMap intervalMap;
+    intervalMap.insert(0, 10, "a");
+    intervalMap.insert(5, 15, "b");
+    intervalMap.insert(20, 30, "c");
+
+    std::cout << "overlapping [8, 12):";
+    intervalMap.for_each_overlapping(8, 12, [](const IntervalMap::value_type& x) { std::cout << " " << x.second; });
+    std::cout << std::endl;
+
+    std::cout << "containing 12:";
+    intervalMap.for_each_containing(12, [](const IntervalMap::value_type& x) { std::cout << " " << x.second; });
+    std::cout << std::endl;
+
+    std::cout << "overlaps [15, 20):" << intervalMap.overlaps(15, 20) << std::endl;
+
+    intervalMap.erase(easy::make_interval(5, 15));
+    std::cout << "overlaps [12, 13) after erase:" << intervalMap.overlaps(12, 13) << std::endl;
+
+    benchmark(100000, 1000);
+}
+
+void TestIntervalMap::benchmark(int count, int queries)
+{
+    // Random intervals of up to 1000 units in [0, 10000000), queried with windows of 100.
+    typedef easy::interval_map<int, int> IntervalMap;
+
+    std::mt19937 rng(1);
+    IntervalMap intervalMap;
+    std::vector<easy::interval<int> > intervals;
+
+    for (int i = 0; i < count; ++i) {
+        int start = (int)(rng() % 10000000);
+        easy::interval<int> x(start, start + 1 + (int)(rng() % 1000));
+        intervals.push_back(x);
+        intervalMap.insert(x.start, x.end, i);
+    }
+
+    std::vector<int> lows;
+    for (int i = 0; i < queries; ++i) {
+        lows.push_back((int)(rng() % 10000000));
+    }
+
+    long long treeHits = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lows.size(); ++i) {
+        intervalMap.for_each_overlapping(lows[i], lows[i] + 100, [&treeHits](const IntervalMap::value_type&) { ++treeHits; });
+    }
+
+    long long scanHits = 0;
+    auto t1 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lows.size(); ++i) {
+        for (size_t j = 0; j < intervals.size(); ++j) {
+            if ((intervals[j].start < lows[i] + 100) && (lows[i] < intervals[j].end)) {
+                ++scanHits;
+            }
+        }
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    std::cout << "interval_map: " << std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() << "us, "
+        << "linear scan: " << std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count() << "us, "
+        << "hits: " << treeHits << "/" << scanHits << std::endl;
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include "IntervalMap.h"
+class TestIntervalMap
+{
+public:
+    TestIntervalMap();
+    ~TestIntervalMap();
+
+    static void main();
+
+private:
+    static void benchmark(int count, int queries);
+};
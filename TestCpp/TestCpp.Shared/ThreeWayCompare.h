@@ -0,0 +1,99 @@
+#ifndef __EASY_THREE_WAY_COMPARE_H__
+#define __EASY_THREE_WAY_COMPARE_H__
+
+/**
+ * 三路比较的Compare: 红黑树查找时每层只调用一次比较, 遇到相等的键即停止
+ */
+
+#include <string.h>
+#include <string>
+#include "RbTree.h"
+
+namespace easy
+{
+    /// three_way
+    ///
+    /// Returns <0, 0 or >0 as a is less than, equal to or greater than b. The general
+    /// version uses operator< up to twice. std::string and C strings compare once,
+    /// which reads the characters once instead of twice when two keys are equal or
+    /// share a long prefix.
+    ///
+    template <typename T>
+    struct three_way
+    {
+        int operator()(const T& a, const T& b) const
+        {
+            return (a < b) ? -1 : ((b < a) ? 1 : 0);
+        }
+    };
+
+    template <>
+    struct three_way<std::string>
+    {
+        int operator()(const std::string& a, const std::string& b) const
+        {
+            return a.compare(b);
+        }
+    };
+
+    template <>
+    struct three_way<const char*>
+    {
+        int operator()(const char* a, const char* b) const
+        {
+            return strcmp(a, b);
+        }
+    };
+
+
+    /// three_way_less
+    ///
+    /// A Compare for map, set and the other rbtree containers which orders keys with
+    /// a three-way comparison. operator() is the usual less, so it fits anywhere a
+    /// Compare does, but the tree (see rbtree_three_way) calls compare instead: find,
+    /// lower_bound, equal_range and insert then compare once per level and stop at an
+    /// equal key, instead of comparing again with the node they end at. That pays
+    /// off when a comparison is expensive, such as for long strings and composite
+    /// keys; for integers, less is as fast. ThreeWay is a functor like three_way.
+    ///
+    /// Example usage:
+    ///     easy::map<std::string, int, easy::three_way_less<std::string> > myMap;
+    ///
+    template <typename T, typename ThreeWay = three_way<T> >
+    struct three_way_less : public binary_function<T, T, bool>
+    {
+        ThreeWay mThreeWay;
+
+        three_way_less() : mThreeWay() {}
+        three_way_less(const ThreeWay& threeWay) : mThreeWay(threeWay) {}
+
+        bool operator()(const T& a, const T& b) const
+        {
+            return mThreeWay(a, b) < 0;
+        }
+
+        int compare(const T& a, const T& b) const
+        {
+            return mThreeWay(a, b);
+        }
+    };
+
+
+    /// rbtree_three_way
+    /// Lets the tree call three_way_less::compare.
+    ///
+    template <typename T, typename ThreeWay>
+    struct rbtree_three_way<three_way_less<T, ThreeWay> >
+    {
+        static const bool kEnabled = true;
+
+        template <typename A, typename B>
+        static int Order(const three_way_less<T, ThreeWay>& compare, const A& a, const B& b)
+        {
+            return compare.compare(a, b);
+        }
+    };
+
+} // namespace easy
+
+#endif // __EASY_THREE_WAY_COMPARE_H__
@@ -0,0 +1,535 @@
+#ifndef __EASY_TTL_MAP_H__
+#define __EASY_TTL_MAP_H__
+
+/**
+ * 条目在一段时间后过期的easy::map, 过期顺序由嵌在节点里的分层时间轮维护, 可以分批回收
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "RbTree.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace easy
+{
+    namespace Internal
+    {
+        // Returns the index of the lowest set bit of a non-zero mask. The halves are
+        // scanned separately, as 32-bit targets have no 64-bit bit scan.
+        inline unsigned TtlLowestBit(uint64_t nMask)
+        {
+            const uint32_t nLow = (uint32_t)nMask;
+            const uint32_t nScan = nLow ? nLow : (uint32_t)(nMask >> 32);
+            const unsigned nOffset = nLow ? 0 : 32;
+#if defined(_MSC_VER)
+            unsigned long nIndex;
+            _BitScanForward(&nIndex, nScan);
+            return nOffset + (unsigned)nIndex;
+#elif defined(__GNUC__) || defined(__clang__)
+            return nOffset + (unsigned)__builtin_ctz(nScan);
+#else
+            unsigned nIndex = 0;
+            for (uint32_t n = nScan; !(n & 1); n >>= 1)
+                ++nIndex;
+            return nOffset + nIndex;
+#endif
+        }
+    }
+
+
+    /// ttl_time
+    ///
+    /// A point in time in ticks of the caller's choosing, e.g. milliseconds of a
+    /// monotonic clock. ttl_map never reads a clock; every call that needs the
+    /// time takes it.
+    ///
+    typedef uint64_t ttl_time;
+
+
+    /// ttl_ignore_expiry
+    ///
+    /// The default ExpireCallback of ttl_map, which does nothing.
+    ///
+    struct ttl_ignore_expiry
+    {
+        template <typename Key, typename T>
+        void operator()(const Key&, T&) const {}
+    };
+
+
+    /// ttl_map_value
+    ///
+    /// The value_type of ttl_map's tree: the key/value pair, its expiry time and its
+    /// place in the timing wheel, which is a doubly linked list through the tree
+    /// nodes in the same slot.
+    ///
+    template <typename Key, typename T>
+    struct ttl_map_value : public easy::pair<Key, T>
+    {
+        typedef easy::pair<Key, T>                      base_type;
+        typedef rbtree_node<ttl_map_value<Key, T> >     node_type;
+
+        ttl_time   mnExpiry;
+        node_type* mpNextInSlot;
+        node_type* mpPrevInSlot;
+        unsigned   mnSlot;          // Level * kSlotCount + slot, see ttl_map.
+
+        ttl_map_value()
+            : base_type(),
+            mnExpiry(0),
+            mpNextInSlot(NULL),
+            mpPrevInSlot(NULL),
+            mnSlot(0) {}
+
+        ttl_map_value(const Key& key, const T& value)
+            : base_type(key, value),
+            mnExpiry(0),
+            mpNextInSlot(NULL),
+            mpPrevInSlot(NULL),
+            mnSlot(0) {}
+    };
+
+
+
+    /// ttl_map
+    ///
+    /// A map whose entries expire a fixed time (the ttl) after they were put or last
+    /// touched. find and the other lookups treat an expired entry as absent as soon
+    /// as it expires, so nothing has to sweep the map for it to be correct; expire
+    /// reclaims the memory of expired entries, a bounded amount of work at a time,
+    /// so it can be called on every tick of an event loop without latency spikes.
+    ///
+    /// The expiry order is kept by a hierarchical timing wheel, as in the Linux
+    /// kernel's timers: kLevelCount levels of kSlotCount slots, where a slot of level
+    /// L covers kSlotCount^L ticks. An entry goes in the lowest level whose slots
+    /// tell its expiry apart from the wheel's current time. When the wheel reaches a
+    /// slot of a higher level, its entries are moved down, and when it reaches a slot
+    /// of level 0, its entries have expired. The slot lists run through the tree
+    /// nodes, so scheduling and cancelling take O(1) and don't allocate. Entries
+    /// beyond the wheel's range, 2^24 ticks, wait in the farthest slot and are
+    /// placed again when it comes round. Empty stretches are skipped with a bitmap
+    /// of the non-empty slots of each level.
+    ///
+    /// size() counts the expired entries which haven't been reclaimed yet. A
+    /// ttl_map can't be copied, as its wheel points into its own nodes.
+    ///
+    /// Example usage:
+    ///     easy::ttl_map<SessionId, Session> sessions(30000); // 30 s in ms ticks.
+    ///     sessions.put(id, session, NowMs());
+    ///     if (Session* p = sessions.find(id, NowMs()))
+    ///         sessions.touch(id, NowMs());
+    ///     sessions.expire(NowMs(), 100); // On every tick.
+    ///
+    template <typename Key, typename T, typename Compare = easy::less<Key>,
+              typename ExpireCallback = ttl_ignore_expiry, typename Allocator = easy::allocator>
+    class ttl_map
+    {
+    public:
+        typedef ttl_map_value<Key, T>                                                               value_type;
+        typedef rbtree<Key, value_type, Compare, easy::use_first<value_type>, true, true, Allocator> tree_type;
+        typedef ttl_map<Key, T, Compare, ExpireCallback, Allocator>                                 this_type;
+        typedef typename tree_type::size_type                                                       size_type;
+        typedef typename tree_type::node_type                                                       node_type;
+        typedef Key                                                                                 key_type;
+        typedef T                                                                                   mapped_type;
+
+        static const unsigned kSlotBits   = 6;
+        static const unsigned kSlotCount  = 1 << kSlotBits;
+        static const unsigned kLevelCount = 4;
+
+    public:
+        explicit ttl_map(ttl_time nTtl, const ExpireCallback& expireCallback = ExpireCallback());
+
+        ttl_map(const this_type&) = delete;
+        this_type& operator=(const this_type&) = delete;
+
+    public:
+        /// Returns the value of key, or NULL if it isn't there or has expired at now.
+        /// An expired entry found this way is reclaimed on the spot.
+        T* find(const Key& key, ttl_time now);
+
+        /// Like find, but leaves an expired entry for expire.
+        const T* peek(const Key& key, ttl_time now) const;
+
+        bool contains(const Key& key, ttl_time now) const;
+
+        /// Sets the value of key, which expires at now + ttl (or nTtl). Returns false
+        /// if the allocator failed.
+        bool put(const Key& key, const T& value, ttl_time now);
+        bool put(const Key& key, const T& value, ttl_time now, ttl_time nTtl);
+
+        /// Restarts the ttl of key if it hasn't expired. Returns false otherwise.
+        bool touch(const Key& key, ttl_time now);
+
+        /// Removes key, expired or not, without calling ExpireCallback.
+        bool erase(const Key& key);
+
+        /// Reclaims entries which have expired at now, calling ExpireCallback for each,
+        /// and stops after nBudget units of work: an entry reclaimed, an entry moved
+        /// down the wheel, or a skip over empty slots. Returns the number reclaimed.
+        size_t expire(ttl_time now, size_t nBudget);
+
+        void clear();
+
+        bool      empty() const { return mTree.empty(); }
+        size_type size() const { return mTree.size(); }
+
+        ttl_time ttl() const { return mnTtl; }
+        void     set_ttl(ttl_time nTtl) { mnTtl = nTtl; }
+
+        bool validate() const;
+
+    protected:
+        static ttl_time Digit(ttl_time t, unsigned nLevel)
+        {
+            return (t >> (nLevel * kSlotBits)) & (kSlotCount - 1);
+        }
+
+        void     DoSchedule(node_type* pNode);
+        void     DoUnschedule(node_type* pNode);
+        void     DoReclaim(node_type* pNode);
+        ttl_time DoNextEvent() const;
+        size_t   DoProcessCurrent();
+
+    protected:
+        tree_type      mTree;
+        node_type*     mpSlots[kLevelCount][kSlotCount];
+        uint64_t       mnOccupied[kLevelCount];    // Bit i is set if mpSlots[level][i] isn't empty.
+        ttl_time       mnCurrent;                  // Every slot before this time has been processed.
+        ttl_time       mnTtl;
+        ExpireCallback mExpireCallback;
+    }; // ttl_map
+
+
+
+
+    ///////////////////////////////////////////////////////////////////////
+    // ttl_map
+    ///////////////////////////////////////////////////////////////////////
+
+    template <typename Key, typename T, typename Compare, typename ExpireCallback, typename Allocator>
+    inline ttl_map<Key, T, Compare, ExpireCallback, Allocator>::ttl_map(ttl_time nTtl, const ExpireCallback& expireCallback)
+        : mTree(),
+        mnCurrent(0),
+        mnTtl(nTtl),
+        mExpireCallback(expireCallback)
+    {
+        for (unsigned nLevel = 0; nLevel < kLevelCount; ++nLevel)
+        {
+            for (unsigned nSlot = 0; nSlot < kSlotCount; ++nSlot)
+                mpSlots[nLevel][nSlot] = NULL;
+            mnOccupied[nLevel] = 0;
+        }
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename ExpireCallback, typename Allocator>
+    inline T* ttl_map<Key, T, Compare, ExpireCallback, Allocator>::find(const Key& key, ttl_time now)
+    {
+        const typename tree_type::iterator it(mTree.find(key));
+
+        if (it == mTree.end())
+            return NULL;
+
+        if (it->mnExpiry <= now)
+        {
+            DoUnschedule(it.mpNode);
+            DoReclaim(it.mpNode);
+            return NULL;
+        }
+
+        return &it->second;
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename ExpireCallback, typename Allocator>
+    inline const T* ttl_map<Key, T, Compare, ExpireCallback, Allocator>::peek(const Key& key, ttl_time now) const
+    {
+        const typename tree_type::const_iterator it(mTree.find(key));
+        return ((it != mTree.end()) && (now < it->mnExpiry)) ? &it->second : NULL;
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename ExpireCallback, typename Allocator>
+    inline bool ttl_map<Key, T, Compare, ExpireCallback, Allocator>::contains(const Key& key, ttl_time now) const
+    {
+        return peek(key, now) != NULL;
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename ExpireCallback, typename Allocator>
+    inline bool ttl_map<Key, T, Compare, ExpireCallback, Allocator>::put(const Key& key, const T& value, ttl_time now)
+    {
+        return put(key, value, now, mnTtl);
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename ExpireCallback, typename Allocator>
+    inline bool ttl_map<Key, T, Compare, ExpireCallback, Allocator>::put(const Key& key, const T& value, ttl_time now, ttl_time nTtl)
+    {
+        typename tree_type::iterator it(mTree.find(key));
+
+        if (it != mTree.end())
+        {
+            DoUnschedule(it.mpNode);
+            it->second = value;
+        } else
+        {
+            const typename tree_type::insert_return_type result(mTree.insert(value_type(key, value)));
+
+            if (!result.second) // If the allocator failed...
+                return false;
+
+            it = result.first;
+        }
+
+        it->mnExpiry = now + nTtl;
+        DoSchedule(it.mpNode);
+        return true;
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename ExpireCallback, typename Allocator>
+    inline bool ttl_map<Key, T, Compare, ExpireCallback, Allocator>::touch(const Key& key, ttl_time now)
+    {
+        const typename tree_type::iterator it(mTree.find(key));
+
+        if ((it == mTree.end()) || (it->mnExpiry <= now))
+            return false;
+
+        DoUnschedule(it.mpNode);
+        it->mnExpiry = now + mnTtl;
+        DoSchedule(it.mpNode);
+        return true;
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename ExpireCallback, typename Allocator>
+    inline bool ttl_map<Key, T, Compare, ExpireCallback, Allocator>::erase(const Key& key)
+    {
+        const typename tree_type::iterator it(mTree.find(key));
+
+        if (it == mTree.end())
+            return false;
+
+        DoUnschedule(it.mpNode);
+        mTree.erase(it);
+        return true;
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename ExpireCallback, typename Allocator>
+    size_t ttl_map<Key, T, Compare, ExpireCallback, Allocator>::expire(ttl_time now, size_t nBudget)
+    {
+        size_t nReclaimed = 0;
+
+        while (nBudget)
+        {
+            const ttl_time nNext = DoNextEvent();
+
+            // Nothing is due before nNext, so the wheel can jump to it, or to now.
+            if (nNext > now)
+            {
+                if (mnCurrent < now)
+                    mnCurrent = now;
+                break;
+            }
+
+            --nBudget;
+
+            if (nNext > mnCurrent)
+                mnCurrent = nNext;
+            else
+                nReclaimed += DoProcessCurrent();
+        }
+
+        return nReclaimed;
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename ExpireCallback, typename Allocator>
+    inline void ttl_map<Key, T, Compare, ExpireCallback, Allocator>::clear()
+    {
+        mTree.clear();
+
+        for (unsigned nLevel = 0; nLevel < kLevelCount; ++nLevel)
+        {
+            for (unsigned nSlot = 0; nSlot < kSlotCount; ++nSlot)
+                mpSlots[nLevel][nSlot] = NULL;
+            mnOccupied[nLevel] = 0;
+        }
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename ExpireCallback, typename Allocator>
+    inline bool ttl_map<Key, T, Compare, ExpireCallback, Allocator>::validate() const
+    {
+        size_type nCount = 0;
+
+        for (unsigned nLevel = 0; nLevel < kLevelCount; ++nLevel)
+        {
+            for (unsigned nSlot = 0; nSlot < kSlotCount; ++nSlot)
+            {
+                const node_type* pPrev = NULL;
+
+                if (((mnOccupied[nLevel] >> nSlot) & 1) != (mpSlots[nLevel][nSlot] ? 1u : 0u))
+                    return false;
+
+                for (const node_type* pNode = mpSlots[nLevel][nSlot]; pNode; pNode = pNode->mValue.mpNextInSlot)
+                {
+                    if ((pNode->mValue.mpPrevInSlot != pPrev) || (pNode->mValue.mnSlot != ((nLevel * kSlotCount) + nSlot)))
+                        return false;
+
+                    // Below the top level, a slot only holds entries which expire within it.
+                    if ((nLevel + 1) < kLevelCount)
+                    {
+                        const ttl_time nExpiry = (pNode->mValue.mnExpiry > mnCurrent) ? pNode->mValue.mnExpiry : mnCurrent;
+                        if (Digit(nExpiry, nLevel) != nSlot)
+                            return false;
+                    }
+
+                    pPrev = pNode;
+                    ++nCount;
+                }
+            }
+        }
+
+        return nCount == mTree.size();
+    }
+
+
+    // Links the node into the slot of its expiry, relative to the current time.
+    template <typename Key, typename T, typename Compare, typename ExpireCallback, typename Allocator>
+    inline void ttl_map<Key, T, Compare, ExpireCallback, Allocator>::DoSchedule(node_type* pNode)
+    {
+        // Anything already due goes in the current slot of level 0.
+        const ttl_time nExpiry = (pNode->mValue.mnExpiry > mnCurrent) ? pNode->mValue.mnExpiry : mnCurrent;
+        unsigned       nLevel = 0;
+
+        while (((nLevel + 1) < kLevelCount) && ((nExpiry >> ((nLevel + 1) * kSlotBits)) != (mnCurrent >> ((nLevel + 1) * kSlotBits))))
+            ++nLevel;
+
+        unsigned nSlot = (unsigned)Digit(nExpiry, nLevel);
+
+        // The top level goes round, so a slot of it is good for less than one turn ahead.
+        // Anything further waits in the slot which comes round last.
+        if (((nLevel + 1) == kLevelCount) &&
+            (((nExpiry - mnCurrent) >> (kLevelCount * kSlotBits)) || (nSlot == Digit(mnCurrent, nLevel))))
+        {
+            nSlot = (unsigned)((Digit(mnCurrent, nLevel) + kSlotCount - 1) & (kSlotCount - 1));
+        }
+
+        node_type*& pHead = mpSlots[nLevel][nSlot];
+
+        pNode->mValue.mnSlot = (nLevel * kSlotCount) + nSlot;
+        pNode->mValue.mpPrevInSlot = NULL;
+        pNode->mValue.mpNextInSlot = pHead;
+        if (pHead)
+            pHead->mValue.mpPrevInSlot = pNode;
+        pHead = pNode;
+
+        mnOccupied[nLevel] |= (uint64_t)1 << nSlot;
+    }
+
+
+    template <typename Key, typename T, typename Compare, typename ExpireCallback, typename Allocator>
+    inline void ttl_map<Key, T, Compare, ExpireCallback, Allocator>::DoUnschedule(node_type* pNode)
+    {
+        value_type&    value = pNode->mValue;
+        const unsigned nLevel = value.mnSlot / kSlotCount;
+        const unsigned nSlot = value.mnSlot % kSlotCount;
+
+        if (value.mpPrevInSlot)
+            value.mpPrevInSlot->mValue.mpNextInSlot = value.mpNextInSlot;
+        else
+        {
+            mpSlots[nLevel][nSlot] = value.mpNextInSlot;
+            if (!value.mpNextInSlot)
+                mnOccupied[nLevel] &= ~((uint64_t)1 << nSlot);
+        }
+
+        if (value.mpNextInSlot)
+            value.mpNextInSlot->mValue.mpPrevInSlot = value.mpPrevInSlot;
+
+        value.mpNextInSlot = NULL;
+        value.mpPrevInSlot = NULL;
+    }
+
+
+    // Destroys an expired entry which is already unscheduled.
+    template <typename Key, typename T, typename Compare, typename ExpireCallback, typename Allocator>
+    inline void ttl_map<Key, T, Compare, ExpireCallback, Allocator>::DoReclaim(node_type* pNode)
+    {
+        mExpireCallback(static_cast<const Key&>(pNode->mValue.first), pNode->mValue.second);
+        mTree.erase(typename tree_type::const_iterator(pNode));
+    }
+
+
+    // Returns the time of the first non-empty slot at or after the current time, or
+    // the largest time if the wheel is empty.
+    template <typename Key, typename T, typename Compare, typename ExpireCallback, typename Allocator>
+    inline ttl_time ttl_map<Key, T, Compare, ExpireCallback, Allocator>::DoNextEvent() const
+    {
+        ttl_time nNext = ~(ttl_time)0;
+
+        for (unsigned nLevel = 0; nLevel < kLevelCount; ++nLevel)
+        {
+            const uint64_t nOccupied = mnOccupied[nLevel];
+
+            if (!nOccupied)
+                continue;
+
+            const unsigned nShift = nLevel * kSlotBits;
+            const ttl_time nBase = (mnCurrent >> (nShift + kSlotBits)) << (nShift + kSlotBits);
+            const uint64_t nAhead = nOccupied & (~(uint64_t)0 << Digit(mnCurrent, nLevel));
+            ttl_time       nTime;
+
+            // Slots behind the current one are a full turn of the level away.
+            if (nAhead)
+                nTime = nBase + ((ttl_time)Internal::TtlLowestBit(nAhead) << nShift);
+            else
+                nTime = nBase + ((ttl_time)1 << (nShift + kSlotBits)) + ((ttl_time)Internal::TtlLowestBit(nOccupied) << nShift);
+
+            if (nTime < mnCurrent) // A slot of a higher level which the current time is inside of.
+                nTime = mnCurrent;
+
+            if (nTime < nNext)
+                nNext = nTime;
+        }
+
+        return nNext;
+    }
+
+
+    // Handles one entry of a slot which the current time has reached. Entries of a
+    // higher level slot are moved down first, so that those which expire at the
+    // current time join level 0 before it is processed. Returns 1 if an entry expired.
+    template <typename Key, typename T, typename Compare, typename ExpireCallback, typename Allocator>
+    inline size_t ttl_map<Key, T, Compare, ExpireCallback, Allocator>::DoProcessCurrent()
+    {
+        for (unsigned nLevel = kLevelCount - 1; nLevel > 0; --nLevel)
+        {
+            if (node_type* const pNode = mpSlots[nLevel][Digit(mnCurrent, nLevel)])
+            {
+                DoUnschedule(pNode);
+                DoSchedule(pNode);
+                return 0;
+            }
+        }
+
+        if (node_type* const pNode = mpSlots[0][Digit(mnCurrent, 0)])
+        {
+            DoUnschedule(pNode);
+            DoReclaim(pNode);
+            return 1;
+        }
+
+        return 0;
+    }
+
+} // namespace easy
+
+#endif // __EASY_TTL_MAP_H__
@@ -17,6 +17,7 @@
 #include <iostream>
 #include "TestEasyMap.h"
 #include "TestEasySet.h"
+#include "TestIntervalMap.h"
 #include "construct/TestConstructor.h"
 
 template<typename T>
@@ -52,6 +53,7 @@ int main()
 
     TestEasySet::main();
     TestEasyMap::main();
+    TestIntervalMap::main();
 
     TestVirtualDestructor::main();
     std::u16string us1 = u"aaa";